@@ -36,8 +36,22 @@ BOOL bStopped=FALSE;	   // set by opcode STOP #XX to indicate
 								// a stopped instruction processing
 unsigned long nIRQs=0;  // count the occurrance of HW irqs
 
+// opcode cache hits and misses (shown in the status bar)
 ULONG hits=0,misses=0;
 
+// decoded opcode cache, direct mapped on (PC>>1) so it spans 8kB of code
+// an entry saves the fetch and the Operation[] lookup of an opcode
+// only pages of cacheable modules (RAM/ROM) get cached, every write
+// to such a page drops its entries again (see PUTxxx() in stmem.c)
+#define ICACHESIZE 4096
+#define ICACHEEMPTY 1L // odd address, never matches a fetch PC
+struct tag_ICACHE
+{
+	unsigned long pc;					// address of opcode
+	unsigned short opcode;			// opcode word
+	void (*Handler)(short opcode);	// Operation[opcode]
+}ICache[ICACHESIZE];
+
 // pointers to plugin _DLLHDRs
 struct tag_DLLHDR* pDllHdr[64];
 
@@ -5199,6 +5213,8 @@ short i;
 	else return FALSE;
 	// set registers back to initial state
 	for(i=0;i<8;i++){cpu.aregs.a[i]=-1; cpu.dregs.d[i]=-1;}
+	// memory contents may have been reloaded by the plugins
+	FlushICache();
 	// reset the special registers
 	cpu.vbr=cpu.sfc=cpu.dfc=cpu.cacr=cpu.caar=0;
 	// startup SR (SUPERVISOR IPL=7 No flags)
@@ -5212,10 +5228,83 @@ short i;
 	return TRUE;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// NAME:				void FlushICache(void)
+//
+// DESCRIPTION:   drop all cached opcodes
+//
+// PARAMETERS:    none
+//
+// RETURNS:       none
+//
+////////////////////////////////////////////////////////////////////////////////
+void FlushICache(void)
+{
+long i;
+
+	for(i=0;i<ICACHESIZE;i++)ICache[i].pc=ICACHEEMPTY;
+	// no page holds cached code any more
+	for(i=0;i<MAPPERSIZE;i++)bCodePage[i]=FALSE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// NAME:				void InvalidateCodePage(unsigned long address)
+//
+// DESCRIPTION:   a write hit a 1kB page holding cached opcodes,
+//						drop the entries of that page
+//
+// PARAMETERS:    unsigned long address: address written to
+//
+// RETURNS:       none
+//
+// REMARKS:			the 512 possible opcodes of a page always use
+//						512 consecutive cache slots
+//
+////////////////////////////////////////////////////////////////////////////////
+void InvalidateCodePage(unsigned long address)
+{
+unsigned long page=(address&0x00FFFFFFL)>>10;
+unsigned short i,slot;
+
+	for(i=0;i<512;i++)
+	{
+		slot=(unsigned short)((page*512+i)&(ICACHESIZE-1));
+		if(((ICache[slot].pc&0x00FFFFFFL)>>10)==page)ICache[slot].pc=ICACHEEMPTY;
+	}
+	bCodePage[page]=FALSE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //              Simulation begin
 ////////////////////////////////////////////////////////////////////////////////
 
+////////////////////////////////////////////////////////////////////////////////
+// NAME:				long *StackShadow(void)
+//
+// DESCRIPTION:   shadow stack pointer that A7 stands for in the current mode
+//
+// PARAMETERS:    none
+//
+// RETURNS:       long *: &cpu.usp, &cpu.ssp or &cpu.msp
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static long *StackShadow(void)
+{
+	switch(cpu.sregs.sr&0x3000)
+	{
+		// we are in supervisor mode
+		case 0x2000:
+			return &cpu.ssp;
+		// we are in master mode
+		case 0x3000:
+			return &cpu.msp;
+		// we are in user mode
+		default:
+			return &cpu.usp;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // NAME:				void Simulate68k(unsigned long ops)
 //
@@ -5227,82 +5316,84 @@ short i;
 // RETURNS:       none
 //
 // REMARKS:			This function could be interpreted as the pipeline
-//						manager of the virtual CPU. It's general operation
-//						looks like this:
+//						manager of the virtual CPU. It runs one batch of
+//						opcodes, A7 is set up once for the whole batch:
+//						(0)	setup stack pointer that application sees
 //						(1)	fetch opcode if not uneven address
-//						(2)	setup stack pointer that application sees
-//						(3)	decode and execute opcode
-//						(4)	setup stack pointer after operation
-//						(5)	has STOP #imm occurred?
-//						(6)	single step?
-//						(7)	hardware IRQ?
-//						(8)	next opcode, start at (1)
+//						(2)	decode and execute opcode
+//						(3)	save stack pointer after operation
+//						(4)	single step?
+//						(5)	hardware IRQ?
+//						(6)	has STOP #imm occurred? -> end of batch
+//						(7)	next opcode, start at (1)
+//						While the CPU is stopped the plugins keep getting
+//						their time slice so they can raise the waking IRQ.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
 void Simulate68k(unsigned long ops)
 {
 	short index;
+	BOOL bWasStopped;
+	struct tag_ICACHE *pEntry;
+
+	// setup the stack to use (A7 according to mode)
+	// the shadow is written back after every opcode, so the
+	// exception processing always sees the current SSP/USP/MSP
+	cpu.aregs.a[7]=*StackShadow();
 
 	// do the process loop [ops] times
 	while(ops--)
 	{
-		// uneven access to fetch opcode -> ADDRESS ERROR
-		if(cpu.pc&0x00000001L)
-		{
-			addr_err();
-		}
+		bWasStopped=bStopped;
 
-		of.o = GETword(cpu.pc);
-
-		// setup the stack to use
-		switch(cpu.sregs.sr&0x3000) // set A7 according to mode
+		if(!bStopped)
 		{
-			// we are in user mode
-			case 0:
-			case 0x1000:
-				cpu.aregs.a[7]=cpu.usp;
-				break;
-			// we are in supervisor mode
-			case 0x2000:
-				cpu.aregs.a[7]=cpu.ssp;
-				break;
-			// we are in master mode
-			case 0x3000:
-				cpu.aregs.a[7]=cpu.msp;
-		}
-
-		// save away the PC before the operation so we can check if anything happened at all
-		// and we can restart a new opcode cycle (exception handling etc.)
-		pcbefore=cpu.pc;
+			// save away the PC before the operation so we can check if anything happened at all
+			// and we can restart a new opcode cycle (exception handling etc.)
+			pcbefore=cpu.pc;
 
+			// uneven access to fetch opcode -> ADDRESS ERROR
+			if(cpu.pc&0x00000001L)
+			{
+				addr_err();
+			}
+			else
+			{
+				pEntry=&ICache[(cpu.pc>>1)&(ICACHESIZE-1)];
+				if(pEntry->pc==(unsigned long)cpu.pc)
+				{
+					hits++;
+				}
+				else
+				{
+					// fetch and decode, remember it if the page is cacheable
+					misses++;
+					of.o = GETword(cpu.pc);
+					pEntry->opcode=of.o;
+					pEntry->Handler=Operation[of.o];
+					if(bCacheablePage[(cpu.pc&0x00FFFFFFL)>>10])
+					{
+						pEntry->pc=cpu.pc;
+						bCodePage[(cpu.pc&0x00FFFFFFL)>>10]=TRUE;
+					}
+					else pEntry->pc=ICACHEEMPTY;
+				}
 
-		if(!bStopped)
-			Operation[of.o](of.o); 	// decode and execute command
+				of.o = pEntry->opcode;
+				pEntry->Handler(of.o); 	// execute command
 
-		// PC didn't change and opcode is STOP #imm
-		// testing the PC distance before and after
-		// is not enough, since a branch command could
-		// start out on the same PC as before, i.e.
-		// label: DBRA D0,label
-		if(of.o==0x4E72 && pcbefore==cpu.pc)bStopped=TRUE;
+				// PC didn't change and opcode is STOP #imm
+				// testing the PC distance before and after
+				// is not enough, since a branch command could
+				// start out on the same PC as before, i.e.
+				// label: DBRA D0,label
+				if(of.o==0x4E72 && pcbefore==cpu.pc)bStopped=TRUE;
+			}
 
-		// setup internal shadow stack pointer after the operation has taken place
-		switch(cpu.sregs.sr&0x3000) // set A7 according to mode
-		{
-			// we switched to user mode
-			case 0:
-			case 0x1000:
-				cpu.usp=cpu.aregs.a[7];
-				break;
-			// we switched to supervisor mode
-			case 0x2000:
-				cpu.ssp=cpu.aregs.a[7];
-				break;
-			// we switched to master mode
-			case 0x3000:
-				cpu.msp=cpu.aregs.a[7];
-				break;
+			// setup internal shadow stack pointer after the operation has taken place
+			// (the operation might have switched the mode)
+			*StackShadow()=cpu.aregs.a[7];
 		}
 
 		// call simulation procedure for each attached module
@@ -5328,8 +5419,11 @@ void Simulate68k(unsigned long ops)
 			// and process it
 			CheckForInt();
 		}
-	}
 
+		// CPU just entered the STOP state, nothing left to do
+		// in this batch but wait for an IRQ
+		if(bStopped && !bWasStopped)break;
+	}
 }
 
 //// EOF /////////////////////////////////////////////////////////////////////////////
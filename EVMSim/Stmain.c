@@ -34,6 +34,7 @@ HWND hStartup;  							// handle of startup windows
 BOOL bRunning=TRUE; 						// FLAG: simulator is bRunning/ will stop
 												// and exit if this flag becomes FALSE
 const unsigned long nOpsAtOnce=100000; 		// operations to be performed in one call
+const unsigned long nIdleOpsAtOnce=1000;	// plugin time slices per call while the CPU is stopped
 long nStartTime=0,nStopTime=0; 		// measuring performance...
 long nTimeForOps=1,nOpsPerSec=1;    // preset to 1, so no DIV_BY_ZERO occurs
 long nMaxOpsPerSec=1;					// maximum of operations per second
@@ -236,7 +237,19 @@ DWORD SimulationThread(LPDWORD lpdwParam)
 	// as long as global status is RUNNING
 	while(bRunning==TRUE)
 	{
-		if(bAppHasFocus)
+		if(!bAppHasFocus)
+		{
+			// background task: wait for the focus without burning a core
+			Sleep(50);
+		}
+		else if(bStopped)
+		{
+			// CPU waits in STOP #imm for an IRQ: the plugins keep getting
+			// their time slices, but the thread sleeps in between
+			Simulate68k(nIdleOpsAtOnce);
+			Sleep(1);
+		}
+		else
 		{
 			nStartTime=GetTickCount();  // start measuring time
 			// is foreground process?
@@ -14,8 +14,8 @@
 #include "STMAIN.H"  // main program
 #include "STCOM.H"   // CPU core
 #include "STEXEP.H"  // exception handling
+#include "STMEM.H"   // memory access, MAPPERSIZE
 
-#define MAPPERSIZE (16*1024) // 16*1024 entries in table = 16MB � 1kB pages
 ////////////////////////////////////////////////////////////////////////////////
 // globals
 ////////////////////////////////////////////////////////////////////////////////
@@ -23,6 +23,10 @@
 unsigned long (*fpReadProc[MAPPERSIZE])(unsigned long address,short size);
 // function pointer array to WRITE() procs of plugins
 void (*fpWriteProc[MAPPERSIZE])(unsigned long address,long data,short size);
+// page belongs to a cacheable module (RAM/ROM), opcodes may be cached
+BYTE bCacheablePage[MAPPERSIZE];
+// page holds cached opcodes, writes must invalidate them
+BYTE bCodePage[MAPPERSIZE];
 
 ////////////////////////////////////////////////////////////////////////////////
 // NAME:				int CheckPeriAddr(unsigned long address)
@@ -69,6 +73,7 @@ short i,index;
 			// fill in function pointer arrays
 			fpReadProc[i]=(void*)pDllHdr[index]->ReadProc;
 			fpWriteProc[i]=(void*)pDllHdr[index]->WriteProc;
+			bCacheablePage[i]=(BYTE)pDllHdr[index]->bCacheable;
 		}
 		// no module there
 		else
@@ -76,8 +81,11 @@ short i,index;
 			// no address
 			fpReadProc[i]=NULL;
 			fpWriteProc[i]=NULL;
+			bCacheablePage[i]=FALSE;
 		}
 	}
+	// the map changed, forget all cached opcodes
+	FlushICache();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -164,6 +172,8 @@ void _fastcall PUTbyte(unsigned long address,char data)
 	address&=0x00FFFFFFL;
 	if(fpWriteProc[address>>10]) // (address)/1024=entry in table
 	{
+		// self modifying code?
+		if(bCodePage[address>>10])InvalidateCodePage(address);
 		fpWriteProc[address>>10](address,data,0);
 	}
 	else bus_err(); // stepped into memory hole?
@@ -186,6 +196,9 @@ void _fastcall PUTword(unsigned long address,short data)
 	address&=0x00FFFFFFL;
 	if(fpWriteProc[address>>10]) // (address)/1024=entry in table
 	{
+		// self modifying code? (word may straddle two pages)
+		if(bCodePage[address>>10])InvalidateCodePage(address);
+		if(bCodePage[((address+1)&0x00FFFFFFL)>>10])InvalidateCodePage(address+1);
 		fpWriteProc[address>>10](address,data,1);
 	}
 	else bus_err(); // sorry, mister!!
@@ -207,6 +220,9 @@ void _fastcall PUTdword(unsigned long address,long data)
 	address&=0x00FFFFFFL;
 	if(fpWriteProc[address>>10]) // (address)/1024=entry in table
 	{
+		// self modifying code? (dword may straddle two pages)
+		if(bCodePage[address>>10])InvalidateCodePage(address);
+		if(bCodePage[((address+3)&0x00FFFFFFL)>>10])InvalidateCodePage(address+3);
 		fpWriteProc[address>>10](address,data,2);
 	}
 	else bus_err(); // all the same, end of game
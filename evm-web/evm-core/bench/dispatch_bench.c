@@ -0,0 +1,259 @@
+/*
+ * dispatch_bench.c
+ *
+ * Opcode dispatch benchmark: compact OperationIndex[]/OperationHandlers[]
+ * tables (sttable.c) against the flat 65536 entry handler and cycle tables
+ * they replaced.
+ *
+ * Replays the dispatch lookups (handler + base cycles) of two opcode
+ * streams through both layouts: the opcodes a ROM image executes from
+ * reset, and every word of the memory the image fills, in address order
+ * (the working set the instruction cache fills over the whole ROM). Reported per stream:
+ *   - footprint: distinct 64 byte lines the lookups touch (cold misses)
+ *   - misses in a modelled 8-way LRU data cache of the given size (the
+ *     lookups are counted in software, not with hardware counters)
+ *   - host time per lookup, measured
+ *
+ * Build and run from evm-core (native):
+ *   cc -O2 -Iinclude -o dispatch_bench bench/dispatch_bench.c \
+ *      src/simulator*.c src/cpu_core_new.c src/cpu_cycles.c src/cpu_icache.c \
+ *      src/cpu_translate.c src/cpu_instructions.c src/exception_handlers.c \
+ *      src/steacalc.c src/stmem.c src/sttable.c
+ *
+ * Usage: dispatch_bench [image.s19] [instructions] [cache KB]
+ *        (defaults: PS20.S19 at the top of the source tree for CMake
+ *        builds, else ../../PS20.S19; 2000000; 32)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simulator.h"
+#include "simulator_internal.h"
+
+/* CMake passes the ROM in the source tree */
+#ifndef EVM_DEFAULT_ROM
+#define EVM_DEFAULT_ROM "../../PS20.S19"
+#endif
+
+#define LINE_SHIFT 6
+#define CACHE_WAYS 8
+
+/* ============================================================================
+ * Host bindings (wasm/bindings.c in the web build)
+ * ============================================================================ */
+
+uint8_t cpu_read_byte(uint32_t addr) { return simulator_read_memory(simulator_get_current(), addr, 1); }
+uint16_t cpu_read_word(uint32_t addr) { return simulator_read_memory(simulator_get_current(), addr, 2); }
+uint32_t cpu_read_dword(uint32_t addr) { return simulator_read_memory(simulator_get_current(), addr, 4); }
+void cpu_write_byte(uint32_t addr, uint8_t value) { simulator_write_memory(simulator_get_current(), addr, value, 1); }
+void cpu_write_word(uint32_t addr, uint16_t value) { simulator_write_memory(simulator_get_current(), addr, value, 2); }
+void cpu_write_dword(uint32_t addr, uint32_t value) { simulator_write_memory(simulator_get_current(), addr, value, 4); }
+
+/* ============================================================================
+ * Trace recording
+ * ============================================================================ */
+
+/* Opcode words of the image itself (every even address it fills) */
+static uint16_t *image_words;
+static long num_image_words;
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* Load an S-record file with the core's loader, then read the words of the
+   segments its memory image lists (layout in simulator_image.c) back from
+   memory */
+static int load_s19(simulator_t *sim, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    simulator_srec_t *srec;
+    char chunk[4096];
+    size_t n, len = 0;
+    uint8_t *image;
+    int rc = 0;
+
+    if (!f) return -1;
+    srec = simulator_srec_begin(sim);
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        simulator_srec_feed(srec, chunk, n);
+    }
+    fclose(f);
+    image = simulator_srec_image(srec, &len);
+    if (simulator_srec_end(srec, NULL) != 0 || image == NULL) {
+        free(image);
+        return -1;
+    }
+
+    uint32_t count = get_le32(image + 20);
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *seg = image + 24 + 16 * i;
+        uint32_t addr = get_le32(seg), size = get_le32(seg + 4);
+        uint8_t *bytes = malloc(size);
+        uint16_t *words = realloc(image_words, (num_image_words + size / 2) * sizeof(*image_words));
+
+        if (bytes == NULL || words == NULL) {
+            free(bytes);
+            rc = -1;
+            break;
+        }
+        image_words = words;
+        simulator_read_block(sim, addr, bytes, size);
+        for (uint32_t j = addr & 1; j + 1 < size; j += 2) {
+            image_words[num_image_words++] = (uint16_t)((bytes[j] << 8) | bytes[j + 1]);
+        }
+        free(bytes);
+    }
+    free(image);
+    return rc;
+}
+
+/* Opcodes executed from reset on */
+static uint16_t *record_trace(const char *path, long count)
+{
+    simulator_t *sim = simulator_init();
+    uint16_t *trace = malloc(count * sizeof(*trace));
+
+    simulator_load_modules(sim);
+    if (load_s19(sim, path) != 0) {
+        fprintf(stderr, "cannot load %s\n", path);
+        exit(1);
+    }
+    simulator_reset(sim);
+
+    for (long i = 0; i < count; i++) {
+        trace[i] = (uint16_t)cpu_read_word(simulator_get_state(sim)->pc);
+        simulator_run_batch(sim, 1, SIM_STOP_NONE);
+    }
+    simulator_destroy(sim);
+    return trace;
+}
+
+/* ============================================================================
+ * Data cache model
+ * ============================================================================ */
+
+typedef struct {
+    int sets;
+    uintptr_t *tags;                /* sets * CACHE_WAYS, most recent first */
+    long accesses;
+    long misses;
+} cache_t;
+
+static void cache_init(cache_t *c, int kbytes)
+{
+    c->sets = (kbytes * 1024 >> LINE_SHIFT) / CACHE_WAYS;
+    c->tags = calloc(c->sets * CACHE_WAYS, sizeof(*c->tags));
+    c->accesses = c->misses = 0;
+}
+
+static void cache_access(cache_t *c, const void *p)
+{
+    uintptr_t line = ((uintptr_t)p >> LINE_SHIFT) + 1;
+    uintptr_t *set = &c->tags[(line % c->sets) * CACHE_WAYS];
+    int way;
+
+    c->accesses++;
+    for (way = 0; way < CACHE_WAYS - 1 && set[way] != line; way++);
+    if (set[way] != line) c->misses++;
+    memmove(&set[1], &set[0], way * sizeof(*set));
+    set[0] = line;
+}
+
+/* ============================================================================
+ * Benchmark
+ * ============================================================================ */
+
+static opcode_handler_t FlatHandlers[65536];
+static uint8_t FlatCycles[65536];
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Replay the dispatch lookups of a trace through both layouts */
+static void run(const char *name, const uint16_t *trace, long count, int kbytes)
+{
+    cache_t flat, compact, flat_cold, compact_cold;
+    volatile uintptr_t sink;
+    uintptr_t sum = 0;
+    double t0, t_flat, t_compact;
+
+    // Cache model, the 16MB cache never evicts and counts distinct lines
+    cache_init(&flat, kbytes);
+    cache_init(&compact, kbytes);
+    cache_init(&flat_cold, 16384);
+    cache_init(&compact_cold, 16384);
+    for (long i = 0; i < count; i++) {
+        uint16_t op = trace[i];
+        uint8_t h = OperationIndex[op];
+
+        cache_access(&flat, &FlatHandlers[op]);
+        cache_access(&flat, &FlatCycles[op]);
+        cache_access(&flat_cold, &FlatHandlers[op]);
+        cache_access(&flat_cold, &FlatCycles[op]);
+
+        cache_access(&compact, &OperationIndex[op]);
+        cache_access(&compact, &OperationHandlers[h]);
+        cache_access(&compact, &OperationHandlerCycles[h]);
+        cache_access(&compact_cold, &OperationIndex[op]);
+        cache_access(&compact_cold, &OperationHandlers[h]);
+        cache_access(&compact_cold, &OperationHandlerCycles[h]);
+    }
+
+    // Host lookup time
+    t0 = now();
+    for (long i = 0; i < count; i++) {
+        sum += (uintptr_t)FlatHandlers[trace[i]] + FlatCycles[trace[i]];
+    }
+    t_flat = (now() - t0) / count;
+    t0 = now();
+    for (long i = 0; i < count; i++) {
+        uint8_t h = OperationIndex[trace[i]];
+        sum += (uintptr_t)OperationHandlers[h] + OperationHandlerCycles[h];
+    }
+    t_compact = (now() - t0) / count;
+    sink = sum;
+    (void)sink;
+
+    printf("%s: %ld opcodes\n", name, count);
+    printf("  footprint         flat %6ld lines   compact %6ld lines\n", flat_cold.misses, compact_cold.misses);
+    printf("  modelled %3dKB    flat %6ld misses  compact %6ld misses\n", kbytes, flat.misses, compact.misses);
+    printf("  lookup (measured) flat %6.2f ns     compact %6.2f ns\n", t_flat * 1e9, t_compact * 1e9);
+    free(flat.tags);
+    free(compact.tags);
+    free(flat_cold.tags);
+    free(compact_cold.tags);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : EVM_DEFAULT_ROM;
+    long count = argc > 2 ? atol(argv[2]) : 2000000;
+    int kbytes = argc > 3 ? atoi(argv[3]) : 32;
+    uint16_t *trace = record_trace(path, count);
+
+    // Flat tables as sttable.c and cpu_cycles.c used to lay them out
+    for (long op = 0; op < 65536; op++) {
+        FlatHandlers[op] = cpu_decode_handler(op);
+        FlatCycles[op] = cpu_opcode_cycles(op);
+    }
+
+    printf("%s\n", path);
+    printf("tables: flat %zu bytes, compact %zu bytes (%d handlers)\n",
+           sizeof(FlatHandlers) + sizeof(FlatCycles),
+           sizeof(OperationIndex) + OperationHandlerCount * (sizeof(opcode_handler_t) + 1),
+           OperationHandlerCount);
+    run("executed", trace, count, kbytes);
+    run("image", image_words, num_image_words, kbytes);
+
+    free(trace);
+    free(image_words);
+    return 0;
+}
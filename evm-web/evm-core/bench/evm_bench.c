@@ -0,0 +1,738 @@
+/*
+ * evm_bench.c
+ *
+ * Benchmark suite for the interpreter hot paths. One JSON object per line
+ * on stdout, so runs can be stored per commit and compared:
+ *
+ *   {"bench":"ea.aripi","value":2.31,"unit":"ns","n":4000000}
+ *
+ * Micro-benchmarks, host time per operation (unit "ns", lower is better):
+ *   decode.*    opcode dispatch lookups (OperationIndex[]/OperationHandlers[])
+ *   dispatch.*  guest instructions through simulator_run_batch()
+ *   ea.*        the steacalc.c addressing mode functions, long reads
+ *   mem.*       GETword()/GETdword() on ROM, RAM and I/O pages
+ *   flags.*     the lazy condition code helpers (STFLAGS.H)
+ *
+ * Macro-benchmarks, guest throughput (unit "MIPS", higher is better):
+ *   boot.ps20     PS20 ROM from reset until the monitor prints READY, or
+ *                 the instruction budget ends ("prompt" tells which)
+ *   guest.memcpy  byte copy of 4KB, 100 times
+ *   guest.crc8    table driven CRC-8 over 4KB, 64 times
+ *   guest.sort    bubble sort of 64 longs, 100 times
+ * The guest programs check their results ("ok").
+ *
+ * Every benchmark reports the best of several repetitions.
+ *
+ * Built by CMake (native builds), or from evm-core:
+ *   cc -O2 -pthread -Iinclude -o evm_bench bench/evm_bench.c tools/evm_tool.c \
+ *      src/simulator*.c src/cpu_core_new.c src/cpu_cycles.c src/cpu_icache.c \
+ *      src/cpu_translate.c src/cpu_instructions.c src/exception_handlers.c \
+ *      src/steacalc.c src/stmem.c src/sttable.c
+ *
+ * Usage: evm_bench [-f filter] [-r rom.s19] [-n boot instructions]
+ *                  [-R revision] [-c baseline.jsonl] [-t percent]
+ *   -f  only run benchmarks whose name contains filter
+ *   -r  ROM for boot.ps20 (default: PS20.S19 at the top of the source tree
+ *       for CMake builds, else ../../PS20.S19)
+ *   -n  instruction budget of boot.ps20 (default: 2000000)
+ *   -R  revision recorded in the header line, e.g. $(git rev-parse HEAD)
+ *   -c  compare against an earlier output, report changes on stderr
+ *   -t  regression threshold for -c in percent (default: 10)
+ *
+ * A benchmark that cannot run (boot.ps20 without its ROM) writes an error
+ * record instead, {"bench":"boot.ps20","error":"..."}, and fails the run.
+ *
+ * Exit status: 0, or 1 if a benchmark could not run, a guest program failed
+ * its check or -c found a regression beyond the threshold.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "simulator.h"
+#include "simulator_internal.h"
+#include "STSTDDEF.H"
+#include "STFLAGS.H"
+#include "STMEM.H"
+#include "STEACALC.H"
+#include "../tools/evm_tool.h"
+
+/* CMake passes the ROM in the source tree */
+#ifndef EVM_DEFAULT_ROM
+#define EVM_DEFAULT_ROM "../../PS20.S19"
+#endif
+
+#define REPEATS         5           /* Repetitions per benchmark, best counts */
+#define MIN_TIME        0.02        /* Seconds per micro-benchmark repetition */
+
+#define GUEST_CODE      0x000100    /* Guest programs (ROM) */
+#define GUEST_DATA      0x401000    /* 4KB guest data (RAM) */
+#define GUEST_AUX       0x402000    /* CRC table, unsorted copy (RAM) */
+#define GUEST_DST       0x403000    /* memcpy destination (RAM) */
+#define EXT_WORDS       0x404000    /* Extension words for the EA benchmarks */
+
+static const char *filter;
+static int failed;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int selected(const char *name)
+{
+    return filter == NULL || strstr(name, filter) != NULL;
+}
+
+/* ============================================================================
+ * Baseline comparison (-c)
+ * ============================================================================ */
+
+typedef struct {
+    char name[64];
+    double value;
+} baseline_t;
+
+static baseline_t *baseline;
+static int num_baseline;
+static double threshold = 10.0;
+static int regressions;
+
+static void read_baseline(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[512];
+
+    if (f == NULL) {
+        perror(path);
+        exit(2);
+    }
+    while (fgets(line, sizeof(line), f)) {
+        char *name = strstr(line, "\"bench\":\"");
+        char *value = strstr(line, "\"value\":");
+        if (name == NULL || value == NULL) continue;
+
+        baseline = realloc(baseline, (num_baseline + 1) * sizeof(*baseline));
+        sscanf(name + 9, "%63[^\"]", baseline[num_baseline].name);
+        baseline[num_baseline].value = strtod(value + 8, NULL);
+        num_baseline++;
+    }
+    fclose(f);
+}
+
+static void compare(const char *name, double value, int higher_is_better)
+{
+    for (int i = 0; i < num_baseline; i++) {
+        if (strcmp(baseline[i].name, name) != 0 || baseline[i].value <= 0) continue;
+
+        double change = (value / baseline[i].value - 1.0) * 100.0;
+        double loss = higher_is_better ? -change : change;
+        int regressed = loss > threshold;
+
+        fprintf(stderr, "%-20s %10.4g -> %10.4g  %+6.1f%%%s\n", name, baseline[i].value, value,
+                change, regressed ? "  REGRESSION" : "");
+        regressions += regressed;
+        return;
+    }
+}
+
+/* ============================================================================
+ * Reporting
+ * ============================================================================ */
+
+static void report_micro(const char *name, double ns, long n)
+{
+    printf("{\"bench\":\"%s\",\"value\":%.4g,\"unit\":\"ns\",\"n\":%ld}\n", name, ns, n);
+    fflush(stdout);
+    compare(name, ns, 0);
+}
+
+static void report_macro(const char *name, double mips, uint64_t insns, const char *extra)
+{
+    printf("{\"bench\":\"%s\",\"value\":%.4g,\"unit\":\"MIPS\",\"insns\":%llu%s}\n",
+           name, mips, (unsigned long long)insns, extra);
+    fflush(stdout);
+    compare(name, mips, 1);
+}
+
+/* A benchmark that could not run; message and path go to stderr as well */
+static void report_error(const char *name, const char *message, const char *path)
+{
+    printf("{\"bench\":\"%s\",\"error\":\"%s\"}\n", name, message);
+    fflush(stdout);
+    fprintf(stderr, "%s: %s %s\n", name, message, path);
+    failed = 1;
+}
+
+/* Best ns per operation of fn(n) */
+static void run_micro(const char *name, void (*fn)(long n))
+{
+    double best = 1e30, t;
+    long n = 1000;
+
+    if (!selected(name)) return;
+
+    // Grow n until one repetition takes MIN_TIME
+    for (;;) {
+        t = now();
+        fn(n);
+        t = now() - t;
+        if (t >= MIN_TIME) break;
+        n *= (t > MIN_TIME / 10) ? 2 : 10;
+    }
+    for (int r = 0; r < REPEATS; r++) {
+        t = now();
+        fn(n);
+        t = now() - t;
+        if (t < best) best = t;
+    }
+    report_micro(name, best / n * 1e9, n);
+}
+
+/* Core diagnostics (bus errors) cost more than the code being measured */
+static int saved_stderr = -1;
+
+static void quiet(int on)
+{
+    if (on) {
+        int null = open("/dev/null", O_WRONLY);
+        fflush(stderr);
+        saved_stderr = dup(STDERR_FILENO);
+        dup2(null, STDERR_FILENO);
+        close(null);
+    } else if (saved_stderr >= 0) {
+        dup2(saved_stderr, STDERR_FILENO);
+        close(saved_stderr);
+        saved_stderr = -1;
+    }
+}
+
+/* ============================================================================
+ * Guest setup
+ * ============================================================================ */
+
+static simulator_t *new_simulator(void)
+{
+    simulator_t *sim = simulator_init();
+
+    if (sim == NULL || simulator_load_modules(sim) != 0) {
+        fprintf(stderr, "simulator setup failed\n");
+        exit(2);
+    }
+    return sim;
+}
+
+/* Reset vectors (SSP 0x410000, PC GUEST_CODE) and program at GUEST_CODE */
+static void load_code(simulator_t *sim, const uint16_t *code, size_t words)
+{
+    static const uint8_t vectors[8] = { 0x00, 0x41, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00 };
+    uint8_t bytes[512];
+
+    for (size_t i = 0; i < words; i++) {
+        bytes[2 * i] = (uint8_t)(code[i] >> 8);
+        bytes[2 * i + 1] = (uint8_t)code[i];
+    }
+    simulator_load_program(sim, vectors, sizeof(vectors), 0);
+    simulator_load_program(sim, bytes, 2 * words, GUEST_CODE);
+}
+
+static void write_long(simulator_t *sim, uint32_t addr, uint32_t value)
+{
+    simulator_write_memory(sim, addr, value, 4);
+}
+
+static uint32_t read_long(simulator_t *sim, uint32_t addr)
+{
+    return simulator_read_memory(sim, addr, 4);
+}
+
+/* ============================================================================
+ * Micro: opcode dispatch
+ * ============================================================================ */
+
+static volatile uintptr_t sink;
+
+static void bench_decode(long n)
+{
+    uintptr_t sum = 0;
+    uint16_t op = 0;
+
+    for (long i = 0; i < n; i++) {
+        sum += (uintptr_t)cpu_decode_handler(op) + cpu_opcode_cycles(op);
+        op += 40503;                /* Odd step, visits every opcode */
+    }
+    sink = sum;
+}
+
+/* 60 NOPs and a branch back, forever */
+static const uint16_t NopLoop[] = {
+#define NOPS10 0x4E71, 0x4E71, 0x4E71, 0x4E71, 0x4E71, 0x4E71, 0x4E71, 0x4E71, 0x4E71, 0x4E71
+    NOPS10, NOPS10, NOPS10, NOPS10, NOPS10, NOPS10,     /* loop: nop x 60 */
+#undef NOPS10
+    0x6086,                         /*       bra.s   loop */
+};
+
+static simulator_t *nop_sim;
+
+static void bench_dispatch_nop(long n)
+{
+    simulator_run_batch(nop_sim, (uint32_t)n, SIM_STOP_NONE);
+}
+
+/* ============================================================================
+ * Micro: addressing modes (steacalc.c)
+ *
+ * Every call reads a long with a0 = d0 = 0x10 and the extension words at
+ * EXT_WORDS, so each mode resolves to an address in RAM.
+ * ============================================================================ */
+
+typedef long (*ea_fn)(char, char, long, char);
+
+static ea_fn ea_mode;
+static char ea_reg;
+
+static void bench_ea(long n)
+{
+    uintptr_t sum = 0;
+
+    for (long i = 0; i < n; i++) {
+        REGS.pc = EXT_WORDS;
+        REGS.aregs.a[0] = GUEST_DATA + 0x10;
+        sum += ea_mode(ea_reg, READ, 0L, SIZE_DWORD);
+    }
+    sink = sum;
+}
+
+static void run_ea(const char *name, ea_fn mode, int reg)
+{
+    ea_mode = mode;
+    ea_reg = (char)reg;
+    run_micro(name, bench_ea);
+}
+
+/* ============================================================================
+ * Micro: memory access (stmem.c)
+ * ============================================================================ */
+
+/* Reads walk 32 bytes from mem_addr, inside the PIT register window for I/O */
+static uint32_t mem_addr;
+
+static void bench_getword(long n)
+{
+    uintptr_t sum = 0;
+
+    for (long i = 0; i < n; i++) {
+        sum += GETword(mem_addr + (i & 0x1E));
+    }
+    sink = sum;
+}
+
+static void bench_getdword(long n)
+{
+    uintptr_t sum = 0;
+
+    for (long i = 0; i < n; i++) {
+        sum += GETdword(mem_addr + (i & 0x1C));
+    }
+    sink = sum;
+}
+
+/* ============================================================================
+ * Micro: condition codes (STFLAGS.H)
+ * ============================================================================ */
+
+/* Flag update plus the condition test a following Bcc does */
+static void bench_flags_setnz(long n)
+{
+    uintptr_t sum = 0;
+
+    for (long i = 0; i < n; i++) {
+        SETNZ(i - 1000);
+        sum += GETCCR();
+    }
+    sink = sum;
+}
+
+/* Whole-SR round trip (MOVE from SR, exception frames) */
+static void bench_flags_sync(long n)
+{
+    for (long i = 0; i < n; i++) {
+        CCR.c = (char)(i & 1);
+        ccr_sync();
+        REGS.sregs.sr ^= 0x04;
+        ccr_load();
+    }
+    sink = REGS.sregs.sr;
+}
+
+static void bench_flags_carry(long n)
+{
+    uintptr_t sum = 0;
+
+    for (long i = 0; i < n; i++) {
+        unsigned long x = (unsigned long)i * 0x9E3779B1UL;
+        long s = (long)x, d = (long)(x << 3), r = (long)(x + (x >> 7));
+        sum += gen_carry(s, d, r) + gen_over(s, d, r);
+    }
+    sink = sum;
+}
+
+/* ============================================================================
+ * Macro: guest programs
+ *
+ * MOVE, ADDQ/SUBQ, DBcc and the shifts are still stubs in the core, so the
+ * programs load with MOVEQ+OR, store with CLR+OR and count with SUB. The
+ * ALU read-modify-write handlers evaluate (An)+ twice, so stores step the
+ * pointer with LEA instead. CMP sets C and V with the ADD formulas
+ * (gen_carry()/gen_over()), so only Z and N are tested.
+ * ============================================================================ */
+
+/* Copy 4KB GUEST_DATA -> GUEST_DST byte by byte, 100 times */
+static const uint16_t Memcpy[] = {
+    0x7C01,                         /*       moveq   #1,d6 */
+    0x7A64,                         /*       moveq   #100,d5 */
+    0x41F9, 0x0040, 0x1000,         /* outer lea     GUEST_DATA,a0 */
+    0x43F9, 0x0040, 0x3000,         /*       lea     GUEST_DST,a1 */
+    0x7840,                         /*       moveq   #64,d4 */
+    0xC8C4,                         /*       mulu.w  d4,d4 */
+    0x7000,                         /* inner moveq   #0,d0 */
+    0x8018,                         /*       or.b    (a0)+,d0 */
+    0x4211,                         /*       clr.b   (a1) */
+    0x8111,                         /*       or.b    d0,(a1) */
+    0x43E9, 0x0001,                 /*       lea     1(a1),a1 */
+    0x9886,                         /*       sub.l   d6,d4 */
+    0x66F0,                         /*       bne.s   inner */
+    0x9A86,                         /*       sub.l   d6,d5 */
+    0x66DC,                         /*       bne.s   outer */
+    0x4E72, 0x2700,                 /*       stop    #$2700 */
+};
+
+/* CRC-8 (poly 0x07) of GUEST_DATA into d1, table at GUEST_AUX, 64 times */
+static const uint16_t Crc8[] = {
+    0x7C01,                         /*       moveq   #1,d6 */
+    0x7A40,                         /*       moveq   #64,d5 */
+    0x41F9, 0x0040, 0x1000,         /* outer lea     GUEST_DATA,a0 */
+    0x45F9, 0x0040, 0x2000,         /*       lea     GUEST_AUX,a2 */
+    0x7840,                         /*       moveq   #64,d4 */
+    0xC8C4,                         /*       mulu.w  d4,d4 */
+    0x7200,                         /*       moveq   #0,d1 */
+    0x7000,                         /* inner moveq   #0,d0 */
+    0x8018,                         /*       or.b    (a0)+,d0 */
+    0xB300,                         /*       eor.b   d1,d0 */
+    0x7200,                         /*       moveq   #0,d1 */
+    0x8232, 0x0000,                 /*       or.b    0(a2,d0.w),d1 */
+    0x9886,                         /*       sub.l   d6,d4 */
+    0x66F0,                         /*       bne.s   inner */
+    0x9A86,                         /*       sub.l   d6,d5 */
+    0x66DA,                         /*       bne.s   outer */
+    0x4E72, 0x2700,                 /*       stop    #$2700 */
+};
+
+/* Copy 64 longs GUEST_AUX -> GUEST_DATA and bubble sort them, 100 times.
+   The values have 30 bits, so the compare never overflows and N alone
+   orders them */
+static const uint16_t Sort[] = {
+    0x7C01,                         /*       moveq   #1,d6 */
+    0x7A64,                         /*       moveq   #100,d5 */
+    0x41F9, 0x0040, 0x2000,         /* outer lea     GUEST_AUX,a0 */
+    0x43F9, 0x0040, 0x1000,         /*       lea     GUEST_DATA,a1 */
+    0x7840,                         /*       moveq   #64,d4 */
+    0x7000,                         /* copy  moveq   #0,d0 */
+    0x8098,                         /*       or.l    (a0)+,d0 */
+    0x4291,                         /*       clr.l   (a1) */
+    0x8191,                         /*       or.l    d0,(a1) */
+    0x43E9, 0x0004,                 /*       lea     4(a1),a1 */
+    0x9886,                         /*       sub.l   d6,d4 */
+    0x66F0,                         /*       bne.s   copy */
+    0x763F,                         /*       moveq   #63,d3 */
+    0x41F9, 0x0040, 0x1000,         /* pass  lea     GUEST_DATA,a0 */
+    0x7400,                         /*       moveq   #0,d2 */
+    0x8483,                         /*       or.l    d3,d2 */
+    0x7000,                         /* inner moveq   #0,d0 */
+    0x8098,                         /*       or.l    (a0)+,d0 */
+    0x7200,                         /*       moveq   #0,d1 */
+    0x8290,                         /*       or.l    (a0),d1 */
+    0xB280,                         /*       cmp.l   d0,d1 */
+    0x6A0C,                         /*       bpl.s   next */
+    0x4290,                         /*       clr.l   (a0) */
+    0x8190,                         /*       or.l    d0,(a0) */
+    0x42A8, 0xFFFC,                 /*       clr.l   -4(a0) */
+    0x83A8, 0xFFFC,                 /*       or.l    d1,-4(a0) */
+    0x9486,                         /* next  sub.l   d6,d2 */
+    0x66E4,                         /*       bne.s   inner */
+    0x9686,                         /*       sub.l   d6,d3 */
+    0x66D6,                         /*       bne.s   pass */
+    0x9A86,                         /*       sub.l   d6,d5 */
+    0x66B2,                         /*       bne.s   outer */
+    0x4E72, 0x2700,                 /*       stop    #$2700 */
+};
+
+static uint8_t guest_bytes[4096];
+static uint8_t crc_table[256];
+static uint32_t sort_input[64];
+
+static void make_guest_data(void)
+{
+    uint32_t x = 12345;
+
+    for (int i = 0; i < 4096; i++) {
+        x = x * 1103515245 + 12345;
+        guest_bytes[i] = (uint8_t)(x >> 16);
+    }
+    for (int i = 0; i < 64; i++) {
+        x = x * 1103515245 + 12345;
+        sort_input[i] = (x ^ (x >> 13)) & 0x3FFFFFFF;
+    }
+    for (int i = 0; i < 256; i++) {
+        uint8_t c = (uint8_t)i;
+        for (int b = 0; b < 8; b++) {
+            c = (uint8_t)((c & 0x80) ? (c << 1) ^ 0x07 : c << 1);
+        }
+        crc_table[i] = c;
+    }
+}
+
+static int check_memcpy(simulator_t *sim)
+{
+    for (int i = 0; i < 4096; i++) {
+        if (simulator_read_memory(sim, GUEST_DST + i, 1) != guest_bytes[i]) return 0;
+    }
+    return 1;
+}
+
+static int check_crc8(simulator_t *sim)
+{
+    uint8_t crc = 0;
+
+    for (int i = 0; i < 4096; i++) {
+        crc = crc_table[crc ^ guest_bytes[i]];
+    }
+    return (simulator_get_state(sim)->dregs.d[1] & 0xFF) == crc;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int check_sort(simulator_t *sim)
+{
+    uint32_t sorted[64];
+
+    memcpy(sorted, sort_input, sizeof(sorted));
+    qsort(sorted, 64, sizeof(sorted[0]), compare_u32);
+    for (int i = 0; i < 64; i++) {
+        if (read_long(sim, GUEST_DATA + 4 * i) != sorted[i]) return 0;
+    }
+    return 1;
+}
+
+/* Guest data, RAM is cleared on reset */
+static void load_guest_data(simulator_t *sim, const uint16_t *code)
+{
+    simulator_load_program(sim, guest_bytes, sizeof(guest_bytes), GUEST_DATA);
+    if (code == Crc8) {
+        simulator_load_program(sim, crc_table, sizeof(crc_table), GUEST_AUX);
+    } else if (code == Sort) {
+        for (int i = 0; i < 64; i++) write_long(sim, GUEST_AUX + 4 * i, sort_input[i]);
+    }
+}
+
+static void run_guest(const char *name, const uint16_t *code, size_t words,
+                      int (*check)(simulator_t *))
+{
+    simulator_t *sim;
+    double best = 1e30;
+    uint64_t insns = 0;
+    int ok = 1;
+
+    if (!selected(name)) return;
+
+    sim = new_simulator();
+    load_code(sim, code, words);
+
+    quiet(1);
+    for (int r = 0; r < REPEATS; r++) {
+        simulator_reset(sim);
+        load_guest_data(sim, code);
+
+        double t = now();
+        insns = 0;
+        do {
+            insns += simulator_run_batch(sim, 1u << 24, SIM_STOP_ON_STOP);
+        } while (simulator_get_stop_reason(sim) != SIM_STOPPED_STOP && insns < (1u << 28));
+        t = now() - t;
+        if (t < best) best = t;
+        ok &= check(sim);
+    }
+    quiet(0);
+
+    report_macro(name, insns / best / 1e6, insns, ok ? ",\"ok\":true" : ",\"ok\":false");
+    if (!ok) {
+        fprintf(stderr, "%s: wrong result\n", name);
+        failed = 1;
+    }
+    simulator_destroy(sim);
+}
+
+/* ============================================================================
+ * Macro: PS20 boot
+ * ============================================================================ */
+
+static const char Prompt[] = "READY";
+static char boot_output[4096];
+static size_t boot_len;
+static int boot_prompt;
+
+static void boot_uart_tx(void *user, int channel, uint8_t data)
+{
+    (void)user;
+    if (channel != SIM_UART_A || boot_prompt) return;
+    if (boot_len == sizeof(boot_output) - 1) boot_len = 0;
+    boot_output[boot_len++] = (char)data;
+    boot_output[boot_len] = '\0';
+    if (strstr(boot_output, Prompt)) {
+        boot_prompt = 1;
+        simulator_pause(simulator_get_current());
+    }
+}
+
+static void run_boot(const char *rom, uint64_t budget)
+{
+    const char *name = "boot.ps20";
+    simulator_t *sim;
+    double best = 1e30;
+    uint64_t insns = 0;
+    char extra[64];
+    FILE *f;
+
+    if (!selected(name)) return;
+
+    sim = new_simulator();
+    f = fopen(rom, "rb");
+    if (f == NULL || tool_load_srec(sim, f, NULL) != 0) {
+        report_error(name, f == NULL ? "cannot open" : "bad S-record file", rom);
+        if (f) fclose(f);
+        simulator_destroy(sim);
+        return;
+    }
+    fclose(f);
+    simulator_set_uart_tx(sim, boot_uart_tx, NULL);
+
+    quiet(1);
+    for (int r = 0; r < 3; r++) {
+        double t = now();
+        simulator_reset(sim);
+        boot_len = 0;
+        boot_prompt = 0;
+        for (insns = 0; insns < budget && !boot_prompt; ) {
+            uint64_t left = budget - insns;
+            insns += simulator_run_batch(sim, left < (1u << 20) ? (uint32_t)left : (1u << 20), SIM_STOP_NONE);
+        }
+        t = now() - t;
+        if (t < best) best = t;
+    }
+    quiet(0);
+
+    snprintf(extra, sizeof(extra), ",\"prompt\":%s", boot_prompt ? "true" : "false");
+    report_macro(name, insns / best / 1e6, insns, extra);
+    simulator_destroy(sim);
+}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+
+int main(int argc, char **argv)
+{
+    const char *rom = EVM_DEFAULT_ROM;
+    const char *revision = "unknown";
+    uint64_t boot_budget = 2000000;
+    simulator_t *sim;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:r:n:R:c:t:")) != -1) {
+        switch (opt) {
+        case 'f': filter = optarg; break;
+        case 'r': rom = optarg; break;
+        case 'n': boot_budget = strtoull(optarg, NULL, 0); break;
+        case 'R': revision = optarg; break;
+        case 'c': read_baseline(optarg); break;
+        case 't': threshold = atof(optarg); break;
+        default:
+            fprintf(stderr, "usage: evm_bench [-f filter] [-r rom.s19] [-n boot instructions]\n"
+                            "                 [-R revision] [-c baseline.jsonl] [-t percent]\n");
+            return 2;
+        }
+    }
+    printf("{\"suite\":\"evm_bench\",\"revision\":\"%s\",\"time\":%lld}\n", revision, (long long)time(NULL));
+    make_guest_data();
+
+    // Micro-benchmarks share one simulator: ROM, RAM and the PIT are mapped,
+    // the EA extension words and d0 select GUEST_DATA + 0x10 in every mode
+    sim = new_simulator();
+    load_code(sim, NopLoop, sizeof(NopLoop) / sizeof(NopLoop[0]));
+    quiet(1);
+    simulator_reset(sim);
+    quiet(0);
+    simulator_load_program(sim, guest_bytes, sizeof(guest_bytes), GUEST_DATA);
+    nop_sim = sim;
+
+    run_micro("decode.lookup", bench_decode);
+    run_micro("dispatch.nop", bench_dispatch_nop);
+
+    cpu_set_current_simulator(sim);
+    REGS.dregs.d[0] = 0x10;
+    simulator_write_memory(sim, EXT_WORDS, 0x0010, 2);     /* (d16,An) */
+    run_ea("ea.drd", DRD, 0);
+    run_ea("ea.ard", ARD, 0);
+    run_ea("ea.ari", ARI, 0);
+    run_ea("ea.aripi", ARIPI, 0);
+    run_ea("ea.aripd", ARIPD, 0);
+    run_ea("ea.arid", ARID, 0);
+    simulator_write_memory(sim, EXT_WORDS, 0x0000, 2);     /* (0,An,d0.w) */
+    run_ea("ea.arii", ARII, 0);
+    simulator_write_memory(sim, EXT_WORDS, 0x1010, 2);     /* abs.w 0x1010 (ROM) */
+    run_ea("ea.absw", MISC, 0);
+    write_long(sim, EXT_WORDS, GUEST_DATA + 0x10);          /* abs.l */
+    run_ea("ea.absl", MISC, 1);
+    simulator_write_memory(sim, EXT_WORDS, 0x0010, 2);     /* (d16,PC) */
+    run_ea("ea.pcd", MISC, 2);
+    run_ea("ea.imm", MISC, 4);
+
+    static const struct { const char *region; uint32_t addr; } regions[] = {
+        { "rom", 0x001000 }, { "ram", GUEST_DATA }, { "io", 0x800000 },
+    };
+    for (size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        char name[32];
+
+        mem_addr = regions[i].addr;
+        snprintf(name, sizeof(name), "mem.getword.%s", regions[i].region);
+        run_micro(name, bench_getword);
+        snprintf(name, sizeof(name), "mem.getdword.%s", regions[i].region);
+        run_micro(name, bench_getdword);
+    }
+
+    run_micro("flags.setnz", bench_flags_setnz);
+    run_micro("flags.sync", bench_flags_sync);
+    run_micro("flags.carry", bench_flags_carry);
+    simulator_destroy(sim);
+
+    run_boot(rom, boot_budget);
+    run_guest("guest.memcpy", Memcpy, sizeof(Memcpy) / sizeof(Memcpy[0]), check_memcpy);
+    run_guest("guest.crc8", Crc8, sizeof(Crc8) / sizeof(Crc8[0]), check_crc8);
+    run_guest("guest.sort", Sort, sizeof(Sort) / sizeof(Sort[0]), check_sort);
+
+    if (num_baseline) {
+        fprintf(stderr, "%d regression(s) beyond %.0f%%\n", regressions, threshold);
+    }
+    free(baseline);
+    return (failed || regressions) ? 1 : 0;
+}
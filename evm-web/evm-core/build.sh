@@ -31,12 +31,12 @@ cmake --build . --config Release
 # Copy output to web directory
 echo "Copying output files..."
 # Emscripten generates evm.js.js and evm.js.wasm
-cp evm.js.js ../web/public/evm.js
-cp evm.js.wasm ../web/public/evm.js.wasm
+cp evm.js.js ../../web/public/evm.js
+cp evm.js.wasm ../../web/public/evm.js.wasm
 
 # Also keep the paired versions for fallback
-cp evm.js.js ../web/public/evm.js.js 2>/dev/null || true
-cp evm.js.wasm ../web/public/evm.wasm 2>/dev/null || true
+cp evm.js.js ../../web/public/evm.js.js 2>/dev/null || true
+cp evm.js.wasm ../../web/public/evm.wasm 2>/dev/null || true
 
 echo "Build complete!"
 echo "Output files:"
@@ -0,0 +1,151 @@
+/*
+ * cpu_ea.h
+ *
+ * Effective address templates for the register and address register
+ * indirect modes (mode fields 000-101). steacalc.c wraps them into the
+ * CommandMode[] functions; the specialised opcode handlers generated in
+ * cpu_instructions.c call them with constant mode, command and size, so
+ * the switches below fold away and only the access itself is left.
+ * Modes 110 and 111 decode extension words and stay out of line.
+ */
+
+#ifndef __CPU_EA_H__
+#define __CPU_EA_H__
+
+#include "STSTDDEF.H"
+#include "STMEM.H"
+#include "STEACALC.H"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CPU_INLINE static inline __attribute__((always_inline))
+#else
+#define CPU_INLINE static inline
+#endif
+
+/* EA calculation clock cycles (MC68020 cache case) */
+#define EACYCLES_ARI    3       /* (An) */
+#define EACYCLES_ARIPI  4       /* (An)+ */
+#define EACYCLES_ARIPD  3       /* -(An) */
+#define EACYCLES_ARID   3       /* (d16,An) */
+
+/* Data Register Direct (mode field = 000) */
+CPU_INLINE long ea_drd(char reg, char command, long destination, char size)
+{
+    if (command == READ) {
+        switch (size) {
+        case SIZE_BYTE:  return REGS.dregs.byted[(uint8_t)reg].dll;
+        case SIZE_WORD:  return REGS.dregs.wordd[(uint8_t)reg].dl;
+        case SIZE_DWORD: return REGS.dregs.d[(uint8_t)reg];
+        }
+    } else {
+        switch (size) {
+        case SIZE_BYTE:  REGS.dregs.byted[(uint8_t)reg].dll = (char)destination; break;
+        case SIZE_WORD:  REGS.dregs.wordd[(uint8_t)reg].dl = (short)destination; break;
+        case SIZE_DWORD: REGS.dregs.d[(uint8_t)reg] = destination; break;
+        }
+    }
+    return 0;
+}
+
+/* Address Register Direct (mode field = 001) */
+CPU_INLINE long ea_ard(char reg, char command, long destination, char size)
+{
+    if (command == READ) {
+        switch (size) {
+        case SIZE_BYTE:  return REGS.aregs.bytea[(uint8_t)reg].all;
+        case SIZE_WORD:  return REGS.aregs.worda[(uint8_t)reg].al;
+        case SIZE_DWORD: return REGS.aregs.a[(uint8_t)reg];
+        }
+    } else {
+        switch (size) {
+        case SIZE_BYTE:  REGS.aregs.bytea[(uint8_t)reg].all = (char)destination; break;
+        case SIZE_WORD:  REGS.aregs.worda[(uint8_t)reg].al = (short)destination; break;
+        case SIZE_DWORD: REGS.aregs.a[(uint8_t)reg] = destination; break;
+        }
+    }
+    return 0;
+}
+
+/* Sized memory access at addr, the write returns 0 */
+CPU_INLINE long ea_mem(unsigned long addr, char command, long destination, char size)
+{
+    if (command == READ) {
+        switch (size) {
+        case SIZE_BYTE:  return GETbyte(addr);
+        case SIZE_WORD:  return GETword(addr);
+        case SIZE_DWORD: return GETdword(addr);
+        }
+    } else {
+        switch (size) {
+        case SIZE_BYTE:  PUTbyte(addr, (char)destination); break;
+        case SIZE_WORD:  PUTword(addr, (short)destination); break;
+        case SIZE_DWORD: PUTdword(addr, destination); break;
+        }
+    }
+    return 0;
+}
+
+/* Address Register Indirect (mode field = 010) */
+CPU_INLINE long ea_ari(char reg, char command, long destination, char size)
+{
+    REGS.cycles += EACYCLES_ARI;
+    return ea_mem(REGS.aregs.a[(uint8_t)reg], command, destination, size);
+}
+
+/* Address Register Indirect with Post Increment (mode field = 011)
+   Both commands return the operand just behind the incremented register */
+CPU_INLINE long ea_aripi(char reg, char command, long destination, char size)
+{
+    REGS.cycles += EACYCLES_ARIPI;
+    if (command == WRITE) {
+        ea_mem(REGS.aregs.a[(uint8_t)reg], WRITE, destination, size);
+    }
+    REGS.aregs.a[(uint8_t)reg] = REGS.aregs.a[(uint8_t)reg] + (1 << size);
+    return ea_mem(REGS.aregs.a[(uint8_t)reg] - (1 << size), READ, 0L, size);
+}
+
+/* Address Register Indirect with Pre Decrement (mode field = 100)
+   Both commands return the operand at the decremented register */
+CPU_INLINE long ea_aripd(char reg, char command, long destination, char size)
+{
+    REGS.cycles += EACYCLES_ARIPD;
+    if (command == READ) {
+        // Remember the PC: a following write to the same operand must not
+        // decrement again
+        REGS.aregs.a[(uint8_t)reg] = REGS.aregs.a[(uint8_t)reg] - (1 << size);
+        EA_PREDEC_PC = REGS.pc;
+    } else {
+        // Read-modify-write of the same operand: already decremented
+        if (REGS.pc != EA_PREDEC_PC) {
+            REGS.aregs.a[(uint8_t)reg] = REGS.aregs.a[(uint8_t)reg] - (1 << size);
+        }
+        ea_mem(REGS.aregs.a[(uint8_t)reg], WRITE, destination, size);
+    }
+    return ea_mem(REGS.aregs.a[(uint8_t)reg], READ, 0L, size);
+}
+
+/* Address Register Indirect with Displacement (mode field = 101) */
+CPU_INLINE long ea_arid(char reg, char command, long destination, char size)
+{
+    REGS.cycles += EACYCLES_ARID;
+    if (size > SIZE_DWORD) return 0;
+    REGS.pc = REGS.pc + 2;
+    return ea_mem(REGS.aregs.a[(uint8_t)reg] + (long)GETword(REGS.pc - 2), command, destination, size);
+}
+
+/* Any mode, what CommandMode[mode] does */
+CPU_INLINE long ea_access(int mode, char reg, char command, long destination, char size)
+{
+    switch (mode) {
+    case 0:  return ea_drd(reg, command, destination, size);
+    case 1:  return ea_ard(reg, command, destination, size);
+    case 2:  return ea_ari(reg, command, destination, size);
+    case 3:  return ea_aripi(reg, command, destination, size);
+    case 4:  return ea_aripd(reg, command, destination, size);
+    case 5:  return ea_arid(reg, command, destination, size);
+    case 6:  return ARII(reg, command, destination, size);
+    default: return MISC(reg, command, destination, size);
+    }
+}
+
+#endif /* __CPU_EA_H__ */
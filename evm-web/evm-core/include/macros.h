@@ -8,18 +8,18 @@
 //						macros for flag manipulation
 // NOTE: CCR is lower 8 bits of SR in MC68020
 ////////////////////////////////////////////////////////////////////////////////
-#define CARRY1    cpu.sregs.sr=cpu.sregs.sr|0x01
-#define CARRY0    cpu.sregs.sr=cpu.sregs.sr&(~0x01)
+// the flags are kept lazily, see STFLAGS.H
+#define CARRY1      setcarry(1)
+#define CARRY0      setcarry(0)
 
-#define ZERO1     cpu.sregs.sr=cpu.sregs.sr|0x04
-#define ZERO0	  cpu.sregs.sr=cpu.sregs.sr&(~0x04)
+#define ZERO1       setzero(1)
+#define ZERO0       setzero(0)
 
-#define OVER1     cpu.sregs.sr=cpu.sregs.sr|0x02
-#define OVER0	  cpu.sregs.sr=cpu.sregs.sr&(~0x02)
+#define OVER1       setover(1)
+#define OVER0       setover(0)
 
-#define XTEND1    cpu.sregs.sr=cpu.sregs.sr|0x10
-#define XTEND0   cpu.sregs.sr=cpu.sregs.sr&(~0x10)
-
-#define NEG1   	  cpu.sregs.sr=cpu.sregs.sr|0x08
-#define NEG0     cpu.sregs.sr=cpu.sregs.sr&(~0x08)
+#define XTEND1      setxtend(1)
+#define XTEND0      setxtend(0)
 
+#define NEG1        setneg(1)
+#define NEG0        setneg(0)
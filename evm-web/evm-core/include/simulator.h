@@ -19,19 +19,58 @@ extern "C" {
  * Type Definitions
  * ============================================================================ */
 
-/* MC68020 CPU State */
+/* MC68020 CPU State
+ *
+ * This is the one and only register file: the instruction handlers work on
+ * it in place through the sregs/dregs/aregs views (see STSTDDEF.H), so the
+ * CPU core never copies registers between instructions. The byte/word views
+ * assume a little-endian host (x86, WASM).
+ *
+ * NOTE: the web worker reads this structure by offset - keep the layout.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the byte/word views of simulator_cpu_state_t need a little-endian host"
+#endif
 typedef struct {
-    uint16_t sr;                    /* Status Register */
-    uint32_t d[8];                  /* Data registers D0-D7 */
-    uint32_t a[8];                  /* Address registers A0-A7 */
+    union {
+        uint16_t sr;                /* Status Register */
+        struct { uint16_t sr; } sregs;
+    };
+    union {
+        uint32_t d[8];              /* Data registers D0-D7 */
+        union {
+            int32_t d[8];
+            struct { int16_t dl, dh; } wordd[8];
+            struct { int8_t dll, dlh, dul, duh; } byted[8];
+        } dregs;
+    };
+    union {
+        uint32_t a[8];              /* Address registers A0-A7 */
+        union {
+            int32_t a[8];
+            struct { int16_t al, ah; } worda[8];
+            struct { int8_t all, alh, aul, auh; } bytea[8];
+        } aregs;
+    };
     uint32_t pc;                    /* Program Counter (24-bit) */
     uint32_t ssp, usp, msp;         /* Stack pointers */
     uint32_t sfc, dfc;              /* Source/Destination function code */
     uint32_t vbr;                   /* Vector base register */
     uint32_t cacr, caar;            /* Cache control */
+    uint64_t cycles;                /* Clock cycles since reset */
 } simulator_cpu_state_t;
 
-/* Module interface for peripherals (RAM, ROM, 68230, 68681) */
+/* CPU clock of the EVM board; simulated time is counted in these cycles */
+#define SIM_CPU_CLOCK_HZ 12500000
+
+struct simulator;
+struct simulator_snapshot;
+
+/* Module interface for peripherals (RAM, ROM, 68230, 68681)
+ *
+ * Every simulator owns its module instances: the built-in descriptors are
+ * copied per simulator, and setup() allocates the instance's state.
+ */
 typedef struct simulator_module {
     /* Module info */
     const char *name;
@@ -45,18 +84,42 @@ typedef struct simulator_module {
     void (*init)(struct simulator_module *);      /* Interconnect phase */
     void (*reset)(struct simulator_module *);     /* Reset to known state */
     void (*exit)(struct simulator_module *);      /* Cleanup */
-    void (*simulate)(struct simulator_module *);  /* Called once per CPU cycle */
+    void (*simulate)(struct simulator_module *);  /* Optional: polled after every instruction,
+                                                     prefer simulator_schedule_event() */
 
     /* Memory access */
     uint32_t (*read)(struct simulator_module *, uint32_t addr, int size);
     void (*write)(struct simulator_module *, uint32_t addr, uint32_t data, int size);
 
+    /* Direct access: host pointer backing addr, or NULL (cacheable modules only) */
+    uint8_t *(*map)(struct simulator_module *, uint32_t addr);
+
+    /* Optional: non-zero if reading addr has no side effect and the value
+       only changes on a write or in one of the module's events, so a loop
+       polling it can be skipped up to the next event */
+    int (*read_stable)(struct simulator_module *, uint32_t addr);
+
+    /* Optional: snapshot support. save() stores the module's registers with
+       simulator_snapshot_put*(), load() reads them back in the same order
+       with simulator_snapshot_get*() and schedules the module's events
+       again. Memory behind map() is saved by the core. Return 0 on success. */
+    int (*save)(struct simulator_module *, struct simulator_snapshot *);
+    int (*load)(struct simulator_module *, struct simulator_snapshot *);
+
     /* Module-specific state pointer */
     void *state;
+
+    /* Simulator the module is registered with */
+    struct simulator *sim;
 } simulator_module_t;
 
-/* Main simulator context */
-typedef struct {
+/* Main simulator context
+ *
+ * All simulator state hangs off this context, so any number of simulators
+ * can coexist in one process. A simulator must only be used by one thread
+ * at a time.
+ */
+typedef struct simulator {
     simulator_cpu_state_t cpu;      /* CPU state */
     simulator_module_t **modules;   /* Array of loaded modules */
     int num_modules;
@@ -87,9 +150,20 @@ int simulator_load_modules(simulator_t *sim);
 
 /**
  * Reset simulator to initial state
+ *
+ * Clears RAM: load programs that live in RAM afterwards.
  */
 void simulator_reset(simulator_t *sim);
 
+/**
+ * Reset the CPU only
+ *
+ * Takes SSP and PC from the reset vectors again and leaves memory and the
+ * modules alone. Hosts loading images call simulator_reset(), load, then
+ * this, so the vectors of a ROM image loaded after the reset are used.
+ */
+void simulator_reset_cpu(simulator_t *sim);
+
 /**
  * Execute N CPU instructions
  *
@@ -105,8 +179,80 @@ uint32_t simulator_run(simulator_t *sim, uint32_t count);
  */
 int simulator_step(simulator_t *sim);
 
+/* Stop conditions for simulator_run_batch() (bit mask) */
+#define SIM_STOP_NONE        0x00   /* Run until the budget is exhausted */
+#define SIM_STOP_ON_STOP     0x01   /* CPU executed STOP #imm */
+#define SIM_STOP_BREAKPOINT  0x02   /* PC reached a breakpoint */
+#define SIM_STOP_INTERRUPT   0x04   /* CPU accepted an interrupt */
+#define SIM_STOP_ALL         (SIM_STOP_ON_STOP | SIM_STOP_BREAKPOINT | SIM_STOP_INTERRUPT)
+
+/* Reason reported by simulator_get_stop_reason() */
+#define SIM_STOPPED_BUDGET       0  /* Executed the requested count or cycles */
+#define SIM_STOPPED_STOP         1  /* STOP #imm, waiting for an interrupt */
+#define SIM_STOPPED_BREAKPOINT   2  /* PC is at a breakpoint */
+#define SIM_STOPPED_INTERRUPT    3  /* PC is at an interrupt handler */
+#define SIM_STOPPED_PAUSE        4  /* simulator_pause() was called */
+
+/**
+ * Execute up to N CPU instructions in one batch
+ *
+ * The CPU context is set up once for the whole batch; exit conditions are
+ * only checked at instruction boundaries. A breakpoint at the PC the batch
+ * starts from is stepped over, so a stopped run can simply be resumed.
+ * While the CPU is stopped (STOP #imm), every 4 idle cycles count as one
+ * instruction. Iterations of a device polling loop that can't see a change
+ * are skipped, but count as if they had run.
+ *
+ * count: Instruction budget
+ * stop_conditions: SIM_STOP_* mask of additional reasons to return early
+ * Returns: Number of instructions actually executed
+ */
+uint32_t simulator_run_batch(simulator_t *sim, uint32_t count, uint32_t stop_conditions);
+
+/**
+ * Run for N CPU clock cycles
+ *
+ * The instruction that crosses the limit is completed, so the result can
+ * exceed 'cycles' by a few cycles.
+ *
+ * cycles: Cycle budget
+ * stop_conditions: SIM_STOP_* mask of additional reasons to return early
+ * Returns: Number of cycles actually run
+ */
+uint64_t simulator_run_cycles(simulator_t *sim, uint64_t cycles, uint32_t stop_conditions);
+
+/**
+ * Get the reason the last simulator_run_batch() returned (SIM_STOPPED_*)
+ */
+int simulator_get_stop_reason(simulator_t *sim);
+
+/**
+ * Check if the CPU is waiting for a device
+ *
+ * True while the CPU is stopped (STOP #imm) waiting for an interrupt, or
+ * spins in a loop that polls device status registers. Either way the run
+ * functions jump the clock to the next device event, and only an event or
+ * the host can change what the CPU sees. A host loop can sleep or wait for
+ * input meanwhile.
+ */
+int simulator_is_idle(simulator_t *sim);
+
+/**
+ * Set a PC breakpoint
+ *
+ * Returns: 0 on success, -1 if the breakpoint table is full
+ */
+int simulator_set_breakpoint(simulator_t *sim, uint32_t addr);
+
+/**
+ * Remove a PC breakpoint
+ */
+void simulator_clear_breakpoint(simulator_t *sim, uint32_t addr);
+
 /**
  * Pause simulator execution
+ *
+ * A running batch returns at the next instruction boundary.
  */
 void simulator_pause(simulator_t *sim);
 
@@ -142,6 +288,45 @@ uint32_t simulator_read_memory(simulator_t *sim, uint32_t addr, int size);
  */
 void simulator_write_memory(simulator_t *sim, uint32_t addr, uint32_t data, int size);
 
+/**
+ * Read a block of memory
+ *
+ * RAM and ROM pages are copied with memcpy; I/O pages go through the
+ * module's read callback byte by byte. Unmapped addresses read as 0.
+ * The address wraps at the end of the 24-bit address space.
+ *
+ * addr: Address to read from
+ * buf: Receives len bytes
+ */
+void simulator_read_block(simulator_t *sim, uint32_t addr, uint8_t *buf, size_t len);
+
+/**
+ * Write a block of memory
+ *
+ * Like simulator_read_block(), with the cached instructions of the pages
+ * written dropped. ROM is written as well.
+ *
+ * addr: Address to write to
+ * data: len bytes to write
+ */
+void simulator_write_block(simulator_t *sim, uint32_t addr, const uint8_t *data, size_t len);
+
+/**
+ * Get decoded instruction cache statistics
+ *
+ * hits/misses: Receive the counters since simulator_init() (may be NULL)
+ * Opcodes run from translated blocks count as hits.
+ */
+void simulator_get_cache_stats(simulator_t *sim, uint64_t *hits, uint64_t *misses);
+
+/**
+ * Drop all cached instructions and translated blocks
+ *
+ * Only needed after writing module memory directly, without going through
+ * simulator_write_memory() or the CPU.
+ */
+void simulator_flush_caches(simulator_t *sim);
+
 /**
  * Load ROM/program image
  *
@@ -152,6 +337,292 @@ void simulator_write_memory(simulator_t *sim, uint32_t addr, uint32_t data, int
  */
 int simulator_load_program(simulator_t *sim, const uint8_t *data, size_t size, uint32_t addr);
 
+/* ============================================================================
+ * S-Record Images
+ * ============================================================================ */
+
+/* Entry point reported when the image has no S7/S8/S9 record */
+#define SIM_SREC_NO_ENTRY 0xFFFFFFFFu
+
+/* Loader state, see simulator_srec_begin() */
+typedef struct simulator_srec simulator_srec_t;
+
+/**
+ * Start loading an S-record image
+ *
+ * The image is then fed in chunks of any size, e.g. as it is read or
+ * downloaded. Every record must pass its checksum. Contiguous S1/S2/S3
+ * records are collected and written with simulator_write_block().
+ *
+ * Returns: Loader context, or NULL on error
+ */
+simulator_srec_t *simulator_srec_begin(simulator_t *sim);
+
+/**
+ * Feed the next chunk of an S-record image
+ *
+ * Returns: 0 on success, -1 once a record was malformed or failed its
+ *          checksum (the rest of the image is ignored)
+ */
+int simulator_srec_feed(simulator_srec_t *srec, const void *data, size_t len);
+
+/**
+ * Finish loading and free the loader
+ *
+ * entry: Receives the address of the S7/S8/S9 record, SIM_SREC_NO_ENTRY if
+ *        there was none (may be NULL)
+ * Returns: 0 on success, -1 if a record was bad
+ */
+int simulator_srec_end(simulator_srec_t *srec, uint32_t *entry);
+
+/**
+ * Load a complete S-record image from memory
+ *
+ * Returns: 0 on success, -1 if a record was bad
+ */
+int simulator_load_srec(simulator_t *sim, const void *data, size_t len, uint32_t *entry);
+
+/**
+ * Memory image of everything the loader wrote so far
+ *
+ * Call before simulator_srec_end(). The image carries the entry point and
+ * the hash of all bytes fed, see simulator_image_build().
+ *
+ * len: Receives the image size
+ * Returns: Image (free() it), or NULL on error or after a bad record
+ */
+void *simulator_srec_image(simulator_srec_t *srec, size_t *len);
+
+/* ============================================================================
+ * Memory Images
+ *
+ * A memory image is a preprocessed program: the memory ranges it fills, its
+ * entry point and the hash of the file it was made from. Hosts cache it next
+ * to the source and load it instead of parsing the source again as long as
+ * the hash matches.
+ * ============================================================================ */
+
+/* Segment data in an image starts on this boundary, so it can be mapped */
+#define SIM_IMAGE_ALIGN 4096
+
+/* simulator_load_image() flags */
+#define SIM_IMAGE_MAP_ROM   0x01    /* Back the boot ROM by the image instead of copying */
+
+/* Memory range stored in an image */
+typedef struct {
+    uint32_t addr;
+    uint32_t size;
+} simulator_segment_t;
+
+/**
+ * Hash of a source file, as stored in the images made from it
+ */
+uint64_t simulator_hash(const void *data, size_t len);
+
+/**
+ * Build an image of memory ranges
+ *
+ * Ranges that touch the boot ROM are stored as one segment covering all of
+ * it, so SIM_IMAGE_MAP_ROM can use it.
+ *
+ * entry: Entry point to record (SIM_SREC_NO_ENTRY if none)
+ * hash:  simulator_hash() of the source
+ * len:   Receives the image size
+ * Returns: Image (free() it), or NULL on error
+ */
+void *simulator_image_build(simulator_t *sim, const simulator_segment_t *segs, int count,
+                            uint32_t entry, uint64_t hash, size_t *len);
+
+/**
+ * Check the header and segment table of an image
+ *
+ * hash, entry: Receive the source hash and entry point (may be NULL)
+ * Returns: 0 if the image is usable, -1 otherwise
+ */
+int simulator_image_check(const void *data, size_t len, uint64_t *hash, uint32_t *entry);
+
+/**
+ * Load an image into memory
+ *
+ * With SIM_IMAGE_MAP_ROM the boot ROM uses the image's ROM segment in place:
+ * data must then stay valid and writable (e.g. a private mapping) until the
+ * simulator is destroyed. Everything else is copied.
+ *
+ * entry: Receives the entry point (may be NULL)
+ * Returns: 0 on success, -1 if the image is malformed
+ */
+int simulator_load_image(simulator_t *sim, void *data, size_t len, int flags, uint32_t *entry);
+
+/* ============================================================================
+ * Snapshots
+ *
+ * A snapshot holds the whole machine: CPU registers, the state of every
+ * module and the RAM/ROM pages. After a snapshot the pages are write
+ * protected, so the simulator sees which ones change; an incremental
+ * snapshot only stores those. Host settings (UART hooks and fds,
+ * breakpoints) are not part of a snapshot.
+ * ============================================================================ */
+
+/* Snapshot format version, snapshots of other versions are rejected */
+#define SIM_SNAPSHOT_VERSION        1
+
+/* simulator_snapshot_save() flags */
+#define SIM_SNAPSHOT_INCREMENTAL    0x01    /* Only pages changed since the last snapshot */
+
+/* Module state being saved or loaded, see simulator_module_t.save/load */
+typedef struct simulator_snapshot simulator_snapshot_t;
+
+/**
+ * Save the machine state
+ *
+ * With SIM_SNAPSHOT_INCREMENTAL only the pages written since the last
+ * snapshot this simulator saved or loaded are stored; the first snapshot
+ * is always complete. Registers and module state are always stored in full.
+ *
+ * len: Receives the snapshot size
+ * Returns: Snapshot (free() it), or NULL on error
+ */
+void *simulator_snapshot_save(simulator_t *sim, int flags, size_t *len);
+
+/**
+ * Restore the machine state
+ *
+ * A complete snapshot can always be loaded. An incremental one only on top
+ * of the snapshot it was saved after, with no memory written since: load
+ * the chain from its complete snapshot in order. Snapshots are
+ * self-delimiting, so a chain can be kept as one file (see
+ * simulator_snapshot_size()).
+ *
+ * Returns: 0 on success, -1 if the snapshot is malformed, does not match the
+ *          simulator's modules or does not follow its current state. On
+ *          errors found after checking the structure (a module rejecting its
+ *          data) the machine is only partly restored.
+ */
+int simulator_snapshot_load(simulator_t *sim, const void *data, size_t len);
+
+/**
+ * Size of the snapshot at data, from its header
+ *
+ * Returns: Size in bytes, or 0 if data does not start with a snapshot header
+ */
+size_t simulator_snapshot_size(const void *data, size_t len);
+
+/**
+ * Make the current state the baseline
+ *
+ * The simulator keeps a full snapshot of it. Like any snapshot it write
+ * protects the pages again, so the ones written from here on are known.
+ * Incremental snapshots saved afterwards follow the baseline.
+ *
+ * Returns: 0 on success, -1 if out of memory
+ */
+int simulator_set_baseline(simulator_t *sim);
+
+/**
+ * Go back to the baseline
+ *
+ * Restores the CPU and the modules, and copies back only the pages written
+ * since the baseline was set or last reset to, so the cost follows the work
+ * done rather than the memory size. Meant for running many short inputs
+ * from the same state, e.g. fuzzing.
+ *
+ * Returns: 0 on success, -1 if there is no baseline
+ */
+int simulator_reset_to_baseline(simulator_t *sim);
+
+/* Module state, for save()/load() callbacks; stored little-endian */
+void simulator_snapshot_put(simulator_snapshot_t *snap, const void *data, size_t len);
+void simulator_snapshot_put32(simulator_snapshot_t *snap, uint32_t value);
+void simulator_snapshot_put64(simulator_snapshot_t *snap, uint64_t value);
+
+/* Reading past the end of the module's data fails the load, the value is 0 */
+void simulator_snapshot_get(simulator_snapshot_t *snap, void *data, size_t len);
+uint32_t simulator_snapshot_get32(simulator_snapshot_t *snap);
+uint64_t simulator_snapshot_get64(simulator_snapshot_t *snap);
+
+/* ============================================================================
+ * Serial Console (68681 DUART)
+ * ============================================================================ */
+
+/* UART channels */
+#define SIM_UART_A 0
+#define SIM_UART_B 1
+
+/* Bytes per UART FIFO, a power of two */
+#define SIM_UART_FIFO_SIZE 4096
+
+/* Called for every character the CPU transmits on a UART channel */
+typedef void (*simulator_uart_tx_fn)(void *user, int channel, uint8_t data);
+
+/**
+ * Route UART transmit data to fn
+ *
+ * fn: Transmit hook, or NULL to queue the data in the channel's transmit
+ *     FIFO (default, see simulator_set_uart_fd())
+ * user: Passed through to fn
+ */
+void simulator_set_uart_tx(simulator_t *sim, simulator_uart_tx_fn fn, void *user);
+
+/* Called for the next character to receive on a UART channel, returns the
+   character or -1 if there is none yet */
+typedef int (*simulator_uart_rx_fn)(void *user, int channel);
+
+/**
+ * Feed UART receive data from fn
+ *
+ * fn is polled once per character time for each channel whose receive
+ * FIFO is not full, and its characters are queued there.
+ *
+ * fn: Receive hook, or NULL to only receive simulator_uart_push() data
+ *     (default)
+ * user: Passed through to fn
+ */
+void simulator_set_uart_rx(simulator_t *sim, simulator_uart_rx_fn fn, void *user);
+
+/*
+ * Each channel has a receive and a transmit FIFO of SIM_UART_FIFO_SIZE
+ * bytes on the host side of the line. The status registers follow them:
+ * RXRDY while the receive FIFO holds data, FFULL once it is full, TXRDY
+ * while the transmit FIFO has room, TXEMT once it is empty. The interrupt
+ * status register reflects the same bits (no interrupt is raised). The
+ * FIFOs keep their contents across simulator_reset().
+ */
+
+/**
+ * Queue receive data for a UART channel
+ *
+ * Returns: Number of bytes queued, less than len once the FIFO is full
+ */
+size_t simulator_uart_push(simulator_t *sim, int channel, const uint8_t *data, size_t len);
+
+/**
+ * Take transmit data of a UART channel
+ *
+ * Only a channel without tx hook and fd sink keeps its data for this call.
+ * While its FIFO is full, the CPU sees TXRDY clear and characters it
+ * writes anyway are lost.
+ *
+ * Returns: Number of bytes copied to buf
+ */
+size_t simulator_uart_pull(simulator_t *sim, int channel, uint8_t *buf, size_t max);
+
+/**
+ * Write the transmit data of a UART channel to fd
+ *
+ * The data is written in bulk: whenever the FIFO fills up, at the end of
+ * each simulator_step()/run_batch()/run_cycles(), and by
+ * simulator_uart_flush(). The tx hook takes precedence.
+ *
+ * fd: File descriptor, or -1 to keep the data for simulator_uart_pull()
+ *     (default: 2, stderr)
+ */
+void simulator_set_uart_fd(simulator_t *sim, int channel, int fd);
+
+/**
+ * Write the queued transmit data of all channels with an fd sink
+ */
+void simulator_uart_flush(simulator_t *sim);
+
 /**
  * Cleanup and destroy simulator
  */
@@ -164,7 +635,8 @@ void simulator_destroy(simulator_t *sim);
 /**
  * Register a built-in module
  *
- * Used during simulator initialization to add modules like RAM, ROM, 68230, 68681
+ * Used during simulator initialization to add modules like RAM, ROM, 68230, 68681.
+ * Sets module->sim; a module instance belongs to exactly one simulator.
  */
 int simulator_register_module(simulator_t *sim, simulator_module_t *module);
 
@@ -176,12 +648,43 @@ int simulator_register_module(simulator_t *sim, simulator_module_t *module);
 simulator_module_t *simulator_get_module_at(simulator_t *sim, uint32_t addr);
 
 /**
- * Get the current global simulator context
+ * Get the simulator the calling thread last initialised, reset or ran
  *
- * Used internally by modules and CPU core to access the current simulator
+ * Legacy accessor; modules should use their 'sim' member instead.
  */
 simulator_t *simulator_get_current(void);
 
+/* ============================================================================
+ * Event Scheduling (for modules)
+ *
+ * Devices schedule their next wakeup on the simulator clock instead of
+ * polling after every instruction. Events due at the same time fire in the
+ * order they were scheduled.
+ * ============================================================================ */
+
+/* Event handler, called at an instruction boundary once the event is due */
+typedef void (*simulator_event_fn)(simulator_t *sim, simulator_module_t *mod);
+
+/**
+ * Schedule fn(sim, mod) to run 'delay' CPU cycles from now
+ *
+ * Returns: 0 on success, -1 if the event queue is full
+ */
+int simulator_schedule_event(simulator_t *sim, simulator_module_t *mod,
+                             uint64_t delay, simulator_event_fn fn);
+
+/**
+ * Cancel pending events of a module
+ *
+ * fn: Only cancel events with this handler, or NULL for all of them
+ */
+void simulator_cancel_events(simulator_t *sim, simulator_module_t *mod, simulator_event_fn fn);
+
+/**
+ * Get the current simulator clock (CPU cycles since reset)
+ */
+uint64_t simulator_get_clock(simulator_t *sim);
+
 /* ============================================================================
  * Memory Access Functions (called by CPU core and exception handlers)
  * ============================================================================ */
@@ -0,0 +1,440 @@
+/*
+ * simulator_internal.h
+ *
+ * Private simulator state shared by the simulator API (simulator.c) and the
+ * CPU core (cpu_core_new.c). Not part of the public API.
+ */
+
+#ifndef __SIMULATOR_INTERNAL_H__
+#define __SIMULATOR_INTERNAL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "simulator.h"
+#include "simulator_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-thread variable. initial-exec keeps accesses a plain thread pointer
+   relative load when the core is linked into a shared library. */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__EMSCRIPTEN__)
+#define SIM_THREAD_LOCAL __thread __attribute__((tls_model("initial-exec")))
+#elif defined(_MSC_VER)
+#define SIM_THREAD_LOCAL __declspec(thread)
+#else
+#define SIM_THREAD_LOCAL _Thread_local
+#endif
+
+/* Maximum number of PC breakpoints per simulator */
+#define SIM_MAX_BREAKPOINTS 32
+
+/* Maximum number of pending device events */
+#define SIM_MAX_EVENTS      64
+
+/* Scheduled device event */
+typedef struct {
+    uint64_t when;                  /* Clock value the event is due at */
+    uint32_t seq;                   /* Tie breaker: scheduling order */
+    simulator_module_t *mod;
+    simulator_event_fn fn;
+} simulator_event_t;
+
+/* Opcode handler, called with the opcode word */
+typedef void (*opcode_handler_t)(short opcode);
+
+/* Decoded instruction cache: direct mapped on (pc >> 1), 8KB of code span */
+#define ICACHE_SIZE         4096
+#define ICACHE_MASK         (ICACHE_SIZE - 1)
+#define ICACHE_EMPTY        1       /* Odd tag, never matches a fetch PC */
+
+/* Decoded instruction cache entry */
+typedef struct {
+    uint32_t pc;                    /* Tag: address of the opcode */
+    uint16_t opcode;                /* Opcode word (loaded into 'of') */
+    uint8_t cycles;                 /* cpu_opcode_cycles(opcode) */
+    opcode_handler_t handler;       /* cpu_decode_handler(opcode) */
+} icache_entry_t;
+
+/* Translated basic blocks */
+#define TB_MAX_INSNS        32      /* Opcodes per block */
+#define TB_MAX_BLOCKS       1024    /* Block pool, flushed as a whole when full */
+#define TB_HASH_SIZE        4096    /* Block lookup, direct mapped on (pc >> 1) */
+#define TB_HASH_MASK        (TB_HASH_SIZE - 1)
+#define TB_MAX_INSN_BYTES   22      /* Longest MC68020 instruction */
+
+/*
+ * Basic block: a straight run of pre-decoded opcodes, executed back to back
+ * without going through the batch loop. insn[num_insns] is a sentinel whose
+ * pc never matches, so leaving the run - at its end, or early on a taken
+ * exception - is the same 'cpu.pc != next entry' test.
+ */
+typedef struct tb_block {
+    uint32_t pc;                    /* Tag: start address, ICACHE_EMPTY once dropped */
+    uint16_t first_page;            /* Pages holding the opcodes and their */
+    uint16_t last_page;             /* extension words (at most two) */
+    uint8_t num_insns;
+    uint8_t exit_to_loop;           /* Last opcode may change SR/IPL: no chaining */
+    uint8_t pure;                   /* No opcode writes memory (polling loops) */
+    struct tb_block *link[2];       /* Chained successors, valid while their tag matches */
+    icache_entry_t insn[TB_MAX_INSNS + 1];
+} tb_block_t;
+
+/* ============================================================================
+ * CPU core context
+ *
+ * What the instruction handlers keep between and during opcodes, one per
+ * simulator. The handlers reach the context of the simulator running on
+ * their thread through g_core, with the accessors in STSTDDEF.H (OF, WORK,
+ * CCR, ...).
+ * ============================================================================ */
+
+/* Operands of the current instruction */
+struct tag_work {
+    long source;
+    long destination;
+    long result;
+};
+
+/*
+ * Lazy condition codes (STFLAGS.H)
+ *
+ * N and Z keep the value the handler tested, C/V/X keep their state.
+ */
+struct tag_ccr {
+    long n;                         /* N = (n < 0) */
+    long z;                         /* Z = (z == 0) */
+    char v, c, x;
+};
+
+/* Opcode word and its operand fields (bit-fields allocated from the least
+   significant bit, as on the little-endian hosts checked in simulator.h) */
+typedef union {
+    unsigned short o;
+    struct {
+        unsigned regsrc   : 3;      /* 0x0007 */
+        unsigned modesrc  : 3;      /* 0x0038 */
+        unsigned modedest : 3;      /* 0x01C0 */
+        unsigned regdest  : 3;      /* 0x0E00 */
+        unsigned group    : 4;      /* 0xF000 */
+    } general;
+    struct {
+        unsigned regsrc   : 3;      /* 0x0007 */
+        unsigned modesrc  : 3;      /* 0x0038 */
+        unsigned size     : 2;      /* 0x00C0 */
+        unsigned reserved : 4;      /* 0x0F00 */
+        unsigned group    : 4;      /* 0xF000 */
+    } special;
+} cpu_opcode_t;
+
+/* Interrupt request from the devices to the CPU (exception_handlers.c) */
+typedef struct {
+    int ipl;                        /* Interrupt Priority Level */
+    int VecNum;                     /* Vector Number, 0x0f if none */
+    int bNonAutoVector;             /* Non-autovector flag */
+} cpu_irq_conn_t;
+
+typedef struct {
+    cpu_opcode_t of;                /* Opcode being executed */
+    struct tag_work work;           /* Operands */
+    struct tag_ccr ccr;             /* Condition codes while a batch runs */
+    int bStopped;                   /* STOP instruction, waiting for an interrupt */
+    long spc;                       /* Temporary PC */
+    long pcbefore;                  /* PC before the instruction */
+    char AddressError;              /* Address error flag */
+    long ea_predec_pc;              /* PC of the last -(An) read (cpu_ea.h) */
+
+    /* Exception processing (exception_handlers.c) */
+    long fault_pc;                  /* PC recorded by set_pcbefore() for fault frames */
+    int halted;                     /* Unknown() hit an unimplemented opcode */
+    uint32_t num_irqs;              /* Interrupts taken */
+    cpu_irq_conn_t irq;
+
+    /* Page table, built by simulator_load_modules() (simulator.c) */
+    memory_page_t memory_map[MEMORY_MAP_SIZE];
+} cpu_core_t;
+
+/* Simulator running on this thread and its core context (cpu_core_new.c) */
+extern SIM_THREAD_LOCAL simulator_t *g_sim;
+extern SIM_THREAD_LOCAL cpu_core_t *g_core;
+
+/* Built-in modules per simulator (simulator_modules.c) */
+#define SIM_MAX_BUILTIN_MODULES 4
+
+/* Polling loop detection (cpu_core_new.c): state at the loop head */
+typedef struct {
+    uint32_t pc;                    /* Loop head, ICACHE_EMPTY if none */
+    int pure;                       /* Only pure blocks ran since the snapshot */
+    int spinning;                   /* The last iteration changed nothing */
+    uint32_t executed;              /* Opcodes of the batch at the snapshot */
+    uint64_t cycles;
+    uint32_t io_unstable;
+    uint32_t d[8], a[8];
+    uint16_t sr;
+    int n, z;                       /* Condition codes */
+    char v, c, x;
+} spin_probe_t;
+
+/* Host side of a UART channel (simulator_modules.c) */
+typedef struct {
+    uint8_t data[SIM_UART_FIFO_SIZE];
+    uint32_t head, tail;            /* Free running, head - tail bytes queued */
+} sim_fifo_t;
+
+typedef struct {
+    sim_fifo_t rx;                  /* Host to CPU */
+    sim_fifo_t tx;                  /* CPU to host, unless the tx hook takes it */
+    int fd;                         /* Transmit sink, -1 to keep tx for pulling */
+} sim_uart_channel_t;
+
+/* Private simulator data (simulator_t.priv) */
+typedef struct {
+    /* CPU core context */
+    cpu_core_t core;
+
+    /* This simulator's instances of the built-in modules */
+    simulator_module_t builtin_modules[SIM_MAX_BUILTIN_MODULES];
+    int num_builtin_modules;
+
+    /* Breakpoints, checked at instruction boundaries by the batch loop */
+    uint32_t breakpoints[SIM_MAX_BREAKPOINTS];
+    int num_breakpoints;
+
+    /* Set by simulator_pause(), consumed by the batch loop */
+    volatile int pause_requested;
+
+    /* Why the last simulator_run_batch() returned */
+    int stop_reason;
+
+    /* UART host hooks (simulator_set_uart_tx(), simulator_set_uart_rx()) */
+    simulator_uart_tx_fn uart_tx;
+    void *uart_tx_user;
+    simulator_uart_rx_fn uart_rx;
+    void *uart_rx_user;
+
+    /* UART FIFOs, per channel; they outlive the module and its resets */
+    sim_uart_channel_t uart[2];
+    simulator_module_t *uart_module;    /* Set by its setup() */
+
+    /* Pending events, binary min-heap on (when, seq) */
+    simulator_event_t events[SIM_MAX_EVENTS];
+    int num_events;
+    uint32_t event_seq;
+    uint64_t next_event;            /* events[0].when, or UINT64_MAX if empty */
+                                    /* (the clock is cpu.cycles) */
+
+    /* Modules that still poll via simulate(), in priority order */
+    simulator_module_t *polled[64];
+    int num_polled;
+
+    /* Decoded instruction cache over the RAM/ROM pages */
+    icache_entry_t icache[ICACHE_SIZE];
+    uint64_t icache_hits;
+    uint64_t icache_misses;
+
+    /* Basic block translator */
+    tb_block_t tb_blocks[TB_MAX_BLOCKS];
+    int tb_num_blocks;
+    tb_block_t *tb_hash[TB_HASH_SIZE];
+    tb_block_t *tb_build;           /* Block being recorded, not yet in tb_hash */
+    uint32_t tb_build_next;         /* Address the next recorded opcode must have */
+    int tb_exit;                    /* Set on I/O access or invalidation: leave the block */
+
+    /* Polling loop detection */
+    int tb_pure;                    /* The last cpu_run_blocks() only ran pure blocks */
+    uint32_t io_unstable;           /* Device reads that are not read_stable() */
+    spin_probe_t spin;
+
+    /* Snapshots: RAM/ROM pages unchanged since the last one are write
+       protected like code pages, the first write marks them dirty again */
+    uint8_t page_clean[MEMORY_MAP_SIZE];    /* SIM_PAGE_CLEAN_* */
+    uint64_t snapshot_id;           /* Last snapshot saved or loaded, 0 if none */
+
+    /* Baseline (simulator_set_baseline()): a full snapshot, where each page
+       is in it, and the pages written since, each listed once */
+    uint8_t *baseline;
+    size_t baseline_state;          /* End of the CPU and module sections */
+    uint32_t *baseline_pages;       /* Offset of each page's data, 0 if none */
+    uint16_t baseline_dirty[MEMORY_MAP_SIZE];
+    uint32_t num_baseline_dirty;
+} simulator_priv_t;
+
+/* page_clean[] bits: unchanged since the last snapshot / the baseline */
+#define SIM_PAGE_CLEAN_SNAPSHOT 0x01
+#define SIM_PAGE_CLEAN_BASELINE 0x02
+
+#define SIM_PRIV(sim) ((simulator_priv_t *)(sim)->priv)
+
+/* Page table of a simulator */
+#define SIM_MEMORY_MAP(sim) (SIM_PRIV(sim)->core.memory_map)
+
+/* Write pointer of a page without cached code: NULL while the page is
+   clean for snapshots or the baseline, so the first write to it is seen */
+static inline uint8_t *sim_page_whost(simulator_priv_t *priv, uint32_t page)
+{
+    return priv->page_clean[page] ? NULL : priv->core.memory_map[page].host;
+}
+
+/* ============================================================================
+ * Memory map (simulator.c)
+ * ============================================================================ */
+
+/* Rebuild the page table after modules or their backing memory changed */
+void sim_build_memory_map(simulator_t *sim);
+
+/* A RAM/ROM page is about to change while write protected (whost NULL) */
+void sim_page_written(simulator_t *sim, uint32_t page);
+
+/* All RAM/ROM pages changed behind the write protection */
+void sim_pages_written(simulator_t *sim);
+
+/* ============================================================================
+ * Event queue (simulator_events.c)
+ * ============================================================================ */
+
+/* Drop all pending events and restart the clock at 0 */
+void sim_events_reset(simulator_t *sim);
+
+/* Fire every event that is due at the current clock */
+void sim_events_dispatch(simulator_t *sim);
+
+/* ============================================================================
+ * UART host side (simulator_modules.c)
+ * ============================================================================ */
+
+static inline uint32_t sim_fifo_count(const sim_fifo_t *f)
+{
+    return f->head - f->tail;
+}
+
+/* Queue up to len bytes, returns the number queued */
+static inline size_t sim_fifo_put(sim_fifo_t *f, const uint8_t *data, size_t len)
+{
+    size_t n = SIM_UART_FIFO_SIZE - sim_fifo_count(f);
+
+    if (n > len) n = len;
+    for (size_t i = 0; i < n; i++) {
+        f->data[f->head++ & (SIM_UART_FIFO_SIZE - 1)] = data[i];
+    }
+    return n;
+}
+
+/* Take up to max bytes, returns the number taken */
+static inline size_t sim_fifo_get(sim_fifo_t *f, uint8_t *buf, size_t max)
+{
+    size_t n = sim_fifo_count(f);
+
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = f->data[f->tail++ & (SIM_UART_FIFO_SIZE - 1)];
+    }
+    return n;
+}
+
+/* Write the queued transmit data of the channels with an fd sink */
+void sim_uart_flush(simulator_t *sim);
+
+/* The rx hook changed: poll it once per character time, or stop polling */
+void sim_uart_rx_changed(simulator_t *sim);
+
+/* ============================================================================
+ * Boot ROM backing (simulator_modules.c)
+ * ============================================================================ */
+
+/* The boot ROM module, NULL if it is not loaded */
+simulator_module_t *sim_rom_module(simulator_t *sim);
+
+/* Back the boot ROM with the caller's memory (module size, must outlive
+   the simulator) instead of its own copy */
+void sim_rom_attach(simulator_t *sim, uint8_t *data);
+
+/* ============================================================================
+ * Content hash (simulator_image.c)
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t h;
+    uint64_t len;
+    uint8_t tail[8];                /* Bytes of an incomplete word */
+    unsigned tail_len;
+} sim_hash_t;
+
+void sim_hash_init(sim_hash_t *hash);
+void sim_hash_update(sim_hash_t *hash, const void *data, size_t len);
+uint64_t sim_hash_final(const sim_hash_t *hash);
+
+/* ============================================================================
+ * Decoded instruction cache (cpu_icache.c)
+ * ============================================================================ */
+
+/* Drop all cached instructions */
+void sim_icache_flush(simulator_t *sim);
+
+/* Decode the opcode at pc into its cache entry, NULL if pc isn't cacheable */
+icache_entry_t *sim_icache_fill(simulator_t *sim, uint32_t pc);
+
+/* A write hit a page holding cached code: drop that page's entries */
+void sim_icache_invalidate_page(simulator_t *sim, uint32_t page);
+
+/* ============================================================================
+ * Basic block translator (cpu_translate.c)
+ * ============================================================================ */
+
+/* Drop all translated blocks */
+void sim_tb_flush(simulator_t *sim);
+
+/* Record an interpreted opcode (e, fetched at pc, left the PC at next_pc) */
+void sim_tb_record(simulator_t *sim, const icache_entry_t *e, uint32_t pc, uint32_t next_pc);
+
+/* A write hit a page holding translated code: drop its blocks */
+void sim_tb_invalidate_page(simulator_t *sim, uint32_t page);
+
+/* Block starting at pc, NULL if there is none */
+static inline tb_block_t *sim_tb_lookup(simulator_priv_t *priv, uint32_t pc)
+{
+    tb_block_t *b = priv->tb_hash[(pc >> 1) & TB_HASH_MASK];
+    return (b && b->pc == pc) ? b : NULL;
+}
+
+/* ============================================================================
+ * Opcode dispatch (sttable.c, cpu_cycles.c, cpu_instructions.c)
+ * ============================================================================ */
+
+/* Every opcode word maps to one of at most 256 handlers */
+#define OPERATION_MAX_HANDLERS 256
+
+extern const uint8_t OperationIndex[65536];
+extern const opcode_handler_t OperationHandlers[];
+extern const int OperationHandlerCount;
+
+/* Base cycles per handler index, built by cpu_build_cycle_table() */
+extern uint8_t OperationHandlerCycles[OPERATION_MAX_HANDLERS];
+
+static inline uint8_t cpu_opcode_cycles(uint16_t opcode)
+{
+    return OperationHandlerCycles[OperationIndex[opcode]];
+}
+
+/* Handler for an opcode: its size/mode specialised instance if there is one */
+opcode_handler_t cpu_decode_handler(uint16_t opcode);
+
+/* ============================================================================
+ * CPU core entry points (cpu_core_new.c)
+ * ============================================================================ */
+
+void cpu_init_state(void);
+void cpu_execute_opcode(simulator_t *sim);
+void cpu_execute_many(simulator_t *sim, unsigned long ops);
+uint32_t cpu_execute_batch(simulator_t *sim, uint32_t count, uint64_t cycle_limit,
+                           uint32_t stop_conditions);
+void cpu_build_cycle_table(void);
+void cpu_specialise_handlers(void);
+simulator_t *cpu_get_current_simulator(void);
+void cpu_set_current_simulator(simulator_t *sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIMULATOR_INTERNAL_H__ */
@@ -0,0 +1,121 @@
+/*
+ * simulator_mem.h
+ *
+ * Direct-pointer memory access layer for the EVM simulator
+ * Shared by the page table (simulator.c), the CPU memory routines (stmem.c)
+ * and the RAM/ROM modules. Cacheable pages carry a host pointer to the
+ * module's backing store; only I/O pages (68230, 68681) use callbacks.
+ */
+
+#ifndef __SIMULATOR_MEM_H__
+#define __SIMULATOR_MEM_H__
+
+#include <stdint.h>
+#include <string.h>
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Memory map geometry: 16K entries = 16MB at 1KB granularity */
+#define MEMORY_MAP_SIZE   (16 * 1024)
+#define MEMORY_PAGE_SHIFT 10
+#define MEMORY_PAGE_SIZE  (1 << MEMORY_PAGE_SHIFT)
+#define MEMORY_PAGE_MASK  (MEMORY_PAGE_SIZE - 1)
+
+/* Memory map entry - one per 1KB page */
+typedef struct {
+    simulator_module_t *mod;        /* Module owning this page, NULL if unmapped */
+    uint8_t *host;                  /* Host pointer to page start (RAM/ROM), NULL for I/O */
+    uint8_t *whost;                 /* Same for writes; NULL while the instruction cache
+                                       holds code from this page, so writes take the
+                                       slow path and invalidate it */
+} memory_page_t;
+
+/* ============================================================================
+ * Big-endian host memory helpers
+ *
+ * memcpy() into a local lets the compiler emit a single (unaligned) load or
+ * store; the byte swap maps to bswap/rev on little-endian hosts.
+ * ============================================================================ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MEM_BSWAP16(x) __builtin_bswap16(x)
+#define MEM_BSWAP32(x) __builtin_bswap32(x)
+#else
+#define MEM_BSWAP16(x) ((uint16_t)(((x) >> 8) | ((x) << 8)))
+#define MEM_BSWAP32(x) ((((x) >> 24) & 0x000000FFu) | (((x) >> 8) & 0x0000FF00u) | \
+                        (((x) << 8) & 0x00FF0000u) | (((x) << 24) & 0xFF000000u))
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define MEM_BE16(x) (x)
+#define MEM_BE32(x) (x)
+#else
+#define MEM_BE16(x) MEM_BSWAP16(x)
+#define MEM_BE32(x) MEM_BSWAP32(x)
+#endif
+
+static inline uint32_t mem_get16(const uint8_t *p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return MEM_BE16(v);
+}
+
+static inline uint32_t mem_get32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return MEM_BE32(v);
+}
+
+static inline void mem_put16(uint8_t *p, uint32_t data)
+{
+    uint16_t v = MEM_BE16((uint16_t)data);
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline void mem_put32(uint8_t *p, uint32_t data)
+{
+    uint32_t v = MEM_BE32(data);
+    memcpy(p, &v, sizeof(v));
+}
+
+/* ============================================================================
+ * Page table lookups
+ *
+ * Return the host pointer for a size-byte access at addr in page table map
+ * (one per simulator), or NULL if the access must go through the module
+ * callback (I/O page, unmapped page, access straddling a page boundary or -
+ * for writes - a page with cached code).
+ * ============================================================================ */
+
+static inline uint8_t *mem_host_ptr(const memory_page_t *map, uint32_t addr, int size)
+{
+    const memory_page_t *page = &map[(addr & 0xFFFFFF) >> MEMORY_PAGE_SHIFT];
+    uint32_t offset = addr & MEMORY_PAGE_MASK;
+
+    if (page->host && offset <= (uint32_t)(MEMORY_PAGE_SIZE - size)) {
+        return page->host + offset;
+    }
+    return NULL;
+}
+
+static inline uint8_t *mem_host_wptr(const memory_page_t *map, uint32_t addr, int size)
+{
+    const memory_page_t *page = &map[(addr & 0xFFFFFF) >> MEMORY_PAGE_SHIFT];
+    uint32_t offset = addr & MEMORY_PAGE_MASK;
+
+    if (page->whost && offset <= (uint32_t)(MEMORY_PAGE_SIZE - size)) {
+        return page->whost + offset;
+    }
+    return NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIMULATOR_MEM_H__ */
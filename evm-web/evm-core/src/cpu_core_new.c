@@ -8,6 +8,7 @@
 #include <string.h>
 #include <math.h>
 #include "simulator.h"
+#include "simulator_internal.h"
 #include "STFLAGS.H"
 #include "STEACALC.H"
 #include "STEXEP.H"
@@ -15,36 +16,13 @@
 #include "STSTDDEF.H"
 
 // ============================================================================
-// Global CPU state (from original Stcom.c)
+// CPU state
 // ============================================================================
 
-CPU cpu;                                    // Virtual CPU register set
-simulator_t *g_sim = NULL;                  // Current simulator context (shared with stmem.c)
-BOOL bStopped = FALSE;                      // STOP instruction flag
-struct tag_work work;                       // Work structure for calculations
-
-long savepc, spc;                           // Temporary PC
-long pcbefore;                              // PC before instruction
-char AddressError = 0;                      // Address error flag
-
-// Opcode decoding union
-union {
-    unsigned short o;                       // Opcode
-    struct {
-        unsigned regsrc   : 3;              // 0x0007
-        unsigned modesrc  : 3;              // 0x0038
-        unsigned modedest : 3;              // 0x01C0
-        unsigned regdest  : 3;              // 0x0E00
-        unsigned group    : 4;              // 0xF000
-    }general;
-    struct {
-        unsigned regsrc   : 3;              // 0x0007
-        unsigned modesrc  : 3;              // 0x0038
-        unsigned size     : 2;              // 0x00C0
-        unsigned reserved : 4;              // 0x0F00
-        unsigned group    : 4;              // 0xF000
-    }special;
-}of;                                        // Opcode union
+// The handlers work on the simulator running on this thread: its register
+// file (REGS) and its core context (OF, WORK, CCR, ... see STSTDDEF.H)
+SIM_THREAD_LOCAL simulator_t *g_sim = NULL;
+SIM_THREAD_LOCAL cpu_core_t *g_core = NULL;
 
 // EA calculation function pointer array
 long (*CommandMode[8])(char reg, char command, long destination, char size) = {
@@ -66,108 +44,366 @@ extern void PUTdword(long addr, long data);
 // Opcode Execution Dispatch
 // ============================================================================
 
-// Forward declare the operation jump table (from sttable.c)
-// This jump table contains 65536 entries mapping opcodes to handler functions
-extern void (*Operation[])(short opcode);
+// Opcodes are decoded through OperationIndex[]/OperationHandlers[] (sttable.c),
+// see cpu_decode_handler() and cpu_opcode_cycles() in simulator_internal.h
 
 // ============================================================================
 // Main Execution Loop
 // ============================================================================
 
-void cpu_execute_opcode(simulator_t *sim)
-{
-    if (sim == NULL) return;
+#define OPCODE_STOP 0x4E72
+#define OPCODE_RTE  0x4E73
 
-    g_sim = sim;
+// Cycle costs outside the per-handler table (cpu_cycles.c)
+#define CYCLES_ADDRESS_ERROR 50     // Address error exception processing
+#define CYCLES_INTERRUPT     26     // Interrupt acknowledge + exception processing
+#define CYCLES_STOPPED       4      // Clock advance per loop while stopped
 
-    // CRITICAL: Sync simulator's CPU state to global cpu variable
-    // The instruction handlers use the global 'cpu' variable, but we maintain state in sim->cpu
-    cpu.pc = sim->cpu.pc;
-    cpu.sregs.sr = sim->cpu.sr;
-    cpu.usp = sim->cpu.usp;
-    cpu.ssp = sim->cpu.ssp;
-    cpu.msp = sim->cpu.msp;
-    for (int i = 0; i < 8; i++) {
-        cpu.dregs.d[i] = sim->cpu.d[i];
-        cpu.aregs.a[i] = sim->cpu.a[i];
+// Shadow stack pointer A7 stands for in the current privilege mode
+static inline uint32_t *cpu_stack_shadow(void)
+{
+    switch (REGS.sregs.sr & 0x3000) {
+        case 0x2000: return &REGS.ssp;
+        case 0x3000: return &REGS.msp;
+        default:     return &REGS.usp;
     }
+}
 
-    // Fetch opcode
-    if (cpu.pc & 0x00000001L) {
-        addr_err();  // Address error on odd PC
-        return;
+static inline int cpu_at_breakpoint(const simulator_priv_t *priv)
+{
+    for (int i = 0; i < priv->num_breakpoints; i++) {
+        if (priv->breakpoints[i] == (REGS.pc & 0xFFFFFF)) return 1;
     }
+    return 0;
+}
 
-    of.o = GETword(cpu.pc);
+/*
+ * Run translated blocks, starting with 'b' and following chained successors
+ *
+ * Returns the number of opcodes executed. Within a block there is no device
+ * time slice and no interrupt check: a block ends at every opcode that can
+ * change the SR or the interrupt level (SR writes, RTE, traps, I/O access),
+ * and leaves early when an event is due or the clock reaches 'cycle_limit'.
+ * Chaining stops at such blocks and while breakpoints are set, so the batch
+ * loop sees every point it has to act on.
+ */
+static uint32_t cpu_run_blocks(simulator_t *sim, tb_block_t *b, uint32_t budget,
+                               uint64_t cycle_limit)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    uint64_t stop_at = priv->next_event < cycle_limit ? priv->next_event : cycle_limit;
+    uint32_t executed = 0;
+    int pure = 1;
+
+    priv->tb_exit = 0;
+
+    for (;;) {
+        const icache_entry_t *e = b->insn;
+        pure &= b->pure;
+        uint32_t *shadow = cpu_stack_shadow();
+
+        // Direct threaded: pre-bound handlers back to back
+        for (;;) {
+            PCBEFORE = e->pc;
+            OF.o = e->opcode;
+            REGS.cycles += e->cycles;
+            e->handler(OF.o);
+            e++;
+            if (REGS.pc != e->pc || REGS.cycles >= stop_at || priv->tb_exit) break;
+            *shadow = REGS.aregs.a[7];
+        }
+        executed += (uint32_t)(e - b->insn);
 
-    // Setup stack pointer based on privilege mode
-    switch (cpu.sregs.sr & 0x3000) {
-        case 0:
-        case 0x1000:
-            cpu.aregs.a[7] = cpu.usp;
+        // Ran to the end of a block that allows chaining?
+        if (e->pc != ICACHE_EMPTY || b->exit_to_loop || REGS.cycles >= stop_at ||
+            priv->tb_exit || priv->num_breakpoints || priv->pause_requested) {
             break;
-        case 0x2000:
-            cpu.aregs.a[7] = cpu.ssp;
-            break;
-        case 0x3000:
-            cpu.aregs.a[7] = cpu.msp;
-    }
+        }
 
-    // Save PC for exception handling
-    pcbefore = cpu.pc;
+        // Follow the chain, link the successor on first use
+        tb_block_t *next = b->link[0];
+        if (next == NULL || next->pc != REGS.pc) {
+            next = b->link[1];
+            if (next == NULL || next->pc != REGS.pc) {
+                next = sim_tb_lookup(priv, REGS.pc);
+                if (next == NULL) break;
+                b->link[b->link[0] != NULL] = next;
+            }
+        }
+        if (budget - executed < next->num_insns) break;
 
-    // Decode and execute opcode
-    if (!bStopped) {
-        Operation[of.o](of.o);
+        // A branch/JSR/RTS doesn't switch modes: the shadow stays valid
+        *shadow = REGS.aregs.a[7];
+        b = next;
     }
 
-    // Check for STOP instruction
-    if (of.o == 0x4E72 && pcbefore == cpu.pc) {
-        bStopped = TRUE;
+    priv->tb_pure = pure;
+    return executed;
+}
+
+// ============================================================================
+// Polling Loops
+// ============================================================================
+
+#define SPIN_MAX_INSNS 32           // Longest loop iteration that is looked for
+
+static inline void cpu_spin_snapshot(spin_probe_t *s, uint32_t executed, uint32_t io_unstable)
+{
+    s->pc = REGS.pc;
+    s->pure = 1;
+    s->spinning = 0;
+    s->executed = executed;
+    s->cycles = REGS.cycles;
+    s->io_unstable = io_unstable;
+    memcpy(s->d, REGS.dregs.d, sizeof(s->d));
+    memcpy(s->a, REGS.aregs.a, sizeof(s->a));
+    s->sr = REGS.sregs.sr;
+    s->n = CCR.n < 0;
+    s->z = CCR.z == 0;
+    s->v = CCR.v;
+    s->c = CCR.c;
+    s->x = CCR.x;
+}
+
+static inline int cpu_spin_same_state(const spin_probe_t *s)
+{
+    return s->sr == REGS.sregs.sr && s->n == (CCR.n < 0) && s->z == (CCR.z == 0) &&
+           s->v == CCR.v && s->c == CCR.c && s->x == CCR.x &&
+           memcmp(s->d, REGS.dregs.d, sizeof(s->d)) == 0 &&
+           memcmp(s->a, REGS.aregs.a, sizeof(s->a)) == 0;
+}
+
+/*
+ * Skip the idle iterations of a loop that polls a device
+ *
+ * Called at the end of every batch loop iteration. When the PC comes back
+ * to where the last snapshot was taken with the same registers and flags,
+ * and in between only pure translated blocks ran (no memory writes) and
+ * every device read was read_stable(), each further iteration would read
+ * the same values and end in the same state - until a device event fires
+ * or the host acts. The iterations that end before the next event are
+ * skipped: clock and opcode count advance as if they had run.
+ *
+ * Returns the number of opcodes skipped.
+ */
+static inline uint32_t cpu_spin_check(simulator_priv_t *priv, int pure, uint32_t executed,
+                                      uint32_t count, uint64_t cycle_limit)
+{
+    spin_probe_t *s = &priv->spin;
+
+    s->pure &= pure;
+    if (REGS.pc != s->pc) {
+        // Somewhere inside the iteration after the snapshot
+        if (s->pc != ICACHE_EMPTY && executed - s->executed <= SPIN_MAX_INSNS) return 0;
+    } else if (s->pure && priv->io_unstable == s->io_unstable && cpu_spin_same_state(s)) {
+        uint64_t wake = priv->next_event < cycle_limit ? priv->next_event : cycle_limit;
+        uint64_t cycles = REGS.cycles - s->cycles;
+        uint32_t insns = executed - s->executed;
+        uint64_t loops = 0;
+
+        if (cycles > 0 && insns > 0 && wake > REGS.cycles) {
+            loops = (wake - 1 - REGS.cycles) / cycles;
+            if (loops > (count - executed) / insns) loops = (count - executed) / insns;
+        }
+        REGS.cycles += loops * cycles;
+        s->spinning = 1;
+        s->cycles = REGS.cycles;
+        s->executed = executed + (uint32_t)loops * insns;
+        s->pure = 1;
+        return (uint32_t)loops * insns;
     }
 
-    // Update shadow stack pointers
-    switch (cpu.sregs.sr & 0x3000) {
-        case 0:
-        case 0x1000:
-            cpu.usp = cpu.aregs.a[7];
+    cpu_spin_snapshot(s, executed, priv->io_unstable);
+    return 0;
+}
+
+/*
+ * Execute up to 'count' opcodes, or until REGS.cycles reaches 'cycle_limit'
+ *
+ * g_sim and A7 are set up once per batch. The shadow stack pointer of the
+ * current mode is written back after every opcode, so the exception
+ * handlers always see an up to date SSP/USP/MSP. The same goes for the
+ * condition codes: lazy in CCR during the batch, back in REGS.sregs.sr
+ * when it returns. Stop conditions are only
+ * evaluated at instruction boundaries; the breakpoint check runs after an
+ * opcode, so a breakpoint at the starting PC is stepped over.
+ *
+ * Opcodes that miss the translated blocks are interpreted one at a time
+ * and recorded into new blocks (cpu_translate.c). Translation is off while
+ * a module still polls, since it needs a call after every opcode.
+ *
+ * While the CPU is stopped, each loop advances the clock by CYCLES_STOPPED
+ * and counts as one opcode; the loops up to the next device event are
+ * skipped in one step. Loops that poll a device are skipped the same way
+ * (cpu_spin_check()).
+ */
+uint32_t cpu_execute_batch(simulator_t *sim, uint32_t count, uint64_t cycle_limit,
+                           uint32_t stop_conditions)
+{
+    if (sim == NULL) return 0;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    simulator_module_t **polled = priv->polled;
+    int num_polled = priv->num_polled;
+    int reason = SIM_STOPPED_BUDGET;
+    int translate = (num_polled == 0);
+    // Breakpoints are no reason to run every loop: blocks start at each of
+    // them, so the iteration that is repeated would have stopped at one
+    int spin_check = translate;
+    uint32_t executed = 0;
+
+    // The handlers work directly on the simulator's register file
+    cpu_set_current_simulator(sim);
+
+    // Setup stack pointer based on privilege mode
+    REGS.aregs.a[7] = *cpu_stack_shadow();
+
+    // The condition codes live in CCR until the batch ends
+    ccr_load();
+
+    // The host may have changed anything since the last batch
+    priv->spin.pc = ICACHE_EMPTY;
+
+    while (executed < count && REGS.cycles < cycle_limit) {
+        uint32_t ops = 1;
+        int pure = 0;
+        tb_block_t *b;
+
+        if (!STOPPED && translate && OF.o != OPCODE_RTE &&
+            (b = sim_tb_lookup(priv, REGS.pc)) != NULL && count - executed >= b->num_insns) {
+            // Translated code; an RTE is followed by one interpreted opcode
+            // so a pending interrupt is taken right after it
+            ops = cpu_run_blocks(sim, b, count - executed, cycle_limit);
+            pure = priv->tb_pure;
+            priv->icache_hits += ops;
+            *cpu_stack_shadow() = REGS.aregs.a[7];
+
+            if (STOPPED && (stop_conditions & SIM_STOP_ON_STOP)) {
+                reason = SIM_STOPPED_STOP;
+            }
+        } else if (!STOPPED) {
+            // Save PC for exception handling
+            PCBEFORE = REGS.pc;
+
+            // Fetch opcode
+            if (REGS.pc & 0x00000001L) {
+                addr_err();  // Address error on odd PC
+                REGS.cycles += CYCLES_ADDRESS_ERROR;
+            } else {
+                // Decoded instruction cache, fetch + decode only on a miss
+                icache_entry_t *e = &priv->icache[(REGS.pc >> 1) & ICACHE_MASK];
+                if (e->pc == REGS.pc) {
+                    priv->icache_hits++;
+                } else {
+                    priv->icache_misses++;
+                    e = sim_icache_fill(sim, REGS.pc);
+                }
+
+                // Execute opcode (EA calculation adds its own cycles)
+                if (e) {
+                    OF.o = e->opcode;
+                    REGS.cycles += e->cycles;
+                    priv->tb_exit = 0;
+                    e->handler(OF.o);
+                    if (translate) {
+                        sim_tb_record(sim, e, PCBEFORE, REGS.pc);
+                    }
+                } else {
+                    OF.o = GETword(REGS.pc);
+                    REGS.cycles += cpu_opcode_cycles(OF.o);
+                    cpu_decode_handler(OF.o)(OF.o);
+                }
+
+                // STOP #imm that left the PC alone (legacy stub behaviour)
+                if (OF.o == OPCODE_STOP && PCBEFORE == REGS.pc) {
+                    STOPPED = TRUE;
+                }
+            }
+
+            // Update shadow stack pointer of the (possibly new) mode
+            *cpu_stack_shadow() = REGS.aregs.a[7];
+
+            if (STOPPED && (stop_conditions & SIM_STOP_ON_STOP)) {
+                reason = SIM_STOPPED_STOP;
+            }
+        } else {
+            // Stopped: nothing can happen before the next device event, so
+            // take all idle loops up to it at once. Clock and count end up
+            // as if they had run one by one; a polling module or a
+            // breakpoint at the PC needs each loop
+            uint64_t wake = priv->next_event < cycle_limit ? priv->next_event : cycle_limit;
+            uint64_t loops = 1;
+
+            if (num_polled == 0 && wake > REGS.cycles &&
+                !(priv->num_breakpoints && (stop_conditions & SIM_STOP_BREAKPOINT) &&
+                  cpu_at_breakpoint(priv))) {
+                loops = (wake - REGS.cycles + CYCLES_STOPPED - 1) / CYCLES_STOPPED;
+                if (loops > count - executed) loops = count - executed;
+            }
+            REGS.cycles += loops * CYCLES_STOPPED;
+            ops = (uint32_t)loops;
+        }
+
+        // Devices only run when one of their events is due
+        if (REGS.cycles >= priv->next_event) {
+            sim_events_dispatch(sim);
+            pure = 0;       // The devices may look different from here on
+        }
+
+        // Modules that still poll
+        for (int i = 0; i < num_polled; i++) {
+            polled[i]->simulate(polled[i]);
+        }
+
+        executed += ops;
+
+        // No interrupt right after RTE, at least one opcode runs in between
+        if (OF.o != OPCODE_RTE && InterruptPending()) {
+            CheckForInt();
+            REGS.cycles += CYCLES_INTERRUPT;
+            STOPPED = FALSE;
+            pure = 0;
+            if (stop_conditions & SIM_STOP_INTERRUPT) {
+                reason = SIM_STOPPED_INTERRUPT;
+            }
+        }
+
+        if (reason != SIM_STOPPED_BUDGET) {
             break;
-        case 0x2000:
-            cpu.ssp = cpu.aregs.a[7];
+        }
+        if (priv->pause_requested) {
+            priv->pause_requested = 0;
+            reason = SIM_STOPPED_PAUSE;
             break;
-        case 0x3000:
-            cpu.msp = cpu.aregs.a[7];
-    }
-
-    // CRITICAL: Sync global cpu variable back to simulator's CPU state
-    // This ensures that cpu_get_state() returns the updated state after instruction execution
-    sim->cpu.pc = cpu.pc;
-    sim->cpu.sr = cpu.sregs.sr;
-    sim->cpu.usp = cpu.usp;
-    sim->cpu.ssp = cpu.ssp;
-    sim->cpu.msp = cpu.msp;
-    for (int i = 0; i < 8; i++) {
-        sim->cpu.d[i] = cpu.dregs.d[i];
-        sim->cpu.a[i] = cpu.aregs.a[i];
-    }
+        }
+        if (priv->num_breakpoints && (stop_conditions & SIM_STOP_BREAKPOINT) &&
+            cpu_at_breakpoint(priv)) {
+            reason = SIM_STOPPED_BREAKPOINT;
+            break;
+        }
 
-    // Call module simulation procedures
-    for (int i = 0; i < sim->num_modules; i++) {
-        if (sim->modules[i]->simulate) {
-            sim->modules[i]->simulate(sim->modules[i]);
+        if (spin_check) {
+            executed += cpu_spin_check(priv, pure, executed, count, cycle_limit);
         }
     }
+
+    ccr_sync();
+    priv->stop_reason = reason;
+    return executed;
 }
 
-void cpu_execute_many(simulator_t *sim, unsigned long ops)
+void cpu_execute_opcode(simulator_t *sim)
 {
-    if (sim == NULL) return;
-
-    g_sim = sim;
+    cpu_execute_batch(sim, 1, UINT64_MAX, SIM_STOP_NONE);
+}
 
-    while (ops--) {
-        cpu_execute_opcode(sim);
+void cpu_execute_many(simulator_t *sim, unsigned long ops)
+{
+    while (ops > 0xFFFFFFFFUL) {
+        cpu_execute_batch(sim, 0xFFFFFFFFUL, UINT64_MAX, SIM_STOP_NONE);
+        ops -= 0xFFFFFFFFUL;
     }
+    cpu_execute_batch(sim, (uint32_t)ops, UINT64_MAX, SIM_STOP_NONE);
 }
 
 // ============================================================================
@@ -176,17 +412,21 @@ void cpu_execute_many(simulator_t *sim, unsigned long ops)
 
 void cpu_init_state(void)
 {
-    memset(&cpu, 0, sizeof(CPU));
-    memset(&work, 0, sizeof(struct tag_work));
+    if (g_sim == NULL) return;
+
+    memset(&REGS, 0, sizeof(CPU));
+    memset(&WORK, 0, sizeof(struct tag_work));
+    memset(&g_core->irq, 0, sizeof(g_core->irq));
+    g_core->irq.VecNum = 0x0f;
 
-    cpu.pc = 0x000000;
-    cpu.sregs.sr = 0x2700;      // Supervisor mode, IPL=7
-    cpu.usp = 0x400000;         // User stack in RAM
-    cpu.ssp = 0x410000;         // Supervisor stack in RAM
-    cpu.msp = 0x420000;         // Master stack in RAM
+    REGS.pc = 0x000000;
+    REGS.sregs.sr = 0x2700;      // Supervisor mode, IPL=7
+    REGS.usp = 0x400000;         // User stack in RAM
+    REGS.ssp = 0x410000;         // Supervisor stack in RAM
+    REGS.msp = 0x420000;         // Master stack in RAM
 
-    bStopped = FALSE;
-    AddressError = 0;
+    STOPPED = FALSE;
+    ADDRESS_ERROR = 0;
 }
 
 simulator_t *cpu_get_current_simulator(void)
@@ -197,5 +437,6 @@ simulator_t *cpu_get_current_simulator(void)
 void cpu_set_current_simulator(simulator_t *sim)
 {
     g_sim = sim;
+    g_core = sim ? &SIM_PRIV(sim)->core : NULL;
 }
 
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+// CPU Cycle Table
+// Base clock cycles per opcode handler
+//
+// Values are MC68020 cache-case timings (instruction already in the cache,
+// no wait states) from the MC68020 User's Manual, section 8. They cover the
+// operation itself; effective address costs are added at run time by the
+// EA calculation routines in steacalc.c, so one table entry per handler
+// (indexed like OperationHandlers[]) is enough. Timing that depends on
+// operands (taken/not taken branches, shift counts, MOVEM register lists,
+// divide values) uses a typical case.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "simulator.h"
+#include "simulator_internal.h"
+
+// Base cycles per handler index (OperationIndex[] of the opcode)
+uint8_t OperationHandlerCycles[OPERATION_MAX_HANDLERS];
+
+// Cycles for an opcode whose handler is not listed below
+#define DEFAULT_CYCLES 4
+
+extern void COM_illegal(short), COM_linea(short), COM_linef(short);
+extern void COM_MoveByte(short), COM_MoveWord(short), COM_MoveLong(short);
+extern void COM_movequick(short), COM_lea(short), COM_pea(short), COM_exg(short);
+extern void COM_add(short), COM_sub(short), COM_and(short), COM_or(short), COM_eor(short);
+extern void COM_cmp(short), COM_cmpa(short), COM_addq(short), COM_subq(short), COM_subx(short);
+extern void COM_addi(short), COM_subi(short), COM_andi(short), COM_ori(short);
+extern void COM_eori(short), COM_cmpi(short);
+extern void COM_clr(short), COM_neg(short), COM_negx(short), COM_not(short), COM_tst(short);
+extern void COM_ext(short), COM_swap(short), COM_tas(short), COM_chk(short);
+extern void COM_abcd(short), COM_sbcd(short), COM_nbcd(short), COM_pack(short), COM_unpack(short);
+extern void COM_mulu(short), COM_divx(short), COM_mul020(short), COM_div020(short);
+extern void COM_asx(short), COM_lsx(short), COM_rx(short), COM_r(short);
+extern void COM_dyntstbit(short), COM_stattstbit(short), COM_BitField(short);
+extern void COM_movep(short), COM_movemtoEA(short), COM_movemtoreg(short);
+extern void COM_movec(short), COM_moveUSP(short), COM_movetoSR(short), COM_movefromSR(short);
+extern void COM_movetoCCR(short);
+extern void COM_bra(short), COM_bsr(short), COM_bhi(short), COM_bls(short), COM_bcc(short);
+extern void COM_bcs(short), COM_bne(short), COM_beq(short), COM_bvc(short), COM_bvs(short);
+extern void COM_bpl(short), COM_bmi(short), COM_bge(short), COM_blt(short), COM_bgt(short);
+extern void COM_ble(short), COM_dbcc(short), COM_scc(short);
+extern void COM_jmp(short), COM_jsr(short), COM_rts(short), COM_rtr(short), COM_rte(short);
+extern void COM_link(short), COM_unlink(short), COM_trap(short), COM_trapv(short);
+extern void COM_nop(short), COM_stop(short), COM_reset(short);
+
+static const struct {
+    void (*handler)(short);
+    unsigned char cycles;
+} HandlerCycles[] = {
+    // data movement
+    { COM_MoveByte, 2 }, { COM_MoveWord, 2 }, { COM_MoveLong, 2 },
+    { COM_movequick, 2 }, { COM_lea, 2 }, { COM_pea, 5 }, { COM_exg, 2 },
+    { COM_movep, 11 }, { COM_movemtoEA, 12 }, { COM_movemtoreg, 16 },
+    { COM_link, 5 }, { COM_unlink, 6 },
+
+    // integer arithmetic and logic
+    { COM_add, 2 }, { COM_sub, 2 }, { COM_and, 2 }, { COM_or, 2 }, { COM_eor, 2 },
+    { COM_cmp, 2 }, { COM_cmpa, 4 }, { COM_addq, 2 }, { COM_subq, 2 }, { COM_subx, 2 },
+    { COM_addi, 2 }, { COM_subi, 2 }, { COM_andi, 2 }, { COM_ori, 2 },
+    { COM_eori, 2 }, { COM_cmpi, 2 },
+    { COM_clr, 2 }, { COM_neg, 2 }, { COM_negx, 2 }, { COM_not, 2 }, { COM_tst, 2 },
+    { COM_ext, 4 }, { COM_swap, 4 }, { COM_tas, 12 }, { COM_chk, 8 },
+    { COM_mulu, 27 }, { COM_mul020, 43 }, { COM_divx, 44 }, { COM_div020, 78 },
+
+    // BCD
+    { COM_abcd, 4 }, { COM_sbcd, 4 }, { COM_nbcd, 6 }, { COM_pack, 6 }, { COM_unpack, 8 },
+
+    // shift, rotate, bit and bit field
+    { COM_asx, 6 }, { COM_lsx, 4 }, { COM_rx, 6 }, { COM_r, 6 },
+    { COM_dyntstbit, 4 }, { COM_stattstbit, 4 }, { COM_BitField, 12 },
+
+    // program control (branches: taken case)
+    { COM_bra, 6 }, { COM_bsr, 7 }, { COM_bhi, 6 }, { COM_bls, 6 }, { COM_bcc, 6 },
+    { COM_bcs, 6 }, { COM_bne, 6 }, { COM_beq, 6 }, { COM_bvc, 6 }, { COM_bvs, 6 },
+    { COM_bpl, 6 }, { COM_bmi, 6 }, { COM_bge, 6 }, { COM_blt, 6 }, { COM_bgt, 6 },
+    { COM_ble, 6 }, { COM_dbcc, 6 }, { COM_scc, 4 },
+    { COM_jmp, 4 }, { COM_jsr, 7 }, { COM_rts, 10 }, { COM_rtr, 12 }, { COM_rte, 20 },
+    { COM_nop, 2 },
+
+    // system control
+    { COM_movec, 10 }, { COM_moveUSP, 2 }, { COM_movetoSR, 8 }, { COM_movefromSR, 2 },
+    { COM_movetoCCR, 4 }, { COM_stop, 8 },
+    { COM_reset, 255 },     // really 518, saturated to fit the table
+
+    // exceptions
+    { COM_trap, 20 }, { COM_trapv, 5 },
+    { COM_illegal, 20 }, { COM_linea, 20 }, { COM_linef, 20 },
+};
+
+// ============================================================================
+// Table setup (once per process, simulator_init())
+// ============================================================================
+
+void cpu_build_cycle_table(void)
+{
+    for (int h = 0; h < OperationHandlerCount; h++) {
+        OperationHandlerCycles[h] = DEFAULT_CYCLES;
+        for (size_t i = 0; i < sizeof(HandlerCycles) / sizeof(HandlerCycles[0]); i++) {
+            if (OperationHandlers[h] == HandlerCycles[i].handler) {
+                OperationHandlerCycles[h] = HandlerCycles[i].cycles;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////
+// Decoded Instruction Cache
+// Caches fetch + decode (opcode word, handler, cycle cost) per PC
+//
+// The cache is direct mapped on (pc >> 1) and only covers RAM/ROM pages.
+// While a page holds cached code its memory_map[].whost pointer is cleared,
+// so every write to that page leaves the direct-pointer fast path and ends
+// up in simulator_write_memory(), which drops the page's entries (and the
+// translated blocks covering it, cpu_translate.c) again.
+// Since the cache spans more than one page, the entries of a page always
+// live in one contiguous block of MEMORY_PAGE_SIZE/2 slots.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "simulator.h"
+#include "simulator_mem.h"
+#include "simulator_internal.h"
+
+// Cache slots per memory page (one per even address)
+#define ICACHE_SLOTS_PER_PAGE (MEMORY_PAGE_SIZE / 2)
+
+void sim_icache_flush(simulator_t *sim)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    for (int i = 0; i < ICACHE_SIZE; i++) {
+        priv->icache[i].pc = ICACHE_EMPTY;
+    }
+
+    // No page holds cached code any more
+    sim_tb_flush(sim);
+    for (int i = 0; i < MEMORY_MAP_SIZE; i++) {
+        priv->core.memory_map[i].whost = sim_page_whost(priv, i);
+    }
+}
+
+icache_entry_t *sim_icache_fill(simulator_t *sim, uint32_t pc)
+{
+    uint32_t addr = pc & 0xFFFFFF;
+    memory_page_t *page = &SIM_MEMORY_MAP(sim)[addr >> MEMORY_PAGE_SHIFT];
+
+    // I/O and unmapped pages are always fetched through the module
+    if (page->host == NULL) return NULL;
+
+    icache_entry_t *e = &SIM_PRIV(sim)->icache[(pc >> 1) & ICACHE_MASK];
+    uint16_t opcode = (uint16_t)mem_get16(page->host + (addr & MEMORY_PAGE_MASK));
+
+    e->pc = pc;
+    e->opcode = opcode;
+    e->handler = cpu_decode_handler(opcode);
+    e->cycles = cpu_opcode_cycles(opcode);
+
+    // Writes to this page must invalidate from now on
+    page->whost = NULL;
+
+    return e;
+}
+
+void sim_icache_invalidate_page(simulator_t *sim, uint32_t page)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    uint32_t first = (page * ICACHE_SLOTS_PER_PAGE) & ICACHE_MASK;
+
+    for (uint32_t i = 0; i < ICACHE_SLOTS_PER_PAGE; i++) {
+        icache_entry_t *e = &priv->icache[(first + i) & ICACHE_MASK];
+        if (e->pc != ICACHE_EMPTY && ((e->pc & 0xFFFFFF) >> MEMORY_PAGE_SHIFT) == page) {
+            e->pc = ICACHE_EMPTY;
+        }
+    }
+    sim_tb_invalidate_page(sim, page);
+
+    priv->core.memory_map[page].whost = sim_page_whost(priv, page);
+}
@@ -9,31 +9,13 @@
 #include "STEACALC.H"
 #include "STEXEP.H"
 #include "STMEM.H"
+#include "cpu_ea.h"
 #include "macros.h"
 #include "../include/simulator.h"
+#include "simulator_internal.h"
 #include <stdint.h>
 
 /* Forward declarations */
-extern CPU cpu;
-extern struct tag_work work;
-extern long spc;
-extern union {
-    unsigned short o;
-    struct {
-        unsigned regsrc:3;
-        unsigned modesrc:3;
-        unsigned modedest:3;
-        unsigned regdest:3;
-        unsigned group:4;
-    } general;
-    struct {
-        unsigned regsrc:3;
-        unsigned modesrc:3;
-        unsigned size:2;
-        unsigned reserved:4;
-        unsigned group:4;
-    } special;
-} of;
 extern long (*CommandMode[8])(char reg, char command, long destination, char size);
 
 /* Helper functions for assembly block ports */
@@ -103,167 +85,124 @@ static void div64_signed(int32_t *quotient, int32_t *remainder,
 
 /* Instruction implementations */
 
-void COM_add(short opcode)
+CPU_INLINE void alu_add(int modedest,int modesrc)
 {
-	CACHEFUNCTION(COM_add);
-	cpu.pc+=2;
-	switch(of.general.modedest)
+	REGS.pc+=2;
+	switch(modedest)
 	{
 		case 0:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.dregs.d[of.general.regdest]=(cpu.dregs.d[of.general.regdest])+
-												(unsigned char)(work.source&0x000000ffL);
-			if(cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.dregs.d[OF.general.regdest]=(REGS.dregs.d[OF.general.regdest])+
+												(unsigned char)(WORK.source&0x000000ffL);
+			SETNZ(REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 1:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.dregs.d[of.general.regdest]=
-				(cpu.dregs.d[of.general.regdest]&0xFFFF0000L)|
-					(((cpu.dregs.d[of.general.regdest])+
-						(unsigned short)(work.source&0x0000ffff))&0x0000FFFFL);
-			if(cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.dregs.d[OF.general.regdest]=
+				(REGS.dregs.d[OF.general.regdest]&0xFFFF0000L)|
+					(((REGS.dregs.d[OF.general.regdest])+
+						(unsigned short)(WORK.source&0x0000ffff))&0x0000FFFFL);
+			SETNZ(REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 2:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]+work.source;
-			if(cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]+WORK.source;
+			SETNZ(REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 3:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.aregs.a[of.general.regdest]=cpu.aregs.a[of.general.regdest]+
-							(work.source&0x0000FFFFL);
-			if(cpu.aregs.a[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.aregs.a[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[OF.general.regdest]+
+							(WORK.source&0x0000FFFFL);
+			SETNZ(REGS.aregs.a[OF.general.regdest]);
 			break;
 		case 4:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.pc=spc;
-			work.source=(work.source)+(cpu.dregs.d[of.general.regdest]&0x000000ffL);
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,0);
-			if(work.source==0)ZERO1;
-			else ZERO0;
-			if(work.source<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.pc=SPC;
+			WORK.source=(WORK.source)+(REGS.dregs.d[OF.general.regdest]&0x000000ffL);
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,0);
+			SETNZ(WORK.source);
 			break;
 		case 5:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.pc=spc;
-			work.source=(work.source)+(cpu.dregs.d[of.general.regdest]&0x0000FFFFL);
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,1);
-			if(work.source==0)ZERO1;
-			else ZERO0;
-			if(work.source<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.pc=SPC;
+			WORK.source=(WORK.source)+(REGS.dregs.d[OF.general.regdest]&0x0000FFFFL);
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,1);
+			SETNZ(WORK.source);
 			break;
 		case 6:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.pc=spc;
-			work.source=work.source+cpu.dregs.d[of.general.regdest];
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,2);
-			if(work.source==0)ZERO1;
-			else ZERO0;
-			if(work.source<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.pc=SPC;
+			WORK.source=WORK.source+REGS.dregs.d[OF.general.regdest];
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,2);
+			SETNZ(WORK.source);
 			break;
 		case 7:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.aregs.a[of.general.regdest]=cpu.aregs.a[of.general.regdest]+work.source;
-			if(cpu.aregs.a[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.aregs.a[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[OF.general.regdest]+WORK.source;
+			SETNZ(REGS.aregs.a[OF.general.regdest]);
 			break;
 	}
 
 }
 
 
-void COM_and(short opcode)
+CPU_INLINE void alu_and(int modedest,int modesrc)
 {
-	CACHEFUNCTION(COM_and);
-	cpu.pc+=2;
-	switch(of.general.modedest)
+	REGS.pc+=2;
+	switch(modedest)
 	{
 		case 0:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.dregs.d[of.general.regdest]=
-				(cpu.dregs.d[of.general.regdest])&
-					(work.source|0xffffff00L);
-			if((char)cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if((short)cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.dregs.d[OF.general.regdest]=
+				(REGS.dregs.d[OF.general.regdest])&
+					(WORK.source|0xffffff00L);
+			SETZ((char)REGS.dregs.d[OF.general.regdest]);
+			SETN((short)REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 1:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.dregs.d[of.general.regdest]=
-				(cpu.dregs.d[of.general.regdest])&
-					(work.source|0xffff0000L);
-			if((short)cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if((short)cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.dregs.d[OF.general.regdest]=
+				(REGS.dregs.d[OF.general.regdest])&
+					(WORK.source|0xffff0000L);
+			SETNZ((short)REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 2:
-			work.source=
-				CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]&work.source;
-			if(cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=
+				ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]&WORK.source;
+			SETNZ(REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 4:
-			spc=cpu.pc;
-			work.destination=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			work.destination=(cpu.dregs.d[of.general.regdest])&(work.destination|0xffffff00L);
-			cpu.pc=spc;
-			work.destination=
-				CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,
-					work.destination,0);
-			if((char)work.destination==0)ZERO1;
-			else ZERO0;
-			if((char)work.destination<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.destination=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			WORK.destination=(REGS.dregs.d[OF.general.regdest])&(WORK.destination|0xffffff00L);
+			REGS.pc=SPC;
+			WORK.destination=
+				ea_access(modesrc,(char)(OF.general.regsrc),1,
+					WORK.destination,0);
+			SETNZ((char)WORK.destination);
 			break;
 		case 5:
-			spc=cpu.pc;
-			work.destination=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			work.destination=(cpu.dregs.d[of.general.regdest])&(work.destination|0xffff0000L);
-			cpu.pc=spc;
-			work.destination=
-				CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,
-					work.destination,1);
-			if((short)work.destination==0)ZERO1;
-			else ZERO0;
-			if((short)work.destination<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.destination=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			WORK.destination=(REGS.dregs.d[OF.general.regdest])&(WORK.destination|0xffff0000L);
+			REGS.pc=SPC;
+			WORK.destination=
+				ea_access(modesrc,(char)(OF.general.regsrc),1,
+					WORK.destination,1);
+			SETNZ((short)WORK.destination);
 			break;
 		case 6:
-			spc=cpu.pc;
-			work.destination=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			work.destination=(cpu.dregs.d[of.general.regdest])&(work.destination);
-			cpu.pc=spc;
-			work.destination=CommandMode[of.general.modesrc]((char)(of.general.regsrc),
-																		1,work.destination,2);
-			if(work.destination==0)ZERO1;
-			else ZERO0;
-			if(work.destination<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.destination=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			WORK.destination=(REGS.dregs.d[OF.general.regdest])&(WORK.destination);
+			REGS.pc=SPC;
+			WORK.destination=ea_access(modesrc,(char)(OF.general.regsrc),
+																		1,WORK.destination,2);
+			SETNZ(WORK.destination);
 			break;
 	}
 	CARRY0;
@@ -277,16 +216,16 @@ void COM_beq(short opcode)
 	switch(opcode&0x00ff)
 	{
 		case 0:
-			if( (cpu.sregs.sr&0x04) != 0)cpu.pc=cpu.pc+(short)GETword(cpu.pc+2)+2;
-			else cpu.pc=cpu.pc+4;
+			if( (GETCCR()&0x04) != 0)REGS.pc=REGS.pc+(short)GETword(REGS.pc+2)+2;
+			else REGS.pc=REGS.pc+4;
 			break;
 		case 0xFF:
-			if( (cpu.sregs.sr&0x04) != 0)cpu.pc=cpu.pc+(long)GETdword(cpu.pc+2)+2;
-			else cpu.pc=cpu.pc+6;
+			if( (GETCCR()&0x04) != 0)REGS.pc=REGS.pc+(long)GETdword(REGS.pc+2)+2;
+			else REGS.pc=REGS.pc+6;
 			break;
 		default:
-			if( (cpu.sregs.sr&0x04) != 0)cpu.pc=cpu.pc+(char)(opcode&0x00ff)+2;
-			else cpu.pc=cpu.pc+2;
+			if( (GETCCR()&0x04) != 0)REGS.pc=REGS.pc+(char)(opcode&0x00ff)+2;
+			else REGS.pc=REGS.pc+2;
 			break;
 	}
 }
@@ -298,16 +237,16 @@ void COM_bne(short opcode)
 	switch(opcode&0x00ff)
 	{
 		case 0:
-			if( (cpu.sregs.sr&0x04) == 0)cpu.pc=cpu.pc+(short)GETword(cpu.pc+2)+2;
-			else cpu.pc=cpu.pc+4;
+			if( (GETCCR()&0x04) == 0)REGS.pc=REGS.pc+(short)GETword(REGS.pc+2)+2;
+			else REGS.pc=REGS.pc+4;
 			break;
 		case 0xFF:
-			if( (cpu.sregs.sr&0x04) == 0)cpu.pc=cpu.pc+(long)GETdword(cpu.pc+2)+2;
-			else cpu.pc=cpu.pc+6;
+			if( (GETCCR()&0x04) == 0)REGS.pc=REGS.pc+(long)GETdword(REGS.pc+2)+2;
+			else REGS.pc=REGS.pc+6;
 			break;
 		default:
-			if( (cpu.sregs.sr&0x04) == 0)cpu.pc=cpu.pc+(char)(opcode&0x00ff)+2;
-			else cpu.pc=cpu.pc+2;
+			if( (GETCCR()&0x04) == 0)REGS.pc=REGS.pc+(char)(opcode&0x00ff)+2;
+			else REGS.pc=REGS.pc+2;
 			break;
 	}
 }
@@ -319,25 +258,24 @@ void COM_bra(short opcode)
 	switch(opcode&0x00ff)
 	{
 		case 0:
-			cpu.pc=cpu.pc+(short)GETword(cpu.pc+2)+2;
+			REGS.pc=REGS.pc+(short)GETword(REGS.pc+2)+2;
 			break;
 		case 0xFF:
-			cpu.pc=cpu.pc+(long)GETdword(cpu.pc+2)+2;
+			REGS.pc=REGS.pc+(long)GETdword(REGS.pc+2)+2;
 			break;
 		default:
-			cpu.pc=cpu.pc+(char)(opcode&0x00ff)+2;
+			REGS.pc=REGS.pc+(char)(opcode&0x00ff)+2;
 			break;
 	}
 }
 
 
-void COM_clr(short opcode)
+CPU_INLINE void alu_clr(int size,int modesrc)
 {
-	CACHEFUNCTION(COM_clr);
-	cpu.pc=cpu.pc+2;	// increment PC
+	REGS.pc=REGS.pc+2;	// increment PC
 	// write zero to destination
-	work.destination=CommandMode[of.general.modesrc]((of.general.regsrc),1,0L,
-							of.special.size);
+	WORK.destination=ea_access(modesrc,(OF.general.regsrc),1,0L,
+							size);
 	CARRY0; // flags
 	OVER0;
 	NEG0;
@@ -345,90 +283,79 @@ void COM_clr(short opcode)
 }
 
 
-void COM_cmp(short opcode)
+CPU_INLINE void alu_cmp(int modedest,int modesrc)
 {
-	CACHEFUNCTION(COM_cmp);
-	cpu.pc+=2;
-	switch(of.general.modedest)
+	REGS.pc+=2;
+	switch(modedest)
 	{
 		case 0:
-			work.source=CommandMode[of.general.modesrc]((of.general.regsrc),0,0L,0);
-			work.result=(char)cpu.dregs.d[of.general.regdest]-(char)work.source;
-			setcarry( gen_carry((char)work.source,
-							(char)cpu.dregs.d[of.general.regdest],(char)work.result) );
-			setover( gen_over((char)work.source,
-							(char)cpu.dregs.d[of.general.regdest],(char)work.result) );
-			if((char)work.result==0)ZERO1;
-			else ZERO0;
-			if((char)work.result<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(OF.general.regsrc),0,0L,0);
+			WORK.result=(char)REGS.dregs.d[OF.general.regdest]-(char)WORK.source;
+			setcarry( gen_carry((char)WORK.source,
+							(char)REGS.dregs.d[OF.general.regdest],(char)WORK.result) );
+			setover( gen_over((char)WORK.source,
+							(char)REGS.dregs.d[OF.general.regdest],(char)WORK.result) );
+			SETNZ((char)WORK.result);
 			break;
 		case 1:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			work.result=(short)cpu.dregs.d[of.general.regdest]-(short)work.source;
-			setcarry( gen_carry((short)work.source,
-						(short)cpu.dregs.d[of.general.regdest],(short)work.result) );
-			setover( gen_over((short)work.source,
-						(short)cpu.dregs.d[of.general.regdest],(short)work.result) );
-			if((short)work.result==0)ZERO1;
-			else ZERO0;
-			if((short)work.result<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			WORK.result=(short)REGS.dregs.d[OF.general.regdest]-(short)WORK.source;
+			setcarry( gen_carry((short)WORK.source,
+						(short)REGS.dregs.d[OF.general.regdest],(short)WORK.result) );
+			setover( gen_over((short)WORK.source,
+						(short)REGS.dregs.d[OF.general.regdest],(short)WORK.result) );
+			SETNZ((short)WORK.result);
 			break;
 		case 2:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			work.result=cpu.dregs.d[of.general.regdest]-work.source;
-			setcarry( gen_carry(work.source,cpu.dregs.d[of.general.regdest],work.result) );
-			setover( gen_over(work.source,cpu.dregs.d[of.general.regdest],work.result) );
-			if(work.result==0)ZERO1;
-			else ZERO0;
-			if(work.result<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			WORK.result=REGS.dregs.d[OF.general.regdest]-WORK.source;
+			setcarry( gen_carry(WORK.source,REGS.dregs.d[OF.general.regdest],WORK.result) );
+			setover( gen_over(WORK.source,REGS.dregs.d[OF.general.regdest],WORK.result) );
+			SETNZ(WORK.result);
 			break;
 	}
 }
 
 
-void COM_eor(short opcode)
+CPU_INLINE void alu_eor(int modedest,int modesrc)
 {
-	CACHEFUNCTION(COM_eor);
-	cpu.pc+=2;
-	switch(of.general.modedest)
+	REGS.pc+=2;
+	switch(modedest)
 	{
 		case 0:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.dregs.d[of.general.regdest]=
-				cpu.dregs.d[of.general.regdest]^(work.source&0x000000FF);
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.dregs.d[OF.general.regdest]=
+				REGS.dregs.d[OF.general.regdest]^(WORK.source&0x000000FF);
 			break;
 		case 1:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.dregs.d[of.general.regdest]=
-				cpu.dregs.d[of.general.regdest]^(work.source&0x0000FFFF);
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.dregs.d[OF.general.regdest]=
+				REGS.dregs.d[OF.general.regdest]^(WORK.source&0x0000FFFF);
 			break;
 		case 2:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]^work.source;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]^WORK.source;
 			break;
 		case 4:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.pc=spc;
-			work.source=work.source^(cpu.dregs.d[of.general.regdest]&0x000000FF);
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,0);
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.pc=SPC;
+			WORK.source=WORK.source^(REGS.dregs.d[OF.general.regdest]&0x000000FF);
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,0);
 			break;
 		case 5:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.pc=spc;
-			work.source=work.source^(cpu.dregs.d[of.general.regdest]&0x0000FFFF);
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,1);
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.pc=SPC;
+			WORK.source=WORK.source^(REGS.dregs.d[OF.general.regdest]&0x0000FFFF);
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,1);
 			break;
 		case 6:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.pc=spc;
-			work.source=work.source^cpu.dregs.d[of.general.regdest];
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,2);
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.pc=SPC;
+			WORK.source=WORK.source^REGS.dregs.d[OF.general.regdest];
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,2);
 			break;
 	}
 }
@@ -437,27 +364,27 @@ void COM_eor(short opcode)
 void COM_jmp(short opcode)
 {
 	CACHEFUNCTION(COM_jmp);
-	cpu.pc+=2;
-	switch(of.general.modesrc)
+	REGS.pc+=2;
+	switch(OF.general.modesrc)
 	{
 		case 2:
-			cpu.pc=cpu.aregs.a[(of.general.regsrc)];
+			REGS.pc=REGS.aregs.a[(OF.general.regsrc)];
 			break;
 		case 5:
-			cpu.pc=cpu.aregs.a[(of.general.regsrc)]+(long)GETword(cpu.pc);
+			REGS.pc=REGS.aregs.a[(OF.general.regsrc)]+(long)GETword(REGS.pc);
 			break;
 		case 7:
-			switch(of.general.regsrc)
+			switch(OF.general.regsrc)
 			{
 				case 0:
-					cpu.pc=(long)GETword(cpu.pc);
+					REGS.pc=(long)GETword(REGS.pc);
 					break;
 				case 1:
-					cpu.pc=GETdword(cpu.pc);
+					REGS.pc=GETdword(REGS.pc);
 					break;
 				case 2:
-					cpu.pc=cpu.pc+(long)GETword(cpu.pc);
-					cpu.pc+=2;
+					REGS.pc=REGS.pc+(long)GETword(REGS.pc);
+					REGS.pc+=2;
 					break;
 			}
 			break;
@@ -475,23 +402,23 @@ short extension;
 long ea,od,bd,index;
 
 	CACHEFUNCTION(COM_jsr);
-	cpu.pc+=2;
-	switch(of.general.modesrc)
+	REGS.pc+=2;
+	switch(OF.general.modesrc)
 	{
 		case 2: // ARI
-			cpu.aregs.a[7]-=4; // decrement stack pointer
-			PUTdword(cpu.aregs.a[7],cpu.pc); // save return address on stack
-			cpu.pc=cpu.aregs.a[(of.general.regsrc)]; // set new PC
+			REGS.aregs.a[7]-=4; // decrement stack pointer
+			PUTdword(REGS.aregs.a[7],REGS.pc); // save return address on stack
+			REGS.pc=REGS.aregs.a[(OF.general.regsrc)]; // set new PC
 			break;
 		case 5: // ARID
-			cpu.aregs.a[7]-=4; // decrement stack pointer
-			PUTdword(cpu.aregs.a[7],cpu.pc); // save return address on stack
-			cpu.pc+=(long)GETword(cpu.pc);
+			REGS.aregs.a[7]-=4; // decrement stack pointer
+			PUTdword(REGS.aregs.a[7],REGS.pc); // save return address on stack
+			REGS.pc+=(long)GETword(REGS.pc);
 			break;
 		case 6: // ARII
-			cpu.aregs.a[7]-=4; // decrement stack pointer
-			extension=GETword(cpu.pc); // get extension word
-			cpu.pc+=2; // increment PC
+			REGS.aregs.a[7]-=4; // decrement stack pointer
+			extension=GETword(REGS.pc); // get extension word
+			REGS.pc+=2; // increment PC
 			switch((extension&0x0100)>>8) // 68000 or 68020 extension
 			{
 				case 0: // brief format extension
@@ -499,14 +426,14 @@ long ea,od,bd,index;
 					{
 						if(extension&0x0800) // long word
 						{
-							cpu.pc=cpu.aregs.a[(of.general.regsrc)]+
-							 (cpu.aregs.a[(extension>>12)&0x0007])*
+							REGS.pc=REGS.aregs.a[(OF.general.regsrc)]+
+							 (REGS.aregs.a[(extension>>12)&0x0007])*
 								(1<<((extension>>9)&0x0003));
 						}
 						else
 						{
-							cpu.pc=cpu.aregs.a[(of.general.regsrc)]+
-							 (long)((short)cpu.aregs.a[(extension>>12)&0x0007])*
+							REGS.pc=REGS.aregs.a[(OF.general.regsrc)]+
+							 (long)((short)REGS.aregs.a[(extension>>12)&0x0007])*
 							  (1<<((extension>>9)&0x0003));
 						}
 					}
@@ -514,39 +441,39 @@ long ea,od,bd,index;
 					{
 						if(extension&0x0800) // long word
 						{
-							cpu.pc=cpu.aregs.a[(of.general.regsrc)]+
-							 (cpu.dregs.d[(extension>>12)&0x0007])*
+							REGS.pc=REGS.aregs.a[(OF.general.regsrc)]+
+							 (REGS.dregs.d[(extension>>12)&0x0007])*
 							  (1<<((extension>>9)&0x0003));
 						}
 						else
 						{
-							cpu.pc=cpu.aregs.a[(of.general.regsrc)]+
-							 (long)((short)cpu.dregs.d[(extension>>12)&0x0007])*
+							REGS.pc=REGS.aregs.a[(OF.general.regsrc)]+
+							 (long)((short)REGS.dregs.d[(extension>>12)&0x0007])*
 							  (1<<((extension>>9)&0x0003));
 						}
 					}
-					cpu.pc+=(long)(extension&0x00FF);
+					REGS.pc+=(long)(extension&0x00FF);
 					break;
 				case 1: // long format extension
 					if(!(extension&0x0080)) // Base is not suppressed
 					{
-						ea=cpu.aregs.a[(of.general.regsrc)];
+						ea=REGS.aregs.a[(OF.general.regsrc)];
 					}
 					else ea=0;
 
 					switch(extension&0x8800)
 					{
 						case 0x0000: // Dn.W
-							index=(long)(short)cpu.dregs.d[(extension>>12)&0x0007];
+							index=(long)(short)REGS.dregs.d[(extension>>12)&0x0007];
 							break;
 						case 0x0800: // Dn.L
-							index=cpu.dregs.d[(extension>>12)&0x0007];
+							index=REGS.dregs.d[(extension>>12)&0x0007];
 							break;
 						case 0x8000: // An.W
-							index=(long)(short)cpu.aregs.a[(extension>>12)&0x0007];
+							index=(long)(short)REGS.aregs.a[(extension>>12)&0x0007];
 							break;
 						case 0x8800: // An.L
-							index=cpu.aregs.a[(extension>>12)&0x0007];
+							index=REGS.aregs.a[(extension>>12)&0x0007];
 							break;
 					}
 
@@ -573,12 +500,12 @@ long ea,od,bd,index;
 							bd=0;
 							break;
 						case 2: // word displacement
-							bd=(long)(short)GETword(cpu.pc);
-							cpu.pc+=2;
+							bd=(long)(short)GETword(REGS.pc);
+							REGS.pc+=2;
 							break;
 						case 3: // long displacement
-							bd=(long)GETdword(cpu.pc);
-							cpu.pc+=4;
+							bd=(long)GETdword(REGS.pc);
+							REGS.pc+=4;
 							break;
 					}
 					if(!(extension&0x0040)) // Index is not suppressed
@@ -592,11 +519,11 @@ long ea,od,bd,index;
 								ea=GETdword(ea+bd+index);
 								break;
 							case 2: // indirect pre-indexed with word displacement
-								od=(long)GETword(cpu.pc);
+								od=(long)GETword(REGS.pc);
 								ea=GETdword(ea+index+bd)+od;
 								break;
 							case 3: // indirect pre-indexed with long displacement
-								od=GETdword(cpu.pc);
+								od=GETdword(REGS.pc);
 								ea=GETdword(ea+index+bd)+od;
 								break;
 							case 4: // reserved
@@ -605,11 +532,11 @@ long ea,od,bd,index;
 								ea=GETdword(ea+bd)+index;
 								break;
 							case 6: // indirect post-indexed with word displacement
-								od=(long)GETword(cpu.pc);
+								od=(long)GETword(REGS.pc);
 								ea=GETdword(ea+bd)+index+od;
 								break;
 							case 7: // indirect post-indexed with long displacement
-								od=GETdword(cpu.pc);
+								od=GETdword(REGS.pc);
 								ea=GETdword(ea+bd)+index+od;
 								break;
 						}
@@ -625,11 +552,11 @@ long ea,od,bd,index;
 								ea=GETdword(ea+bd);
 								break;
 							case 2: // memory indirect with word displacement
-								od=(long)GETword(cpu.pc);
+								od=(long)GETword(REGS.pc);
 								ea=GETdword(ea+bd)+od;
 								break;
 							case 3: // memory indirect with long displacement
-								od=GETdword(cpu.pc);
+								od=GETdword(REGS.pc);
 								ea=GETdword(ea+bd)+od;
 								break;
 							case 4: // reserved
@@ -641,26 +568,26 @@ long ea,od,bd,index;
 					}
 					break;
 			}
-			PUTdword(cpu.aregs.a[7],cpu.pc); // save return address on stack
-			cpu.pc=ea; // set new PC
+			PUTdword(REGS.aregs.a[7],REGS.pc); // save return address on stack
+			REGS.pc=ea; // set new PC
 			break;
 		case 7: // MISC
-			switch(of.general.regsrc)
+			switch(OF.general.regsrc)
 			{
 				case 0: // (XXX).w
-					cpu.aregs.a[7]-=4;
-					PUTdword(cpu.aregs.a[7],cpu.pc+2);
-					cpu.pc=(long)GETword(cpu.pc);
+					REGS.aregs.a[7]-=4;
+					PUTdword(REGS.aregs.a[7],REGS.pc+2);
+					REGS.pc=(long)GETword(REGS.pc);
 					break;
 				case 1: // (XXX).l
-					cpu.aregs.a[7]-=4;
-					PUTdword(cpu.aregs.a[7],cpu.pc+4);
-					cpu.pc=GETdword(cpu.pc);
+					REGS.aregs.a[7]-=4;
+					PUTdword(REGS.aregs.a[7],REGS.pc+4);
+					REGS.pc=GETdword(REGS.pc);
 					break;
 				case 2: // (d16,PC)
-					cpu.aregs.a[7]-=4;
-					PUTdword(cpu.aregs.a[7],cpu.pc+2);
-					cpu.pc=cpu.pc+(long)GETword(cpu.pc);
+					REGS.aregs.a[7]-=4;
+					PUTdword(REGS.aregs.a[7],REGS.pc+2);
+					REGS.pc=REGS.pc+(long)GETword(REGS.pc);
 					break;
 			}
 			break;
@@ -677,20 +604,20 @@ short extension;
 long index,od,bd;
 
 	CACHEFUNCTION(COM_lea);
-	cpu.pc+=2;
-	switch(of.general.modesrc)
+	REGS.pc+=2;
+	switch(OF.general.modesrc)
 	{
 		case 2: // ARI
-			cpu.aregs.a[of.general.regdest]=cpu.aregs.a[(of.general.regsrc)];
+			REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[(OF.general.regsrc)];
 			break;
 		case 5: // ARID
-			cpu.aregs.a[of.general.regdest]=cpu.aregs.a[(of.general.regsrc)]+
-														(long)GETword(cpu.pc);
-			cpu.pc+=2;
+			REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[(OF.general.regsrc)]+
+														(long)GETword(REGS.pc);
+			REGS.pc+=2;
 			break;
 		case 6: // ARII
-			extension=GETword(cpu.pc);
-			cpu.pc+=2;
+			extension=GETword(REGS.pc);
+			REGS.pc+=2;
 			switch((extension&0x0100)>>8)
 			{
 				case 0: // brief format extension
@@ -698,14 +625,14 @@ long index,od,bd;
 					{
 						if(extension&0x0800) // long word
 						{
-							cpu.aregs.a[of.general.regdest]=cpu.aregs.a[(of.general.regsrc)]+
-								(cpu.aregs.a[(extension>>12)&0x0007])*
+							REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[(OF.general.regsrc)]+
+								(REGS.aregs.a[(extension>>12)&0x0007])*
 									(1<<((extension>>9)&0x0003));
 						}
 						else
 						{
-							cpu.aregs.a[of.general.regdest]=cpu.aregs.a[(of.general.regsrc)]+
-							 (long)((short)cpu.aregs.a[(extension>>12)&0x0007])*
+							REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[(OF.general.regsrc)]+
+							 (long)((short)REGS.aregs.a[(extension>>12)&0x0007])*
 								(1<<((extension>>9)&0x0003));
 						}
 					}
@@ -713,40 +640,40 @@ long index,od,bd;
 					{
 						if(extension&0x0800) // long word
 						{
-							cpu.aregs.a[of.general.regdest]=cpu.aregs.a[(of.general.regsrc)]+
-							  (cpu.dregs.d[(extension>>12)&0x0007])*
+							REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[(OF.general.regsrc)]+
+							  (REGS.dregs.d[(extension>>12)&0x0007])*
 								(1<<((extension>>9)&0x0003));
 						}
 						else
 						{
-							cpu.aregs.a[of.general.regdest]=cpu.aregs.a[(of.general.regsrc)]+
-							 (long)((short)cpu.dregs.d[(extension>>12)&0x0007])*
+							REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[(OF.general.regsrc)]+
+							 (long)((short)REGS.dregs.d[(extension>>12)&0x0007])*
 								(1<<((extension>>9)&0x0003));
 						}
 					}
-					cpu.aregs.a[of.general.regdest]+=(long)(extension&0x00FF);
+					REGS.aregs.a[OF.general.regdest]+=(long)(extension&0x00FF);
 					break;
 				case 1: // long format extension
 
 					if(!(extension&0x0080)) // BD is not suppressed
 					{
-						cpu.aregs.a[of.general.regdest]=cpu.aregs.a[(of.general.regsrc)];
+						REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[(OF.general.regsrc)];
 					}
-					else cpu.aregs.a[of.general.regdest]=0;
+					else REGS.aregs.a[OF.general.regdest]=0;
 
 					switch(extension&0x8800)
 					{
 						case 0x0000: // Dn.W
-							index=(long)(short)cpu.dregs.d[(extension>>12)&0x0007];
+							index=(long)(short)REGS.dregs.d[(extension>>12)&0x0007];
 							break;
 						case 0x0800: // Dn.L
-							index=cpu.dregs.d[(extension>>12)&0x0007];
+							index=REGS.dregs.d[(extension>>12)&0x0007];
 							break;
 						case 0x8000: // An.W
-							index=(long)(short)cpu.aregs.a[(extension>>12)&0x0007];
+							index=(long)(short)REGS.aregs.a[(extension>>12)&0x0007];
 							break;
 						case 0x8800: // An.L
-							index=cpu.aregs.a[(extension>>12)&0x0007];
+							index=REGS.aregs.a[(extension>>12)&0x0007];
 							break;
 					}
 
@@ -773,12 +700,12 @@ long index,od,bd;
 							bd=0;
 							break;
 						case 2: // word displacement
-							bd=(long)(short)GETword(cpu.pc);
-							cpu.pc+=2;
+							bd=(long)(short)GETword(REGS.pc);
+							REGS.pc+=2;
 							break;
 						case 3: // long displacement
-							bd=(long)GETdword(cpu.pc);
-							cpu.pc+=4;
+							bd=(long)GETdword(REGS.pc);
+							REGS.pc+=4;
 							break;
 					}
 					if(!(extension&0x0040)) // Index is not suppressed
@@ -786,41 +713,41 @@ long index,od,bd;
 						switch(extension&0x0007)
 						{
 							case 0: // no memory indirection
-								cpu.aregs.a[of.general.regdest]+=index+bd;
+								REGS.aregs.a[OF.general.regdest]+=index+bd;
 								break;
 							case 1: // indirect pre-indexed with null displacement
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+bd+index);
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+bd+index);
 								break;
 							case 2: // indirect pre-indexed with word displacement
-								od=(long)GETword(cpu.pc);
-								cpu.pc+=2;
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+index+bd)+od;
+								od=(long)GETword(REGS.pc);
+								REGS.pc+=2;
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+index+bd)+od;
 								break;
 							case 3: // indirect pre-indexed with long displacement
-								od=GETdword(cpu.pc);
-								cpu.pc+=4;
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+index+bd)+od;
+								od=GETdword(REGS.pc);
+								REGS.pc+=4;
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+index+bd)+od;
 								break;
 							case 4: // reserved
 								break;
 							case 5: // indirect post-indexed with null displacement
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+bd)+index;
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+bd)+index;
 								break;
 							case 6: // indirect post-indexed with word displacement
-								od=(long)GETword(cpu.pc);
-								cpu.pc+=2;
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+bd)+index+od;
+								od=(long)GETword(REGS.pc);
+								REGS.pc+=2;
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+bd)+index+od;
 								break;
 							case 7: // indirect post-indexed with long displacement
-								od=GETdword(cpu.pc);
-								cpu.pc+=4;
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+bd)+index+od;
+								od=GETdword(REGS.pc);
+								REGS.pc+=4;
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+bd)+index+od;
 								break;
 						}
 					}
@@ -829,23 +756,23 @@ long index,od,bd;
 						switch(extension&0x0007)
 						{
 							case 0: // no memory indirection
-								cpu.aregs.a[of.general.regdest]+=bd;
+								REGS.aregs.a[OF.general.regdest]+=bd;
 								break;
 							case 1: // memory indirect with null displacement
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+bd);
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+bd);
 								break;
 							case 2: // memory indirect with word displacement
-								od=(long)GETword(cpu.pc);
-								cpu.pc+=2;
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+bd)+od;
+								od=(long)GETword(REGS.pc);
+								REGS.pc+=2;
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+bd)+od;
 								break;
 							case 3: // memory indirect with long displacement
-								od=GETdword(cpu.pc);
-								cpu.pc+=4;
-								cpu.aregs.a[of.general.regdest]=
-									GETdword(cpu.aregs.a[of.general.regdest]+bd)+od;
+								od=GETdword(REGS.pc);
+								REGS.pc+=4;
+								REGS.aregs.a[OF.general.regdest]=
+									GETdword(REGS.aregs.a[OF.general.regdest]+bd)+od;
 								break;
 							case 4: // reserved
 							case 5:
@@ -858,19 +785,19 @@ long index,od,bd;
 			}
 			break;
 		case 7: // MISC (PC,Absolute)
-			switch(of.general.regsrc)
+			switch(OF.general.regsrc)
 			{
 				case 0: // (XXX).w
-					cpu.aregs.a[of.general.regdest]=(long)GETword(cpu.pc);
-					cpu.pc+=2;
+					REGS.aregs.a[OF.general.regdest]=(long)GETword(REGS.pc);
+					REGS.pc+=2;
 					break;
 				case 1: // (XXX).l
-					cpu.aregs.a[of.general.regdest]=GETdword(cpu.pc);
-					cpu.pc+=4;
+					REGS.aregs.a[OF.general.regdest]=GETdword(REGS.pc);
+					REGS.pc+=4;
 					break;
 				case 2: // (d16,PC)
-					cpu.aregs.a[of.general.regdest]=cpu.pc+(long)GETword(cpu.pc);
-					cpu.pc+=2;
+					REGS.aregs.a[OF.general.regdest]=REGS.pc+(long)GETword(REGS.pc);
+					REGS.pc+=2;
 					break;
 				default:
 					Unknown(opcode);
@@ -888,10 +815,11 @@ void COM_movefromSR(short opcode)
 {
 	CACHEFUNCTION(COM_movefromSR);
 	// test if in supervisor modes
-	if(cpu.sregs.sr&0x3000)
+	if(REGS.sregs.sr&0x3000)
 	{
-		cpu.pc+=2;
-		CommandMode[of.general.modesrc]((of.general.regsrc),1,cpu.sregs.sr,1);
+		REGS.pc+=2;
+		ccr_sync(); // condition codes are kept apart while executing
+		CommandMode[OF.general.modesrc]((OF.general.regsrc),1,REGS.sregs.sr,1);
 	}
 	else priv_viol();
 
@@ -900,9 +828,9 @@ void COM_movefromSR(short opcode)
 
 void COM_movequick(short opcode)
 {
-	cpu.pc+=2;
-	work.source=(long)((char)opcode);
-	cpu.dregs.d[of.general.regdest]=work.source;
+	REGS.pc+=2;
+	WORK.source=(long)((char)opcode);
+	REGS.dregs.d[OF.general.regdest]=WORK.source;
 }
 
 
@@ -910,32 +838,32 @@ void COM_movetoSR(short opcode)
 {
 	CACHEFUNCTION(COM_movetoSR);
 	// test if in supervisor modes (master and supervisor)
-	if(cpu.sregs.sr&0x3000)
+	if(REGS.sregs.sr&0x3000)
 	{
-		cpu.pc+=2;
-		work.source=CommandMode[of.general.modesrc]((of.general.regsrc),0,0L,1);
-		cpu.sregs.sr=(short)work.source;
-		cpu.aregs.a[7]=cpu.usp;
+		REGS.pc+=2;
+		WORK.source=CommandMode[OF.general.modesrc]((OF.general.regsrc),0,0L,1);
+		REGS.sregs.sr=(short)WORK.source;
+		ccr_load();
+		REGS.aregs.a[7]=REGS.usp;
 	}
 	else priv_viol();
 }
 
 
-void COM_neg(short opcode)
+CPU_INLINE void alu_neg(int size,int modesrc)
 {
-	CACHEFUNCTION(COM_neg);
-	cpu.pc+=2;
-	spc=cpu.pc;
-	work.destination=CommandMode[of.general.modesrc]((of.general.regsrc),0,0L,
-																	of.special.size);
-	cpu.pc=spc;
-	work.destination=0-work.destination;
-	CommandMode[of.general.modesrc]((of.general.regsrc),1,work.destination,
-																of.special.size);
-	switch(of.special.size)
+	REGS.pc+=2;
+	SPC=REGS.pc;
+	WORK.destination=ea_access(modesrc,(OF.general.regsrc),0,0L,
+																	size);
+	REGS.pc=SPC;
+	WORK.destination=0-WORK.destination;
+	ea_access(modesrc,(OF.general.regsrc),1,WORK.destination,
+																size);
+	switch(size)
 	{
 		case 0:
-			if((char)work.destination==0)
+			if((char)WORK.destination==0)
 			{
 				ZERO1;
 				CARRY0;
@@ -949,7 +877,7 @@ void COM_neg(short opcode)
 			}
 		break;
 		case 1:
-			if((short)work.destination==0)
+			if((short)WORK.destination==0)
 			{
 				ZERO1;
 				CARRY0;
@@ -963,7 +891,7 @@ void COM_neg(short opcode)
 			}
 		break;
 		case 2:
-			if(work.destination==0)
+			if(WORK.destination==0)
 			{
 				ZERO1;
 				CARRY0;
@@ -977,19 +905,16 @@ void COM_neg(short opcode)
 			}
 		break;
 	}
-	switch(of.special.size)
+	switch(size)
 	{
 		case 0:
-			if((char)work.destination<0)NEG1;
-			else NEG0;
+			SETN((char)WORK.destination);
 			break;
 		case 1:
-			if((short)work.destination<0)NEG1;
-			else NEG0;
+			SETN((short)WORK.destination);
 			break;
 		case 2:
-			if(work.destination<0)NEG1;
-			else NEG0;
+			SETN(WORK.destination);
 			break;
 	}
 
@@ -999,122 +924,96 @@ void COM_neg(short opcode)
 void COM_nop(short opcode)
 {
 	CACHEFUNCTION(COM_nop);
-	cpu.pc+=2;
+	REGS.pc+=2;
 }
 
 
-void COM_not(short opcode)
+CPU_INLINE void alu_not(int size,int modesrc)
 {
-	CACHEFUNCTION(COM_not);
-	cpu.pc+=2;
-	spc=cpu.pc;
-	work.source=~CommandMode[of.general.modesrc]((of.general.regsrc),0,0L,
-																		of.special.size);
-	cpu.pc=spc;
-	CommandMode[of.general.modesrc]((of.general.regsrc),1,work.source,
-												of.special.size);
+	REGS.pc+=2;
+	SPC=REGS.pc;
+	WORK.source=~ea_access(modesrc,(OF.general.regsrc),0,0L,
+																		size);
+	REGS.pc=SPC;
+	ea_access(modesrc,(OF.general.regsrc),1,WORK.source,
+												size);
 	CARRY0;
 	OVER0;
-	switch(of.special.size)
+	switch(size)
 	{
 		case 0:
-			if((char)work.destination==0)ZERO1;
-			else ZERO0;
+			SETZ((char)WORK.destination);
 			break;
 		case 1:
-			if((short)work.destination==0)ZERO1;
-			else ZERO0;
+			SETZ((short)WORK.destination);
 			break;
 		case 2:
-			if(work.destination==0)ZERO1;
-			else ZERO0;
+			SETZ(WORK.destination);
 			break;
 	}
-	switch(of.special.size)
+	switch(size)
 	{
 		case 0:
-			if((char)work.destination<0)NEG1;
-			else NEG0;
+			SETN((char)WORK.destination);
 			break;
 		case 1:
-			if((short)work.destination<0)NEG1;
-			else NEG0;
+			SETN((short)WORK.destination);
 			break;
 		case 2:
-			if(work.destination<0)NEG1;
-			else NEG0;
+			SETN(WORK.destination);
 			break;
 	}
 }
 
 
-void COM_or(short opcode)
+CPU_INLINE void alu_or(int modedest,int modesrc)
 {
-	CACHEFUNCTION(COM_or);
-	cpu.pc+=2;
-	switch(of.general.modedest)
+	REGS.pc+=2;
+	switch(modedest)
 	{
 		case 0:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]|
-															(work.source&0x000000FF);
-			if((char)cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if((char)cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]|
+															(WORK.source&0x000000FF);
+			SETNZ((char)REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 1:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]|
-														(work.source&0x0000FFFF);
-			if((short)cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if((short)cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]|
+														(WORK.source&0x0000FFFF);
+			SETNZ((short)REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 2:
-			work.source=CommandMode[of.general.modesrc]((of.general.regsrc),0,0L,2);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]|work.source;
-			if(cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(OF.general.regsrc),0,0L,2);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]|WORK.source;
+			SETNZ(REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 4:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.pc=spc;
-			work.source=work.source|(cpu.dregs.d[of.general.regdest]&0x000000FF);
-			work.destination=CommandMode[of.general.modesrc]((char)(of.general.regsrc),
-										1,(char)work.source,0);
-			if((char)work.destination==0)ZERO1;
-			else ZERO0;
-			if((char)work.destination<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.pc=SPC;
+			WORK.source=WORK.source|(REGS.dregs.d[OF.general.regdest]&0x000000FF);
+			WORK.destination=ea_access(modesrc,(char)(OF.general.regsrc),
+										1,(char)WORK.source,0);
+			SETNZ((char)WORK.destination);
 			break;
 		case 5:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.pc=spc;
-			work.source=work.source|(cpu.dregs.d[of.general.regdest]&0x0000FFFF);
-			work.destination=CommandMode[of.general.modesrc]((char)(of.general.regsrc),
-																		1,(short)work.source,1);
-			if((short)work.destination==0)ZERO1;
-			else ZERO0;
-			if((short)work.destination<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.pc=SPC;
+			WORK.source=WORK.source|(REGS.dregs.d[OF.general.regdest]&0x0000FFFF);
+			WORK.destination=ea_access(modesrc,(char)(OF.general.regsrc),
+																		1,(short)WORK.source,1);
+			SETNZ((short)WORK.destination);
 			break;
 		case 6:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.pc=spc;
-			work.source=work.source|cpu.dregs.d[of.general.regdest];
-			work.destination=CommandMode[of.general.modesrc]((char)(of.general.regsrc),
-																		1,work.source,2);
-			if(work.destination==0)ZERO1;
-			else ZERO0;
-			if(work.destination<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.pc=SPC;
+			WORK.source=WORK.source|REGS.dregs.d[OF.general.regdest];
+			WORK.destination=ea_access(modesrc,(char)(OF.general.regsrc),
+																		1,WORK.source,2);
+			SETNZ(WORK.destination);
 			break;
 	}
 	CARRY0;
@@ -1128,24 +1027,24 @@ short extension;
 long ea, index,od,bd;
 
 	CACHEFUNCTION(COM_pea);
-	cpu.aregs.a[7]-=4;
-	cpu.pc=cpu.pc+2;
-	switch(of.general.modesrc)
+	REGS.aregs.a[7]-=4;
+	REGS.pc=REGS.pc+2;
+	switch(OF.general.modesrc)
 	{
 		// ARI
 		case 2:
-			PUTdword(cpu.aregs.a[7],cpu.aregs.a[(of.general.regsrc)]);
+			PUTdword(REGS.aregs.a[7],REGS.aregs.a[(OF.general.regsrc)]);
 			break;
 		// ARID
 		case 5:
-			PUTdword(cpu.aregs.a[7],cpu.aregs.a[(of.general.regsrc)]+
-									(long)GETword(cpu.pc));
-			cpu.pc+=2;
+			PUTdword(REGS.aregs.a[7],REGS.aregs.a[(OF.general.regsrc)]+
+									(long)GETword(REGS.pc));
+			REGS.pc+=2;
 			break;
 		// ARII
 		case 6: // ARII
-			extension=GETword(cpu.pc);
-			cpu.pc+=2;
+			extension=GETword(REGS.pc);
+			REGS.pc+=2;
 			switch((extension&0x0100)>>8)
 			{
 				case 0: // brief format extension
@@ -1153,14 +1052,14 @@ long ea, index,od,bd;
 					{
 						if(extension&0x0800) // long word
 						{
-							ea=cpu.aregs.a[(of.general.regsrc)]+
-							 (cpu.aregs.a[(extension>>12)&0x0007])*
+							ea=REGS.aregs.a[(OF.general.regsrc)]+
+							 (REGS.aregs.a[(extension>>12)&0x0007])*
 								(1<<((extension>>9)&0x0003));
 						}
 						else
 						{
-							ea=cpu.aregs.a[(of.general.regsrc)]+
-							 (long)((short)cpu.aregs.a[(extension>>12)&0x0007])*
+							ea=REGS.aregs.a[(OF.general.regsrc)]+
+							 (long)((short)REGS.aregs.a[(extension>>12)&0x0007])*
 								(1<<((extension>>9)&0x0003));
 						}
 					}
@@ -1168,14 +1067,14 @@ long ea, index,od,bd;
 					{
 						if(extension&0x0800) // long word
 						{
-							ea=cpu.aregs.a[(of.general.regsrc)]+
-							 (cpu.dregs.d[(extension>>12)&0x0007])*
+							ea=REGS.aregs.a[(OF.general.regsrc)]+
+							 (REGS.dregs.d[(extension>>12)&0x0007])*
 							  (1<<((extension>>9)&0x0003));
 						}
 						else
 						{
-							ea=cpu.aregs.a[(of.general.regsrc)]+
-							 (long)((short)cpu.dregs.d[(extension>>12)&0x0007])*
+							ea=REGS.aregs.a[(OF.general.regsrc)]+
+							 (long)((short)REGS.dregs.d[(extension>>12)&0x0007])*
 							  (1<<((extension>>9)&0x0003));
 						}
 					}
@@ -1185,23 +1084,23 @@ long ea, index,od,bd;
 
 					if(!(extension&0x0080)) // BD is not suppressed
 					{
-						ea=cpu.aregs.a[(of.general.regsrc)];
+						ea=REGS.aregs.a[(OF.general.regsrc)];
 					}
 					else ea=0;
 
 					switch(extension&0x8800)
 					{
 						case 0x0000: // Dn.W
-							index=(long)(short)cpu.dregs.d[(extension>>12)&0x0007];
+							index=(long)(short)REGS.dregs.d[(extension>>12)&0x0007];
 							break;
 						case 0x0800: // Dn.L
-							index=cpu.dregs.d[(extension>>12)&0x0007];
+							index=REGS.dregs.d[(extension>>12)&0x0007];
 							break;
 						case 0x8000: // An.W
-							index=(long)(short)cpu.aregs.a[(extension>>12)&0x0007];
+							index=(long)(short)REGS.aregs.a[(extension>>12)&0x0007];
 							break;
 						case 0x8800: // An.L
-							index=cpu.aregs.a[(extension>>12)&0x0007];
+							index=REGS.aregs.a[(extension>>12)&0x0007];
 							break;
 					}
 
@@ -1228,12 +1127,12 @@ long ea, index,od,bd;
 							bd=0;
 							break;
 						case 2: // word displacement
-							bd=(long)(short)GETword(cpu.pc);
-							cpu.pc+=2;
+							bd=(long)(short)GETword(REGS.pc);
+							REGS.pc+=2;
 							break;
 						case 3: // long displacement
-							bd=(long)GETdword(cpu.pc);
-							cpu.pc+=4;
+							bd=(long)GETdword(REGS.pc);
+							REGS.pc+=4;
 							break;
 					}
 					if(!(extension&0x0040)) // Index is not suppressed
@@ -1247,13 +1146,13 @@ long ea, index,od,bd;
 								ea=GETdword(ea+bd+index);
 								break;
 							case 2: // indirect pre-indexed with word displacement
-								od=(long)GETword(cpu.pc);
-								cpu.pc+=2;
+								od=(long)GETword(REGS.pc);
+								REGS.pc+=2;
 								ea=GETdword(ea+index+bd)+od;
 								break;
 							case 3: // indirect pre-indexed with long displacement
-								od=GETdword(cpu.pc);
-								cpu.pc+=4;
+								od=GETdword(REGS.pc);
+								REGS.pc+=4;
 								ea=GETdword(ea+index+bd)+od;
 								break;
 							case 4: // reserved
@@ -1262,13 +1161,13 @@ long ea, index,od,bd;
 								ea=GETdword(ea+bd)+index;
 								break;
 							case 6: // indirect post-indexed with word displacement
-								od=(long)GETword(cpu.pc);
-								cpu.pc+=2;
+								od=(long)GETword(REGS.pc);
+								REGS.pc+=2;
 								ea=GETdword(ea+bd)+index+od;
 								break;
 							case 7: // indirect post-indexed with long displacement
-								od=GETdword(cpu.pc);
-								cpu.pc+=4;
+								od=GETdword(REGS.pc);
+								REGS.pc+=4;
 								ea=GETdword(ea+bd)+index+od;
 								break;
 						}
@@ -1284,13 +1183,13 @@ long ea, index,od,bd;
 								ea=GETdword(ea+bd);
 								break;
 							case 2: // memory indirect with word displacement
-								od=(long)GETword(cpu.pc);
-								cpu.pc+=2;
+								od=(long)GETword(REGS.pc);
+								REGS.pc+=2;
 								ea=GETdword(ea+bd)+od;
 								break;
 							case 3: // memory indirect with long displacement
-								od=GETdword(cpu.pc);
-								cpu.pc+=4;
+								od=GETdword(REGS.pc);
+								REGS.pc+=4;
 								ea=GETdword(ea+bd)+od;
 								break;
 							case 4: // reserved
@@ -1302,22 +1201,22 @@ long ea, index,od,bd;
 					}
 					break;
 			}
-			PUTdword(cpu.aregs.a[7],ea);
+			PUTdword(REGS.aregs.a[7],ea);
 			break;
 		case 7:
-			switch(of.general.regsrc)
+			switch(OF.general.regsrc)
 			{
 				case 0:
-					PUTdword(cpu.aregs.a[7],(long)GETword(cpu.pc));
-					cpu.pc+=2;
+					PUTdword(REGS.aregs.a[7],(long)GETword(REGS.pc));
+					REGS.pc+=2;
 					break;
 				case 1:
-					PUTdword(cpu.aregs.a[7],GETdword(cpu.pc));
-					cpu.pc+=4;
+					PUTdword(REGS.aregs.a[7],GETdword(REGS.pc));
+					REGS.pc+=4;
 					break;
 				case 2:
-					PUTdword(cpu.aregs.a[7],cpu.pc+(long)GETword(cpu.pc));
-					cpu.pc+=2;
+					PUTdword(REGS.aregs.a[7],REGS.pc+(long)GETword(REGS.pc));
+					REGS.pc+=2;
 					break;
 			}
 			break;
@@ -1332,12 +1231,12 @@ void COM_reset(short opcode)
 {
 	CACHEFUNCTION(COM_reset);
 	// test if in supervisor modes
-	if(cpu.sregs.sr&0x3000)
+	if(REGS.sregs.sr&0x3000)
 	{
 	int index;
 		// call all plugin reset functions
 		// Peripheral reset not supported in WASM
-		cpu.pc+=2; // increment PC
+		REGS.pc+=2; // increment PC
 	}
 	else priv_viol();
 }
@@ -1347,21 +1246,22 @@ void COM_rte(short opcode)
 {
 	CACHEFUNCTION(COM_rte);
 	// test if in supervisor modes
-	if(cpu.sregs.sr&0x3000) // in supervisor mode?
+	if(REGS.sregs.sr&0x3000) // in supervisor mode?
 	{
-		cpu.sregs.sr=GETword(cpu.ssp);  // fetch SR from stack
-		cpu.pc=GETdword(cpu.ssp+2);     // fetch PC from stack
-		switch(GETword(cpu.ssp+6)&0xF000)  // test stack frame format
+		REGS.sregs.sr=GETword(REGS.ssp);  // fetch SR from stack
+		ccr_load();
+		REGS.pc=GETdword(REGS.ssp+2);     // fetch PC from stack
+		switch(GETword(REGS.ssp+6)&0xF000)  // test stack frame format
 		{
 			case 0:
-				cpu.ssp+=8;
+				REGS.ssp+=8;
 				break;
 			case 0x2000:
-				cpu.ssp+=12;
+				REGS.ssp+=12;
 				break;
 		}
-		if(cpu.sregs.sr&0x3000)cpu.aregs.a[7]=cpu.ssp;
-		else cpu.aregs.a[7]=cpu.usp;
+		if(REGS.sregs.sr&0x3000)REGS.aregs.a[7]=REGS.ssp;
+		else REGS.aregs.a[7]=REGS.usp;
 	}
 	else priv_viol();
 }
@@ -1370,119 +1270,84 @@ void COM_rte(short opcode)
 void COM_rts(short opcode)
 {
 	CACHEFUNCTION(COM_rts);
-	cpu.pc=GETdword(cpu.aregs.a[7]); // get PC from stack
-	cpu.aregs.a[7]+=4;      // increment stack pointer
+	REGS.pc=GETdword(REGS.aregs.a[7]); // get PC from stack
+	REGS.aregs.a[7]+=4;      // increment stack pointer
 }
 
 
-void COM_sub(short opcode)
+CPU_INLINE void alu_sub(int modedest,int modesrc)
 {
-	CACHEFUNCTION(COM_sub);
-	cpu.pc+=2;
-	switch(of.general.modedest)
+	REGS.pc+=2;
+	switch(modedest)
 	{
 		case 0:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]-work.source;
-			if(cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]-WORK.source;
+			SETNZ(REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 1:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]-work.source;
-			if(cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]-WORK.source;
+			SETNZ(REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 2:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.dregs.d[of.general.regdest]=cpu.dregs.d[of.general.regdest]-work.source;
-			if(cpu.dregs.d[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.dregs.d[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.dregs.d[OF.general.regdest]=REGS.dregs.d[OF.general.regdest]-WORK.source;
+			SETNZ(REGS.dregs.d[OF.general.regdest]);
 			break;
 		case 3:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.aregs.a[of.general.regdest]=cpu.aregs.a[of.general.regdest]-work.source;
-			if(cpu.aregs.a[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.aregs.a[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[OF.general.regdest]-WORK.source;
+			SETNZ(REGS.aregs.a[OF.general.regdest]);
 			break;
 		case 4:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,0);
-			cpu.pc=spc;
-			work.source=work.source-cpu.dregs.d[of.general.regdest];
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,0);
-			if(work.source==0)ZERO1;
-			else ZERO0;
-			if(work.source<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,0);
+			REGS.pc=SPC;
+			WORK.source=WORK.source-REGS.dregs.d[OF.general.regdest];
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,0);
+			SETNZ(WORK.source);
 			break;
 		case 5:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,1);
-			cpu.pc=spc;
-			work.source=work.source-cpu.dregs.d[of.general.regdest];
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,1);
-			if(work.source==0)ZERO1;
-			else ZERO0;
-			if(work.source<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,1);
+			REGS.pc=SPC;
+			WORK.source=WORK.source-REGS.dregs.d[OF.general.regdest];
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,1);
+			SETNZ(WORK.source);
 			break;
 		case 6:
-			spc=cpu.pc;
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.pc=spc;
-			work.source=work.source-cpu.dregs.d[of.general.regdest];
-			CommandMode[of.general.modesrc]((char)(of.general.regsrc),1,work.source,2);
-			if(work.source==0)ZERO1;
-			else ZERO0;
-			if(work.source<0)NEG1;
-			else NEG0;
+			SPC=REGS.pc;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.pc=SPC;
+			WORK.source=WORK.source-REGS.dregs.d[OF.general.regdest];
+			ea_access(modesrc,(char)(OF.general.regsrc),1,WORK.source,2);
+			SETNZ(WORK.source);
 			break;
 		case 7:
-			work.source=CommandMode[of.general.modesrc]((char)(of.general.regsrc),0,0L,2);
-			cpu.aregs.a[of.general.regdest]=cpu.aregs.a[of.general.regdest]-work.source;
-			if(cpu.aregs.a[of.general.regdest]==0)ZERO1;
-			else ZERO0;
-			if(cpu.aregs.a[of.general.regdest]<0)NEG1;
-			else NEG0;
+			WORK.source=ea_access(modesrc,(char)(OF.general.regsrc),0,0L,2);
+			REGS.aregs.a[OF.general.regdest]=REGS.aregs.a[OF.general.regdest]-WORK.source;
+			SETNZ(REGS.aregs.a[OF.general.regdest]);
 			break;
 	}
 }
 
 
-void COM_tst(short opcode)
+CPU_INLINE void alu_tst(int size,int modesrc)
 {
-	CACHEFUNCTION(COM_tst);
-	cpu.pc+=2;
-	work.source=CommandMode[of.general.modesrc]((of.general.regsrc),0,0L,
-																of.special.size);
-	switch(of.special.size)
+	REGS.pc+=2;
+	WORK.source=ea_access(modesrc,(OF.general.regsrc),0,0L,
+																size);
+	switch(size)
 	{
 		case 0:
-			if((char)work.source==0)ZERO1;
-			else ZERO0;
-			if((char)work.source<0)NEG1;
-			else NEG0;
+			SETNZ((char)WORK.source);
 			break;
 		case 1:
-			if((short)work.source==0)ZERO1;
-			else ZERO0;
-			if((short)work.source<0)NEG1;
-			else NEG0;
+			SETNZ((short)WORK.source);
 			break;
 		case 2:
-			if(work.source==0)ZERO1;
-			else ZERO0;
-			if(work.source<0)NEG1;
-			else NEG0;
+			SETNZ(WORK.source);
 			break;
 	}
 	CARRY0;
@@ -1490,6 +1355,111 @@ void COM_tst(short opcode)
 }
 
 
+/* ============================================================================
+   SPECIALISED HANDLERS
+   The templates above are instantiated once per (operation, opmode/size,
+   source mode) at compile time, replacing the BUILD.EXE/SKRIPT.TXT step of
+   the original simulator. With the modes and the size constant the EA and
+   size switches fold away. cpu_decode_handler() hands out the instances
+   in place of the generic handler from OperationHandlers[]; the COM_xxx
+   entry points dispatch through the same tables for anything still calling
+   them directly.
+   ============================================================================ */
+
+#define SPEC_HANDLER(op,row,mode) \
+	static void op##_##row##mode(short opcode) { (void)opcode; alu_##op(row,mode); }
+
+#define SPEC_ROW(op,row) \
+	SPEC_HANDLER(op,row,0) SPEC_HANDLER(op,row,1) SPEC_HANDLER(op,row,2) \
+	SPEC_HANDLER(op,row,3) SPEC_HANDLER(op,row,4) SPEC_HANDLER(op,row,5) \
+	SPEC_HANDLER(op,row,6) SPEC_HANDLER(op,row,7)
+
+#define SPEC_ROW_PTRS(op,row) \
+	{ op##_##row##0, op##_##row##1, op##_##row##2, op##_##row##3, \
+	  op##_##row##4, op##_##row##5, op##_##row##6, op##_##row##7 }
+
+/* [opmode][source mode], opmode 3 and 7 are the An destinations */
+#define SPEC_BY_OPMODE(op) \
+	SPEC_ROW(op,0) SPEC_ROW(op,1) SPEC_ROW(op,2) SPEC_ROW(op,3) \
+	SPEC_ROW(op,4) SPEC_ROW(op,5) SPEC_ROW(op,6) SPEC_ROW(op,7) \
+	static void (*const Spec_##op[8][8])(short) = { \
+		SPEC_ROW_PTRS(op,0), SPEC_ROW_PTRS(op,1), SPEC_ROW_PTRS(op,2), SPEC_ROW_PTRS(op,3), \
+		SPEC_ROW_PTRS(op,4), SPEC_ROW_PTRS(op,5), SPEC_ROW_PTRS(op,6), SPEC_ROW_PTRS(op,7) }; \
+	void COM_##op(short opcode) \
+	{ \
+		CACHEFUNCTION(COM_##op); \
+		Spec_##op[OF.general.modedest][OF.general.modesrc](opcode); \
+	}
+
+/* [size][mode], size 3 never reaches these handlers (sttable.c) */
+#define SPEC_BY_SIZE(op) \
+	SPEC_ROW(op,0) SPEC_ROW(op,1) SPEC_ROW(op,2) \
+	static void (*const Spec_##op[3][8])(short) = { \
+		SPEC_ROW_PTRS(op,0), SPEC_ROW_PTRS(op,1), SPEC_ROW_PTRS(op,2) }; \
+	void COM_##op(short opcode) \
+	{ \
+		CACHEFUNCTION(COM_##op); \
+		Spec_##op[OF.special.size][OF.general.modesrc](opcode); \
+	}
+
+SPEC_BY_OPMODE(add)
+SPEC_BY_OPMODE(sub)
+SPEC_BY_OPMODE(cmp)
+SPEC_BY_OPMODE(and)
+SPEC_BY_OPMODE(or)
+SPEC_BY_OPMODE(eor)
+SPEC_BY_SIZE(clr)
+SPEC_BY_SIZE(tst)
+SPEC_BY_SIZE(neg)
+SPEC_BY_SIZE(not)
+
+static const struct spec_entry {
+	void (*handler)(short);
+	void (*const *spec)(short);	/* Spec_xxx[0][0] */
+	int by_size;
+} SpecialisedHandlers[] = {
+	{ COM_add, &Spec_add[0][0], 0 }, { COM_sub, &Spec_sub[0][0], 0 },
+	{ COM_cmp, &Spec_cmp[0][0], 0 }, { COM_and, &Spec_and[0][0], 0 },
+	{ COM_or, &Spec_or[0][0], 0 }, { COM_eor, &Spec_eor[0][0], 0 },
+	{ COM_clr, &Spec_clr[0][0], 1 }, { COM_tst, &Spec_tst[0][0], 1 },
+	{ COM_neg, &Spec_neg[0][0], 1 }, { COM_not, &Spec_not[0][0], 1 },
+};
+
+/* Specialised instances per handler index, NULL for generic handlers */
+static const struct spec_entry *SpecByIndex[OPERATION_MAX_HANDLERS];
+
+/* Look up the handler indices that have specialised instances
+   (once per process, simulator_init()) */
+void cpu_specialise_handlers(void)
+{
+	int h;
+	size_t i;
+
+	for(h=0;h<OperationHandlerCount;h++)
+	{
+		for(i=0;i<sizeof(SpecialisedHandlers)/sizeof(SpecialisedHandlers[0]);i++)
+		{
+			if(OperationHandlers[h]==SpecialisedHandlers[i].handler)
+			{
+				SpecByIndex[h]=&SpecialisedHandlers[i];
+				break;
+			}
+		}
+	}
+}
+
+opcode_handler_t cpu_decode_handler(uint16_t opcode)
+{
+	uint8_t h=OperationIndex[opcode];
+	const struct spec_entry *spec=SpecByIndex[h];
+	unsigned row;
+
+	if(spec==NULL)return OperationHandlers[h];
+	row=spec->by_size?(opcode>>6)&0x3:(opcode>>6)&0x7;
+	return spec->spec[row*8+((opcode>>3)&0x7)];
+}
+
+
 
 /* ============================================================================
 
@@ -1502,79 +1472,79 @@ void COM_tst(short opcode)
    ============================================================================ */
 
 /* Multiplication and Division */
-void COM_mul(short opcode) { cpu.pc += 2; }
+void COM_mul(short opcode) { REGS.pc += 2; }
 /* Multiply Unsigned */
 void COM_mulu(short opcode)
 {
-    static short regs;
+    short regs;
 
     CACHEFUNCTION(COM_mulu);
-    cpu.pc += 2;
-    if ((of.general.regdest) == 6) {
-        regs = GETword(cpu.pc);
-        cpu.pc += 2;
-        work.source = CommandMode[of.general.modesrc]((char)(of.general.regsrc), 0, 0L, 2);
+    REGS.pc += 2;
+    if ((OF.general.regdest) == 6) {
+        regs = GETword(REGS.pc);
+        REGS.pc += 2;
+        WORK.source = CommandMode[OF.general.modesrc]((char)(OF.general.regsrc), 0, 0L, 2);
         if (opcode & 0x0400) {
             Unknown(opcode);
         } else {
-            cpu.dregs.d[(regs >> 12) & 0x0007] =
-                (unsigned long)((unsigned long)cpu.dregs.d[(regs >> 12) & 0x0007] *
-                                (unsigned long)work.source);
+            REGS.dregs.d[(regs >> 12) & 0x0007] =
+                (unsigned long)((unsigned long)REGS.dregs.d[(regs >> 12) & 0x0007] *
+                                (unsigned long)WORK.source);
         }
     } else {
-        work.source = CommandMode[of.general.modesrc]((char)(of.general.regsrc), 0, 0L, 1);
-        cpu.dregs.d[of.general.regdest] =
-            (unsigned long)((unsigned short)cpu.dregs.d[of.general.regdest] *
-                            (unsigned short)work.source);
+        WORK.source = CommandMode[OF.general.modesrc]((char)(OF.general.regsrc), 0, 0L, 1);
+        REGS.dregs.d[OF.general.regdest] =
+            (unsigned long)((unsigned short)REGS.dregs.d[OF.general.regdest] *
+                            (unsigned short)WORK.source);
     }
 }
 
 /* Multiply Signed */
 void COM_muls(short opcode)
 {
-    static short regs;
+    short regs;
 
     CACHEFUNCTION(COM_muls);
-    cpu.pc += 2;
-    if ((of.general.regdest) == 6) {
-        regs = GETword(cpu.pc);
-        cpu.pc += 2;
-        work.source = CommandMode[of.general.modesrc]((char)(of.general.regsrc), 0, 0L, 2);
+    REGS.pc += 2;
+    if ((OF.general.regdest) == 6) {
+        regs = GETword(REGS.pc);
+        REGS.pc += 2;
+        WORK.source = CommandMode[OF.general.modesrc]((char)(OF.general.regsrc), 0, 0L, 2);
         if (opcode & 0x0400) {
             Unknown(opcode);
         } else {
-            cpu.dregs.d[(regs >> 12) & 0x0007] =
-                (long)((long)cpu.dregs.d[(regs >> 12) & 0x0007] *
-                       (long)work.source);
+            REGS.dregs.d[(regs >> 12) & 0x0007] =
+                (long)((long)REGS.dregs.d[(regs >> 12) & 0x0007] *
+                       (long)WORK.source);
         }
     } else {
-        work.source = CommandMode[of.general.modesrc]((char)(of.general.regsrc), 0, 0L, 1);
-        cpu.dregs.d[of.general.regdest] =
-            (long)((short)cpu.dregs.d[of.general.regdest] *
-                   (short)work.source);
+        WORK.source = CommandMode[OF.general.modesrc]((char)(OF.general.regsrc), 0, 0L, 1);
+        REGS.dregs.d[OF.general.regdest] =
+            (long)((short)REGS.dregs.d[OF.general.regdest] *
+                   (short)WORK.source);
     }
 }
 
 /* 68020 Multiply - supports 64-bit result */
 void COM_mul020(short opcode)
 {
-    static short extension;
+    short extension;
 
     CACHEFUNCTION(COM_mul020);
-    cpu.pc += 2;
-    extension = GETword(cpu.pc);
-    cpu.pc += 2;
-    work.source = CommandMode[of.general.modesrc]((char)(of.general.regsrc), 0, 0L, 2);
+    REGS.pc += 2;
+    extension = GETword(REGS.pc);
+    REGS.pc += 2;
+    WORK.source = CommandMode[OF.general.modesrc]((char)(OF.general.regsrc), 0, 0L, 2);
 
     switch ((extension >> 11) & 0x0001) {
         case 0: /* MULU - unsigned multiply */
             switch ((extension >> 10) & 0x0001) {
                 case 0: /* 32 bit to Di */
-                    cpu.dregs.d[(extension >> 12) & 0x0007] =
-                        (unsigned long)cpu.dregs.d[(extension >> 12) & 0x0007] *
-                        (unsigned long)work.source;
-                    if ((unsigned long)cpu.dregs.d[(extension >> 12) & 0x0007] <
-                        (unsigned short)work.source)
+                    REGS.dregs.d[(extension >> 12) & 0x0007] =
+                        (unsigned long)REGS.dregs.d[(extension >> 12) & 0x0007] *
+                        (unsigned long)WORK.source;
+                    if ((unsigned long)REGS.dregs.d[(extension >> 12) & 0x0007] <
+                        (unsigned short)WORK.source)
                         OVER1;
                     else
                         OVER0;
@@ -1587,11 +1557,11 @@ void COM_mul020(short opcode)
         case 1: /* MULS - signed multiply */
             switch ((extension >> 10) & 0x0001) {
                 case 0: /* 32 bit to Di */
-                    cpu.dregs.d[(extension >> 12) & 0x0007] =
-                        (long)cpu.dregs.d[(extension >> 12) & 0x0007] *
-                        (long)work.source;
-                    if ((short)cpu.dregs.d[(extension >> 12) & 0x0007] <
-                        (short)work.source)
+                    REGS.dregs.d[(extension >> 12) & 0x0007] =
+                        (long)REGS.dregs.d[(extension >> 12) & 0x0007] *
+                        (long)WORK.source;
+                    if ((short)REGS.dregs.d[(extension >> 12) & 0x0007] <
+                        (short)WORK.source)
                         OVER1;
                     else
                         OVER0;
@@ -1602,18 +1572,18 @@ void COM_mul020(short opcode)
             }
             break;
     }
-    if (cpu.dregs.d[(extension >> 12) & 0x0007] == 0)
+    if (REGS.dregs.d[(extension >> 12) & 0x0007] == 0)
         ZERO1;
     else
         ZERO0;
-    if ((long)cpu.dregs.d[(extension >> 12) & 0x0007] < 0)
+    if ((long)REGS.dregs.d[(extension >> 12) & 0x0007] < 0)
         NEG1;
     else
         NEG0;
     CARRY0;
 }
-void COM_div(short opcode) { cpu.pc += 2; }
-void COM_divx(short opcode) { cpu.pc += 2; }
+void COM_div(short opcode) { REGS.pc += 2; }
+void COM_divx(short opcode) { REGS.pc += 2; }
 /* 68020 Division with optional 64-bit support */
 void COM_div020(short opcode)
 {
@@ -1622,30 +1592,30 @@ void COM_div020(short opcode)
     uint32_t quotient, remainder;
 
     CACHEFUNCTION(COM_div020);
-    cpu.pc += 2;
-    extension = GETword(cpu.pc);
-    cpu.pc += 2;
-    work.source = CommandMode[of.general.modesrc]((char)(of.general.regsrc), 0, 0L, 2);
+    REGS.pc += 2;
+    extension = GETword(REGS.pc);
+    REGS.pc += 2;
+    WORK.source = CommandMode[OF.general.modesrc]((char)(OF.general.regsrc), 0, 0L, 2);
 
-    if (work.source) {
+    if (WORK.source) {
         switch ((extension >> 11) & 0x0001) {
             case 0: /* DIVU - unsigned divide */
                 switch ((extension >> 10) & 0x0001) {
                     case 0: /* 32 bit to Dq */
-                        div64_unsigned(&quotient, &remainder, 0, cpu.dregs.d[(extension >> 12) & 0x0007], work.source);
-                        cpu.dregs.d[extension & 0x0007] = remainder;
-                        cpu.dregs.d[(extension >> 12) & 0x0007] = quotient;
-                        if (quotient < (unsigned short)work.source)
+                        div64_unsigned(&quotient, &remainder, 0, REGS.dregs.d[(extension >> 12) & 0x0007], WORK.source);
+                        REGS.dregs.d[extension & 0x0007] = remainder;
+                        REGS.dregs.d[(extension >> 12) & 0x0007] = quotient;
+                        if (quotient < (unsigned short)WORK.source)
                             OVER1;
                         else
                             OVER0;
                         break;
                     case 1: /* 64 bit in Dq:Dr */
-                        Dr = cpu.dregs.d[extension & 0x0007];
-                        Dq = cpu.dregs.d[(extension >> 12) & 0x0007];
-                        div64_unsigned(&quotient, &remainder, Dr, Dq, (uint32_t)work.source);
-                        cpu.dregs.d[extension & 0x0007] = remainder;
-                        cpu.dregs.d[(extension >> 12) & 0x0007] = quotient;
+                        Dr = REGS.dregs.d[extension & 0x0007];
+                        Dq = REGS.dregs.d[(extension >> 12) & 0x0007];
+                        div64_unsigned(&quotient, &remainder, Dr, Dq, (uint32_t)WORK.source);
+                        REGS.dregs.d[extension & 0x0007] = remainder;
+                        REGS.dregs.d[(extension >> 12) & 0x0007] = quotient;
                         break;
                 }
                 break;
@@ -1653,30 +1623,30 @@ void COM_div020(short opcode)
                 switch ((extension >> 10) & 0x0001) {
                     case 0: /* 32 bit to Dq */
                         div64_signed((int32_t*)&quotient, (int32_t*)&remainder,
-                                    0, (int32_t)cpu.dregs.d[(extension >> 12) & 0x0007], (int32_t)work.source);
-                        cpu.dregs.d[extension & 0x0007] = remainder;
-                        cpu.dregs.d[(extension >> 12) & 0x0007] = quotient;
-                        if ((int32_t)quotient < (short)work.source)
+                                    0, (int32_t)REGS.dregs.d[(extension >> 12) & 0x0007], (int32_t)WORK.source);
+                        REGS.dregs.d[extension & 0x0007] = remainder;
+                        REGS.dregs.d[(extension >> 12) & 0x0007] = quotient;
+                        if ((int32_t)quotient < (short)WORK.source)
                             OVER1;
                         else
                             OVER0;
                         break;
                     case 1: /* 64 bit in Dq:Dr */
-                        Dr = cpu.dregs.d[extension & 0x0007];
-                        Dq = cpu.dregs.d[(extension >> 12) & 0x0007];
+                        Dr = REGS.dregs.d[extension & 0x0007];
+                        Dq = REGS.dregs.d[(extension >> 12) & 0x0007];
                         div64_signed((int32_t*)&quotient, (int32_t*)&remainder,
-                                    (int32_t)Dr, (int32_t)Dq, (int32_t)work.source);
-                        cpu.dregs.d[extension & 0x0007] = remainder;
-                        cpu.dregs.d[(extension >> 12) & 0x0007] = quotient;
+                                    (int32_t)Dr, (int32_t)Dq, (int32_t)WORK.source);
+                        REGS.dregs.d[extension & 0x0007] = remainder;
+                        REGS.dregs.d[(extension >> 12) & 0x0007] = quotient;
                         break;
                 }
                 break;
         }
-        if (cpu.dregs.d[(extension >> 12) & 0x0007] == 0)
+        if (REGS.dregs.d[(extension >> 12) & 0x0007] == 0)
             ZERO1;
         else
             ZERO0;
-        if ((int32_t)cpu.dregs.d[(extension >> 12) & 0x0007] < 0)
+        if ((int32_t)REGS.dregs.d[(extension >> 12) & 0x0007] < 0)
             NEG1;
         else
             NEG0;
@@ -1694,22 +1664,22 @@ void COM_bcc(short opcode)
     CACHEFUNCTION(COM_bcc);
     switch (opcode & 0x00ff) {
         case 0:
-            if ((cpu.sregs.sr & 0x01) == 0)
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x01) == 0)
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if ((cpu.sregs.sr & 0x01) == 0)
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x01) == 0)
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if ((cpu.sregs.sr & 0x01) == 0)
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if ((GETCCR() & 0x01) == 0)
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1720,22 +1690,22 @@ void COM_bcs(short opcode)
     CACHEFUNCTION(COM_bcs);
     switch (opcode & 0x00ff) {
         case 0:
-            if ((cpu.sregs.sr & 0x01) != 0)
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x01) != 0)
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if ((cpu.sregs.sr & 0x01) != 0)
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x01) != 0)
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if ((cpu.sregs.sr & 0x01) != 0)
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if ((GETCCR() & 0x01) != 0)
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1746,22 +1716,22 @@ void COM_bge(short opcode)
     CACHEFUNCTION(COM_bge);
     switch (opcode & 0x00ff) {
         case 0:
-            if (((cpu.sregs.sr & 0x0A) == 0) || ((cpu.sregs.sr & 0x0A) == 0x0A))
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x0A) == 0) || ((GETCCR() & 0x0A) == 0x0A))
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if (((cpu.sregs.sr & 0x0A) == 0) || ((cpu.sregs.sr & 0x0A) == 0x0A))
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x0A) == 0) || ((GETCCR() & 0x0A) == 0x0A))
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if (((cpu.sregs.sr & 0x0A) == 0) || ((cpu.sregs.sr & 0x0A) == 0x0A))
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if (((GETCCR() & 0x0A) == 0) || ((GETCCR() & 0x0A) == 0x0A))
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1772,22 +1742,22 @@ void COM_bgt(short opcode)
     CACHEFUNCTION(COM_bgt);
     switch (opcode & 0x00ff) {
         case 0:
-            if (((cpu.sregs.sr & 0x0e) == 0x0A) || ((cpu.sregs.sr & 0x0e) == 0))
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x0e) == 0x0A) || ((GETCCR() & 0x0e) == 0))
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if (((cpu.sregs.sr & 0x0e) == 0x0A) || ((cpu.sregs.sr & 0x0e) == 0))
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x0e) == 0x0A) || ((GETCCR() & 0x0e) == 0))
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if (((cpu.sregs.sr & 0x0e) == 0x0A) || ((cpu.sregs.sr & 0x0e) == 0))
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if (((GETCCR() & 0x0e) == 0x0A) || ((GETCCR() & 0x0e) == 0))
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1798,22 +1768,22 @@ void COM_bhi(short opcode)
     CACHEFUNCTION(COM_bhi);
     switch (opcode & 0x00ff) {
         case 0:
-            if (((cpu.sregs.sr & 0x05) == 0))
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x05) == 0))
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if (((cpu.sregs.sr & 0x05) == 0))
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x05) == 0))
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if (((cpu.sregs.sr & 0x05) == 0))
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if (((GETCCR() & 0x05) == 0))
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1824,22 +1794,22 @@ void COM_ble(short opcode)
     CACHEFUNCTION(COM_ble);
     switch (opcode & 0x00ff) {
         case 0:
-            if (((cpu.sregs.sr & 0x0A) != 0))
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x0A) != 0))
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if (((cpu.sregs.sr & 0x0A) != 0))
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x0A) != 0))
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if (((cpu.sregs.sr & 0x0A) != 0))
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if (((GETCCR() & 0x0A) != 0))
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1850,22 +1820,22 @@ void COM_bls(short opcode)
     CACHEFUNCTION(COM_bls);
     switch (opcode & 0x00ff) {
         case 0:
-            if (((cpu.sregs.sr & 0x05) != 0))
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x05) != 0))
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if (((cpu.sregs.sr & 0x05) != 0))
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x05) != 0))
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if (((cpu.sregs.sr & 0x05) != 0))
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if (((GETCCR() & 0x05) != 0))
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1876,22 +1846,22 @@ void COM_blt(short opcode)
     CACHEFUNCTION(COM_blt);
     switch (opcode & 0x00ff) {
         case 0:
-            if (((cpu.sregs.sr & 0x0e) == 0x08) || ((cpu.sregs.sr & 0x0e) == 0x04))
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x0e) == 0x08) || ((GETCCR() & 0x0e) == 0x04))
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if (((cpu.sregs.sr & 0x0e) == 0x08) || ((cpu.sregs.sr & 0x0e) == 0x04))
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if (((GETCCR() & 0x0e) == 0x08) || ((GETCCR() & 0x0e) == 0x04))
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if (((cpu.sregs.sr & 0x0e) == 0x08) || ((cpu.sregs.sr & 0x0e) == 0x04))
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if (((GETCCR() & 0x0e) == 0x08) || ((GETCCR() & 0x0e) == 0x04))
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1902,22 +1872,22 @@ void COM_bmi(short opcode)
     CACHEFUNCTION(COM_bmi);
     switch (opcode & 0x00ff) {
         case 0:
-            if ((cpu.sregs.sr & 0x08) != 0)
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x08) != 0)
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if ((cpu.sregs.sr & 0x08) != 0)
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x08) != 0)
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if ((cpu.sregs.sr & 0x08) != 0)
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if ((GETCCR() & 0x08) != 0)
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1928,22 +1898,22 @@ void COM_bpl(short opcode)
     CACHEFUNCTION(COM_bpl);
     switch (opcode & 0x00ff) {
         case 0:
-            if ((cpu.sregs.sr & 0x08) == 0)
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x08) == 0)
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if ((cpu.sregs.sr & 0x08) == 0)
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x08) == 0)
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if ((cpu.sregs.sr & 0x08) == 0)
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if ((GETCCR() & 0x08) == 0)
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1952,17 +1922,17 @@ void COM_bpl(short opcode)
 void COM_bsr(short opcode)
 {
     CACHEFUNCTION(COM_bsr);
-    cpu.aregs.a[7] -= 4;
-    PUTdword(cpu.aregs.a[7], cpu.pc + 2);
+    REGS.aregs.a[7] -= 4;
+    PUTdword(REGS.aregs.a[7], REGS.pc + 2);
     switch (opcode & 0x00ff) {
         case 0:
-            cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             break;
         case 0xFF:
-            cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             break;
         default:
-            cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             break;
     }
 }
@@ -1973,22 +1943,22 @@ void COM_bvc(short opcode)
     CACHEFUNCTION(COM_bvc);
     switch (opcode & 0x00ff) {
         case 0:
-            if ((cpu.sregs.sr & 0x02) == 0)
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x02) == 0)
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if ((cpu.sregs.sr & 0x02) == 0)
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x02) == 0)
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if ((cpu.sregs.sr & 0x02) == 0)
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if ((GETCCR() & 0x02) == 0)
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
@@ -1999,28 +1969,28 @@ void COM_bvs(short opcode)
     CACHEFUNCTION(COM_bvs);
     switch (opcode & 0x00ff) {
         case 0:
-            if ((cpu.sregs.sr & 0x02) != 0)
-                cpu.pc = cpu.pc + (short)GETword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x02) != 0)
+                REGS.pc = REGS.pc + (short)GETword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 4;
+                REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            if ((cpu.sregs.sr & 0x02) != 0)
-                cpu.pc = cpu.pc + (long)GETdword(cpu.pc + 2) + 2;
+            if ((GETCCR() & 0x02) != 0)
+                REGS.pc = REGS.pc + (long)GETdword(REGS.pc + 2) + 2;
             else
-                cpu.pc = cpu.pc + 6;
+                REGS.pc = REGS.pc + 6;
             break;
         default:
-            if ((cpu.sregs.sr & 0x02) != 0)
-                cpu.pc = cpu.pc + (char)(opcode & 0x00ff) + 2;
+            if ((GETCCR() & 0x02) != 0)
+                REGS.pc = REGS.pc + (char)(opcode & 0x00ff) + 2;
             else
-                cpu.pc = cpu.pc + 2;
+                REGS.pc = REGS.pc + 2;
             break;
     }
 }
 
 /* Decrement and Branch if Condition Clear (DBCC) */
-void COM_dbcc(short opcode) { cpu.pc += 2; }
+void COM_dbcc(short opcode) { REGS.pc += 2; }
 
 /* Branch if False (BF) - never branches */
 void COM_bf(short opcode)
@@ -2028,103 +1998,115 @@ void COM_bf(short opcode)
     CACHEFUNCTION(COM_bf);
     switch (opcode & 0x00ff) {
         case 0:
-            cpu.pc = cpu.pc + 4;
+            REGS.pc = REGS.pc + 4;
             break;
         case 0xFF:
-            cpu.pc = cpu.pc + 6;
+            REGS.pc = REGS.pc + 6;
             break;
         default:
-            cpu.pc = cpu.pc + 2;
+            REGS.pc = REGS.pc + 2;
             break;
     }
 }
 
 /* Move Operations */
-void COM_MoveByte(short opcode) { cpu.pc += 2; }
-void COM_MoveWord(short opcode) { cpu.pc += 2; }
-void COM_MoveLong(short opcode) { cpu.pc += 2; }
-void COM_movemtoEA(short opcode) { cpu.pc += 2; }
-void COM_movemtoreg(short opcode) { cpu.pc += 2; }
-void COM_movep(short opcode) { cpu.pc += 2; }
-void COM_movetoCCR(short opcode) { cpu.pc += 2; }
-void COM_moveUSP(short opcode) { cpu.pc += 2; }
-void COM_movec(short opcode) { cpu.pc += 2; }
+void COM_MoveByte(short opcode) { REGS.pc += 2; }
+void COM_MoveWord(short opcode) { REGS.pc += 2; }
+void COM_MoveLong(short opcode) { REGS.pc += 2; }
+void COM_movemtoEA(short opcode) { REGS.pc += 2; }
+void COM_movemtoreg(short opcode) { REGS.pc += 2; }
+void COM_movep(short opcode) { REGS.pc += 2; }
+void COM_movetoCCR(short opcode) { REGS.pc += 2; }
+void COM_moveUSP(short opcode) { REGS.pc += 2; }
+void COM_movec(short opcode) { REGS.pc += 2; }
 
 /* Bit Operations */
-void COM_BitField(short opcode) { cpu.pc += 2; }
-void COM_dyntstbit(short opcode) { cpu.pc += 2; }
-void COM_stattstbit(short opcode) { cpu.pc += 2; }
-void COM_tas(short opcode) { cpu.pc += 2; }
+void COM_BitField(short opcode) { REGS.pc += 2; }
+void COM_dyntstbit(short opcode) { REGS.pc += 2; }
+void COM_stattstbit(short opcode) { REGS.pc += 2; }
+void COM_tas(short opcode) { REGS.pc += 2; }
 
 /* Shift and Rotate */
-void COM_asx(short opcode) { cpu.pc += 2; }
-void COM_lsx(short opcode) { cpu.pc += 2; }
-void COM_rx(short opcode) { cpu.pc += 2; }
+void COM_asx(short opcode) { REGS.pc += 2; }
+void COM_lsx(short opcode) { REGS.pc += 2; }
+void COM_rx(short opcode) { REGS.pc += 2; }
 
 /* BCD Arithmetic */
-void COM_abcd(short opcode) { cpu.pc += 2; }
-void COM_nbcd(short opcode) { cpu.pc += 2; }
-void COM_sbcd(short opcode) { cpu.pc += 2; }
-void COM_pack(short opcode) { cpu.pc += 2; }
-void COM_unpack(short opcode) { cpu.pc += 2; }
+void COM_abcd(short opcode) { REGS.pc += 2; }
+void COM_nbcd(short opcode) { REGS.pc += 2; }
+void COM_sbcd(short opcode) { REGS.pc += 2; }
+void COM_pack(short opcode) { REGS.pc += 2; }
+void COM_unpack(short opcode) { REGS.pc += 2; }
 
 /* Control Flow */
 void COM_link(short opcode)
 {
 	CACHEFUNCTION(COM_link);
-	cpu.pc+=2;
-	cpu.aregs.a[7]-=4;
-	PUTdword(cpu.aregs.a[7],cpu.aregs.a[of.general.regsrc]);
-	cpu.aregs.a[of.general.regsrc]=cpu.aregs.a[7];
-	cpu.aregs.a[7]=cpu.aregs.a[7]+(long)GETword(cpu.pc);
-	cpu.pc+=2;
+	REGS.pc+=2;
+	REGS.aregs.a[7]-=4;
+	PUTdword(REGS.aregs.a[7],REGS.aregs.a[OF.general.regsrc]);
+	REGS.aregs.a[OF.general.regsrc]=REGS.aregs.a[7];
+	REGS.aregs.a[7]=REGS.aregs.a[7]+(long)GETword(REGS.pc);
+	REGS.pc+=2;
 }
 void COM_unlink(short opcode)
 {
 	CACHEFUNCTION(COM_unlink);
-	cpu.pc+=2;
-	cpu.aregs.a[7]=cpu.aregs.a[of.general.regsrc];
-	cpu.aregs.a[of.general.regsrc]=GETdword(cpu.aregs.a[7]);
-	cpu.aregs.a[7]+=4;
+	REGS.pc+=2;
+	REGS.aregs.a[7]=REGS.aregs.a[OF.general.regsrc];
+	REGS.aregs.a[OF.general.regsrc]=GETdword(REGS.aregs.a[7]);
+	REGS.aregs.a[7]+=4;
 }
-void COM_trap(short opcode) { cpu.pc += 2; }
-void COM_trapv(short opcode) { cpu.pc += 2; }
-void COM_rtr(short opcode) { cpu.pc += 2; }
+void COM_trap(short opcode) { REGS.pc += 2; }
+void COM_trapv(short opcode) { REGS.pc += 2; }
+void COM_rtr(short opcode) { REGS.pc += 2; }
 
 /* Status Register Operations */
-void COM_oritoSR(short opcode) { cpu.pc += 2; }
-void COM_oritoCCR(short opcode) { cpu.pc += 2; }
+void COM_oritoSR(short opcode) { REGS.pc += 2; }
+void COM_oritoCCR(short opcode) { REGS.pc += 2; }
 
 /* Arithmetic Extensions */
-void COM_negx(short opcode) { cpu.pc += 2; }
-void COM_subx(short opcode) { cpu.pc += 2; }
-void COM_ext(short opcode) { cpu.pc += 2; }
+void COM_negx(short opcode) { REGS.pc += 2; }
+void COM_subx(short opcode) { REGS.pc += 2; }
+void COM_ext(short opcode) { REGS.pc += 2; }
 
 /* Other Operations */
-void COM_chk(short opcode) { cpu.pc += 2; }
-void COM_exg(short opcode) { cpu.pc += 2; }
-void COM_swap(short opcode) { cpu.pc += 2; }
-void COM_scc(short opcode) { cpu.pc += 2; }
-void COM_r(short opcode) { cpu.pc += 2; }
+void COM_chk(short opcode) { REGS.pc += 2; }
+void COM_exg(short opcode) { REGS.pc += 2; }
+void COM_swap(short opcode) { REGS.pc += 2; }
+void COM_scc(short opcode) { REGS.pc += 2; }
+void COM_r(short opcode) { REGS.pc += 2; }
 void COM_linea(short opcode) { emulatelinea(); }
 void COM_linef(short opcode) { emulatelinef(); }
-void COM_stop(short opcode) { cpu.pc += 2; }
+void COM_stop(short opcode)
+{
+	CACHEFUNCTION(COM_stop);
+	// test if in supervisor modes
+	if(REGS.sregs.sr&0x3000) // test if in supervisor mode
+	{
+		REGS.pc+=4; // increment PC
+		REGS.sregs.sr=GETword(REGS.pc-2); // load SR from immediate data
+		ccr_load();
+		STOPPED=TRUE; // stop CPU
+	}
+	else priv_viol();
+}
 
 /* Missing handlers - add as stubs for now */
-void COM_ori(short opcode) { cpu.pc += 2; }  /* Stub - will replace with real implementation */
+void COM_ori(short opcode) { REGS.pc += 2; }  /* Stub - will replace with real implementation */
 void COM_illegal(short opcode) { illegal(); }
 
 /* All handlers now defined */
 
 /* Additional missing handlers - quick stubs */
-void COM_andi(short opcode) { cpu.pc += 2; }
+void COM_andi(short opcode) { REGS.pc += 2; }
 
 
 /* Auto-generated stubs for missing handlers */
-void COM_addi(short opcode) { cpu.pc += 2; }
-void COM_addq(short opcode) { cpu.pc += 2; }
-void COM_cmpa(short opcode) { cpu.pc += 2; }
-void COM_cmpi(short opcode) { cpu.pc += 2; }
-void COM_eori(short opcode) { cpu.pc += 2; }
-void COM_subi(short opcode) { cpu.pc += 2; }
-void COM_subq(short opcode) { cpu.pc += 2; }
+void COM_addi(short opcode) { REGS.pc += 2; }
+void COM_addq(short opcode) { REGS.pc += 2; }
+void COM_cmpa(short opcode) { REGS.pc += 2; }
+void COM_cmpi(short opcode) { REGS.pc += 2; }
+void COM_eori(short opcode) { REGS.pc += 2; }
+void COM_subi(short opcode) { REGS.pc += 2; }
+void COM_subq(short opcode) { REGS.pc += 2; }
@@ -0,0 +1,270 @@
+////////////////////////////////////////////////////////////////////////////////
+// Basic Block Translator
+// Chains decoded opcodes into blocks of pre-bound handler calls
+//
+// Blocks are recorded while the batch loop interprets: every opcode that
+// came out of the instruction cache is appended to the block under
+// construction until a branch, JSR/RTS, trap, SR write or I/O access ends
+// it. The handlers still fetch their own extension words, so a block only
+// stores what the instruction cache does (opcode, handler, cycles) plus
+// the address of every opcode; the next opcode's address doubles as the
+// fall-through check when the block is replayed.
+//
+// Recorded pages are write protected through memory_map[].whost just like
+// cached instructions, so self-modifying code written by PUTbyte/PUTword/
+// PUTdword ends up in sim_tb_invalidate_page().
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include "simulator.h"
+#include "simulator_mem.h"
+#include "simulator_internal.h"
+
+extern void COM_bra(short), COM_bsr(short), COM_bhi(short), COM_bls(short), COM_bcc(short);
+extern void COM_bcs(short), COM_bne(short), COM_beq(short), COM_bvc(short), COM_bvs(short);
+extern void COM_bpl(short), COM_bmi(short), COM_bge(short), COM_blt(short), COM_bgt(short);
+extern void COM_ble(short), COM_dbcc(short);
+extern void COM_jmp(short), COM_jsr(short), COM_rts(short), COM_rtr(short), COM_rte(short);
+extern void COM_trap(short), COM_trapv(short), COM_chk(short);
+extern void COM_illegal(short), COM_linea(short), COM_linef(short);
+extern void COM_stop(short), COM_reset(short), COM_movetoSR(short), COM_movec(short);
+
+// How an opcode ends a block
+#define TB_STRAIGHT  0      // Falls through to the next opcode
+#define TB_END_CHAIN 1      // Control transfer, the successor block may be chained
+#define TB_END_LOOP  2      // May change SR/IPL or raise an exception: back to the batch loop
+
+// ORI/ANDI/EORI #imm,SR
+#define OPCODE_ORI_SR  0x007C
+#define OPCODE_ANDI_SR 0x027C
+#define OPCODE_EORI_SR 0x0A7C
+
+static const struct {
+    void (*handler)(short);
+    int kind;
+} BlockEnders[] = {
+    { COM_bra, TB_END_CHAIN }, { COM_bsr, TB_END_CHAIN }, { COM_bhi, TB_END_CHAIN },
+    { COM_bls, TB_END_CHAIN }, { COM_bcc, TB_END_CHAIN }, { COM_bcs, TB_END_CHAIN },
+    { COM_bne, TB_END_CHAIN }, { COM_beq, TB_END_CHAIN }, { COM_bvc, TB_END_CHAIN },
+    { COM_bvs, TB_END_CHAIN }, { COM_bpl, TB_END_CHAIN }, { COM_bmi, TB_END_CHAIN },
+    { COM_bge, TB_END_CHAIN }, { COM_blt, TB_END_CHAIN }, { COM_bgt, TB_END_CHAIN },
+    { COM_ble, TB_END_CHAIN }, { COM_dbcc, TB_END_CHAIN },
+    { COM_jmp, TB_END_CHAIN }, { COM_jsr, TB_END_CHAIN }, { COM_rts, TB_END_CHAIN },
+    { COM_rtr, TB_END_CHAIN },
+
+    { COM_rte, TB_END_LOOP }, { COM_trap, TB_END_LOOP }, { COM_trapv, TB_END_LOOP },
+    { COM_chk, TB_END_LOOP }, { COM_illegal, TB_END_LOOP }, { COM_linea, TB_END_LOOP },
+    { COM_linef, TB_END_LOOP }, { COM_stop, TB_END_LOOP }, { COM_reset, TB_END_LOOP },
+    { COM_movetoSR, TB_END_LOOP }, { COM_movec, TB_END_LOOP },
+};
+
+static int tb_insn_kind(const icache_entry_t *e)
+{
+    if (e->opcode == OPCODE_ORI_SR || e->opcode == OPCODE_ANDI_SR ||
+        e->opcode == OPCODE_EORI_SR) {
+        return TB_END_LOOP;
+    }
+    for (size_t i = 0; i < sizeof(BlockEnders) / sizeof(BlockEnders[0]); i++) {
+        if (e->handler == BlockEnders[i].handler) return BlockEnders[i].kind;
+    }
+    return TB_STRAIGHT;
+}
+
+// Opcodes that write no memory and only read through their source EA: the
+// blocks a polling loop can consist of. Anything not listed counts as a
+// write, so the list only has to cover what status polling loops use.
+static int tb_insn_pure(uint16_t op)
+{
+    unsigned mode = (op >> 3) & 7, opmode = (op >> 6) & 7;
+
+    switch (op >> 12) {
+    case 0x0:
+        if ((op & 0xF1C0) == 0x0100 && mode != 1) return 1;         // BTST Dn,<ea>
+        if ((op & 0xFFC0) == 0x0800) return 1;                      // BTST #n,<ea>
+        if (op & 0x0100) return 0;                                  // Other bit ops, MOVEP
+        if ((op & 0x00C0) == 0x00C0) return 0;                      // CMP2/CHK2/CAS, size 3
+        switch ((op >> 9) & 7) {
+        case 0: case 1: case 2: case 3: case 5:                     // ORI ANDI SUBI ADDI EORI
+            return mode == 0;
+        case 6:                                                     // CMPI
+            return 1;
+        }
+        return 0;
+    case 0x1: case 0x2: case 0x3:                                   // MOVE/MOVEA to a register
+        return opmode <= 1;
+    case 0x4:
+        if ((op & 0xFF00) == 0x4A00 && (op & 0x00C0) != 0x00C0) return 1;   // TST
+        if ((op & 0xFFB8) == 0x4880 || (op & 0xFFF8) == 0x49C0) return 1;   // EXT, EXTB
+        if ((op & 0xF1C0) == 0x41C0) return 1;                      // LEA
+        return op == 0x4E71;                                        // NOP
+    case 0x5:
+        return (op & 0xF0F8) == 0x50C8;                             // DBcc
+    case 0x6:
+        return (op & 0xFF00) != 0x6100;                             // Bcc, not BSR
+    case 0x7:
+        return !(op & 0x0100);                                      // MOVEQ
+    case 0x8: case 0x9: case 0xC: case 0xD:                         // OR SUB AND ADD <ea>,Dn
+        return opmode <= 3 || opmode == 7;                          // and the An/MUL/DIV forms
+    case 0xB:                                                       // CMP, CMPA
+        return opmode <= 3 || opmode == 7;
+    }
+    return 0;
+}
+
+static inline uint16_t tb_page(uint32_t addr)
+{
+    return (uint16_t)((addr & 0xFFFFFF) >> MEMORY_PAGE_SHIFT);
+}
+
+static int tb_is_breakpoint(const simulator_priv_t *priv, uint32_t pc)
+{
+    for (int i = 0; i < priv->num_breakpoints; i++) {
+        if (priv->breakpoints[i] == (pc & 0xFFFFFF)) return 1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// Block pool
+// ============================================================================
+
+void sim_tb_flush(simulator_t *sim)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    // Page protection stays: the instruction cache may still hold code there
+    memset(priv->tb_hash, 0, sizeof(priv->tb_hash));
+    priv->tb_num_blocks = 0;
+    priv->tb_build = NULL;
+}
+
+// Drop the block under construction (always the last one allocated)
+static void tb_abandon(simulator_priv_t *priv)
+{
+    if (priv->tb_build) {
+        priv->tb_build->pc = ICACHE_EMPTY;
+        priv->tb_build = NULL;
+        priv->tb_num_blocks--;
+    }
+}
+
+static void tb_commit(simulator_priv_t *priv)
+{
+    tb_block_t *b = priv->tb_build;
+
+    priv->tb_build = NULL;
+    b->insn[b->num_insns].pc = ICACHE_EMPTY;
+    priv->tb_hash[(b->pc >> 1) & TB_HASH_MASK] = b;
+}
+
+static tb_block_t *tb_begin(simulator_t *sim, uint32_t pc)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    if (priv->tb_num_blocks == TB_MAX_BLOCKS) {
+        sim_tb_flush(sim);
+    }
+
+    tb_block_t *b = &priv->tb_blocks[priv->tb_num_blocks++];
+    b->pc = pc;
+    b->first_page = b->last_page = tb_page(pc);
+    b->num_insns = 0;
+    b->exit_to_loop = 0;
+    b->pure = 1;
+    b->link[0] = b->link[1] = NULL;
+
+    priv->tb_build = b;
+    return b;
+}
+
+// ============================================================================
+// Recording (batch loop, interpreted opcodes only)
+// ============================================================================
+
+void sim_tb_record(simulator_t *sim, const icache_entry_t *e, uint32_t pc, uint32_t next_pc)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    tb_block_t *b = priv->tb_build;
+
+    // The opcode overwrote itself; its cache entry is gone and so is the block
+    if (e->pc != pc) {
+        tb_abandon(priv);
+        return;
+    }
+
+    // Something other than a fall-through got us here (interrupt, new batch)
+    if (b && pc != priv->tb_build_next) {
+        tb_commit(priv);
+        b = NULL;
+    }
+
+    if (b == NULL) {
+        // Interpreted although translated (budget, after RTE): nothing to do
+        if (sim_tb_lookup(priv, pc)) return;
+        b = tb_begin(sim, pc);
+    }
+
+    b->insn[b->num_insns++] = *e;
+    b->pure &= tb_insn_pure(e->opcode);
+
+    // Protect the opcode and its extension words against writes
+    uint16_t last = tb_page(pc + TB_MAX_INSN_BYTES - 1);
+    priv->core.memory_map[tb_page(pc)].whost = NULL;
+    priv->core.memory_map[last].whost = NULL;
+    b->last_page = last;
+
+    int kind = tb_insn_kind(e);
+    if (kind != TB_STRAIGHT) {
+        b->exit_to_loop = (kind == TB_END_LOOP);
+        tb_commit(priv);
+        return;
+    }
+
+    // Exception (PC left the instruction) or I/O access: the loop takes over
+    if (next_pc <= pc || next_pc > pc + TB_MAX_INSN_BYTES || priv->tb_exit) {
+        b->exit_to_loop = 1;
+        tb_commit(priv);
+        return;
+    }
+
+    if (b->num_insns == TB_MAX_INSNS || tb_is_breakpoint(priv, next_pc) ||
+        sim_tb_lookup(priv, next_pc)) {
+        tb_commit(priv);
+        return;
+    }
+
+    priv->tb_build_next = next_pc;
+}
+
+// ============================================================================
+// Invalidation (simulator_write_memory)
+// ============================================================================
+
+void sim_tb_invalidate_page(simulator_t *sim, uint32_t page)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    // A running block must not execute past the write
+    priv->tb_exit = 1;
+
+    tb_block_t *b = priv->tb_build;
+    if (b && (b->first_page == page || b->last_page == page)) {
+        tb_abandon(priv);
+    }
+
+    for (int i = 0; i < priv->tb_num_blocks; i++) {
+        b = &priv->tb_blocks[i];
+        if (b->pc == ICACHE_EMPTY || b == priv->tb_build) continue;
+        if (b->first_page == page || b->last_page == page) {
+            tb_block_t **slot = &priv->tb_hash[(b->pc >> 1) & TB_HASH_MASK];
+            if (*slot == b) *slot = NULL;
+            b->pc = ICACHE_EMPTY;
+        }
+    }
+
+    // Code patching itself usually hits the blocks recorded last: reuse them
+    while (priv->tb_num_blocks > 0 && priv->tb_blocks[priv->tb_num_blocks - 1].pc == ICACHE_EMPTY &&
+           &priv->tb_blocks[priv->tb_num_blocks - 1] != priv->tb_build) {
+        priv->tb_num_blocks--;
+    }
+}
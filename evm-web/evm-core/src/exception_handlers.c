@@ -2,30 +2,20 @@
  * MC68020 Exception Handlers - WASM-compatible implementation
  * Based on original Stexep.c adapted for WebAssembly environment
  * Handles CPU exceptions and interrupts
+ * Stack frames and vectors go through stmem.c, i.e. to the memory of the
+ * simulator running on this thread
  */
 
 #include "STSTDDEF.H"
 #include "STMEM.H"
+#include "STFLAGS.H"
 #include "../include/simulator.h"
 
-/* External references */
-extern CPU cpu;
-extern long spc;
-
-/* Global state for exception handling */
-static long pcbefore = 0;
-static long savepc = 0;
-
-/* Interrupt connection structure (simplified for WASM) */
-struct {
-    int ipl;                    /* Interrupt Priority Level */
-    int VecNum;                 /* Vector Number */
-    int bNonAutoVector;         /* Non-autovector flag */
-} sConn_to_cpu = {0, 0x0f, 0};
-
-/* Global counters */
-static int bStopped = 0;
-static int nIRQs = 0;
+/* Exception state of the running simulator (cpu_core_t). The fault frames
+   use the PC recorded by set_pcbefore(), not the batch loop's pcbefore. */
+#define fault_pc     (g_core->fault_pc)
+#define sConn_to_cpu (g_core->irq)
+#define nIRQs        (g_core->num_irqs)
 
 /*
  * Set the value to remember the PC from before instruction execution
@@ -33,8 +23,7 @@ static int nIRQs = 0;
  */
 void set_pcbefore(long pc)
 {
-    pcbefore = pc;
-    savepc = pc;
+    fault_pc = pc;
 }
 
 /*
@@ -44,28 +33,29 @@ void set_pcbefore(long pc)
  */
 void bus_err(void)
 {
-    if(cpu.pc == pcbefore) {
+    if(REGS.pc == fault_pc) {
         /* Create short bus cycle fault stack frame */
-        cpu.ssp -= 24;
-        cpu.ssp -= 2;
-        cpu_write_word(cpu.ssp, 0xa008);  /* FORMAT $A + vector offset */
+        REGS.ssp -= 24;
+        REGS.ssp -= 2;
+        PUTword(REGS.ssp, 0xa008);  /* FORMAT $A + vector offset */
     }
     else {
         /* Create long bus cycle fault stack frame */
-        cpu.ssp -= 24;
-        cpu.ssp -= 2;
-        cpu_write_word(cpu.ssp, 0xb008);  /* FORMAT $B + vector offset */
+        REGS.ssp -= 24;
+        REGS.ssp -= 2;
+        PUTword(REGS.ssp, 0xb008);  /* FORMAT $B + vector offset */
     }
 
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, cpu.pc);     /* Save current PC to stack */
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, cpu.sregs.sr); /* Save SR to stack */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, REGS.pc);     /* Save current PC to stack */
+    REGS.ssp -= 2;
+    ccr_sync();
+    PUTword(REGS.ssp, REGS.sregs.sr); /* Save SR to stack */
 
     /* Get PC for bus error exception (vector #3) */
-    cpu.pc = cpu_read_dword((long)(0x08 & 0x0FFF) + cpu.vbr);
-    cpu.aregs.a[7] = cpu.ssp;              /* Setup stack for supervisor mode */
-    cpu.sregs.sr = (cpu.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
+    REGS.pc = GETdword((long)(0x08 & 0x0FFF) + REGS.vbr);
+    REGS.aregs.a[7] = REGS.ssp;              /* Setup stack for supervisor mode */
+    REGS.sregs.sr = (REGS.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
 }
 
 /*
@@ -75,28 +65,29 @@ void bus_err(void)
  */
 void addr_err(void)
 {
-    if(cpu.pc == pcbefore) {
+    if(REGS.pc == fault_pc) {
         /* Create short bus cycle fault stack frame */
-        cpu.ssp -= 24;
-        cpu.ssp -= 2;
-        cpu_write_word(cpu.ssp, 0xa00c);
+        REGS.ssp -= 24;
+        REGS.ssp -= 2;
+        PUTword(REGS.ssp, 0xa00c);
     }
     else {
         /* Create long bus cycle fault stack frame */
-        cpu.ssp -= 24;
-        cpu.ssp -= 2;
-        cpu_write_word(cpu.ssp, 0xb00c);
+        REGS.ssp -= 24;
+        REGS.ssp -= 2;
+        PUTword(REGS.ssp, 0xb00c);
     }
 
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, cpu.pc);     /* Save current PC to stack */
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, cpu.sregs.sr); /* Save SR to stack */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, REGS.pc);     /* Save current PC to stack */
+    REGS.ssp -= 2;
+    ccr_sync();
+    PUTword(REGS.ssp, REGS.sregs.sr); /* Save SR to stack */
 
     /* Get PC for address error (vector #3) */
-    cpu.pc = cpu_read_dword((long)(0x0c & 0x0FFF) + cpu.vbr);
-    cpu.aregs.a[7] = cpu.ssp;              /* Setup stack for supervisor mode */
-    cpu.sregs.sr = (cpu.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
+    REGS.pc = GETdword((long)(0x0c & 0x0FFF) + REGS.vbr);
+    REGS.aregs.a[7] = REGS.ssp;              /* Setup stack for supervisor mode */
+    REGS.sregs.sr = (REGS.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
 }
 
 /*
@@ -106,17 +97,18 @@ void addr_err(void)
  */
 void priv_viol(void)
 {
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, 0x0020);       /* FORMAT $0 + vector offset */
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, cpu.pc);      /* Save current PC to stack */
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, cpu.sregs.sr); /* Save SR to stack */
+    REGS.ssp -= 2;
+    PUTword(REGS.ssp, 0x0020);       /* FORMAT $0 + vector offset */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, REGS.pc);      /* Save current PC to stack */
+    REGS.ssp -= 2;
+    ccr_sync();
+    PUTword(REGS.ssp, REGS.sregs.sr); /* Save SR to stack */
 
     /* Get PC for privilege violation (vector #8) */
-    cpu.pc = cpu_read_dword((long)(0x20 & 0x0FFF) + cpu.vbr);
-    cpu.aregs.a[7] = cpu.ssp;              /* Setup stack for supervisor mode */
-    cpu.sregs.sr = (cpu.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
+    REGS.pc = GETdword((long)(0x20 & 0x0FFF) + REGS.vbr);
+    REGS.aregs.a[7] = REGS.ssp;              /* Setup stack for supervisor mode */
+    REGS.sregs.sr = (REGS.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
 }
 
 /*
@@ -126,24 +118,25 @@ void priv_viol(void)
 void div_by_zero(void)
 {
     /* Set stack pointer according to privilege mode */
-    if((cpu.sregs.sr & 0x2000) == 0) {
-        cpu.usp = cpu.aregs.a[7];
+    if((REGS.sregs.sr & 0x2000) == 0) {
+        REGS.usp = REGS.aregs.a[7];
     }
     else {
-        cpu.ssp = cpu.aregs.a[7];
+        REGS.ssp = REGS.aregs.a[7];
     }
 
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, 0x2014);       /* FORMAT $2 + vector offset #14 */
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, cpu.pc);      /* Save current PC to stack */
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, cpu.sregs.sr); /* Save SR to stack */
+    REGS.ssp -= 2;
+    PUTword(REGS.ssp, 0x2014);       /* FORMAT $2 + vector offset #14 */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, REGS.pc);      /* Save current PC to stack */
+    REGS.ssp -= 2;
+    ccr_sync();
+    PUTword(REGS.ssp, REGS.sregs.sr); /* Save SR to stack */
 
     /* Get PC for divide by zero exception (vector #5) */
-    cpu.pc = cpu_read_dword((long)(0x14 & 0x0FFF) + cpu.vbr);
-    cpu.aregs.a[7] = cpu.ssp;              /* Setup stack for supervisor mode */
-    cpu.sregs.sr = (cpu.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
+    REGS.pc = GETdword((long)(0x14 & 0x0FFF) + REGS.vbr);
+    REGS.aregs.a[7] = REGS.ssp;              /* Setup stack for supervisor mode */
+    REGS.sregs.sr = (REGS.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
 }
 
 /*
@@ -153,19 +146,20 @@ void div_by_zero(void)
  */
 void single_step(void)
 {
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, pcbefore);
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, 0x2024);       /* FORMAT $A + vector offset #24 */
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, cpu.pc);      /* Save current PC to stack */
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, cpu.sregs.sr); /* Save SR to stack */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, fault_pc);
+    REGS.ssp -= 2;
+    PUTword(REGS.ssp, 0x2024);       /* FORMAT $A + vector offset #24 */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, REGS.pc);      /* Save current PC to stack */
+    REGS.ssp -= 2;
+    ccr_sync();
+    PUTword(REGS.ssp, REGS.sregs.sr); /* Save SR to stack */
 
     /* Get PC for trace exception (vector #9) */
-    cpu.pc = cpu_read_dword((long)(0x24 & 0x0FFF) + cpu.vbr);
-    cpu.aregs.a[7] = cpu.ssp;              /* Setup stack for supervisor mode */
-    cpu.sregs.sr = (cpu.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
+    REGS.pc = GETdword((long)(0x24 & 0x0FFF) + REGS.vbr);
+    REGS.aregs.a[7] = REGS.ssp;              /* Setup stack for supervisor mode */
+    REGS.sregs.sr = (REGS.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
 }
 
 /*
@@ -175,19 +169,20 @@ void single_step(void)
  */
 void illegal(void)
 {
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, pcbefore);
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, 0x2010);       /* FORMAT $A + vector offset */
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, cpu.pc);      /* Save current PC to stack */
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, cpu.sregs.sr); /* Save SR to stack */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, fault_pc);
+    REGS.ssp -= 2;
+    PUTword(REGS.ssp, 0x2010);       /* FORMAT $A + vector offset */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, REGS.pc);      /* Save current PC to stack */
+    REGS.ssp -= 2;
+    ccr_sync();
+    PUTword(REGS.ssp, REGS.sregs.sr); /* Save SR to stack */
 
     /* Get PC for illegal opcode exception (vector #4) */
-    cpu.pc = cpu_read_dword((long)(0x10 & 0x0FFF) + cpu.vbr);
-    cpu.aregs.a[7] = cpu.ssp;              /* Setup stack for supervisor mode */
-    cpu.sregs.sr = (cpu.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
+    REGS.pc = GETdword((long)(0x10 & 0x0FFF) + REGS.vbr);
+    REGS.aregs.a[7] = REGS.ssp;              /* Setup stack for supervisor mode */
+    REGS.sregs.sr = (REGS.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
 }
 
 /*
@@ -197,17 +192,18 @@ void illegal(void)
  */
 void emulatelinea(void)
 {
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, 0x0028);       /* FORMAT $0 + vector offset */
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, cpu.pc);      /* Save current PC to stack */
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, cpu.sregs.sr); /* Save SR to stack */
+    REGS.ssp -= 2;
+    PUTword(REGS.ssp, 0x0028);       /* FORMAT $0 + vector offset */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, REGS.pc);      /* Save current PC to stack */
+    REGS.ssp -= 2;
+    ccr_sync();
+    PUTword(REGS.ssp, REGS.sregs.sr); /* Save SR to stack */
 
     /* Get PC for line A exception (vector #10) */
-    cpu.pc = cpu_read_dword((long)(0x28 & 0x0FFF) + cpu.vbr);
-    cpu.aregs.a[7] = cpu.ssp;              /* Setup stack for supervisor mode */
-    cpu.sregs.sr = (cpu.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
+    REGS.pc = GETdword((long)(0x28 & 0x0FFF) + REGS.vbr);
+    REGS.aregs.a[7] = REGS.ssp;              /* Setup stack for supervisor mode */
+    REGS.sregs.sr = (REGS.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
 }
 
 /*
@@ -217,17 +213,18 @@ void emulatelinea(void)
  */
 void emulatelinef(void)
 {
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, 0x002c);       /* FORMAT $0 + vector offset */
-    cpu.ssp -= 4;
-    cpu_write_dword(cpu.ssp, cpu.pc);      /* Save current PC to stack */
-    cpu.ssp -= 2;
-    cpu_write_word(cpu.ssp, cpu.sregs.sr); /* Save SR to stack */
+    REGS.ssp -= 2;
+    PUTword(REGS.ssp, 0x002c);       /* FORMAT $0 + vector offset */
+    REGS.ssp -= 4;
+    PUTdword(REGS.ssp, REGS.pc);      /* Save current PC to stack */
+    REGS.ssp -= 2;
+    ccr_sync();
+    PUTword(REGS.ssp, REGS.sregs.sr); /* Save SR to stack */
 
     /* Get PC for line F exception (vector #11) */
-    cpu.pc = cpu_read_dword((long)(0x2c & 0x0FFF) + cpu.vbr);
-    cpu.aregs.a[7] = cpu.ssp;              /* Setup stack for supervisor mode */
-    cpu.sregs.sr = (cpu.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
+    REGS.pc = GETdword((long)(0x2c & 0x0FFF) + REGS.vbr);
+    REGS.aregs.a[7] = REGS.ssp;              /* Setup stack for supervisor mode */
+    REGS.sregs.sr = (REGS.sregs.sr & 0x07ff) | 0x2000; /* Setup SR for exception */
 }
 
 /*
@@ -239,7 +236,18 @@ void Unknown(short opcode)
 {
     /* In WASM environment, we log the error via console or internal log
      * For now, just stop the simulation */
-    bStopped = 1;
+    g_core->halted = 1;
+}
+
+/*
+ * NAME: int InterruptPending(void)
+ * DESCRIPTION: Check if CheckForInt() would accept an interrupt now
+ */
+int InterruptPending(void)
+{
+    /* Check if interrupt priority level > interrupt mask in SR
+     * OR if non-maskable interrupt (NMI has ipl=7) */
+    return sConn_to_cpu.ipl > ((REGS.sregs.sr >> 8) & 0x0007) || sConn_to_cpu.ipl == 7;
 }
 
 /*
@@ -248,43 +256,43 @@ void Unknown(short opcode)
  */
 void CheckForInt(void)
 {
-    /* Check if interrupt priority level > interrupt mask in SR
-     * OR if non-maskable interrupt (NMI has ipl=7) */
-    if(sConn_to_cpu.ipl > ((cpu.sregs.sr >> 8) & 0x0007) || sConn_to_cpu.ipl == 7) {
-        bStopped = 0;
+    if(InterruptPending()) {
+        g_core->halted = 0;
         nIRQs++;
 
         /* Handle non-autovector interrupt */
         if(sConn_to_cpu.bNonAutoVector) {
             if(sConn_to_cpu.VecNum != 0x0f) {
                 /* Setup interrupt stack frame */
-                cpu.ssp -= 2;
-                cpu_write_word(cpu.ssp, (sConn_to_cpu.VecNum * 4));
-                cpu.ssp -= 4;
-                cpu_write_dword(cpu.ssp, cpu.pc);       /* Save PC */
-                cpu.ssp -= 2;
-                cpu_write_word(cpu.ssp, cpu.sregs.sr);  /* Save SR */
+                REGS.ssp -= 2;
+                PUTword(REGS.ssp, (sConn_to_cpu.VecNum * 4));
+                REGS.ssp -= 4;
+                PUTdword(REGS.ssp, REGS.pc);       /* Save PC */
+                REGS.ssp -= 2;
+                ccr_sync();
+                PUTword(REGS.ssp, REGS.sregs.sr);  /* Save SR */
 
                 /* Get PC from vector table */
-                cpu.pc = cpu_read_dword((long)((sConn_to_cpu.VecNum * 4) + cpu.vbr));
-                cpu.aregs.a[7] = cpu.ssp;
-                cpu.sregs.sr = (cpu.sregs.sr & 0x00ff) | 0x2000 | (sConn_to_cpu.ipl << 8);
+                REGS.pc = GETdword((long)((sConn_to_cpu.VecNum * 4) + REGS.vbr));
+                REGS.aregs.a[7] = REGS.ssp;
+                REGS.sregs.sr = (REGS.sregs.sr & 0x00ff) | 0x2000 | (sConn_to_cpu.ipl << 8);
                 sConn_to_cpu.ipl = 0;
                 sConn_to_cpu.VecNum = 0x0f;
                 sConn_to_cpu.bNonAutoVector = 0;
             }
             else {
                 /* Default vector */
-                cpu.ssp -= 2;
-                cpu_write_word(cpu.ssp, 0x3c);
-                cpu.ssp -= 4;
-                cpu_write_dword(cpu.ssp, cpu.pc);       /* Save PC */
-                cpu.ssp -= 2;
-                cpu_write_word(cpu.ssp, cpu.sregs.sr);  /* Save SR */
+                REGS.ssp -= 2;
+                PUTword(REGS.ssp, 0x3c);
+                REGS.ssp -= 4;
+                PUTdword(REGS.ssp, REGS.pc);       /* Save PC */
+                REGS.ssp -= 2;
+                ccr_sync();
+                PUTword(REGS.ssp, REGS.sregs.sr);  /* Save SR */
 
-                cpu.pc = cpu_read_dword((long)(0x3c + cpu.vbr));
-                cpu.aregs.a[7] = cpu.ssp;
-                cpu.sregs.sr = (cpu.sregs.sr & 0x00ff) | 0x2000 | (sConn_to_cpu.ipl << 8);
+                REGS.pc = GETdword((long)(0x3c + REGS.vbr));
+                REGS.aregs.a[7] = REGS.ssp;
+                REGS.sregs.sr = (REGS.sregs.sr & 0x00ff) | 0x2000 | (sConn_to_cpu.ipl << 8);
                 sConn_to_cpu.ipl = 0;
                 sConn_to_cpu.VecNum = 0x0f;
                 sConn_to_cpu.bNonAutoVector = 0;
@@ -292,17 +300,18 @@ void CheckForInt(void)
         }
         /* Handle autovector interrupt */
         else {
-            cpu.ssp -= 2;
-            cpu_write_word(cpu.ssp, (sConn_to_cpu.ipl * 4) + 0x60);
-            cpu.ssp -= 4;
-            cpu_write_dword(cpu.ssp, cpu.pc);           /* Save PC */
-            cpu.ssp -= 2;
-            cpu_write_word(cpu.ssp, cpu.sregs.sr);      /* Save SR */
+            REGS.ssp -= 2;
+            PUTword(REGS.ssp, (sConn_to_cpu.ipl * 4) + 0x60);
+            REGS.ssp -= 4;
+            PUTdword(REGS.ssp, REGS.pc);           /* Save PC */
+            REGS.ssp -= 2;
+            ccr_sync();
+            PUTword(REGS.ssp, REGS.sregs.sr);      /* Save SR */
 
             /* Get PC from vector table */
-            cpu.pc = cpu_read_dword((long)((sConn_to_cpu.ipl * 4 + 0x60) + cpu.vbr));
-            cpu.aregs.a[7] = cpu.ssp;
-            cpu.sregs.sr = (cpu.sregs.sr & 0x00ff) | 0x2000 | (sConn_to_cpu.ipl << 8);
+            REGS.pc = GETdword((long)((sConn_to_cpu.ipl * 4 + 0x60) + REGS.vbr));
+            REGS.aregs.a[7] = REGS.ssp;
+            REGS.sregs.sr = (REGS.sregs.sr & 0x00ff) | 0x2000 | (sConn_to_cpu.ipl << 8);
             sConn_to_cpu.ipl = 0;
             sConn_to_cpu.bNonAutoVector = 0;
         }
@@ -8,73 +8,97 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
 #include "../include/simulator.h"
-
-/* Forward declarations from CPU core */
-extern void cpu_init_state(void);
-extern void cpu_execute_opcode(simulator_t *sim);
-extern void cpu_execute_many(simulator_t *sim, unsigned long ops);
-extern simulator_t *cpu_get_current_simulator(void);
-extern void cpu_set_current_simulator(simulator_t *sim);
-
-/* Global CPU structure from cpu_core_new.c */
-extern struct tag_CPU {
-    struct { long a[8]; } aregs;         /* address registers */
-    struct { long d[8]; } dregs;         /* data registers */
-    long pc;                              /* program counter */
-    struct {
-        unsigned sr : 16;                 /* status register */
-    } sregs;
-    long usp, ssp, msp;                   /* user, supervisor, master stack pointers */
-} cpu;
-
-/* Memory access array - maps addresses to modules */
-#define MEMORY_MAP_SIZE (16 * 1024)  /* 16K entries = 16MB at 1KB granularity */
-static simulator_module_t *memory_map[MEMORY_MAP_SIZE];
-
-/* Global simulator context */
-static simulator_t *g_simulator = NULL;
+#include "../include/simulator_mem.h"
+#include "../include/simulator_internal.h"
 
 /* ============================================================================
  * Memory Access Functions
  * ============================================================================ */
 
 /**
- * Find module responsible for given address
+ * Build memory map from modules for fast address lookup
+ *
+ * Pages lying completely inside a cacheable module also get a direct host
+ * pointer, so RAM/ROM accesses bypass the module callbacks.
+ */
+void sim_build_memory_map(simulator_t *sim)
+{
+    memory_page_t *memory_map = SIM_MEMORY_MAP(sim);
+
+    memset(memory_map, 0, MEMORY_MAP_SIZE * sizeof(*memory_map));
+
+    /* Walk lowest priority first so higher priority modules win overlaps */
+    for (int i = sim->num_modules - 1; i >= 0; i--) {
+        simulator_module_t *mod = sim->modules[i];
+        /* Map each 1KB block to this module */
+        uint32_t start_block = mod->base_addr >> MEMORY_PAGE_SHIFT;
+        uint32_t num_blocks = (mod->size + MEMORY_PAGE_MASK) >> MEMORY_PAGE_SHIFT;
+
+        for (uint32_t j = 0; j < num_blocks && start_block + j < MEMORY_MAP_SIZE; j++) {
+            memory_page_t *page = &memory_map[start_block + j];
+            uint32_t page_addr = (start_block + j) << MEMORY_PAGE_SHIFT;
+
+            page->mod = mod;
+            page->host = NULL;
+            if (mod->cacheable && mod->map &&
+                page_addr >= mod->base_addr &&
+                page_addr + MEMORY_PAGE_SIZE <= mod->base_addr + mod->size) {
+                page->host = mod->map(mod, page_addr);
+            }
+        }
+    }
+
+    /* Cached instructions may refer to the old layout, and the pages may
+       hold other memory than at the last snapshot */
+    sim_pages_written(sim);
+    sim_icache_flush(sim);
+}
+
+/**
+ * Get module at given address
  */
-static simulator_module_t *find_module_for_address(simulator_t *sim, uint32_t addr)
+simulator_module_t *simulator_get_module_at(simulator_t *sim, uint32_t addr)
 {
     if (sim == NULL) return NULL;
 
     /* Mask to 24-bit address space */
     addr &= 0xFFFFFF;
 
-    for (int i = 0; i < sim->num_modules; i++) {
-        simulator_module_t *mod = sim->modules[i];
-        if (addr >= mod->base_addr && addr < (mod->base_addr + mod->size)) {
-            return mod;
-        }
+    simulator_module_t *mod = SIM_MEMORY_MAP(sim)[addr >> MEMORY_PAGE_SHIFT].mod;
+    if (mod && addr - mod->base_addr < mod->size) {
+        return mod;
     }
     return NULL;
 }
 
-/**
- * Build memory map from modules for fast address lookup
+/*
+ * A write reached a RAM/ROM page that is write protected: it holds cached
+ * code, or is clean since the last snapshot or the baseline. Either way it
+ * is dirty now.
  */
-static void build_memory_map(simulator_t *sim)
+void sim_page_written(simulator_t *sim, uint32_t page)
 {
-    memset(memory_map, 0, sizeof(memory_map));
+    simulator_priv_t *priv = SIM_PRIV(sim);
 
-    for (int i = 0; i < sim->num_modules; i++) {
-        simulator_module_t *mod = sim->modules[i];
-        /* Map each 1KB block to this module */
-        uint32_t start_block = mod->base_addr >> 10;
-        uint32_t num_blocks = (mod->size + 1023) >> 10;
+    if (priv->page_clean[page] & SIM_PAGE_CLEAN_BASELINE) {
+        priv->baseline_dirty[priv->num_baseline_dirty++] = (uint16_t)page;
+    }
+    priv->page_clean[page] = 0;
+    sim_icache_invalidate_page(sim, page);
+}
 
-        for (uint32_t j = 0; j < num_blocks && start_block + j < MEMORY_MAP_SIZE; j++) {
-            memory_map[start_block + j] = mod;
+void sim_pages_written(simulator_t *sim)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    for (uint32_t i = 0; i < MEMORY_MAP_SIZE; i++) {
+        if (priv->page_clean[i] & SIM_PAGE_CLEAN_BASELINE) {
+            priv->baseline_dirty[priv->num_baseline_dirty++] = (uint16_t)i;
         }
     }
+    memset(priv->page_clean, 0, MEMORY_MAP_SIZE);
 }
 
 /**
@@ -84,14 +108,30 @@ uint32_t simulator_read_memory(simulator_t *sim, uint32_t addr, int size)
 {
     if (sim == NULL) return 0;
 
+    const memory_page_t *memory_map = SIM_MEMORY_MAP(sim);
     addr &= 0xFFFFFF;  /* Mask to 24-bit address space */
 
-    simulator_module_t *mod = find_module_for_address(sim, addr);
-    if (mod && mod->read) {
+    /* RAM/ROM hit: read straight from host memory (big-endian) */
+    uint8_t *p = mem_host_ptr(memory_map, addr, size);
+    if (p) {
+        switch (size) {
+            case 1: return p[0];
+            case 2: return mem_get16(p);
+            case 4: return mem_get32(p);
+        }
+    }
+
+    simulator_module_t *mod = memory_map[addr >> MEMORY_PAGE_SHIFT].mod;
+    if (mod && mod->read && addr - mod->base_addr < mod->size) {
+        SIM_PRIV(sim)->tb_exit = 1;     /* Device access ends a translated block */
+        if (mod->read_stable == NULL || !mod->read_stable(mod, addr)) {
+            SIM_PRIV(sim)->io_unstable++;
+        }
         return mod->read(mod, addr, size);
     }
 
     /* Bus error - unmappe address */
+    SIM_PRIV(sim)->io_unstable++;
     fprintf(stderr, "BUS ERROR: Read from unmapped address 0x%06X\n", addr);
     return 0;
 }
@@ -103,10 +143,33 @@ void simulator_write_memory(simulator_t *sim, uint32_t addr, uint32_t data, int
 {
     if (sim == NULL) return;
 
+    const memory_page_t *memory_map = SIM_MEMORY_MAP(sim);
     addr &= 0xFFFFFF;  /* Mask to 24-bit address space */
 
-    simulator_module_t *mod = find_module_for_address(sim, addr);
-    if (mod && mod->write) {
+    /* Code and clean pages are write protected: drop their cached
+       instructions first */
+    uint32_t first = addr >> MEMORY_PAGE_SHIFT;
+    uint32_t last = ((addr + size - 1) & 0xFFFFFF) >> MEMORY_PAGE_SHIFT;
+    if (memory_map[first].host && !memory_map[first].whost) {
+        sim_page_written(sim, first);
+    }
+    if (last != first && memory_map[last].host && !memory_map[last].whost) {
+        sim_page_written(sim, last);
+    }
+
+    /* RAM/ROM hit: write straight to host memory (big-endian) */
+    uint8_t *p = mem_host_wptr(memory_map, addr, size);
+    if (p) {
+        switch (size) {
+            case 1: p[0] = (uint8_t)data; return;
+            case 2: mem_put16(p, data); return;
+            case 4: mem_put32(p, data); return;
+        }
+    }
+
+    simulator_module_t *mod = memory_map[addr >> MEMORY_PAGE_SHIFT].mod;
+    if (mod && mod->write && addr - mod->base_addr < mod->size) {
+        SIM_PRIV(sim)->tb_exit = 1;     /* Device access ends a translated block */
         mod->write(mod, addr, data, size);
     } else {
         /* Bus error - unmapped address */
@@ -114,6 +177,73 @@ void simulator_write_memory(simulator_t *sim, uint32_t addr, uint32_t data, int
     }
 }
 
+/**
+ * Read a block of memory, a page at a time
+ */
+void simulator_read_block(simulator_t *sim, uint32_t addr, uint8_t *buf, size_t len)
+{
+    if (sim == NULL || buf == NULL) return;
+
+    const memory_page_t *memory_map = SIM_MEMORY_MAP(sim);
+
+    while (len > 0) {
+        addr &= 0xFFFFFF;
+        const memory_page_t *page = &memory_map[addr >> MEMORY_PAGE_SHIFT];
+        size_t run = MEMORY_PAGE_SIZE - (addr & MEMORY_PAGE_MASK);
+        if (run > len) run = len;
+
+        if (page->host) {
+            memcpy(buf, page->host + (addr & MEMORY_PAGE_MASK), run);
+        } else if (page->mod) {
+            for (size_t i = 0; i < run; i++) {
+                buf[i] = (uint8_t)simulator_read_memory(sim, addr + i, 1);
+            }
+        } else {
+            memset(buf, 0, run);
+        }
+
+        addr += run;
+        buf += run;
+        len -= run;
+    }
+}
+
+/**
+ * Write a block of memory, a page at a time
+ */
+void simulator_write_block(simulator_t *sim, uint32_t addr, const uint8_t *data, size_t len)
+{
+    if (sim == NULL || data == NULL) return;
+
+    memory_page_t *memory_map = SIM_MEMORY_MAP(sim);
+
+    while (len > 0) {
+        addr &= 0xFFFFFF;
+        uint32_t index = addr >> MEMORY_PAGE_SHIFT;
+        memory_page_t *page = &memory_map[index];
+        size_t run = MEMORY_PAGE_SIZE - (addr & MEMORY_PAGE_MASK);
+        if (run > len) run = len;
+
+        if (page->host) {
+            /* Write protected while it holds cached code or is clean */
+            if (page->whost == NULL) {
+                sim_page_written(sim, index);
+            }
+            memcpy(page->host + (addr & MEMORY_PAGE_MASK), data, run);
+        } else if (page->mod) {
+            for (size_t i = 0; i < run; i++) {
+                simulator_write_memory(sim, addr + i, data[i], 1);
+            }
+        } else {
+            fprintf(stderr, "BUS ERROR: Write to unmapped address 0x%06X\n", addr);
+        }
+
+        addr += run;
+        data += run;
+        len -= run;
+    }
+}
+
 /* ============================================================================
  * CPU Execution Loop
  * ============================================================================ */
@@ -127,11 +257,9 @@ int simulator_step(simulator_t *sim)
 {
     if (sim == NULL) return -1;
 
-    /* Set current simulator context */
-    cpu_set_current_simulator(sim);
-
     /* Execute one CPU opcode (handles fetch, decode, execute) */
-    cpu_execute_opcode(sim);
+    cpu_execute_batch(sim, 1, UINT64_MAX, SIM_STOP_NONE);
+    sim_uart_flush(sim);
 
     return 0;
 }
@@ -140,29 +268,135 @@ int simulator_step(simulator_t *sim)
  * Execute N CPU instructions
  */
 uint32_t simulator_run(simulator_t *sim, uint32_t count)
+{
+    return simulator_run_batch(sim, count, SIM_STOP_NONE);
+}
+
+/**
+ * Execute up to N CPU instructions in one batch
+ *
+ * The CPU core sets up its context once and runs until the budget is
+ * exhausted or one of the requested stop conditions occurs.
+ */
+uint32_t simulator_run_batch(simulator_t *sim, uint32_t count, uint32_t stop_conditions)
 {
     if (sim == NULL) return 0;
 
-    uint32_t executed = 0;
-    for (uint32_t i = 0; i < count; i++) {
-        if (simulator_step(sim) != 0) {
-            break;  /* Error occurred */
-        }
-        executed++;
+    uint32_t executed = cpu_execute_batch(sim, count, UINT64_MAX, stop_conditions);
+    sim_uart_flush(sim);
+    return executed;
+}
+
+/**
+ * Run for N CPU clock cycles
+ */
+uint64_t simulator_run_cycles(simulator_t *sim, uint64_t cycles, uint32_t stop_conditions)
+{
+    if (sim == NULL) return 0;
+
+    uint64_t start = sim->cpu.cycles;
+    uint64_t limit = (cycles > UINT64_MAX - start) ? UINT64_MAX : start + cycles;
+
+    /* A batch is limited to 2^32-1 instructions; each takes at least one cycle */
+    do {
+        cpu_execute_batch(sim, UINT32_MAX, limit, stop_conditions);
+    } while (sim->cpu.cycles < limit && SIM_PRIV(sim)->stop_reason == SIM_STOPPED_BUDGET);
+    sim_uart_flush(sim);
+
+    return sim->cpu.cycles - start;
+}
+
+/**
+ * Get instruction cache statistics
+ */
+void simulator_get_cache_stats(simulator_t *sim, uint64_t *hits, uint64_t *misses)
+{
+    if (sim == NULL) return;
+
+    if (hits) *hits = SIM_PRIV(sim)->icache_hits;
+    if (misses) *misses = SIM_PRIV(sim)->icache_misses;
+}
+
+/**
+ * Drop cached instructions after memory was modified directly
+ */
+void simulator_flush_caches(simulator_t *sim)
+{
+    if (sim == NULL) return;
+    sim_icache_flush(sim);
+}
+
+/**
+ * Get the reason the last batch returned
+ */
+int simulator_get_stop_reason(simulator_t *sim)
+{
+    if (sim == NULL) return SIM_STOPPED_BUDGET;
+    return SIM_PRIV(sim)->stop_reason;
+}
+
+/**
+ * Check if the CPU is stopped or polls a device
+ */
+int simulator_is_idle(simulator_t *sim)
+{
+    if (sim == NULL) return 0;
+    return SIM_PRIV(sim)->core.bStopped || SIM_PRIV(sim)->spin.spinning;
+}
+
+/**
+ * Set a PC breakpoint
+ */
+int simulator_set_breakpoint(simulator_t *sim, uint32_t addr)
+{
+    if (sim == NULL) return -1;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    addr &= 0xFFFFFF;
+
+    for (int i = 0; i < priv->num_breakpoints; i++) {
+        if (priv->breakpoints[i] == addr) return 0;  /* Already set */
+    }
+    if (priv->num_breakpoints >= SIM_MAX_BREAKPOINTS) {
+        return -1;
     }
 
-    return executed;
+    priv->breakpoints[priv->num_breakpoints++] = addr;
+
+    /* Translated blocks never run across a breakpoint */
+    sim_tb_flush(sim);
+    return 0;
+}
+
+/**
+ * Remove a PC breakpoint
+ */
+void simulator_clear_breakpoint(simulator_t *sim, uint32_t addr)
+{
+    if (sim == NULL) return;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    addr &= 0xFFFFFF;
+
+    for (int i = 0; i < priv->num_breakpoints; i++) {
+        if (priv->breakpoints[i] == addr) {
+            /* Order doesn't matter - move the last entry into the hole */
+            priv->breakpoints[i] = priv->breakpoints[--priv->num_breakpoints];
+            return;
+        }
+    }
 }
 
 /**
  * Pause simulator execution
+ *
+ * Only raises a flag; a running batch returns at the next instruction
+ * boundary, so this is safe to call from module callbacks.
  */
 void simulator_pause(simulator_t *sim)
 {
-    /* In this simple implementation, pause just stops calling step()
-     * More complex implementations might have thread synchronization */
     if (sim) {
-        /* No-op for now */
+        SIM_PRIV(sim)->pause_requested = 1;
     }
 }
 
@@ -170,6 +404,15 @@ void simulator_pause(simulator_t *sim)
  * Initialization and Cleanup
  * ============================================================================ */
 
+/* Opcode decode tables, shared by all simulators of the process */
+static pthread_once_t decode_tables_once = PTHREAD_ONCE_INIT;
+
+static void build_decode_tables(void)
+{
+    cpu_build_cycle_table();
+    cpu_specialise_handlers();
+}
+
 /**
  * Initialize the simulator
  */
@@ -190,12 +433,22 @@ simulator_t *simulator_init(void)
     }
     sim->num_modules = 0;
 
-    /* Initialize CPU state and instruction handlers */
-    cpu_init_state();
-    cpu_set_current_simulator(sim);
+    sim->priv = calloc(1, sizeof(simulator_priv_t));
+    if (sim->priv == NULL) {
+        fprintf(stderr, "Failed to allocate simulator private data\n");
+        free(sim->modules);
+        free(sim);
+        return NULL;
+    }
+    sim_events_reset(sim);
+    sim_icache_flush(sim);
+    SIM_PRIV(sim)->uart[SIM_UART_A].fd = 2;
+    SIM_PRIV(sim)->uart[SIM_UART_B].fd = 2;
 
-    /* Set as global for access from other modules */
-    g_simulator = sim;
+    /* Initialize CPU state (the core works on sim->cpu in place) */
+    pthread_once(&decode_tables_once, build_decode_tables);
+    cpu_set_current_simulator(sim);
+    cpu_init_state();
 
     return sim;
 }
@@ -211,6 +464,7 @@ int simulator_register_module(simulator_t *sim, simulator_module_t *module)
         return -1;
     }
 
+    module->sim = sim;
     sim->modules[sim->num_modules++] = module;
 
     /* Sort modules by priority (highest first) */
@@ -224,9 +478,35 @@ int simulator_register_module(simulator_t *sim, simulator_module_t *module)
         }
     }
 
+    /* Rebuild the list of modules that want a call after every instruction */
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    priv->num_polled = 0;
+    for (int i = 0; i < sim->num_modules; i++) {
+        if (sim->modules[i]->simulate) {
+            priv->polled[priv->num_polled++] = sim->modules[i];
+        }
+    }
+
     return 0;
 }
 
+/**
+ * Instance of a built-in module for sim
+ *
+ * The descriptors in simulator_modules.c are templates; each simulator
+ * registers its own copy, whose setup() allocates the module state.
+ */
+static simulator_module_t *builtin_module(simulator_t *sim, const simulator_module_t *tmpl)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    if (priv->num_builtin_modules >= SIM_MAX_BUILTIN_MODULES) return NULL;
+
+    simulator_module_t *mod = &priv->builtin_modules[priv->num_builtin_modules++];
+    *mod = *tmpl;
+    return mod;
+}
+
 /**
  * Load all built-in modules
  *
@@ -236,29 +516,29 @@ int simulator_load_modules(simulator_t *sim)
 {
     if (sim == NULL) return -1;
 
-    /* Forward declarations for built-in modules (defined in simulator_modules.c) */
-    extern simulator_module_t evmram_module;
-    extern simulator_module_t evmrom_module;
-    extern simulator_module_t pit68230_module;
-    extern simulator_module_t uart68681_module;
+    /* Built-in modules (defined in simulator_modules.c) */
+    extern const simulator_module_t evmram_module;
+    extern const simulator_module_t evmrom_module;
+    extern const simulator_module_t pit68230_module;
+    extern const simulator_module_t uart68681_module;
 
     /* Register modules in order */
-    if (simulator_register_module(sim, &evmram_module) != 0) {
+    if (simulator_register_module(sim, builtin_module(sim, &evmram_module)) != 0) {
         fprintf(stderr, "Failed to register RAM module\n");
         return -1;
     }
 
-    if (simulator_register_module(sim, &evmrom_module) != 0) {
+    if (simulator_register_module(sim, builtin_module(sim, &evmrom_module)) != 0) {
         fprintf(stderr, "Failed to register ROM module\n");
         return -1;
     }
 
-    if (simulator_register_module(sim, &pit68230_module) != 0) {
+    if (simulator_register_module(sim, builtin_module(sim, &pit68230_module)) != 0) {
         fprintf(stderr, "Failed to register 68230 PIT module\n");
         return -1;
     }
 
-    if (simulator_register_module(sim, &uart68681_module) != 0) {
+    if (simulator_register_module(sim, builtin_module(sim, &uart68681_module)) != 0) {
         fprintf(stderr, "Failed to register 68681 UART module\n");
         return -1;
     }
@@ -281,13 +561,13 @@ int simulator_load_modules(simulator_t *sim)
     }
 
     /* Build memory map for fast lookups */
-    build_memory_map(sim);
+    sim_build_memory_map(sim);
 
     return 0;
 }
 
 /**
- * Reset simulator to initial state
+ * Reset the CPU
  *
  * Implements MC68020 reset sequence:
  * 1. Read initial SSP from address 0x000000 (longword)
@@ -295,13 +575,14 @@ int simulator_load_modules(simulator_t *sim)
  * 3. Set A7 (SP) = initial SSP
  * 4. Set PC = reset vector
  */
-void simulator_reset(simulator_t *sim)
+void simulator_reset_cpu(simulator_t *sim)
 {
     if (sim == NULL) return;
 
-    /* Reset CPU state */
-    memset(&sim->cpu, 0, sizeof(simulator_cpu_state_t));
-    sim->cpu.sr = 0x2700;  /* Supervisor mode, IPL=7 */
+    /* Reset CPU state (also leaves the STOP state) */
+    cpu_set_current_simulator(sim);
+    cpu_init_state();
+    SIM_PRIV(sim)->spin.spinning = 0;
 
     /* Try to read reset vectors from ROM (0x000000) */
     uint32_t reset_ssp = simulator_read_memory(sim, 0x000000, 4) & 0xFFFFFF;
@@ -342,6 +623,19 @@ void simulator_reset(simulator_t *sim)
         fprintf(stderr, "[RESET]   Initial SSP: 0x%06X\n", sim->cpu.ssp);
         fprintf(stderr, "[RESET]   Reset PC:    0x%06X\n", sim->cpu.pc);
     }
+}
+
+/**
+ * Reset simulator to initial state: the CPU, then the clock and modules
+ */
+void simulator_reset(simulator_t *sim)
+{
+    if (sim == NULL) return;
+
+    simulator_reset_cpu(sim);
+
+    /* Restart the clock; modules schedule their first events on reset */
+    sim_events_reset(sim);
 
     /* Reset all modules */
     for (int i = 0; i < sim->num_modules; i++) {
@@ -349,6 +643,9 @@ void simulator_reset(simulator_t *sim)
             sim->modules[i]->reset(sim->modules[i]);
         }
     }
+
+    /* RAM was cleared past the write protection */
+    sim_pages_written(sim);
 }
 
 /**
@@ -381,13 +678,74 @@ int simulator_load_program(simulator_t *sim, const uint8_t *data, size_t size, u
 {
     if (sim == NULL || data == NULL) return -1;
 
-    for (size_t i = 0; i < size; i++) {
-        simulator_write_memory(sim, (addr + i) & 0xFFFFFF, data[i], 1);
-    }
-
+    simulator_write_block(sim, addr, data, size);
     return 0;
 }
 
+/**
+ * Route UART transmit data
+ */
+void simulator_set_uart_tx(simulator_t *sim, simulator_uart_tx_fn fn, void *user)
+{
+    if (sim == NULL) return;
+
+    SIM_PRIV(sim)->uart_tx = fn;
+    SIM_PRIV(sim)->uart_tx_user = user;
+}
+
+/**
+ * Feed UART receive data
+ */
+void simulator_set_uart_rx(simulator_t *sim, simulator_uart_rx_fn fn, void *user)
+{
+    if (sim == NULL) return;
+
+    SIM_PRIV(sim)->uart_rx = fn;
+    SIM_PRIV(sim)->uart_rx_user = user;
+    sim_uart_rx_changed(sim);
+}
+
+/**
+ * Queue UART receive data
+ */
+size_t simulator_uart_push(simulator_t *sim, int channel, const uint8_t *data, size_t len)
+{
+    if (sim == NULL || data == NULL || (channel != SIM_UART_A && channel != SIM_UART_B)) return 0;
+
+    return sim_fifo_put(&SIM_PRIV(sim)->uart[channel].rx, data, len);
+}
+
+/**
+ * Take UART transmit data
+ */
+size_t simulator_uart_pull(simulator_t *sim, int channel, uint8_t *buf, size_t max)
+{
+    if (sim == NULL || buf == NULL || (channel != SIM_UART_A && channel != SIM_UART_B)) return 0;
+
+    return sim_fifo_get(&SIM_PRIV(sim)->uart[channel].tx, buf, max);
+}
+
+/**
+ * Route UART transmit data to a file descriptor
+ */
+void simulator_set_uart_fd(simulator_t *sim, int channel, int fd)
+{
+    if (sim == NULL || (channel != SIM_UART_A && channel != SIM_UART_B)) return;
+
+    /* Data queued so far goes to the previous sink */
+    sim_uart_flush(sim);
+    SIM_PRIV(sim)->uart[channel].fd = fd;
+}
+
+/**
+ * Write queued UART transmit data
+ */
+void simulator_uart_flush(simulator_t *sim)
+{
+    if (sim == NULL) return;
+    sim_uart_flush(sim);
+}
+
 /**
  * Cleanup and destroy simulator
  */
@@ -395,6 +753,8 @@ void simulator_destroy(simulator_t *sim)
 {
     if (sim == NULL) return;
 
+    sim_uart_flush(sim);
+
     /* Call exit procedures */
     for (int i = 0; i < sim->num_modules; i++) {
         if (sim->modules[i]->exit) {
@@ -402,16 +762,21 @@ void simulator_destroy(simulator_t *sim)
         }
     }
 
+    if (cpu_get_current_simulator() == sim) {
+        cpu_set_current_simulator(NULL);
+    }
+
     free(sim->modules);
+    free(SIM_PRIV(sim)->baseline);
+    free(SIM_PRIV(sim)->baseline_pages);
+    free(sim->priv);
     free(sim);
-
-    g_simulator = NULL;
 }
 
 /**
- * Get global simulator context (for use by modules)
+ * Get the calling thread's current simulator (for legacy callers)
  */
 simulator_t *simulator_get_current(void)
 {
-    return g_simulator;
+    return cpu_get_current_simulator();
 }
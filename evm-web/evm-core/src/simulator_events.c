@@ -0,0 +1,161 @@
+/*
+ * simulator_events.c
+ *
+ * Device event queue for the EVM simulator
+ * Modules schedule their next wakeup (timer underflow, character ready, ...)
+ * on the simulator clock; the CPU loop only calls into a device when one of
+ * its events is due.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../include/simulator.h"
+#include "../include/simulator_internal.h"
+
+/* ============================================================================
+ * Binary min-heap on (when, seq)
+ * ============================================================================ */
+
+static int event_before(const simulator_event_t *a, const simulator_event_t *b)
+{
+    if (a->when != b->when) return a->when < b->when;
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void heap_sift_up(simulator_event_t *heap, int i)
+{
+    simulator_event_t ev = heap[i];
+
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!event_before(&ev, &heap[parent])) break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = ev;
+}
+
+static void heap_sift_down(simulator_event_t *heap, int count, int i)
+{
+    simulator_event_t ev = heap[i];
+
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && event_before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!event_before(&heap[child], &ev)) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = ev;
+}
+
+static void update_next_event(simulator_priv_t *priv)
+{
+    priv->next_event = priv->num_events ? priv->events[0].when : UINT64_MAX;
+}
+
+/* ============================================================================
+ * Event API
+ * ============================================================================ */
+
+/**
+ * Schedule an event 'delay' cycles from now
+ */
+int simulator_schedule_event(simulator_t *sim, simulator_module_t *mod,
+                             uint64_t delay, simulator_event_fn fn)
+{
+    if (sim == NULL || fn == NULL) return -1;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    if (priv->num_events >= SIM_MAX_EVENTS) {
+        fprintf(stderr, "Event queue full (max %d)\n", SIM_MAX_EVENTS);
+        return -1;
+    }
+
+    simulator_event_t *ev = &priv->events[priv->num_events];
+    ev->when = sim->cpu.cycles + delay;
+    ev->seq = priv->event_seq++;
+    ev->mod = mod;
+    ev->fn = fn;
+    heap_sift_up(priv->events, priv->num_events++);
+
+    update_next_event(priv);
+    return 0;
+}
+
+/**
+ * Cancel pending events of a module
+ */
+void simulator_cancel_events(simulator_t *sim, simulator_module_t *mod, simulator_event_fn fn)
+{
+    if (sim == NULL) return;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    int kept = 0;
+
+    for (int i = 0; i < priv->num_events; i++) {
+        simulator_event_t *ev = &priv->events[i];
+        if (ev->mod == mod && (fn == NULL || ev->fn == fn)) continue;
+        priv->events[kept++] = *ev;
+    }
+
+    /* Rare operation - just rebuild the heap */
+    priv->num_events = kept;
+    for (int i = kept / 2 - 1; i >= 0; i--) {
+        heap_sift_down(priv->events, kept, i);
+    }
+
+    update_next_event(priv);
+}
+
+/**
+ * Get the current simulator clock
+ */
+uint64_t simulator_get_clock(simulator_t *sim)
+{
+    if (sim == NULL) return 0;
+    return sim->cpu.cycles;
+}
+
+/* ============================================================================
+ * Internal (simulator.c, cpu_core_new.c)
+ * ============================================================================ */
+
+/**
+ * Drop all pending events and restart the clock
+ */
+void sim_events_reset(simulator_t *sim)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    sim->cpu.cycles = 0;
+    priv->num_events = 0;
+    priv->event_seq = 0;
+    priv->next_event = UINT64_MAX;
+}
+
+/**
+ * Fire all due events
+ *
+ * Handlers may schedule new events; one that is already due again fires in
+ * the same call.
+ */
+void sim_events_dispatch(simulator_t *sim)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    while (priv->num_events && priv->events[0].when <= sim->cpu.cycles) {
+        simulator_event_t ev = priv->events[0];
+
+        priv->events[0] = priv->events[--priv->num_events];
+        if (priv->num_events) {
+            heap_sift_down(priv->events, priv->num_events, 0);
+        }
+        update_next_event(priv);
+
+        ev.fn(sim, ev.mod);
+    }
+}
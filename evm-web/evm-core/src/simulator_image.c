@@ -0,0 +1,280 @@
+/*
+ * simulator_image.c
+ *
+ * Binary memory images for the EVM simulator
+ * An image holds the segments an S-record or binary file loaded, its entry
+ * point and a hash of the file it was made from, so hosts can cache it and
+ * skip parsing on the next start.
+ *
+ * Layout (all fields little-endian):
+ *   0   magic "EVMIMG", 0, version
+ *   8   u64 hash of the source file (simulator_hash())
+ *   16  u32 entry point (SIM_SREC_NO_ENTRY if none)
+ *   20  u32 number of segments
+ *   24  segment table: u32 addr, u32 size, u32 file offset, u32 reserved
+ *   ... segment data, each starting on a SIM_IMAGE_ALIGN boundary
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/simulator.h"
+#include "../include/simulator_internal.h"
+
+#define IMAGE_VERSION       1
+#define IMAGE_HEADER_SIZE   24
+#define IMAGE_SEGMENT_SIZE  16
+
+static const uint8_t image_magic[8] = { 'E', 'V', 'M', 'I', 'M', 'G', 0, IMAGE_VERSION };
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_le64(const uint8_t *p)
+{
+    return (uint64_t)get_le32(p) | (uint64_t)get_le32(p + 4) << 32;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_le64(uint8_t *p, uint64_t v)
+{
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+/* ============================================================================
+ * Content hash
+ *
+ * One multiply-rotate round per 8 byte word, so checking whether a cached
+ * image is current costs a fraction of parsing the source again.
+ * ============================================================================ */
+
+#define HASH_P1 0x9E3779B185EBCA87ULL
+#define HASH_P2 0xC2B2AE3D27D4EB4FULL
+#define HASH_P3 0x165667B19E3779F9ULL
+
+static uint64_t hash_round(uint64_t h, uint64_t w)
+{
+    h += w * HASH_P2;
+    h = (h << 31) | (h >> 33);
+    return h * HASH_P1;
+}
+
+void sim_hash_init(sim_hash_t *hash)
+{
+    memset(hash, 0, sizeof(*hash));
+    hash->h = HASH_P3;
+}
+
+void sim_hash_update(sim_hash_t *hash, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    hash->len += len;
+
+    /* Complete a word started by the previous chunk */
+    if (hash->tail_len > 0) {
+        size_t n = 8 - hash->tail_len;
+        if (n > len) n = len;
+        memcpy(hash->tail + hash->tail_len, p, n);
+        hash->tail_len += (unsigned)n;
+        p += n;
+        len -= n;
+        if (hash->tail_len < 8) return;
+        hash->h = hash_round(hash->h, get_le64(hash->tail));
+        hash->tail_len = 0;
+    }
+
+    for (; len >= 8; p += 8, len -= 8) {
+        hash->h = hash_round(hash->h, get_le64(p));
+    }
+
+    memcpy(hash->tail + hash->tail_len, p, len);
+    hash->tail_len += (unsigned)len;
+}
+
+uint64_t sim_hash_final(const sim_hash_t *hash)
+{
+    uint8_t last[8] = { 0 };
+    uint64_t h = hash->h;
+
+    memcpy(last, hash->tail, hash->tail_len);
+    h = hash_round(h, get_le64(last));
+    h = hash_round(h, hash->len);
+
+    h ^= h >> 33;
+    h *= HASH_P2;
+    h ^= h >> 29;
+    h *= HASH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * Hash of a source file, as stored in images made from it
+ */
+uint64_t simulator_hash(const void *data, size_t len)
+{
+    sim_hash_t hash;
+
+    sim_hash_init(&hash);
+    sim_hash_update(&hash, data, len);
+    return sim_hash_final(&hash);
+}
+
+/* ============================================================================
+ * Building images
+ * ============================================================================ */
+
+/* Append seg, merging it into the last segment when they touch */
+static void add_segment(simulator_segment_t *segs, int *count, uint32_t addr, uint32_t size)
+{
+    if (size == 0) return;
+    if (*count > 0 && segs[*count - 1].addr + segs[*count - 1].size == addr) {
+        segs[*count - 1].size += size;
+        return;
+    }
+    segs[*count].addr = addr;
+    segs[*count].size = size;
+    (*count)++;
+}
+
+/**
+ * Build an image of the given memory ranges
+ *
+ * Ranges touching the boot ROM are replaced by the whole ROM, so the ROM
+ * can later be mapped onto the image (SIM_IMAGE_MAP_ROM).
+ */
+void *simulator_image_build(simulator_t *sim, const simulator_segment_t *segs, int count,
+                            uint32_t entry, uint64_t hash, size_t *len)
+{
+    if (sim == NULL || len == NULL || count < 0 || (segs == NULL && count > 0)) return NULL;
+
+    simulator_module_t *rom = sim_rom_module(sim);
+    uint32_t rom_start = rom ? rom->base_addr : 0;
+    uint32_t rom_end = rom ? rom->base_addr + rom->size : 0;
+    int rom_used = 0;
+
+    /* Worst case: every range splits around the ROM, plus the ROM */
+    simulator_segment_t *out = (simulator_segment_t *)malloc((2 * (size_t)count + 1) * sizeof(*out));
+    int n = 0;
+    if (out == NULL) return NULL;
+
+    for (int i = 0; i < count; i++) {
+        uint32_t start = segs[i].addr & 0xFFFFFF;
+        uint32_t end = start + segs[i].size;
+
+        if (rom && start < rom_end && end > rom_start) {
+            if (!rom_used) {
+                add_segment(out, &n, rom_start, rom->size);
+                rom_used = 1;
+            }
+            add_segment(out, &n, start, start < rom_start ? rom_start - start : 0);
+            add_segment(out, &n, rom_end, end > rom_end ? end - rom_end : 0);
+        } else {
+            add_segment(out, &n, start, segs[i].size);
+        }
+    }
+
+    /* Header, table, then the data of each segment on its own boundary */
+    size_t size = IMAGE_HEADER_SIZE + (size_t)n * IMAGE_SEGMENT_SIZE;
+    for (int i = 0; i < n; i++) {
+        size = (size + SIM_IMAGE_ALIGN - 1) & ~(size_t)(SIM_IMAGE_ALIGN - 1);
+        size += out[i].size;
+    }
+
+    uint8_t *image = (uint8_t *)calloc(1, size);
+    if (image == NULL) {
+        free(out);
+        return NULL;
+    }
+
+    memcpy(image, image_magic, sizeof(image_magic));
+    put_le64(image + 8, hash);
+    put_le32(image + 16, entry);
+    put_le32(image + 20, (uint32_t)n);
+
+    size_t offset = IMAGE_HEADER_SIZE + (size_t)n * IMAGE_SEGMENT_SIZE;
+    for (int i = 0; i < n; i++) {
+        uint8_t *entry_p = image + IMAGE_HEADER_SIZE + (size_t)i * IMAGE_SEGMENT_SIZE;
+
+        offset = (offset + SIM_IMAGE_ALIGN - 1) & ~(size_t)(SIM_IMAGE_ALIGN - 1);
+        put_le32(entry_p, out[i].addr);
+        put_le32(entry_p + 4, out[i].size);
+        put_le32(entry_p + 8, (uint32_t)offset);
+        simulator_read_block(sim, out[i].addr, image + offset, out[i].size);
+        offset += out[i].size;
+    }
+
+    free(out);
+    *len = size;
+    return image;
+}
+
+/* ============================================================================
+ * Loading images
+ * ============================================================================ */
+
+/**
+ * Check an image's header and segment table
+ */
+int simulator_image_check(const void *data, size_t len, uint64_t *hash, uint32_t *entry)
+{
+    const uint8_t *image = (const uint8_t *)data;
+
+    if (image == NULL || len < IMAGE_HEADER_SIZE ||
+        memcmp(image, image_magic, sizeof(image_magic)) != 0) {
+        return -1;
+    }
+
+    uint32_t count = get_le32(image + 20);
+    if (count > (len - IMAGE_HEADER_SIZE) / IMAGE_SEGMENT_SIZE) return -1;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *seg = image + IMAGE_HEADER_SIZE + (size_t)i * IMAGE_SEGMENT_SIZE;
+        uint32_t size = get_le32(seg + 4);
+        uint32_t offset = get_le32(seg + 8);
+
+        if (offset > len || size > len - offset) return -1;
+    }
+
+    if (hash) *hash = get_le64(image + 8);
+    if (entry) *entry = get_le32(image + 16);
+    return 0;
+}
+
+/**
+ * Load an image into memory
+ */
+int simulator_load_image(simulator_t *sim, void *data, size_t len, int flags, uint32_t *entry)
+{
+    uint8_t *image = (uint8_t *)data;
+
+    if (sim == NULL || simulator_image_check(data, len, NULL, entry) != 0) return -1;
+
+    simulator_module_t *rom = sim_rom_module(sim);
+    uint32_t count = get_le32(image + 20);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *seg = image + IMAGE_HEADER_SIZE + (size_t)i * IMAGE_SEGMENT_SIZE;
+        uint32_t addr = get_le32(seg);
+        uint32_t size = get_le32(seg + 4);
+        uint8_t *p = image + get_le32(seg + 8);
+
+        if ((flags & SIM_IMAGE_MAP_ROM) && rom && addr == rom->base_addr && size == rom->size) {
+            sim_rom_attach(sim, p);
+        } else {
+            simulator_write_block(sim, addr, p, size);
+        }
+    }
+    return 0;
+}
@@ -6,12 +6,20 @@
  *
  * This is a simplified version suitable for WASM.
  * The Windows build can use the full DLL-based modules.
+ *
+ * The descriptors below are templates: simulator_load_modules() registers
+ * a copy per simulator, and setup() allocates that instance's state.
  */
 
+#include <errno.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "../include/simulator.h"
+#include "../include/simulator_mem.h"
+#include "../include/simulator_internal.h"
 
 /* ============================================================================
  * RAM Module (128KB at 0x400000)
@@ -25,11 +33,14 @@ typedef struct {
 #define RAM_BASE_ADDR   0x400000
 #define RAM_SIZE        (128 * 1024)
 
-static ram_state_t ram_state = {0};
-
 static int ram_setup(simulator_module_t *mod)
 {
-    ram_state_t *state = (ram_state_t *)mod->state;
+    ram_state_t *state = (ram_state_t *)calloc(1, sizeof(ram_state_t));
+    if (state == NULL) {
+        fprintf(stderr, "Failed to allocate RAM\n");
+        return 0;
+    }
+    mod->state = state;
     state->size = RAM_SIZE;
     state->memory = (uint8_t *)malloc(RAM_SIZE);
     if (state->memory == NULL) {
@@ -54,17 +65,13 @@ static void ram_reset(simulator_module_t *mod)
 static void ram_exit(simulator_module_t *mod)
 {
     ram_state_t *state = (ram_state_t *)mod->state;
-    if (state->memory) {
+    if (state) {
         free(state->memory);
-        state->memory = NULL;
+        free(state);
+        mod->state = NULL;
     }
 }
 
-static void ram_simulate(simulator_module_t *mod)
-{
-    /* No simulation needed for passive memory */
-}
-
 static uint32_t ram_read(simulator_module_t *mod, uint32_t addr, int size)
 {
     ram_state_t *state = (ram_state_t *)mod->state;
@@ -75,21 +82,12 @@ static uint32_t ram_read(simulator_module_t *mod, uint32_t addr, int size)
         return 0;
     }
 
-    uint32_t result = 0;
-    if (size == 1) {
-        result = state->memory[offset];
-    } else if (size == 2) {
-        /* Big-endian word */
-        result = ((uint32_t)state->memory[offset] << 8) |
-                  (uint32_t)state->memory[offset + 1];
-    } else if (size == 4) {
-        /* Big-endian dword */
-        result = ((uint32_t)state->memory[offset] << 24) |
-                 ((uint32_t)state->memory[offset + 1] << 16) |
-                 ((uint32_t)state->memory[offset + 2] << 8) |
-                  (uint32_t)state->memory[offset + 3];
+    switch (size) {
+        case 1: return state->memory[offset];
+        case 2: return mem_get16(state->memory + offset);   /* Big-endian word */
+        case 4: return mem_get32(state->memory + offset);   /* Big-endian dword */
     }
-    return result;
+    return 0;
 }
 
 static void ram_write(simulator_module_t *mod, uint32_t addr, uint32_t data, int size)
@@ -102,22 +100,37 @@ static void ram_write(simulator_module_t *mod, uint32_t addr, uint32_t data, int
         return;
     }
 
-    if (size == 1) {
-        state->memory[offset] = (uint8_t)data;
-    } else if (size == 2) {
-        /* Big-endian word */
-        state->memory[offset] = (uint8_t)((data >> 8) & 0xFF);
-        state->memory[offset + 1] = (uint8_t)(data & 0xFF);
-    } else if (size == 4) {
-        /* Big-endian dword */
-        state->memory[offset] = (uint8_t)((data >> 24) & 0xFF);
-        state->memory[offset + 1] = (uint8_t)((data >> 16) & 0xFF);
-        state->memory[offset + 2] = (uint8_t)((data >> 8) & 0xFF);
-        state->memory[offset + 3] = (uint8_t)(data & 0xFF);
+    switch (size) {
+        case 1: state->memory[offset] = (uint8_t)data; break;
+        case 2: mem_put16(state->memory + offset, data); break;   /* Big-endian word */
+        case 4: mem_put32(state->memory + offset, data); break;   /* Big-endian dword */
+    }
+}
+
+static uint8_t *ram_map(simulator_module_t *mod, uint32_t addr)
+{
+    ram_state_t *state = (ram_state_t *)mod->state;
+    uint32_t offset = (addr - mod->base_addr) & 0xFFFFFF;
+
+    if (state->memory == NULL || offset >= state->size) {
+        return NULL;
     }
+    return state->memory + offset;
+}
+
+/* The memory itself is saved with the pages, only check it fits */
+static int ram_save(simulator_module_t *mod, simulator_snapshot_t *snap)
+{
+    simulator_snapshot_put32(snap, (uint32_t)((ram_state_t *)mod->state)->size);
+    return 0;
 }
 
-simulator_module_t evmram_module = {
+static int ram_load(simulator_module_t *mod, simulator_snapshot_t *snap)
+{
+    return simulator_snapshot_get32(snap) == ((ram_state_t *)mod->state)->size ? 0 : -1;
+}
+
+const simulator_module_t evmram_module = {
     .name = "EVMRAM",
     .base_addr = RAM_BASE_ADDR,
     .size = RAM_SIZE,
@@ -127,10 +140,11 @@ simulator_module_t evmram_module = {
     .init = ram_init,
     .reset = ram_reset,
     .exit = ram_exit,
-    .simulate = ram_simulate,
     .read = ram_read,
     .write = ram_write,
-    .state = &ram_state
+    .map = ram_map,
+    .save = ram_save,
+    .load = ram_load,
 };
 
 /* ============================================================================
@@ -144,16 +158,20 @@ simulator_module_t evmram_module = {
 typedef struct {
     uint8_t *memory;
     size_t size;
+    int attached;       /* memory belongs to the host, see sim_rom_attach() */
 } rom_state_t;
 
 #define ROM_BASE_ADDR   0x000000
 #define ROM_SIZE        (64 * 1024)
 
-static rom_state_t rom_state = {0};
-
 static int rom_setup(simulator_module_t *mod)
 {
-    rom_state_t *state = (rom_state_t *)mod->state;
+    rom_state_t *state = (rom_state_t *)calloc(1, sizeof(rom_state_t));
+    if (state == NULL) {
+        fprintf(stderr, "Failed to allocate ROM\n");
+        return 0;
+    }
+    mod->state = state;
     state->size = ROM_SIZE;
     state->memory = (uint8_t *)malloc(ROM_SIZE);
     if (state->memory == NULL) {
@@ -177,17 +195,13 @@ static void rom_reset(simulator_module_t *mod)
 static void rom_exit(simulator_module_t *mod)
 {
     rom_state_t *state = (rom_state_t *)mod->state;
-    if (state->memory) {
-        free(state->memory);
-        state->memory = NULL;
+    if (state) {
+        if (!state->attached) free(state->memory);
+        free(state);
+        mod->state = NULL;
     }
 }
 
-static void rom_simulate(simulator_module_t *mod)
-{
-    /* No simulation needed */
-}
-
 static uint32_t rom_read(simulator_module_t *mod, uint32_t addr, int size)
 {
     rom_state_t *state = (rom_state_t *)mod->state;
@@ -198,21 +212,12 @@ static uint32_t rom_read(simulator_module_t *mod, uint32_t addr, int size)
         return 0;
     }
 
-    uint32_t result = 0;
-    if (size == 1) {
-        result = state->memory[offset];
-    } else if (size == 2) {
-        /* Big-endian word */
-        result = ((uint32_t)state->memory[offset] << 8) |
-                  (uint32_t)state->memory[offset + 1];
-    } else if (size == 4) {
-        /* Big-endian dword */
-        result = ((uint32_t)state->memory[offset] << 24) |
-                 ((uint32_t)state->memory[offset + 1] << 16) |
-                 ((uint32_t)state->memory[offset + 2] << 8) |
-                  (uint32_t)state->memory[offset + 3];
+    switch (size) {
+        case 1: return state->memory[offset];
+        case 2: return mem_get16(state->memory + offset);   /* Big-endian word */
+        case 4: return mem_get32(state->memory + offset);   /* Big-endian dword */
     }
-    return result;
+    return 0;
 }
 
 static void rom_write(simulator_module_t *mod, uint32_t addr, uint32_t data, int size)
@@ -225,22 +230,36 @@ static void rom_write(simulator_module_t *mod, uint32_t addr, uint32_t data, int
         return;
     }
 
-    if (size == 1) {
-        state->memory[offset] = (uint8_t)data;
-    } else if (size == 2) {
-        /* Big-endian word */
-        state->memory[offset] = (uint8_t)((data >> 8) & 0xFF);
-        state->memory[offset + 1] = (uint8_t)(data & 0xFF);
-    } else if (size == 4) {
-        /* Big-endian dword */
-        state->memory[offset] = (uint8_t)((data >> 24) & 0xFF);
-        state->memory[offset + 1] = (uint8_t)((data >> 16) & 0xFF);
-        state->memory[offset + 2] = (uint8_t)((data >> 8) & 0xFF);
-        state->memory[offset + 3] = (uint8_t)(data & 0xFF);
+    switch (size) {
+        case 1: state->memory[offset] = (uint8_t)data; break;
+        case 2: mem_put16(state->memory + offset, data); break;   /* Big-endian word */
+        case 4: mem_put32(state->memory + offset, data); break;   /* Big-endian dword */
+    }
+}
+
+static uint8_t *rom_map(simulator_module_t *mod, uint32_t addr)
+{
+    rom_state_t *state = (rom_state_t *)mod->state;
+    uint32_t offset = (addr - mod->base_addr) & 0xFFFFFF;
+
+    if (state->memory == NULL || offset >= state->size) {
+        return NULL;
     }
+    return state->memory + offset;
 }
 
-simulator_module_t evmrom_module = {
+static int rom_save(simulator_module_t *mod, simulator_snapshot_t *snap)
+{
+    simulator_snapshot_put32(snap, (uint32_t)((rom_state_t *)mod->state)->size);
+    return 0;
+}
+
+static int rom_load(simulator_module_t *mod, simulator_snapshot_t *snap)
+{
+    return simulator_snapshot_get32(snap) == ((rom_state_t *)mod->state)->size ? 0 : -1;
+}
+
+const simulator_module_t evmrom_module = {
     .name = "EVMROM",
     .base_addr = ROM_BASE_ADDR,
     .size = ROM_SIZE,
@@ -250,12 +269,35 @@ simulator_module_t evmrom_module = {
     .init = rom_init,
     .reset = rom_reset,
     .exit = rom_exit,
-    .simulate = rom_simulate,
     .read = rom_read,
     .write = rom_write,
-    .state = &rom_state
+    .map = rom_map,
+    .save = rom_save,
+    .load = rom_load,
 };
 
+simulator_module_t *sim_rom_module(simulator_t *sim)
+{
+    for (int i = 0; i < sim->num_modules; i++) {
+        if (sim->modules[i]->setup == rom_setup) return sim->modules[i];
+    }
+    return NULL;
+}
+
+void sim_rom_attach(simulator_t *sim, uint8_t *data)
+{
+    simulator_module_t *mod = sim_rom_module(sim);
+    if (mod == NULL || mod->state == NULL) return;
+
+    rom_state_t *state = (rom_state_t *)mod->state;
+    if (!state->attached) free(state->memory);
+    state->memory = data;
+    state->attached = 1;
+
+    /* Pages still point at the old copy */
+    sim_build_memory_map(sim);
+}
+
 /* ============================================================================
  * 68230 PIT Module (Parallel Interface/Timer at 0x800000)
  * ============================================================================ */
@@ -293,23 +335,76 @@ typedef struct {
     uint8_t CNTRH, CNTRM, CNTRL;  /* Counter */
 
     /* Timer state */
-    uint32_t counter;
+    uint32_t counter;   /* Count at load_cycles */
     uint32_t preload;
-    uint32_t tick_count;
+    uint64_t load_cycles;       /* CPU cycle the counter was last loaded at */
+    uint64_t cycles_per_count;  /* CPU cycles per counter decrement */
 
 } pit_state_t;
 
 #define PIT_BASE_ADDR   0x800000
 #define PIT_SIZE        0x36
 
-static pit_state_t pit_state = {0};
+/* Timer input clock: 6.25 MHz (160ns), divided by 32 unless TCR bit 1 is set */
+#define PIT_PCLK_HZ     6250000
+#define PIT_PRESCALER   32
 
-static int pit_setup(simulator_module_t *mod)
+static void pit_underflow(simulator_t *sim, simulator_module_t *mod);
+
+/* Counter runs down to 0, the decrement after that underflows */
+static void pit_schedule_underflow(simulator_module_t *mod)
 {
     pit_state_t *state = (pit_state_t *)mod->state;
-    memset(state, 0, sizeof(pit_state_t));
+    simulator_t *sim = mod->sim;
+
+    state->cycles_per_count = SIM_CPU_CLOCK_HZ / PIT_PCLK_HZ;
+    if (!(state->TCR & 0x02)) {
+        state->cycles_per_count *= PIT_PRESCALER;
+    }
+    state->load_cycles = simulator_get_clock(sim);
+
+    simulator_cancel_events(sim, mod, pit_underflow);
+    simulator_schedule_event(sim, mod,
+                             ((uint64_t)state->counter + 1) * state->cycles_per_count,
+                             pit_underflow);
+}
+
+/* Count the timer has run down to by now; the underflow event is due one
+   decrement after it reaches 0 */
+static uint32_t pit_current_count(simulator_module_t *mod)
+{
+    pit_state_t *state = (pit_state_t *)mod->state;
+    uint64_t elapsed = simulator_get_clock(mod->sim) - state->load_cycles;
+    uint64_t counts = elapsed / state->cycles_per_count;
+
+    return (counts < state->counter) ? state->counter - (uint32_t)counts : 0;
+}
+
+/* Bring the counter up to date, e.g. before the timer clock changes */
+static void pit_sync_counter(simulator_module_t *mod)
+{
+    pit_state_t *state = (pit_state_t *)mod->state;
+
+    state->counter = pit_current_count(mod);
+}
+
+static void pit_underflow(simulator_t *sim, simulator_module_t *mod)
+{
+    pit_state_t *state = (pit_state_t *)mod->state;
+
+    state->counter = state->preload;
+    state->TSR |= 0x01;  /* Set underflow bit */
+    pit_schedule_underflow(mod);
+}
+
+static int pit_setup(simulator_module_t *mod)
+{
+    pit_state_t *state = (pit_state_t *)calloc(1, sizeof(pit_state_t));
+    if (state == NULL) return 0;
+    mod->state = state;
     state->preload = 0xFFFFFF;
     state->counter = 0xFFFFFF;
+    pit_schedule_underflow(mod);
     return 1;  /* Success */
 }
 
@@ -324,27 +419,13 @@ static void pit_reset(simulator_module_t *mod)
     memset(state, 0, sizeof(pit_state_t));
     state->preload = 0xFFFFFF;
     state->counter = 0xFFFFFF;
+    pit_schedule_underflow(mod);
 }
 
 static void pit_exit(simulator_module_t *mod)
 {
-    /* No cleanup needed */
-}
-
-static void pit_simulate(simulator_module_t *mod)
-{
-    pit_state_t *state = (pit_state_t *)mod->state;
-
-    /* Basic timer decrement - decrements every 1000 ticks */
-    if ((++(state->tick_count) & 0x3FF) == 0) {
-        if (state->counter > 0) {
-            state->counter--;
-        } else {
-            /* Timer underflow */
-            state->counter = state->preload;
-            state->TSR |= 0x01;  /* Set underflow bit */
-        }
-    }
+    free(mod->state);
+    mod->state = NULL;
 }
 
 static uint32_t pit_read(simulator_module_t *mod, uint32_t addr, int size)
@@ -371,9 +452,9 @@ static uint32_t pit_read(simulator_module_t *mod, uint32_t addr, int size)
             case 0x1B: return state->PSR;
             case 0x21: return state->TCR;
             case 0x23: return state->TIVR;
-            case 0x27: return state->CNTRH;
-            case 0x29: return state->CNTRM;
-            case 0x2B: return state->CNTRL;
+            case 0x27: return (pit_current_count(mod) >> 16) & 0xFF;
+            case 0x29: return (pit_current_count(mod) >> 8) & 0xFF;
+            case 0x2B: return pit_current_count(mod) & 0xFF;
             case 0x2D: return state->TSR;
             default: return 0xFF;
         }
@@ -409,7 +490,12 @@ static void pit_write(simulator_module_t *mod, uint32_t addr, uint32_t data, int
             case 0x15: state->PAAR = data; break;
             case 0x17: state->PBAR = data; break;
             case 0x19: state->PCDR = data & state->PCDDR; break;
-            case 0x21: state->TCR = data; break;
+            case 0x21:
+                /* Prescaler may change: continue from the current count */
+                pit_sync_counter(mod);
+                state->TCR = data;
+                pit_schedule_underflow(mod);
+                break;
             case 0x23: state->TIVR = data; break;
             case 0x25: state->CPRH = data; break;
             case 0x27: state->CPRM = data; break;
@@ -427,7 +513,50 @@ static void pit_write(simulator_module_t *mod, uint32_t addr, uint32_t data, int
     }
 }
 
-simulator_module_t pit68230_module = {
+/* Register bytes PADR..CNTRL, saved as one block */
+#define PIT_REGS_SIZE   (offsetof(pit_state_t, CNTRL) + 1)
+
+static int pit_save(simulator_module_t *mod, simulator_snapshot_t *snap)
+{
+    pit_state_t *state = (pit_state_t *)mod->state;
+
+    simulator_snapshot_put(snap, state, PIT_REGS_SIZE);
+    simulator_snapshot_put32(snap, state->counter);
+    simulator_snapshot_put32(snap, state->preload);
+    simulator_snapshot_put64(snap, state->load_cycles);
+    simulator_snapshot_put64(snap, state->cycles_per_count);
+    return 0;
+}
+
+static int pit_load(simulator_module_t *mod, simulator_snapshot_t *snap)
+{
+    pit_state_t *state = (pit_state_t *)mod->state;
+    uint64_t now = simulator_get_clock(mod->sim);
+
+    simulator_snapshot_get(snap, state, PIT_REGS_SIZE);
+    state->counter = simulator_snapshot_get32(snap);
+    state->preload = simulator_snapshot_get32(snap);
+    state->load_cycles = simulator_snapshot_get64(snap);
+    state->cycles_per_count = simulator_snapshot_get64(snap);
+    if (state->cycles_per_count == 0) return -1;
+
+    /* Underflow at the same clock as in the saved run */
+    uint64_t due = state->load_cycles + ((uint64_t)state->counter + 1) * state->cycles_per_count;
+    simulator_cancel_events(mod->sim, mod, pit_underflow);
+    simulator_schedule_event(mod->sim, mod, due > now ? due - now : 0, pit_underflow);
+    return 0;
+}
+
+/* The counter runs down between the events, everything else only changes
+   on writes and in pit_underflow() */
+static int pit_read_stable(simulator_module_t *mod, uint32_t addr)
+{
+    uint32_t offset = (addr - mod->base_addr) & 0x3F;
+
+    return offset < 0x26 || offset > 0x2C;
+}
+
+const simulator_module_t pit68230_module = {
     .name = "68230 PIT",
     .base_addr = PIT_BASE_ADDR,
     .size = PIT_SIZE,
@@ -437,10 +566,11 @@ simulator_module_t pit68230_module = {
     .init = pit_init,
     .reset = pit_reset,
     .exit = pit_exit,
-    .simulate = pit_simulate,
     .read = pit_read,
     .write = pit_write,
-    .state = &pit_state
+    .read_stable = pit_read_stable,
+    .save = pit_save,
+    .load = pit_load,
 };
 
 /* ============================================================================
@@ -450,25 +580,22 @@ simulator_module_t pit68230_module = {
 typedef struct {
     /* Channel A */
     uint8_t MR1A;       /* Mode Register 1A */
-    uint8_t SRA;        /* Status Register A */
     uint8_t CSRA;       /* Clock Select Register A */
     uint8_t CRA;        /* Command Register A */
-    uint8_t RBA;        /* Receiver Buffer A */
+    uint8_t RBA;        /* Receiver Buffer A (last character taken) */
     uint8_t TBA;        /* Transmitter Buffer A */
     uint8_t IPCR;       /* Input Port Change Register */
     uint8_t IPU;        /* Input Port Unlatched */
 
     /* Channel B */
     uint8_t MR1B;       /* Mode Register 1B */
-    uint8_t SRB;        /* Status Register B */
     uint8_t CSRB;       /* Clock Select Register B */
     uint8_t CRB;        /* Command Register B */
-    uint8_t RBB;        /* Receiver Buffer B */
+    uint8_t RBB;        /* Receiver Buffer B (last character taken) */
     uint8_t TBB;        /* Transmitter Buffer B */
 
     /* Common Registers */
     uint8_t ACR;        /* Auxiliary Control Register */
-    uint8_t ISR;        /* Interrupt Status Register */
     uint8_t IMR;        /* Interrupt Mask Register */
     uint8_t IVR;        /* Interrupt Vector Register */
     uint8_t CTUR;       /* Counter/Timer Upper Register */
@@ -478,27 +605,104 @@ typedef struct {
     uint8_t OPCR;       /* Output Port Configuration */
     uint8_t OPR;        /* Output Port Register */
 
-    /* State tracking */
-    uint16_t tx_buffer_a;
-    uint16_t tx_buffer_b;
-    uint32_t counter;
-    uint32_t rx_ready_a;  /* Fake RX for testing */
-    uint32_t rx_ready_b;
-
+    /* The status registers SRA/SRB and ISR follow the host side FIFOs
+       (priv->uart[]) */
 } uart_state_t;
 
 #define UART_BASE_ADDR  0xA00000
 #define UART_SIZE       0x20
 
-static uart_state_t uart_state = {0};
+/* Status register bits */
+#define UART_SR_RXRDY   0x01
+#define UART_SR_FFULL   0x02
+#define UART_SR_TXRDY   0x04
+#define UART_SR_TXEMT   0x08
+
+/* CPU cycles between received characters: one character time
+ * (start + 8 data + stop bits) at 9600 baud */
+#define UART_RX_CYCLES ((uint64_t)SIM_CPU_CLOCK_HZ * 10 / 9600)
+
+/* Status register of a channel */
+static uint8_t uart_status(simulator_priv_t *priv, int channel)
+{
+    sim_uart_channel_t *ch = &priv->uart[channel];
+    uint32_t rx = sim_fifo_count(&ch->rx);
+    /* Data waiting for a sink counts as sent, only pulled data backs up */
+    uint32_t tx = (priv->uart_tx == NULL && ch->fd < 0) ? sim_fifo_count(&ch->tx) : 0;
+    uint8_t sr = 0;
+
+    if (rx > 0) sr |= UART_SR_RXRDY;
+    if (rx == SIM_UART_FIFO_SIZE) sr |= UART_SR_FFULL;
+    if (tx < SIM_UART_FIFO_SIZE) sr |= UART_SR_TXRDY;
+    if (tx == 0) sr |= UART_SR_TXEMT;
+    return sr;
+}
+
+/* Interrupt status: TxRDY and RxRDY (FFULL if MR1 bit 6 is set) of both
+   channels. Nothing is wired to the CPU's interrupt inputs. */
+static uint8_t uart_isr(uart_state_t *state, simulator_priv_t *priv)
+{
+    uint8_t sra = uart_status(priv, SIM_UART_A);
+    uint8_t srb = uart_status(priv, SIM_UART_B);
+    uint8_t isr = 0;
+
+    if (sra & UART_SR_TXRDY) isr |= 0x01;
+    if (sra & ((state->MR1A & 0x40) ? UART_SR_FFULL : UART_SR_RXRDY)) isr |= 0x02;
+    if (srb & UART_SR_TXRDY) isr |= 0x10;
+    if (srb & ((state->MR1B & 0x40) ? UART_SR_FFULL : UART_SR_RXRDY)) isr |= 0x20;
+    return isr;
+}
+
+/* Queue the next character from the host while the receive FIFO has room */
+static void uart_receive(simulator_priv_t *priv, int channel)
+{
+    sim_fifo_t *rx = &priv->uart[channel].rx;
+    int data;
+
+    if (sim_fifo_count(rx) == SIM_UART_FIFO_SIZE) return;
+
+    data = priv->uart_rx(priv->uart_rx_user, channel);
+    if (data >= 0) {
+        uint8_t c = (uint8_t)data;
+        sim_fifo_put(rx, &c, 1);
+    }
+}
+
+static void uart_rx_event(simulator_t *sim, simulator_module_t *mod)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    if (priv->uart_rx == NULL) return;  /* Hook removed */
+    uart_receive(priv, SIM_UART_A);
+    uart_receive(priv, SIM_UART_B);
+    simulator_schedule_event(sim, mod, UART_RX_CYCLES, uart_rx_event);
+}
+
+/* Poll the rx hook once per character time, if there is one */
+static void uart_start(simulator_module_t *mod)
+{
+    simulator_t *sim = mod->sim;
+
+    simulator_cancel_events(sim, mod, NULL);
+    if (SIM_PRIV(sim)->uart_rx) {
+        simulator_schedule_event(sim, mod, UART_RX_CYCLES, uart_rx_event);
+    }
+}
+
+void sim_uart_rx_changed(simulator_t *sim)
+{
+    simulator_module_t *mod = SIM_PRIV(sim)->uart_module;
+
+    if (mod) uart_start(mod);
+}
 
 static int uart_setup(simulator_module_t *mod)
 {
-    uart_state_t *state = (uart_state_t *)mod->state;
-    memset(state, 0, sizeof(uart_state_t));
-    /* Initialize status registers with TXRDY bits set (ready to transmit) */
-    state->SRA = 0x04;  /* TXRDY for channel A */
-    state->SRB = 0x04;  /* TXRDY for channel B */
+    uart_state_t *state = (uart_state_t *)calloc(1, sizeof(uart_state_t));
+    if (state == NULL) return 0;
+    mod->state = state;
+    SIM_PRIV(mod->sim)->uart_module = mod;
+    uart_start(mod);
     return 1;  /* Success */
 }
 
@@ -511,33 +715,27 @@ static void uart_reset(simulator_module_t *mod)
 {
     uart_state_t *state = (uart_state_t *)mod->state;
     memset(state, 0, sizeof(uart_state_t));
-    state->SRA = 0x04;
-    state->SRB = 0x04;
+    uart_start(mod);
 }
 
 static void uart_exit(simulator_module_t *mod)
 {
-    /* No cleanup needed */
+    SIM_PRIV(mod->sim)->uart_module = NULL;
+    free(mod->state);
+    mod->state = NULL;
 }
 
-static void uart_simulate(simulator_module_t *mod)
+/* Take the next received character; an empty FIFO leaves the last one */
+static uint8_t uart_take(simulator_priv_t *priv, int channel, uint8_t *rb)
 {
-    uart_state_t *state = (uart_state_t *)mod->state;
-
-    /* Simple simulation: always set TXRDY and periodically set RXRDY */
-    state->SRA |= 0x04;  /* TXRDY - transmitter ready */
-    state->SRB |= 0x04;  /* TXRDY - transmitter ready */
-
-    /* Simulate occasional RX data availability */
-    if ((++state->counter & 0x1FFF) == 0) {
-        state->SRA |= 0x01;  /* Set RXRDY for channel A */
-        state->rx_ready_a = 1;
-    }
+    sim_fifo_get(&priv->uart[channel].rx, rb, 1);
+    return *rb;
 }
 
 static uint32_t uart_read(simulator_module_t *mod, uint32_t addr, int size)
 {
     uart_state_t *state = (uart_state_t *)mod->state;
+    simulator_priv_t *priv = SIM_PRIV(mod->sim);
     uint32_t offset = (addr - mod->base_addr) & 0x1F;
 
     if (size == 1) {
@@ -545,23 +743,19 @@ static uint32_t uart_read(simulator_module_t *mod, uint32_t addr, int size)
         switch (offset) {
             /* Channel A */
             case 0x01: return state->MR1A;
-            case 0x03: return state->SRA;
+            case 0x03: return uart_status(priv, SIM_UART_A);
             case 0x05: return 0xFF;  /* Reserved */
-            case 0x07:
-                state->SRA &= ~0x01;  /* Clear RXRDY after read */
-                return state->RBA;
+            case 0x07: return uart_take(priv, SIM_UART_A, &state->RBA);
             case 0x09: return state->IPCR;
-            case 0x0B: return state->ISR;
+            case 0x0B: return uart_isr(state, priv);
             case 0x0D: return state->CMSB;
             case 0x0F: return state->CLSB;
 
             /* Channel B */
             case 0x11: return state->MR1B;
-            case 0x13: return state->SRB;
+            case 0x13: return uart_status(priv, SIM_UART_B);
             case 0x15: return 0xFF;  /* Reserved */
-            case 0x17:
-                state->SRB &= ~0x01;  /* Clear RXRDY after read */
-                return state->RBB;
+            case 0x17: return uart_take(priv, SIM_UART_B, &state->RBB);
             case 0x19: return state->IVR;
             case 0x1B: return state->IPU;
             case 0x1D: return 0xFF;  /* Reserved */
@@ -573,6 +767,59 @@ static uint32_t uart_read(simulator_module_t *mod, uint32_t addr, int size)
     return 0;
 }
 
+/* Write the transmit FIFO of a channel to its fd */
+static void uart_flush_channel(sim_uart_channel_t *ch)
+{
+    sim_fifo_t *tx = &ch->tx;
+
+    while (sim_fifo_count(tx) > 0) {
+        uint32_t tail = tx->tail & (SIM_UART_FIFO_SIZE - 1);
+        uint32_t len = sim_fifo_count(tx);
+        ssize_t n;
+
+        if (len > SIM_UART_FIFO_SIZE - tail) len = SIM_UART_FIFO_SIZE - tail;
+        n = write(ch->fd, tx->data + tail, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) {
+            /* Non-blocking fd, e.g. a terminal shared with stdin */
+            struct pollfd pfd = { ch->fd, POLLOUT, 0 };
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        if (n <= 0) {
+            tx->tail = tx->head;    /* The sink failed, drop the data */
+            break;
+        }
+        tx->tail += (uint32_t)n;
+    }
+}
+
+void sim_uart_flush(simulator_t *sim)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+
+    for (int c = SIM_UART_A; c <= SIM_UART_B; c++) {
+        if (priv->uart[c].fd >= 0) uart_flush_channel(&priv->uart[c]);
+    }
+}
+
+/* Hand a transmitted character to the hook, or queue it */
+static void uart_transmit(simulator_module_t *mod, int channel, uint8_t data)
+{
+    simulator_priv_t *priv = SIM_PRIV(mod->sim);
+    sim_uart_channel_t *ch = &priv->uart[channel];
+
+    if (priv->uart_tx) {
+        priv->uart_tx(priv->uart_tx_user, channel, data);
+        return;
+    }
+    if (sim_fifo_count(&ch->tx) == SIM_UART_FIFO_SIZE) {
+        if (ch->fd < 0) return;     /* TXRDY was clear, the character is lost */
+        uart_flush_channel(ch);
+    }
+    sim_fifo_put(&ch->tx, &data, 1);
+}
+
 static void uart_write(simulator_module_t *mod, uint32_t addr, uint32_t data, int size)
 {
     uart_state_t *state = (uart_state_t *)mod->state;
@@ -587,14 +834,7 @@ static void uart_write(simulator_module_t *mod, uint32_t addr, uint32_t data, in
             case 0x05: state->CRA = data; break;
             case 0x07:
                 state->TBA = data;
-                /* Echo output to stderr for debugging */
-                if (data >= 32 && data < 127) {
-                    fprintf(stderr, "%c", data);
-                } else if (data == '\n') {
-                    fprintf(stderr, "\n");
-                }
-                fflush(stderr);
-                state->SRA |= 0x04;  /* Set TXRDY */
+                uart_transmit(mod, SIM_UART_A, data);
                 break;
             case 0x09: state->ACR = data; break;
             case 0x0B: state->IMR = data; break;
@@ -607,14 +847,7 @@ static void uart_write(simulator_module_t *mod, uint32_t addr, uint32_t data, in
             case 0x15: state->CRB = data; break;
             case 0x17:
                 state->TBB = data;
-                /* Echo output */
-                if (data >= 32 && data < 127) {
-                    fprintf(stderr, "%c", data);
-                } else if (data == '\n') {
-                    fprintf(stderr, "\n");
-                }
-                fflush(stderr);
-                state->SRB |= 0x04;  /* Set TXRDY */
+                uart_transmit(mod, SIM_UART_B, data);
                 break;
             case 0x19: state->IVR = data; break;
             case 0x1B: state->OPCR = data; break;
@@ -624,7 +857,73 @@ static void uart_write(simulator_module_t *mod, uint32_t addr, uint32_t data, in
     }
 }
 
-simulator_module_t uart68681_module = {
+/* Register bytes MR1A..OPR, saved as one block */
+#define UART_REGS_SIZE  (offsetof(uart_state_t, OPR) + 1)
+
+/* The FIFOs are saved with the registers: what the CPU has yet to receive
+   and what the host has yet to take belong to the machine state */
+static void uart_save_fifo(simulator_snapshot_t *snap, const sim_fifo_t *f)
+{
+    uint32_t n = sim_fifo_count(f);
+    uint32_t tail = f->tail & (SIM_UART_FIFO_SIZE - 1);
+    uint32_t first = n < SIM_UART_FIFO_SIZE - tail ? n : SIM_UART_FIFO_SIZE - tail;
+
+    /* Oldest first: up to the end of the buffer, then from its start */
+    simulator_snapshot_put32(snap, n);
+    simulator_snapshot_put(snap, f->data + tail, first);
+    simulator_snapshot_put(snap, f->data, n - first);
+}
+
+/* A count the FIFO cannot hold means a corrupt section: the bytes that
+   follow would be read as the wrong fields */
+static int uart_load_fifo(simulator_snapshot_t *snap, sim_fifo_t *f)
+{
+    uint32_t n = simulator_snapshot_get32(snap);
+
+    f->head = f->tail = 0;
+    if (n > SIM_UART_FIFO_SIZE) return -1;
+    f->head = n;
+    simulator_snapshot_get(snap, f->data, n);
+    return 0;
+}
+
+static int uart_save(simulator_module_t *mod, simulator_snapshot_t *snap)
+{
+    simulator_priv_t *priv = SIM_PRIV(mod->sim);
+
+    simulator_snapshot_put(snap, mod->state, UART_REGS_SIZE);
+    for (int c = SIM_UART_A; c <= SIM_UART_B; c++) {
+        uart_save_fifo(snap, &priv->uart[c].rx);
+        uart_save_fifo(snap, &priv->uart[c].tx);
+    }
+    return 0;
+}
+
+static int uart_load(simulator_module_t *mod, simulator_snapshot_t *snap)
+{
+    simulator_priv_t *priv = SIM_PRIV(mod->sim);
+    int rc = 0;
+
+    simulator_snapshot_get(snap, mod->state, UART_REGS_SIZE);
+    for (int c = SIM_UART_A; c <= SIM_UART_B && rc == 0; c++) {
+        rc = uart_load_fifo(snap, &priv->uart[c].rx);
+        if (rc == 0) rc = uart_load_fifo(snap, &priv->uart[c].tx);
+    }
+    uart_start(mod);
+    return rc;
+}
+
+/* Reading a receive buffer takes a character; the status registers only
+   change with it, on writes, in uart_rx_event() and through the host calls
+   between batches */
+static int uart_read_stable(simulator_module_t *mod, uint32_t addr)
+{
+    uint32_t offset = (addr - mod->base_addr) & 0x1F;
+
+    return offset != 0x07 && offset != 0x17;
+}
+
+const simulator_module_t uart68681_module = {
     .name = "68681 UART",
     .base_addr = UART_BASE_ADDR,
     .size = UART_SIZE,
@@ -634,8 +933,9 @@ simulator_module_t uart68681_module = {
     .init = uart_init,
     .reset = uart_reset,
     .exit = uart_exit,
-    .simulate = uart_simulate,
     .read = uart_read,
     .write = uart_write,
-    .state = &uart_state
+    .read_stable = uart_read_stable,
+    .save = uart_save,
+    .load = uart_load,
 };
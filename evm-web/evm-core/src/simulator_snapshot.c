@@ -0,0 +1,521 @@
+/*
+ * simulator_snapshot.c
+ *
+ * Machine snapshots for the EVM simulator
+ * A snapshot is a header followed by tagged sections: the CPU registers,
+ * one section per module (its save() data) and one per RAM/ROM page.
+ *
+ * Layout (all fields little-endian):
+ *   0   magic "EVMSNAP", 0
+ *   8   u32 version (SIM_SNAPSHOT_VERSION)
+ *   12  u32 flags (SIM_SNAPSHOT_INCREMENTAL)
+ *   16  u64 size of the whole snapshot
+ *   24  u64 id: hash of the snapshot with this field 0
+ *   32  u64 id of the snapshot an incremental one follows, 0 otherwise
+ *   40  sections: char tag[4], u32 length, data
+ *         "CPU " registers and core state
+ *         "MODL" module name, NUL, the module's save() data
+ *         "PAGE" u32 address, MEMORY_PAGE_SIZE bytes
+ *
+ * Pages are tracked through the page table: after a snapshot every RAM/ROM
+ * page is write protected (whost NULL, see sim_page_whost()), and the write
+ * that finds it protected marks it dirty (sim_page_written(), simulator.c).
+ * The same write adds the page to the list of pages to restore on
+ * simulator_reset_to_baseline().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/simulator.h"
+#include "../include/simulator_internal.h"
+
+#define SNAPSHOT_HEADER_SIZE    40
+#define SECTION_HEADER_SIZE     8
+
+static const uint8_t snapshot_magic[8] = { 'E', 'V', 'M', 'S', 'N', 'A', 'P', 0 };
+
+/* Buffer being written, or section being read */
+struct simulator_snapshot {
+    uint8_t *data;
+    size_t len;
+    size_t size;                    /* Allocated (writing) */
+    size_t pos;                     /* Read position (reading) */
+    int error;
+};
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_le64(const uint8_t *p)
+{
+    return (uint64_t)get_le32(p) | (uint64_t)get_le32(p + 4) << 32;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_le64(uint8_t *p, uint64_t v)
+{
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+/* ============================================================================
+ * Module data
+ * ============================================================================ */
+
+void simulator_snapshot_put(simulator_snapshot_t *snap, const void *data, size_t len)
+{
+    if (snap->error) return;
+
+    if (snap->len + len > snap->size) {
+        size_t size = snap->size ? snap->size : 65536;
+        while (size < snap->len + len) size *= 2;
+
+        uint8_t *p = (uint8_t *)realloc(snap->data, size);
+        if (p == NULL) {
+            snap->error = 1;
+            return;
+        }
+        snap->data = p;
+        snap->size = size;
+    }
+    memcpy(snap->data + snap->len, data, len);
+    snap->len += len;
+}
+
+void simulator_snapshot_put32(simulator_snapshot_t *snap, uint32_t value)
+{
+    uint8_t b[4];
+    put_le32(b, value);
+    simulator_snapshot_put(snap, b, sizeof(b));
+}
+
+void simulator_snapshot_put64(simulator_snapshot_t *snap, uint64_t value)
+{
+    uint8_t b[8];
+    put_le64(b, value);
+    simulator_snapshot_put(snap, b, sizeof(b));
+}
+
+void simulator_snapshot_get(simulator_snapshot_t *snap, void *data, size_t len)
+{
+    if (snap->error || len > snap->len - snap->pos) {
+        snap->error = 1;
+        memset(data, 0, len);
+        return;
+    }
+    memcpy(data, snap->data + snap->pos, len);
+    snap->pos += len;
+}
+
+uint32_t simulator_snapshot_get32(simulator_snapshot_t *snap)
+{
+    uint8_t b[4];
+    simulator_snapshot_get(snap, b, sizeof(b));
+    return get_le32(b);
+}
+
+uint64_t simulator_snapshot_get64(simulator_snapshot_t *snap)
+{
+    uint8_t b[8];
+    simulator_snapshot_get(snap, b, sizeof(b));
+    return get_le64(b);
+}
+
+/* ============================================================================
+ * Sections
+ * ============================================================================ */
+
+/* Start a section, returns its offset for section_end() */
+static size_t section_begin(simulator_snapshot_t *snap, const char *tag)
+{
+    size_t offset = snap->len;
+    uint8_t header[SECTION_HEADER_SIZE] = { 0 };
+
+    memcpy(header, tag, 4);
+    simulator_snapshot_put(snap, header, sizeof(header));
+    return offset;
+}
+
+static void section_end(simulator_snapshot_t *snap, size_t offset)
+{
+    if (!snap->error) {
+        put_le32(snap->data + offset + 4, (uint32_t)(snap->len - offset - SECTION_HEADER_SIZE));
+    }
+}
+
+static void save_cpu(simulator_snapshot_t *snap, simulator_t *sim)
+{
+    const simulator_cpu_state_t *cpu = &sim->cpu;
+    const cpu_core_t *core = &SIM_PRIV(sim)->core;
+
+    simulator_snapshot_put32(snap, cpu->sr);
+    for (int i = 0; i < 8; i++) simulator_snapshot_put32(snap, cpu->d[i]);
+    for (int i = 0; i < 8; i++) simulator_snapshot_put32(snap, cpu->a[i]);
+    simulator_snapshot_put32(snap, cpu->pc);
+    simulator_snapshot_put32(snap, cpu->ssp);
+    simulator_snapshot_put32(snap, cpu->usp);
+    simulator_snapshot_put32(snap, cpu->msp);
+    simulator_snapshot_put32(snap, cpu->sfc);
+    simulator_snapshot_put32(snap, cpu->dfc);
+    simulator_snapshot_put32(snap, cpu->vbr);
+    simulator_snapshot_put32(snap, cpu->cacr);
+    simulator_snapshot_put32(snap, cpu->caar);
+    simulator_snapshot_put64(snap, cpu->cycles);
+
+    simulator_snapshot_put32(snap, (uint32_t)core->bStopped);
+    simulator_snapshot_put32(snap, (uint32_t)core->halted);
+    simulator_snapshot_put32(snap, core->num_irqs);
+    simulator_snapshot_put32(snap, (uint32_t)core->fault_pc);
+    simulator_snapshot_put32(snap, (uint32_t)core->irq.ipl);
+    simulator_snapshot_put32(snap, (uint32_t)core->irq.VecNum);
+    simulator_snapshot_put32(snap, (uint32_t)core->irq.bNonAutoVector);
+}
+
+static void load_cpu(simulator_snapshot_t *snap, simulator_t *sim)
+{
+    simulator_cpu_state_t *cpu = &sim->cpu;
+    cpu_core_t *core = &SIM_PRIV(sim)->core;
+
+    cpu->sr = (uint16_t)simulator_snapshot_get32(snap);
+    for (int i = 0; i < 8; i++) cpu->d[i] = simulator_snapshot_get32(snap);
+    for (int i = 0; i < 8; i++) cpu->a[i] = simulator_snapshot_get32(snap);
+    cpu->pc = simulator_snapshot_get32(snap);
+    cpu->ssp = simulator_snapshot_get32(snap);
+    cpu->usp = simulator_snapshot_get32(snap);
+    cpu->msp = simulator_snapshot_get32(snap);
+    cpu->sfc = simulator_snapshot_get32(snap);
+    cpu->dfc = simulator_snapshot_get32(snap);
+    cpu->vbr = simulator_snapshot_get32(snap);
+    cpu->cacr = simulator_snapshot_get32(snap);
+    cpu->caar = simulator_snapshot_get32(snap);
+    cpu->cycles = simulator_snapshot_get64(snap);
+
+    core->bStopped = (int)simulator_snapshot_get32(snap);
+    core->halted = (int)simulator_snapshot_get32(snap);
+    core->num_irqs = simulator_snapshot_get32(snap);
+    core->fault_pc = (long)simulator_snapshot_get32(snap);
+    core->irq.ipl = (int)simulator_snapshot_get32(snap);
+    core->irq.VecNum = (int)simulator_snapshot_get32(snap);
+    core->irq.bNonAutoVector = (int)simulator_snapshot_get32(snap);
+}
+
+/* Write protect all RAM/ROM pages: the next snapshot starts from here */
+static void protect_pages(simulator_t *sim)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    memory_page_t *memory_map = priv->core.memory_map;
+
+    for (int i = 0; i < MEMORY_MAP_SIZE; i++) {
+        if (memory_map[i].host) {
+            priv->page_clean[i] |= SIM_PAGE_CLEAN_SNAPSHOT;
+            memory_map[i].whost = NULL;
+        }
+    }
+}
+
+static simulator_module_t *find_module(simulator_t *sim, const char *name)
+{
+    for (int i = 0; i < sim->num_modules; i++) {
+        if (sim->modules[i]->name && strcmp(sim->modules[i]->name, name) == 0) {
+            return sim->modules[i];
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+/**
+ * Save the machine state
+ */
+void *simulator_snapshot_save(simulator_t *sim, int flags, size_t *len)
+{
+    if (sim == NULL || len == NULL) return NULL;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    const memory_page_t *memory_map = priv->core.memory_map;
+    simulator_snapshot_t snap = { 0 };
+    uint8_t header[SNAPSHOT_HEADER_SIZE] = { 0 };
+    size_t section;
+
+    /* Nothing to be incremental to yet */
+    if (priv->snapshot_id == 0) flags &= ~SIM_SNAPSHOT_INCREMENTAL;
+
+    memcpy(header, snapshot_magic, sizeof(snapshot_magic));
+    put_le32(header + 8, SIM_SNAPSHOT_VERSION);
+    put_le32(header + 12, (uint32_t)flags);
+    if (flags & SIM_SNAPSHOT_INCREMENTAL) {
+        put_le64(header + 32, priv->snapshot_id);
+    }
+    simulator_snapshot_put(&snap, header, sizeof(header));
+
+    section = section_begin(&snap, "CPU ");
+    save_cpu(&snap, sim);
+    section_end(&snap, section);
+
+    for (int i = 0; i < sim->num_modules; i++) {
+        simulator_module_t *mod = sim->modules[i];
+
+        if (mod->save == NULL || mod->name == NULL) continue;
+        section = section_begin(&snap, "MODL");
+        simulator_snapshot_put(&snap, mod->name, strlen(mod->name) + 1);
+        if (mod->save(mod, &snap) != 0) snap.error = 1;
+        section_end(&snap, section);
+    }
+
+    for (uint32_t i = 0; i < MEMORY_MAP_SIZE; i++) {
+        if (memory_map[i].host == NULL) continue;
+        if ((flags & SIM_SNAPSHOT_INCREMENTAL) && (priv->page_clean[i] & SIM_PAGE_CLEAN_SNAPSHOT)) continue;
+
+        section = section_begin(&snap, "PAGE");
+        simulator_snapshot_put32(&snap, i << MEMORY_PAGE_SHIFT);
+        simulator_snapshot_put(&snap, memory_map[i].host, MEMORY_PAGE_SIZE);
+        section_end(&snap, section);
+    }
+
+    if (snap.error) {
+        free(snap.data);
+        return NULL;
+    }
+
+    /* The id covers everything but itself */
+    put_le64(snap.data + 16, snap.len);
+    uint64_t id = simulator_hash(snap.data, snap.len);
+    if (id == 0) id = 1;
+    put_le64(snap.data + 24, id);
+
+    priv->snapshot_id = id;
+    protect_pages(sim);
+
+    *len = snap.len;
+    return snap.data;
+}
+
+/**
+ * Size of the snapshot at data
+ */
+size_t simulator_snapshot_size(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    if (p == NULL || len < SNAPSHOT_HEADER_SIZE ||
+        memcmp(p, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+        return 0;
+    }
+    uint64_t size = get_le64(p + 16);
+    return size >= SNAPSHOT_HEADER_SIZE && size <= SIZE_MAX ? (size_t)size : 0;
+}
+
+/* Check the header, the id and the section structure */
+static int snapshot_check(simulator_t *sim, const uint8_t *p, size_t len)
+{
+    size_t size = simulator_snapshot_size(p, len);
+    sim_hash_t hash;
+    static const uint8_t no_id[8] = { 0 };
+
+    if (size == 0 || size > len) return -1;
+    if (get_le32(p + 8) != SIM_SNAPSHOT_VERSION) {
+        fprintf(stderr, "Snapshot: version %u, expected %u\n", get_le32(p + 8), SIM_SNAPSHOT_VERSION);
+        return -1;
+    }
+
+    sim_hash_init(&hash);
+    sim_hash_update(&hash, p, 24);
+    sim_hash_update(&hash, no_id, sizeof(no_id));
+    sim_hash_update(&hash, p + 32, size - 32);
+    uint64_t id = sim_hash_final(&hash);
+    if ((id ? id : 1) != get_le64(p + 24)) {
+        fprintf(stderr, "Snapshot: checksum mismatch\n");
+        return -1;
+    }
+
+    for (size_t pos = SNAPSHOT_HEADER_SIZE; pos < size; ) {
+        if (size - pos < SECTION_HEADER_SIZE) return -1;
+
+        const uint8_t *tag = p + pos;
+        uint32_t n = get_le32(p + pos + 4);
+        const uint8_t *body = p + pos + SECTION_HEADER_SIZE;
+        if (n > size - pos - SECTION_HEADER_SIZE) return -1;
+
+        if (memcmp(tag, "PAGE", 4) == 0) {
+            if (n != 4 + MEMORY_PAGE_SIZE) return -1;
+            uint32_t page = get_le32(body) >> MEMORY_PAGE_SHIFT;
+            if (page >= MEMORY_MAP_SIZE || SIM_MEMORY_MAP(sim)[page].host == NULL) {
+                fprintf(stderr, "Snapshot: page 0x%06X is not RAM/ROM\n", get_le32(body));
+                return -1;
+            }
+        } else if (memcmp(tag, "MODL", 4) == 0) {
+            const uint8_t *nul = memchr(body, 0, n);
+            if (nul == NULL) return -1;
+            simulator_module_t *mod = find_module(sim, (const char *)body);
+            if (mod == NULL || mod->load == NULL) {
+                fprintf(stderr, "Snapshot: no module '%s'\n", (const char *)body);
+                return -1;
+            }
+        }
+        pos += SECTION_HEADER_SIZE + n;
+    }
+    return 0;
+}
+
+/* Apply the sections of a checked snapshot up to end */
+static int load_sections(simulator_t *sim, const uint8_t *p, size_t end)
+{
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    memory_page_t *memory_map = priv->core.memory_map;
+    int rc = 0;
+
+    /* Modules schedule their events again as they load */
+    sim_events_reset(sim);
+    priv->spin.spinning = 0;
+    priv->stop_reason = SIM_STOPPED_BUDGET;
+
+    for (size_t pos = SNAPSHOT_HEADER_SIZE; pos < end; ) {
+        uint32_t n = get_le32(p + pos + 4);
+        simulator_snapshot_t section = { (uint8_t *)(p + pos + SECTION_HEADER_SIZE), n, 0, 0, 0 };
+
+        if (memcmp(p + pos, "CPU ", 4) == 0) {
+            load_cpu(&section, sim);
+        } else if (memcmp(p + pos, "MODL", 4) == 0) {
+            simulator_module_t *mod = find_module(sim, (const char *)section.data);
+            section.pos = strlen((const char *)section.data) + 1;
+            if (mod->load(mod, &section) != 0) section.error = 1;
+        } else if (memcmp(p + pos, "PAGE", 4) == 0) {
+            uint32_t page = get_le32(section.data) >> MEMORY_PAGE_SHIFT;
+
+            /* Drops the page's cached code, marks it for the baseline */
+            if (memory_map[page].whost == NULL) {
+                sim_page_written(sim, page);
+            }
+            memcpy(memory_map[page].host, section.data + 4, MEMORY_PAGE_SIZE);
+        }
+        /* Unknown sections are skipped */
+
+        if (section.error) {
+            fprintf(stderr, "Snapshot: bad '%.4s' section\n", (const char *)(p + pos));
+            rc = -1;
+        }
+        pos += SECTION_HEADER_SIZE + n;
+    }
+    return rc;
+}
+
+/**
+ * Restore the machine state
+ */
+int simulator_snapshot_load(simulator_t *sim, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    if (sim == NULL || snapshot_check(sim, p, len) != 0) return -1;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    memory_page_t *memory_map = priv->core.memory_map;
+    size_t size = (size_t)get_le64(p + 16);
+    uint64_t parent = get_le64(p + 32);
+
+    /* Pages missing from an incremental snapshot must still hold its parent */
+    if (get_le32(p + 12) & SIM_SNAPSHOT_INCREMENTAL) {
+        int dirty = 0;
+        for (int i = 0; i < MEMORY_MAP_SIZE; i++) {
+            if (memory_map[i].host && !(priv->page_clean[i] & SIM_PAGE_CLEAN_SNAPSHOT)) dirty = 1;
+        }
+        if (parent != priv->snapshot_id || dirty) {
+            fprintf(stderr, "Snapshot: does not follow the current state\n");
+            return -1;
+        }
+    }
+
+    int rc = load_sections(sim, p, size);
+
+    priv->snapshot_id = get_le64(p + 24);
+    protect_pages(sim);
+    return rc;
+}
+
+/* ============================================================================
+ * Baseline
+ *
+ * The baseline is a full snapshot kept by the simulator, with the offset of
+ * each page's data in it. Resetting to it copies back only the pages listed
+ * in baseline_dirty, then loads the CPU and module sections, which come
+ * before the pages.
+ * ============================================================================ */
+
+/**
+ * Make the current state the baseline
+ */
+int simulator_set_baseline(simulator_t *sim)
+{
+    if (sim == NULL) return -1;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    size_t len;
+    uint8_t *p = (uint8_t *)simulator_snapshot_save(sim, 0, &len);
+    uint32_t *pages = (uint32_t *)calloc(MEMORY_MAP_SIZE, sizeof(*pages));
+
+    if (p == NULL || pages == NULL) {
+        free(p);
+        free(pages);
+        return -1;
+    }
+
+    free(priv->baseline);
+    free(priv->baseline_pages);
+    priv->baseline = p;
+    priv->baseline_pages = pages;
+    priv->baseline_state = len;
+
+    for (size_t pos = SNAPSHOT_HEADER_SIZE; pos < len; pos += SECTION_HEADER_SIZE + get_le32(p + pos + 4)) {
+        if (memcmp(p + pos, "PAGE", 4) != 0) continue;
+
+        uint32_t page = get_le32(p + pos + SECTION_HEADER_SIZE) >> MEMORY_PAGE_SHIFT;
+        if (priv->baseline_state == len) priv->baseline_state = pos;
+        pages[page] = (uint32_t)(pos + SECTION_HEADER_SIZE + 4);
+        priv->page_clean[page] |= SIM_PAGE_CLEAN_BASELINE;
+    }
+    priv->num_baseline_dirty = 0;
+    return 0;
+}
+
+/**
+ * Go back to the baseline
+ */
+int simulator_reset_to_baseline(simulator_t *sim)
+{
+    if (sim == NULL || SIM_PRIV(sim)->baseline == NULL) return -1;
+
+    simulator_priv_t *priv = SIM_PRIV(sim);
+    memory_page_t *memory_map = priv->core.memory_map;
+
+    for (uint32_t i = 0; i < priv->num_baseline_dirty; i++) {
+        uint32_t page = priv->baseline_dirty[i];
+        uint32_t offset = priv->baseline_pages[page];
+
+        if (memory_map[page].host == NULL || offset == 0) continue;
+
+        /* Drops the page's cached code */
+        if (memory_map[page].whost == NULL) {
+            sim_icache_invalidate_page(sim, page);
+        }
+        memcpy(memory_map[page].host, priv->baseline + offset, MEMORY_PAGE_SIZE);
+        priv->page_clean[page] = SIM_PAGE_CLEAN_SNAPSHOT | SIM_PAGE_CLEAN_BASELINE;
+        memory_map[page].whost = NULL;
+    }
+    priv->num_baseline_dirty = 0;
+
+    priv->snapshot_id = get_le64(priv->baseline + 24);
+    return load_sections(sim, priv->baseline, priv->baseline_state);
+}
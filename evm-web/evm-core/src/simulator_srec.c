@@ -0,0 +1,326 @@
+/*
+ * simulator_srec.c
+ *
+ * Streaming S-record loader for the EVM simulator
+ * The image is fed in chunks of any size (file reads, a download), split
+ * into records, checked against the record checksums and written to memory.
+ * Contiguous data records are collected and written as one block.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/simulator.h"
+#include "../include/simulator_internal.h"
+
+/* Longest record: "S", type, 255 bytes as hex */
+#define SREC_MAX_LINE   (4 + 2 * 255)
+
+/* Data collected before it is written */
+#define SREC_RUN_SIZE   4096
+
+struct simulator_srec {
+    simulator_t *sim;
+    uint32_t entry;
+    unsigned line_no;
+    int error;
+    int after_cr;           /* Last chunk ended in CR, skip an LF */
+
+    /* Start of a record split across two chunks */
+    size_t partial;
+    char line[SREC_MAX_LINE];
+
+    /* Contiguous data not written yet */
+    uint32_t run_addr;
+    size_t run_len;
+    uint8_t run[SREC_RUN_SIZE];
+
+    /* What was written and fed so far, for simulator_srec_image() */
+    simulator_segment_t *segs;
+    int num_segs;
+    int max_segs;
+    sim_hash_t hash;
+};
+
+/* ============================================================================
+ * Hex decoding
+ * ============================================================================ */
+
+/* Digit value + 1, 0 for anything that is not a hex digit */
+#define HEX(c, v) [c] = (v) + 1
+static const uint8_t hex_digit[256] = {
+    HEX('0', 0), HEX('1', 1), HEX('2', 2), HEX('3', 3), HEX('4', 4),
+    HEX('5', 5), HEX('6', 6), HEX('7', 7), HEX('8', 8), HEX('9', 9),
+    HEX('A', 10), HEX('B', 11), HEX('C', 12), HEX('D', 13), HEX('E', 14), HEX('F', 15),
+    HEX('a', 10), HEX('b', 11), HEX('c', 12), HEX('d', 13), HEX('e', 14), HEX('f', 15),
+};
+#undef HEX
+
+/* Decode n bytes of hex, returns -1 on a bad digit */
+static int hex_decode(const char *p, uint8_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        unsigned hi = hex_digit[(uint8_t)p[2 * i]];
+        unsigned lo = hex_digit[(uint8_t)p[2 * i + 1]];
+        if (hi == 0 || lo == 0) return -1;
+        out[i] = (uint8_t)(((hi - 1) << 4) | (lo - 1));
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Records
+ * ============================================================================ */
+
+/* Note a written range, extending the last segment if it follows on */
+static void srec_segment(simulator_srec_t *srec, uint32_t addr, uint32_t len)
+{
+    if (srec->num_segs > 0) {
+        simulator_segment_t *last = &srec->segs[srec->num_segs - 1];
+        if (last->addr + last->size == addr) {
+            last->size += len;
+            return;
+        }
+    }
+    if (srec->num_segs == srec->max_segs) {
+        int max = srec->max_segs ? 2 * srec->max_segs : 16;
+        simulator_segment_t *segs = (simulator_segment_t *)realloc(srec->segs, max * sizeof(*segs));
+        if (segs == NULL) {
+            srec->error = 1;
+            return;
+        }
+        srec->segs = segs;
+        srec->max_segs = max;
+    }
+    srec->segs[srec->num_segs].addr = addr;
+    srec->segs[srec->num_segs].size = len;
+    srec->num_segs++;
+}
+
+static void srec_flush(simulator_srec_t *srec)
+{
+    if (srec->run_len > 0) {
+        simulator_write_block(srec->sim, srec->run_addr, srec->run, srec->run_len);
+        srec_segment(srec, srec->run_addr, (uint32_t)srec->run_len);
+        srec->run_len = 0;
+    }
+}
+
+static void srec_data(simulator_srec_t *srec, uint32_t addr, const uint8_t *data, size_t len)
+{
+    if (srec->run_len > 0 &&
+        (addr != srec->run_addr + srec->run_len || srec->run_len + len > SREC_RUN_SIZE)) {
+        srec_flush(srec);
+    }
+    if (srec->run_len == 0) {
+        srec->run_addr = addr;
+    }
+    memcpy(srec->run + srec->run_len, data, len);
+    srec->run_len += len;
+}
+
+/* Decode one record, returns -1 if it is malformed or fails its checksum */
+static int srec_record(simulator_srec_t *srec, const char *p, size_t n)
+{
+    uint8_t bytes[256];
+    uint8_t count;
+    unsigned sum;
+
+    if (n < 4 || p[0] != 'S') return -1;
+
+    /* The header is only a comment, and not every tool gets it right */
+    if (p[1] == '0') return 0;
+    if (hex_decode(p + 2, &count, 1) != 0 || count == 0) return -1;
+    if (n < 4 + 2 * (size_t)count || hex_decode(p + 4, bytes, count) != 0) return -1;
+
+    /* Count, address and data add up to 0xFF with the checksum */
+    sum = count;
+    for (unsigned i = 0; i < count; i++) {
+        sum += bytes[i];
+    }
+    if ((sum & 0xFF) != 0xFF) return -1;
+
+    switch (p[1]) {
+        case '5':   /* Record counts */
+        case '6':
+            return 0;
+
+        case '1':   /* Data with 16, 24 or 32 bit address */
+        case '2':
+        case '3': {
+            unsigned addr_len = (unsigned)(p[1] - '0') + 1;
+            uint32_t addr = 0;
+
+            if (count < addr_len + 1) return -1;
+            for (unsigned i = 0; i < addr_len; i++) {
+                addr = (addr << 8) | bytes[i];
+            }
+            srec_data(srec, addr, bytes + addr_len, count - addr_len - 1);
+            return 0;
+        }
+
+        case '7':   /* Entry point; some tools write a short address field */
+        case '8':
+        case '9':
+            srec->entry = 0;
+            for (unsigned i = 0; i + 1 < count; i++) {
+                srec->entry = (srec->entry << 8) | bytes[i];
+            }
+            return 0;
+    }
+    return -1;
+}
+
+/* First CR or LF, NULL if the line goes on in the next chunk */
+static const char *find_eol(const char *p, const char *end)
+{
+    while (p < end && *p != '\n' && *p != '\r') {
+        p++;
+    }
+    return p < end ? p : NULL;
+}
+
+/* Handle one line, blank lines are skipped */
+static void srec_line(simulator_srec_t *srec, const char *p, size_t n)
+{
+    srec->line_no++;
+    while (n > 0 && (p[n - 1] == ' ' || p[n - 1] == '\t')) {
+        n--;
+    }
+    if (n > 0 && srec_record(srec, p, n) != 0) {
+        fprintf(stderr, "S-record line %u: bad record\n", srec->line_no);
+        srec->error = 1;
+    }
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+/**
+ * Start loading an S-record image
+ */
+simulator_srec_t *simulator_srec_begin(simulator_t *sim)
+{
+    if (sim == NULL) return NULL;
+
+    simulator_srec_t *srec = (simulator_srec_t *)calloc(1, sizeof(*srec));
+    if (srec == NULL) return NULL;
+
+    srec->sim = sim;
+    srec->entry = SIM_SREC_NO_ENTRY;
+    sim_hash_init(&srec->hash);
+    return srec;
+}
+
+/**
+ * Feed the next chunk of an S-record image
+ *
+ * Complete lines are decoded straight from the chunk; only a line split
+ * across two chunks is copied.
+ */
+int simulator_srec_feed(simulator_srec_t *srec, const void *data, size_t len)
+{
+    if (srec == NULL || (data == NULL && len > 0)) return -1;
+
+    const char *p = (const char *)data;
+    const char *end = p + len;
+
+    sim_hash_update(&srec->hash, data, len);
+
+    while (p < end && !srec->error) {
+        if (srec->after_cr) {
+            srec->after_cr = 0;
+            if (*p == '\n') {
+                p++;
+                continue;
+            }
+        }
+
+        const char *eol = find_eol(p, end);
+        size_t n = (size_t)((eol ? eol : end) - p);
+
+        if (srec->partial + n > SREC_MAX_LINE) {
+            fprintf(stderr, "S-record line %u: too long\n", srec->line_no + 1);
+            srec->error = 1;
+            break;
+        }
+        if (eol == NULL) {
+            /* Rest of the chunk: keep it for the next one */
+            memcpy(srec->line + srec->partial, p, n);
+            srec->partial += n;
+            break;
+        }
+
+        if (srec->partial > 0) {
+            memcpy(srec->line + srec->partial, p, n);
+            srec_line(srec, srec->line, srec->partial + n);
+            srec->partial = 0;
+        } else {
+            srec_line(srec, p, n);
+        }
+
+        /* CR LF ends one line, not two */
+        p = eol + 1;
+        if (*eol == '\r') {
+            if (p == end) {
+                srec->after_cr = 1;
+            } else if (*p == '\n') {
+                p++;
+            }
+        }
+    }
+
+    return srec->error ? -1 : 0;
+}
+
+/**
+ * Finish loading and free the loader
+ */
+int simulator_srec_end(simulator_srec_t *srec, uint32_t *entry)
+{
+    if (srec == NULL) return -1;
+
+    /* Last line without a line break */
+    if (srec->partial > 0 && !srec->error) {
+        srec_line(srec, srec->line, srec->partial);
+    }
+    srec_flush(srec);
+
+    int rc = srec->error ? -1 : 0;
+    if (entry) *entry = srec->entry;
+    free(srec->segs);
+    free(srec);
+    return rc;
+}
+
+/**
+ * Memory image of everything loaded so far
+ */
+void *simulator_srec_image(simulator_srec_t *srec, size_t *len)
+{
+    if (srec == NULL || srec->error) return NULL;
+
+    /* The image is read back from memory, so everything must be there */
+    if (srec->partial > 0) {
+        srec_line(srec, srec->line, srec->partial);
+        srec->partial = 0;
+    }
+    srec_flush(srec);
+    if (srec->error) return NULL;
+
+    return simulator_image_build(srec->sim, srec->segs, srec->num_segs, srec->entry,
+                                 sim_hash_final(&srec->hash), len);
+}
+
+/**
+ * Load a complete S-record image from memory
+ */
+int simulator_load_srec(simulator_t *sim, const void *data, size_t len, uint32_t *entry)
+{
+    simulator_srec_t *srec = simulator_srec_begin(sim);
+    if (srec == NULL) return -1;
+
+    simulator_srec_feed(srec, data, len);
+    return simulator_srec_end(srec, entry);
+}
@@ -9,6 +9,7 @@
 #include "STMEM.H"   // high level memory handling
 #include "STSTDDEF.H" // standard defines
 #include "STCOM.H"   // global simulation stuff (variables etc...)
+#include "cpu_ea.h"  // inline EA templates (modes 000-101)
 
 ///////////////////////////////////////////////////////////////////////////
 //              EA calculation
@@ -25,8 +26,16 @@
 // Its purpose is the decoding of the effective address of the operation
 // via the related mode fields in the opcode and return the associated
 // data or write it to the right address in memory.
+// Every mode also adds its MC68020 cache case EA calculation time to
+// REGS.cycles, the opcode's own time comes from cpu_opcode_cycles().
 ///////////////////////////////////////////////////////////////////////////
 
+// EA calculation clock cycles, (An) to (d16,An) are in cpu_ea.h
+#define EACYCLES_ARII		4	// (d8,An,Xn)
+#define EACYCLES_FULL	5	// additional for 68020 full extension word formats
+// mode 111: (xxx).W (xxx).L (d16,PC) (d8,PC,Xn) #<data>
+static const unsigned char EACyclesMisc[8]={3,4,3,4,0,0,0,0};
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // NAME:				long DRD(char reg,char command,long destination,char size)
@@ -41,34 +50,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 long DRD(char reg,char command,long destination,char size)
 {
-	if(command==READ) // do we read or write anything
-	{
-		switch(size)
-		{
-			case 0:
-				return cpu.dregs.byted[reg].dll;
-			case 1:
-				return cpu.dregs.wordd[reg].dl;
-			case 2:
-				return cpu.dregs.d[reg];
-		}
-	}
-	else
-	{
-		switch(size)
-		{
-			case 0:
-				cpu.dregs.byted[reg].dll=(char)(destination);
-				break;
-			case 1:
-				cpu.dregs.wordd[reg].dl=(short)(destination);
-				break;
-			case 2:
-				cpu.dregs.d[reg]=destination;
-				break;
-		}
-		return 0;
-	}
+	return ea_drd(reg,command,destination,size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -84,34 +66,7 @@ long DRD(char reg,char command,long destination,char size)
 ////////////////////////////////////////////////////////////////////////////////
 long ARD(char reg,char command,long destination,char size)
 {
-	switch(command)
-	{
-		case READ:
-			switch(size)
-			{
-				case 0:
-					return cpu.aregs.bytea[reg].all;
-				case 1:
-					return cpu.aregs.worda[reg].al;
-				case 2:
-					return cpu.aregs.a[reg];
-			}
-			break;
-		case WRITE:
-			switch(size)
-			{
-				case 0:
-					cpu.aregs.bytea[reg].all=(char)(destination);
-					break;
-				case 1:
-					cpu.aregs.worda[reg].al=(short)(destination);
-					break;
-				case 2:
-					cpu.aregs.a[reg]=destination;
-					break;
-			}
-			break;
-	}
+	return ea_ard(reg,command,destination,size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -127,40 +82,7 @@ long ARD(char reg,char command,long destination,char size)
 ////////////////////////////////////////////////////////////////////////////////
 long ARI(char reg,char command,long destination,char size)
 {
-	switch(size)
-	{
-		case 0:
-			switch(command)
-			{
-				case READ:
-					return (GETbyte(cpu.aregs.a[reg]));
-				case WRITE:
-					PUTbyte(cpu.aregs.a[reg],(char)destination);
-					break;
-			}
-			break;
-		case 1:
-			switch(command)
-			{
-				case READ:
-					return (GETword(cpu.aregs.a[reg]));
-				case WRITE:
-					PUTword(cpu.aregs.a[reg],(short)destination);
-					break;
-			}
-			break;
-		case 2:
-			switch(command)
-			{
-				case READ:
-					return (GETdword(cpu.aregs.a[reg]));
-				case WRITE:
-					PUTdword(cpu.aregs.a[reg],destination);
-					break;
-			}
-			break;
-  }
-  return 0L;
+	return ea_ari(reg,command,destination,size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -177,23 +99,7 @@ long ARI(char reg,char command,long destination,char size)
 ////////////////////////////////////////////////////////////////////////////////
 long ARIPI(char reg,char command,long destination,char size)
 {
-
-	switch(command)
-	{
-		case READ:
-			cpu.aregs.a[reg]=cpu.aregs.a[reg]+(1<<size);
-			break;
-		case WRITE:
-			if(size==SIZE_BYTE)PUTbyte(cpu.aregs.a[reg],(char)destination);
-			else if(size==SIZE_WORD)PUTword(cpu.aregs.a[reg],(short)destination);
-			else PUTdword(cpu.aregs.a[reg],destination);
-			cpu.aregs.a[reg]=cpu.aregs.a[reg]+(1<<size);
-			break;
-	}
-	if(size==SIZE_BYTE)return (GETbyte(cpu.aregs.a[reg]-(1<<size)));
-	else if(size==SIZE_WORD)return (GETword(cpu.aregs.a[reg]-(1<<size)));
-	else if(size==SIZE_DWORD)return (GETdword(cpu.aregs.a[reg]-(1<<size)));
-	else return 0;
+	return ea_aripi(reg,command,destination,size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -210,40 +116,7 @@ long ARIPI(char reg,char command,long destination,char size)
 ////////////////////////////////////////////////////////////////////////////////
 long ARIPD(char reg,char command,long destination,char size)
 {
-static long spc=0;
-
-	switch(command)
-	{
-		case READ:
-			cpu.aregs.a[reg]=cpu.aregs.a[reg]-(1<<size);
-			spc=cpu.pc;
-			break;
-		case WRITE:
-			// PATCH
-			// if source and destination register are the same
-			// this would cause wrong increment
-			// so, check first if this is true
-			// by comparing the PC before and after
-			// maybe better yet, compare reg,size etc. too
-			if(cpu.pc!=spc)
-			{
-				cpu.aregs.a[reg]=cpu.aregs.a[reg]-(1<<size);
-			}
-			if(size==SIZE_BYTE)PUTbyte(cpu.aregs.a[reg],(char)destination);
-			else if(size==SIZE_WORD)PUTword(cpu.aregs.a[reg],(short)destination);
-			else if(size==SIZE_DWORD)PUTdword(cpu.aregs.a[reg],destination);
-			break;
-	}
-	switch(size)
-	{
-		case 0:
-			return (GETbyte(cpu.aregs.a[reg]));
-		case 1:
-			return (GETword(cpu.aregs.a[reg]));
-		case 2:
-			return (GETdword(cpu.aregs.a[reg]));
-	}
-	return 0;
+	return ea_aripd(reg,command,destination,size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -260,47 +133,7 @@ static long spc=0;
 ////////////////////////////////////////////////////////////////////////////////
 long ARID(char reg,char command,long destination,char size)
 {
-	switch(size)
-	{
-		case 0:
-			switch(command)
-			{
-				case READ:
-					cpu.pc=cpu.pc+2;
-					return (GETbyte(cpu.aregs.a[reg]+(long)GETword(cpu.pc-2)));
-				case WRITE:
-					cpu.pc=cpu.pc+2;
-					PUTbyte(cpu.aregs.a[reg]+(long)GETword(cpu.pc-2),(short)destination);
-					break;
-			}
-		break;
-		case 1:
-			switch(command)
-			{
-				case READ:
-					cpu.pc=cpu.pc+2;
-					return (GETword(cpu.aregs.a[reg]+(long)(GETword(cpu.pc-2))));
-				case WRITE:
-					cpu.pc=cpu.pc+2;
-					PUTword(cpu.aregs.a[reg]+(long)(GETword(cpu.pc-2)),(short)destination);
-					break;
-			}
-		break;
-		case 2:
-			switch(command)
-			{
-				case READ:
-					cpu.pc=cpu.pc+2;
-					return (GETdword(cpu.aregs.a[reg]+(long)(GETword(cpu.pc-2))));
-				case WRITE:
-					cpu.pc=cpu.pc+2;
-					PUTdword(cpu.aregs.a[reg]+(long)(GETword(cpu.pc-2)),destination);
-					break;
-			}
-		break;
-
-	}
-	return 0L;
+	return ea_arid(reg,command,destination,size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -317,10 +150,11 @@ long ARID(char reg,char command,long destination,char size)
 ////////////////////////////////////////////////////////////////////////////////
 long ARII(char reg,char command,long destination,char size)
 {
-static long indexreg,bd,od,ea;
-static unsigned short extension,scale;
+long indexreg=0,bd,od,ea;
+unsigned short extension,scale;
 
-	extension=GETword(cpu.pc);  // 16 bit extension
+	extension=GETword(REGS.pc);  // 16 bit extension
+	REGS.cycles+=(extension&0x0100)?EACYCLES_ARII+EACYCLES_FULL:EACYCLES_ARII;
 	switch((extension>>9)&0x0003)  // retreive scaling of index reg
 	{
 		case 0:
@@ -332,7 +166,7 @@ static unsigned short extension,scale;
 		case 2:
 			scale=4;
 			break;
-		case 4:
+		case 3:
 			scale=8;
 			break;
 	}
@@ -341,16 +175,16 @@ static unsigned short extension,scale;
 		switch(extension&0x8800)
 		{
 			case 0x0000: // index=Dn index size=word
-				indexreg=(long)(cpu.dregs.d[(extension&0x7000)>>12]&0x0000FFFF);
+				indexreg=(long)(REGS.dregs.d[(extension&0x7000)>>12]&0x0000FFFF);
 				break;
 			case 0x8000: // index=An index size=word
-				indexreg=(long)(cpu.aregs.a[(extension&0x7000)>>12]&0x0000FFFF);
+				indexreg=(long)(REGS.aregs.a[(extension&0x7000)>>12]&0x0000FFFF);
 				break;
 			case 0x0800: // index=Dn index size=long
-				indexreg=cpu.dregs.d[(extension&0x7000)>>12];
+				indexreg=REGS.dregs.d[(extension&0x7000)>>12];
 				break;
 			case 0x8800: // index=An index size=long
-				indexreg=cpu.aregs.a[(extension&0x7000)>>12];
+				indexreg=REGS.aregs.a[(extension&0x7000)>>12];
 				break;
 		}
 
@@ -361,11 +195,11 @@ static unsigned short extension,scale;
 				switch(command)
 				{
 					case READ:
-						cpu.pc=cpu.pc+2;
-						return ( GETbyte( cpu.aregs.a[reg]+ (short)(extension&0x00ff) +indexreg) );
+						REGS.pc=REGS.pc+2;
+						return ( GETbyte( REGS.aregs.a[reg]+ (short)(extension&0x00ff) +indexreg) );
 					case WRITE:
-						cpu.pc=cpu.pc+2;
-						PUTbyte(cpu.aregs.a[reg]+(short)(extension&0x00ff)+indexreg,(char)destination);
+						REGS.pc=REGS.pc+2;
+						PUTbyte(REGS.aregs.a[reg]+(short)(extension&0x00ff)+indexreg,(char)destination);
 						break;
 				}
 			break;
@@ -373,11 +207,11 @@ static unsigned short extension,scale;
 				switch(command)
 				{
 					case READ:
-						cpu.pc=cpu.pc+2;
-						return (GETword(cpu.aregs.a[reg]+(short)(extension&0x00ff)+indexreg));
+						REGS.pc=REGS.pc+2;
+						return (GETword(REGS.aregs.a[reg]+(short)(extension&0x00ff)+indexreg));
 					case WRITE:
-						cpu.pc=cpu.pc+2;
-						PUTword(cpu.aregs.a[reg]+(short)(extension&0x00ff)+indexreg,(short)destination);
+						REGS.pc=REGS.pc+2;
+						PUTword(REGS.aregs.a[reg]+(short)(extension&0x00ff)+indexreg,(short)destination);
 						break;
 				}
 			break;
@@ -385,11 +219,11 @@ static unsigned short extension,scale;
 				switch(command)
 				{
 					case READ:
-						cpu.pc=cpu.pc+2;
-						return (GETdword(cpu.aregs.a[reg]+(short)(extension&0x00ff)+indexreg));
+						REGS.pc=REGS.pc+2;
+						return (GETdword(REGS.aregs.a[reg]+(short)(extension&0x00ff)+indexreg));
 					case WRITE:
-						cpu.pc=cpu.pc+2;
-						PUTdword(cpu.aregs.a[reg]+(short)(extension&0x00ff)+indexreg,destination);
+						REGS.pc=REGS.pc+2;
+						PUTdword(REGS.aregs.a[reg]+(short)(extension&0x00ff)+indexreg,destination);
 						break;
 				}
 			break;
@@ -402,16 +236,16 @@ static unsigned short extension,scale;
 			switch(extension&0x8800)
 			{
 				case 0x0000: // index=Dn index size=word
-					indexreg=(long)(cpu.dregs.d[(extension&0x7000)>>12]&0x0000FFFF);
+					indexreg=(long)(REGS.dregs.d[(extension&0x7000)>>12]&0x0000FFFF);
 					break;
 				case 0x8000: // index=An index size=word
-					indexreg=(long)(cpu.aregs.a[(extension&0x7000)>>12]&0x0000FFFF);
+					indexreg=(long)(REGS.aregs.a[(extension&0x7000)>>12]&0x0000FFFF);
 					break;
 				case 0x0800: // index=Dn index size=long
-					indexreg=cpu.dregs.d[(extension&0x7000)>>12];
+					indexreg=REGS.dregs.d[(extension&0x7000)>>12];
 					break;
 				case 0x8800: // index=An index size=long
-					indexreg=cpu.aregs.a[(extension&0x7000)>>12];
+					indexreg=REGS.aregs.a[(extension&0x7000)>>12];
 					break;
 			}
 			indexreg=indexreg*scale; // scale factor
@@ -421,7 +255,7 @@ static unsigned short extension,scale;
       switch((extension>>7)&0x0001) // BS field
       {
       	case 0: // base register added
-				ea=cpu.aregs.a[reg];
+				ea=REGS.aregs.a[reg];
 	        	break;
          case 1: // base register suppressed
 				ea=0;
@@ -435,12 +269,12 @@ static unsigned short extension,scale;
             bd=0;
             break;
          case 2: // base displacement is one word
-            cpu.pc+=4;
-            bd=(long)GETword(cpu.pc-2);
+            REGS.pc+=4;
+            bd=(long)GETword(REGS.pc-2);
             break;
          case 3: // base displacement is two words
-            cpu.pc+=6;
-            bd=GETdword(cpu.pc-4);
+            REGS.pc+=6;
+            bd=GETdword(REGS.pc-4);
             break;
       }
 
@@ -456,13 +290,13 @@ static unsigned short extension,scale;
 						ea=GETdword(ea+bd+indexreg);
 						break;
 					case 2: // indirect pre-indexed with word displacement
-						od=(long)GETword(cpu.pc);
-						cpu.pc+=2;
+						od=(long)GETword(REGS.pc);
+						REGS.pc+=2;
 						ea=GETdword(ea+bd+indexreg)+od;
 						break;
 					case 3: // indirect pre-indexed with long displacement
-						od=GETdword(cpu.pc);
-						cpu.pc+=4;
+						od=GETdword(REGS.pc);
+						REGS.pc+=4;
 						ea=GETdword(ea+bd+indexreg)+od;
 						break;
 					case 4: // reserved
@@ -471,13 +305,13 @@ static unsigned short extension,scale;
 						ea=GETdword(ea+bd)+indexreg;
 						break;
 					case 6: // indirect post-indexed with word displacement
-						od=(long)GETword(cpu.pc);
-						cpu.pc+=2;
+						od=(long)GETword(REGS.pc);
+						REGS.pc+=2;
 						ea=GETdword(ea+bd)+indexreg+od;
 						break;
 					case 7: // indirect post-indexed with long displacement
-						od=GETdword(cpu.pc);
-						cpu.pc+=4;
+						od=GETdword(REGS.pc);
+						REGS.pc+=4;
 						ea=GETdword(ea+bd)+indexreg+od;
 						break;
 				}
@@ -492,13 +326,13 @@ static unsigned short extension,scale;
 						ea=GETdword(ea+bd);
 						break;
 					case 2: // memory indirect with word displacement
-						od=(long)GETword(cpu.pc);
-						cpu.pc+=2;
+						od=(long)GETword(REGS.pc);
+						REGS.pc+=2;
 						ea=GETdword(ea+bd)+od;
 						break;
 					case 3: // memory indirect with long displacement
-						od=GETdword(cpu.pc);
-						cpu.pc+=4;
+						od=GETdword(REGS.pc);
+						REGS.pc+=4;
 						ea=GETdword(ea+bd)+od;
 						break;
 					case 4: // reserved
@@ -562,6 +396,8 @@ long MISC(char reg,char command,long destination,char size)
 {
 long t1,t2;
 
+	REGS.cycles+=EACyclesMisc[reg&7];
+
 	switch(reg)
 	{
 		case 0: // absolute short
@@ -572,29 +408,29 @@ long t1,t2;
 					switch(size)
                {
                	case 0:
-							cpu.pc=cpu.pc+2;
-							return GETbyte((long)GETword(cpu.pc-2));
+							REGS.pc=REGS.pc+2;
+							return GETbyte((long)GETword(REGS.pc-2));
                	case 1:
-							cpu.pc=cpu.pc+2;
-							return GETword((long)GETword(cpu.pc-2));
+							REGS.pc=REGS.pc+2;
+							return GETword((long)GETword(REGS.pc-2));
                	case 2:
-							cpu.pc=cpu.pc+2;
-							return GETdword((long)GETword(cpu.pc-2));
+							REGS.pc=REGS.pc+2;
+							return GETdword((long)GETword(REGS.pc-2));
                }
 				case WRITE:
             	switch(size)
                {
                	case 0:
-							cpu.pc=cpu.pc+2;
-							PUTbyte((long)GETword(cpu.pc-2),(char)destination);
+							REGS.pc=REGS.pc+2;
+							PUTbyte((long)GETword(REGS.pc-2),(char)destination);
                      break;
                	case 1:
-							cpu.pc=cpu.pc+2;
-							PUTword((long)GETword(cpu.pc-2),(short)destination);
+							REGS.pc=REGS.pc+2;
+							PUTword((long)GETword(REGS.pc-2),(short)destination);
                      break;
                	case 2:
-							cpu.pc=cpu.pc+2;
-							PUTdword((long)GETword(cpu.pc-2),destination);
+							REGS.pc=REGS.pc+2;
+							PUTdword((long)GETword(REGS.pc-2),destination);
                      break;
                }
 					break;
@@ -608,11 +444,11 @@ long t1,t2;
 					switch(command)
 					{
 						case READ:
-							cpu.pc=cpu.pc+4;
-							return GETbyte(GETdword(cpu.pc-4));
+							REGS.pc=REGS.pc+4;
+							return GETbyte(GETdword(REGS.pc-4));
 						case WRITE:
-							cpu.pc=cpu.pc+4;
-							PUTbyte(GETdword(cpu.pc-4),(char)destination);
+							REGS.pc=REGS.pc+4;
+							PUTbyte(GETdword(REGS.pc-4),(char)destination);
 							return destination;
 					}
 					break;
@@ -620,11 +456,11 @@ long t1,t2;
 					switch(command)
 					{
 						case READ:
-							cpu.pc=cpu.pc+4;
-							return (GETword(GETdword(cpu.pc-4)));
+							REGS.pc=REGS.pc+4;
+							return (GETword(GETdword(REGS.pc-4)));
 						case WRITE:
-							cpu.pc=cpu.pc+4;
-							PUTword(GETdword(cpu.pc-4),(short)destination);
+							REGS.pc=REGS.pc+4;
+							PUTword(GETdword(REGS.pc-4),(short)destination);
 							return destination;
 					}
 					break;
@@ -632,11 +468,11 @@ long t1,t2;
 					switch(command)
 					{
 						case READ:
-							cpu.pc=cpu.pc+4;
-							return (GETdword(GETdword(cpu.pc-4)));
+							REGS.pc=REGS.pc+4;
+							return (GETdword(GETdword(REGS.pc-4)));
 						case WRITE:
-							cpu.pc=cpu.pc+4;
-							PUTdword(GETdword(cpu.pc-4),destination);
+							REGS.pc=REGS.pc+4;
+							PUTdword(GETdword(REGS.pc-4),destination);
 							return destination;
 					}
 					break;
@@ -646,28 +482,28 @@ long t1,t2;
 			switch(command)
 			{
 				case READ:
-					cpu.pc=cpu.pc+2;
+					REGS.pc=REGS.pc+2;
                switch(size)
                {
                	case 0:
-							return GETbyte((long)(GETword(cpu.pc-2))+(long)(cpu.pc)-2);
+							return GETbyte((long)(GETword(REGS.pc-2))+(long)(REGS.pc)-2);
                   case 1:
-							return GETword((long)(GETword(cpu.pc-2))+(long)(cpu.pc)-2);
+							return GETword((long)(GETword(REGS.pc-2))+(long)(REGS.pc)-2);
                   case 2:
-							return GETdword((long)(GETword(cpu.pc-2))+(long)(cpu.pc)-2);
+							return GETdword((long)(GETword(REGS.pc-2))+(long)(REGS.pc)-2);
                }
                break;
 				case WRITE:
 					switch(size)
                {
                	case 0:
-							PUTbyte((long)(GETword(cpu.pc-2))+(long)(cpu.pc)-2,(char)destination);
+							PUTbyte((long)(GETword(REGS.pc-2))+(long)(REGS.pc)-2,(char)destination);
                      break;
                   case 1:
-							PUTword((long)(GETword(cpu.pc-2))+(long)(cpu.pc)-2,(short)destination);
+							PUTword((long)(GETword(REGS.pc-2))+(long)(REGS.pc)-2,(short)destination);
                      break;
                   case 2:
-							PUTdword((long)(GETword(cpu.pc-2))+(long)(cpu.pc)-2,destination);
+							PUTdword((long)(GETword(REGS.pc-2))+(long)(REGS.pc)-2,destination);
                      break;
                }
 					break;
@@ -678,13 +514,13 @@ long t1,t2;
 			switch(command)
 			{
 				case READ:
-					cpu.pc=cpu.pc+2;
-					t1=(GETword(cpu.pc-2)&0x00FF);
-					t2=cpu.dregs.d[(GETword(cpu.pc-2)>>12)&0x0007];
-					if((GETword(cpu.pc-2)&0x8000)==0)t2=t2&0x0000FFFF;
-					if(size==SIZE_BYTE)return GETbyte((long)(t1+(long)(cpu.pc)-2+t2));
-					else if(size==SIZE_WORD)return GETword((long)(t1+(long)(cpu.pc)-2+t2));
-					else if(size==SIZE_DWORD)return GETdword((long)(t1+(long)(cpu.pc)-2+t2));
+					REGS.pc=REGS.pc+2;
+					t1=(GETword(REGS.pc-2)&0x00FF);
+					t2=REGS.dregs.d[(GETword(REGS.pc-2)>>12)&0x0007];
+					if((GETword(REGS.pc-2)&0x8000)==0)t2=t2&0x0000FFFF;
+					if(size==SIZE_BYTE)return GETbyte((long)(t1+(long)(REGS.pc)-2+t2));
+					else if(size==SIZE_WORD)return GETword((long)(t1+(long)(REGS.pc)-2+t2));
+					else if(size==SIZE_DWORD)return GETdword((long)(t1+(long)(REGS.pc)-2+t2));
 				case WRITE:
 					break;
 			}
@@ -697,8 +533,8 @@ long t1,t2;
 					switch(command)
 					{
 						case READ:
-							cpu.pc=cpu.pc+2;
-							return (GETword(cpu.pc-2)&0x00FF);
+							REGS.pc=REGS.pc+2;
+							return (GETword(REGS.pc-2)&0x00FF);
 						case WRITE:
 							break;
 					}
@@ -707,8 +543,8 @@ long t1,t2;
 					switch(command)
 					{
 						case READ:
-							cpu.pc=cpu.pc+2;
-							return (GETword(cpu.pc-2));
+							REGS.pc=REGS.pc+2;
+							return (GETword(REGS.pc-2));
 						case WRITE:
 							break;
 					}
@@ -717,8 +553,8 @@ long t1,t2;
 					switch(command)
 					{
 						case READ:
-							cpu.pc=cpu.pc+4;
-							return (GETdword(cpu.pc-4));
+							REGS.pc=REGS.pc+4;
+							return (GETdword(REGS.pc-4));
 						case WRITE:
 							break;
 					}
@@ -10,76 +10,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "simulator.h" // New simulator module interface
+#include "simulator_mem.h" // direct-pointer access to RAM/ROM pages
 #include "STCOM.H"   // CPU core
 #include "STEXEP.H"  // exception handling
 
-// External simulator context (set by cpu_execute_opcode in cpu_core_new.c)
-extern simulator_t *g_sim;
-
-#define MAPPERSIZE (16*1024) // 16*1024 entries in table = 16MB � 1kB pages
-////////////////////////////////////////////////////////////////////////////////
-// globals
-////////////////////////////////////////////////////////////////////////////////
-// function pointer array to READ() procs of plugins
-unsigned long (*fpReadProc[MAPPERSIZE])(unsigned long address,short size);
-// function pointer array to WRITE() procs of plugins
-void (*fpWriteProc[MAPPERSIZE])(unsigned long address,long data,short size);
-
-////////////////////////////////////////////////////////////////////////////////
-// NAME:				int CheckPeriAddr(unsigned long address)
-//
-// DESCRIPTION:	check to which attached module address belongs
-//
-// PARAMETERS:    unsigned long address: address to check
-//
-// RETURNS:       int: index into array fpReadProc[] and fpWriteProc[]
-//
-////////////////////////////////////////////////////////////////////////////////
-int CheckPeriAddr(unsigned long address)
-{
-int index;
-
-	for(index=0;pDllHdr[index]!=0;index++)
-	{
-		if(address>=pDllHdr[index]->nAddress &&
-			 address<(pDllHdr[index]->nAddress+pDllHdr[index]->nSize))return index;
-	}
-	return -1;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// NAME:				void SetupMapperArrays(void)
-//
-// DESCRIPTION:	create two arrays containing READ and WRITE procedure addresses
-// 					for fast access to the attached module procedures
-//
-// PARAMETERS:    none
-//
-// RETURNS:       none
-//
-////////////////////////////////////////////////////////////////////////////////
-void SetupMapperArrays(void)
-{
-short i,index;
-
-	for(i=0;i<(MAPPERSIZE);i++) // for each entry
-	{
-		// any module for that address?
-		if((index=CheckPeriAddr(i*(MAPPERSIZE/16)))!=-1)
-		{
-			// fill in function pointer arrays
-			fpReadProc[i]=(void*)pDllHdr[index]->ReadProc;
-			fpWriteProc[i]=(void*)pDllHdr[index]->WriteProc;
-		}
-		// no module there
-		else
-		{
-			// no address
-			fpReadProc[i]=NULL;
-			fpWriteProc[i]=NULL;
-		}
-	}
-}
+// All accesses go to the memory of the simulator running on this thread
+// (g_sim, g_core)
 
 ////////////////////////////////////////////////////////////////////////////////
 // NAME:          char   GETbyte(unsigned long address)
@@ -93,11 +29,11 @@ short i,index;
 ////////////////////////////////////////////////////////////////////////////////
 char GETbyte(unsigned long address)
 {
+uint8_t *p;
+
 	address&=0x00FFFFFFL;
-	if (g_sim == NULL) {
-		bus_err();
-		return 0L;
-	}
+	// RAM/ROM page: read host memory directly
+	if((p=mem_host_ptr(g_core->memory_map,address,1))!=NULL)return (char)*p;
 	return (BYTE)simulator_read_memory(g_sim, address, 1);
 }
 
@@ -113,11 +49,11 @@ char GETbyte(unsigned long address)
 ////////////////////////////////////////////////////////////////////////////////
 short GETword(unsigned long address)
 {
+uint8_t *p;
+
 	address&=0x00FFFFFFL;
-	if (g_sim == NULL) {
-		bus_err();
-		return 0L;
-	}
+	// RAM/ROM page: single load + byte swap
+	if((p=mem_host_ptr(g_core->memory_map,address,2))!=NULL)return (short)mem_get16(p);
 	return (short)(unsigned long)simulator_read_memory(g_sim, address, 2);
 }
 
@@ -134,11 +70,11 @@ short GETword(unsigned long address)
 ////////////////////////////////////////////////////////////////////////////////
 long GETdword(unsigned long address)
 {
+uint8_t *p;
+
 	address&=0x00FFFFFFL;
-	if (g_sim == NULL) {
-		bus_err();
-		return 0L;
-	}
+	// RAM/ROM page: single load + byte swap
+	if((p=mem_host_ptr(g_core->memory_map,address,4))!=NULL)return (long)mem_get32(p);
 	return simulator_read_memory(g_sim, address, 4);
 }
 
@@ -156,9 +92,13 @@ long GETdword(unsigned long address)
 ////////////////////////////////////////////////////////////////////////////////
 void PUTbyte(unsigned long address,char data)
 {
+uint8_t *p;
+
 	address&=0x00FFFFFFL;
-	if (g_sim == NULL) {
-		bus_err();
+	// RAM/ROM page: write host memory directly
+	if((p=mem_host_wptr(g_core->memory_map,address,1))!=NULL)
+	{
+		*p=(uint8_t)data;
 		return;
 	}
 	simulator_write_memory(g_sim, address, data, 1);
@@ -177,9 +117,13 @@ void PUTbyte(unsigned long address,char data)
 ////////////////////////////////////////////////////////////////////////////////
 void PUTword(unsigned long address,short data)
 {
+uint8_t *p;
+
 	address&=0x00FFFFFFL;
-	if (g_sim == NULL) {
-		bus_err();
+	// RAM/ROM page: byte swap + single store
+	if((p=mem_host_wptr(g_core->memory_map,address,2))!=NULL)
+	{
+		mem_put16(p,(uint16_t)data);
 		return;
 	}
 	simulator_write_memory(g_sim, address, data, 2);
@@ -198,9 +142,13 @@ void PUTword(unsigned long address,short data)
 ////////////////////////////////////////////////////////////////////////////////
 void PUTdword(unsigned long address,long data)
 {
+uint8_t *p;
+
 	address&=0x00FFFFFFL;
-	if (g_sim == NULL) {
-		bus_err();
+	// RAM/ROM page: byte swap + single store
+	if((p=mem_host_wptr(g_core->memory_map,address,4))!=NULL)
+	{
+		mem_put32(p,(uint32_t)data);
 		return;
 	}
 	simulator_write_memory(g_sim, address, data, 4);
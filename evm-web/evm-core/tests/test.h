@@ -0,0 +1,141 @@
+/*
+ * test.h
+ *
+ * Helpers shared by the core tests. Every test is a program that ctest
+ * runs (native CMake build); a failed check prints its file, line and
+ * values to stderr, and the program exits with 1 if any check failed.
+ */
+
+#ifndef EVM_TEST_H
+#define EVM_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simulator.h"
+
+#define TEST_CODE       0x000100    /* Guest programs (ROM) */
+#define TEST_DATA       0x401000    /* Guest data (RAM) */
+#define TEST_STACK      0x410000
+#define TEST_RAM        0x400000
+#define TEST_RAM_SIZE   0x20000
+
+static int test_failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    test_check_eq((unsigned long long)(a), (unsigned long long)(b), #a, #b, __FILE__, __LINE__)
+
+static inline void test_check_eq(unsigned long long a, unsigned long long b,
+                                 const char *sa, const char *sb, const char *file, int line)
+{
+    if (a != b) {
+        fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: 0x%llX != 0x%llX\n",
+                file, line, sa, sb, a, b);
+        test_failures++;
+    }
+}
+
+/* Simulator with the standard modules, UART output dropped */
+static inline simulator_t *test_simulator(void)
+{
+    simulator_t *sim = simulator_init();
+
+    if (sim == NULL || simulator_load_modules(sim) != 0) {
+        fprintf(stderr, "simulator setup failed\n");
+        exit(2);
+    }
+    simulator_set_uart_fd(sim, SIM_UART_A, -1);
+    simulator_set_uart_fd(sim, SIM_UART_B, -1);
+    return sim;
+}
+
+/* Reset vectors (SSP TEST_STACK, PC TEST_CODE) and program at TEST_CODE,
+   then reset */
+static inline void test_load_code(simulator_t *sim, const uint16_t *code, size_t words)
+{
+    static const uint8_t vectors[8] = { 0x00, 0x41, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00 };
+    uint8_t bytes[512];
+
+    if (words > sizeof(bytes) / 2) words = sizeof(bytes) / 2;
+    for (size_t i = 0; i < words; i++) {
+        bytes[2 * i] = (uint8_t)(code[i] >> 8);
+        bytes[2 * i + 1] = (uint8_t)code[i];
+    }
+    simulator_load_program(sim, vectors, sizeof(vectors), 0);
+    simulator_load_program(sim, bytes, 2 * words, TEST_CODE);
+    simulator_reset(sim);
+}
+
+/* Run until STOP #imm, at most insns instructions */
+static inline uint64_t test_run_to_stop(simulator_t *sim, uint64_t insns)
+{
+    uint64_t done = 0;
+
+    do {
+        done += simulator_run_batch(sim, (uint32_t)(insns - done), SIM_STOP_ON_STOP);
+    } while (simulator_get_stop_reason(sim) != SIM_STOPPED_STOP && done < insns);
+    return done;
+}
+
+/* What a snapshot restores: registers, clock and RAM */
+typedef struct {
+    simulator_cpu_state_t cpu;
+    uint64_t clock;
+    uint8_t ram[TEST_RAM_SIZE];
+} test_machine_t;
+
+static inline void test_capture(simulator_t *sim, test_machine_t *m)
+{
+    m->cpu = *simulator_get_state(sim);
+    m->clock = simulator_get_clock(sim);
+    simulator_read_block(sim, TEST_RAM, m->ram, sizeof(m->ram));
+}
+
+/* Compares the fields, the structure has padding */
+#define CHECK_MACHINE(a, b) test_check_machine(a, b, __FILE__, __LINE__)
+
+static inline void test_check_machine(const test_machine_t *a, const test_machine_t *b,
+                                      const char *file, int line)
+{
+    int same = a->cpu.sr == b->cpu.sr && a->cpu.pc == b->cpu.pc &&
+               memcmp(a->cpu.d, b->cpu.d, sizeof(a->cpu.d)) == 0 &&
+               memcmp(a->cpu.a, b->cpu.a, sizeof(a->cpu.a)) == 0 &&
+               a->cpu.ssp == b->cpu.ssp && a->cpu.usp == b->cpu.usp &&
+               a->cpu.vbr == b->cpu.vbr && a->cpu.cycles == b->cpu.cycles;
+
+    if (!same) {
+        fprintf(stderr, "%s:%d: registers differ (PC 0x%06X/0x%06X, D0 0x%08X/0x%08X)\n",
+                file, line, a->cpu.pc, b->cpu.pc, a->cpu.d[0], b->cpu.d[0]);
+        test_failures++;
+    }
+    if (a->clock != b->clock) {
+        fprintf(stderr, "%s:%d: clock differs (%llu/%llu)\n", file, line,
+                (unsigned long long)a->clock, (unsigned long long)b->clock);
+        test_failures++;
+    }
+    if (memcmp(a->ram, b->ram, sizeof(a->ram)) != 0) {
+        fprintf(stderr, "%s:%d: RAM differs\n", file, line);
+        test_failures++;
+    }
+}
+
+/* Exit status of the test */
+static inline int test_done(const char *name)
+{
+    if (test_failures) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif /* EVM_TEST_H */
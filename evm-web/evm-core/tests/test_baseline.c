@@ -0,0 +1,80 @@
+/*
+ * test_baseline.c
+ *
+ * simulator_set_baseline()/simulator_reset_to_baseline(): going back
+ * undoes guest and host writes to RAM and ROM, registers, clock and module
+ * state, also with snapshots saved in between, and runs from the baseline
+ * repeat exactly.
+ */
+
+#include "test.h"
+
+/* Stores a falling counter every 256 bytes through RAM */
+static const uint16_t Walk[] = {
+    0x7C01,                         /*      moveq   #1,d6 */
+    0x41F9, 0x0040, 0x1000,         /*      lea     TEST_DATA,a0 */
+    0x9086,                         /* loop sub.l   d6,d0 */
+    0x4290,                         /*      clr.l   (a0) */
+    0x8190,                         /*      or.l    d0,(a0) */
+    0x41E8, 0x0100,                 /*      lea     256(a0),a0 */
+    0x60F4,                         /*      bra.s   loop */
+};
+
+#define ITERATION   5               /* Instructions per loop */
+
+static test_machine_t base, first, now;
+
+int main(void)
+{
+    simulator_t *sim = test_simulator();
+    static const uint8_t junk[300] = { 0xA5, 0x5A };
+    size_t base_len = 0, len = 0;
+    uint8_t *base_snap, *snap;
+
+    CHECK_EQ(simulator_reset_to_baseline(sim), -1);
+
+    test_load_code(sim, Walk, sizeof(Walk) / sizeof(Walk[0]));
+    simulator_run_batch(sim, 2 + 10 * ITERATION, SIM_STOP_NONE);
+    CHECK_EQ(simulator_set_baseline(sim), 0);
+    test_capture(sim, &base);
+    base_snap = simulator_snapshot_save(sim, 0, &base_len);
+    CHECK(base_snap != NULL);
+
+    for (int round = 0; round < 4; round++) {
+        /* Guest writes over several pages, then the host writes RAM and
+           ROM and queues UART input */
+        simulator_run_batch(sim, 100 * ITERATION, SIM_STOP_NONE);
+        if (round == 0) {
+            test_capture(sim, &first);
+        } else {
+            test_capture(sim, &now);
+            CHECK_MACHINE(&now, &first);
+        }
+        simulator_write_block(sim, TEST_RAM + 0x1F000 - 100, junk, sizeof(junk));
+        simulator_write_block(sim, 0x8000, junk, sizeof(junk));
+        simulator_uart_push(sim, SIM_UART_A, junk, sizeof(junk));
+
+        /* A snapshot in between starts a new write tracking period */
+        if (round & 1) {
+            snap = simulator_snapshot_save(sim, SIM_SNAPSHOT_INCREMENTAL, &len);
+            CHECK(snap != NULL);
+            free(snap);
+            simulator_run_batch(sim, 20 * ITERATION, SIM_STOP_NONE);
+            simulator_write_block(sim, TEST_RAM + 0x18000, junk, sizeof(junk));
+        }
+
+        CHECK_EQ(simulator_reset_to_baseline(sim), 0);
+        test_capture(sim, &now);
+        CHECK_MACHINE(&now, &base);
+
+        /* The whole machine, modules and ROM included */
+        snap = simulator_snapshot_save(sim, 0, &len);
+        CHECK(snap != NULL && base_snap != NULL && len == base_len &&
+              memcmp(snap, base_snap, len) == 0);
+        free(snap);
+    }
+
+    free(base_snap);
+    simulator_destroy(sim);
+    return test_done("test_baseline");
+}
@@ -0,0 +1,117 @@
+/*
+ * test_block.c
+ *
+ * simulator_read_block()/simulator_write_block(): blocks across pages
+ * agree with byte accesses, ROM is written, unmapped memory reads as 0,
+ * addresses wrap at 24 bits, I/O goes through the module, and code that
+ * already ran is dropped from the caches when it is written.
+ */
+
+#include "test.h"
+#include "simulator_mem.h"
+
+#define UNMAPPED    0x600000
+#define PIT         0x800000
+
+static void fill(uint8_t *buf, size_t len, uint8_t seed)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)(seed + i * 7 + (i >> 8));
+    }
+}
+
+/* RAM and ROM, from just before a page boundary over several pages */
+static void test_round_trip(simulator_t *sim)
+{
+    static const uint32_t starts[] = { 0x400000 + MEMORY_PAGE_SIZE - 7, 0x001000 - 3 };
+    static uint8_t data[3 * MEMORY_PAGE_SIZE + 123], back[sizeof(data)];
+
+    for (size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+        uint32_t addr = starts[s];
+
+        fill(data, sizeof(data), (uint8_t)s);
+        simulator_write_block(sim, addr, data, sizeof(data));
+        memset(back, 0xEE, sizeof(back));
+        simulator_read_block(sim, addr, back, sizeof(back));
+        CHECK(memcmp(data, back, sizeof(data)) == 0);
+
+        for (size_t i = 0; i < sizeof(data); i += 251) {
+            CHECK_EQ(simulator_read_memory(sim, addr + (uint32_t)i, 1), data[i]);
+        }
+        CHECK_EQ(simulator_read_memory(sim, addr + sizeof(data) - 1, 1), data[sizeof(data) - 1]);
+    }
+}
+
+static void test_unmapped_and_wrap(simulator_t *sim)
+{
+    static const uint8_t data[4] = { 0x11, 0x22, 0x33, 0x44 };
+    uint8_t back[8];
+
+    memset(back, 0xEE, sizeof(back));
+    simulator_read_block(sim, UNMAPPED, back, sizeof(back));
+    for (size_t i = 0; i < sizeof(back); i++) {
+        CHECK_EQ(back[i], 0);
+    }
+
+    /* 0xFFFFFE is unmapped (a bus error message), the last two bytes
+       land at 0x000000 (ROM) */
+    simulator_write_block(sim, 0xFFFFFE, data, sizeof(data));
+    simulator_read_block(sim, 0x000000, back, 2);
+    CHECK_EQ(back[0], 0x33);
+    CHECK_EQ(back[1], 0x44);
+    simulator_read_block(sim, 0xFFFFFE, back, 4);
+    CHECK_EQ(back[2], 0x33);
+    CHECK_EQ(back[3], 0x44);
+}
+
+/* I/O pages read through the module, like byte reads */
+static void test_io(simulator_t *sim)
+{
+    uint8_t back[16];
+
+    simulator_read_block(sim, PIT, back, sizeof(back));
+    for (size_t i = 0; i < sizeof(back); i++) {
+        CHECK_EQ(back[i], simulator_read_memory(sim, PIT + (uint32_t)i, 1));
+    }
+}
+
+/* Endless loop setting d0; the block write changes the constant */
+static const uint16_t Loop[] = {
+    0x7001,                         /* loop moveq   #1,d0 */
+    0x60FC,                         /*      bra.s   loop */
+};
+
+static void test_code_dropped(simulator_t *sim)
+{
+    static const uint32_t code[] = { TEST_CODE, TEST_DATA };
+    static const uint8_t patch[2] = { 0x70, 0x02 };     /* moveq #2,d0 */
+    uint8_t bytes[sizeof(Loop)];
+
+    for (size_t i = 0; i < sizeof(Loop) / sizeof(Loop[0]); i++) {
+        bytes[2 * i] = (uint8_t)(Loop[i] >> 8);
+        bytes[2 * i + 1] = (uint8_t)Loop[i];
+    }
+    for (size_t c = 0; c < sizeof(code) / sizeof(code[0]); c++) {
+        test_load_code(sim, Loop, sizeof(Loop) / sizeof(Loop[0]));
+        simulator_write_block(sim, code[c], bytes, sizeof(bytes));
+        sim->cpu.pc = code[c];
+
+        simulator_run_batch(sim, 1000, SIM_STOP_NONE);
+        CHECK_EQ(simulator_get_state(sim)->d[0], 1);
+        simulator_write_block(sim, code[c], patch, sizeof(patch));
+        simulator_run_batch(sim, 1000, SIM_STOP_NONE);
+        CHECK_EQ(simulator_get_state(sim)->d[0], 2);
+    }
+}
+
+int main(void)
+{
+    simulator_t *sim = test_simulator();
+
+    test_round_trip(sim);
+    test_unmapped_and_wrap(sim);
+    test_io(sim);
+    test_code_dropped(sim);
+    simulator_destroy(sim);
+    return test_done("test_block");
+}
@@ -0,0 +1,133 @@
+/*
+ * test_flags.c
+ *
+ * Lazy condition codes (STFLAGS.H): the CCR the helpers assemble matches
+ * the flags set eagerly, the SR survives a sync/load round trip, SR writes
+ * by the host between batches are seen, and a program gives the same
+ * registers whether it runs in one batch or one instruction per batch
+ * (which syncs and reloads the CCR around every instruction).
+ */
+
+#include "test.h"
+#include "simulator_internal.h"
+#include "STSTDDEF.H"
+#include "STFLAGS.H"
+
+/* SETNZ() and the C/V/X setters against the bits set directly */
+static void test_helpers(void)
+{
+    static const long results[] = {
+        0, 1, -1, 0x7F, (char)0x80, 0x7FFF, (short)0x8000, 0x7FFFFFFF, (int32_t)0x80000000,
+    };
+
+    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++) {
+        for (int cvx = 0; cvx < 8; cvx++) {
+            long r = results[i];
+            unsigned short expect = (unsigned short)((cvx & 4 ? 0x10 : 0) | (r < 0 ? 0x08 : 0) |
+                                                     (r == 0 ? 0x04 : 0) | (cvx & 2 ? 0x02 : 0) |
+                                                     (cvx & 1 ? 0x01 : 0));
+
+            SETNZ(r);
+            setcarry(cvx & 1);
+            setover(cvx & 2);
+            setxtend(cvx & 4);
+            CHECK_EQ(GETCCR(), expect);
+
+            REGS.sregs.sr = 0x2700;
+            ccr_sync();
+            CHECK_EQ(REGS.sregs.sr, 0x2700 | expect);
+        }
+    }
+
+    /* ccr_load() takes every CCR value and leaves the system byte alone */
+    for (unsigned short ccr = 0; ccr < 0x20; ccr++) {
+        REGS.sregs.sr = 0x2300 | ccr;
+        ccr_load();
+        CHECK_EQ(GETCCR(), ccr);
+        REGS.sregs.sr = 0x2700;
+        ccr_sync();
+        CHECK_EQ(REGS.sregs.sr, 0x2700 | ccr);
+    }
+}
+
+/* Each result's SR is kept with MOVE from SR */
+static const uint16_t Flags[] = {
+    0x7000,                         /* moveq   #0,d0 */
+    0x72FF,                         /* moveq   #-1,d1 */
+    0x8080,                         /* or.l    d0,d0 */
+    0x40C2,                         /* move    sr,d2 */
+    0x8081,                         /* or.l    d1,d0 */
+    0x40C3,                         /* move    sr,d3 */
+    0x7801,                         /* moveq   #1,d4 */
+    0x9084,                         /* sub.l   d4,d0 */
+    0x40C5,                         /* move    sr,d5 */
+    0x9080,                         /* sub.l   d0,d0 */
+    0x40C6,                         /* move    sr,d6 */
+    0x4E72, 0x2700,                 /* stop    #$2700 */
+};
+
+static void test_program(void)
+{
+    simulator_t *one = test_simulator(), *stepped = test_simulator();
+    const simulator_cpu_state_t *a, *b;
+
+    /* X set by the host before the run, OR leaves it alone */
+    test_load_code(one, Flags, sizeof(Flags) / sizeof(Flags[0]));
+    one->cpu.sr = 0x2710;
+    test_run_to_stop(one, 100);
+    a = simulator_get_state(one);
+    CHECK_EQ(a->d[2], 0x2714);                  /* X Z */
+    CHECK_EQ(a->d[3], 0x2718);                  /* X N */
+    CHECK_EQ(a->d[5] & 0x0C, 0x08);             /* N */
+    CHECK_EQ(a->d[6] & 0x0C, 0x04);             /* Z */
+
+    test_load_code(stepped, Flags, sizeof(Flags) / sizeof(Flags[0]));
+    stepped->cpu.sr = 0x2710;
+    for (int i = 0; i < 100 && simulator_get_stop_reason(stepped) != SIM_STOPPED_STOP; i++) {
+        simulator_run_batch(stepped, 1, SIM_STOP_ON_STOP);
+    }
+    b = simulator_get_state(stepped);
+    CHECK_EQ(b->pc, a->pc);
+    CHECK_EQ(b->sr, a->sr);
+    for (int r = 0; r < 8; r++) {
+        CHECK_EQ(b->d[r], a->d[r]);
+    }
+
+    simulator_destroy(one);
+    simulator_destroy(stepped);
+}
+
+/* beq on the Z flag the host wrote into the SR */
+static const uint16_t Branch[] = {
+    0x6706,                         /*       beq.s   taken */
+    0x7001,                         /*       moveq   #1,d0 */
+    0x4E72, 0x2700,                 /*       stop    #$2700 */
+    0x7002,                         /* taken moveq   #2,d0 */
+    0x4E72, 0x2700,                 /*       stop    #$2700 */
+};
+
+static void test_host_sr(void)
+{
+    simulator_t *sim = test_simulator();
+
+    for (int z = 0; z < 2; z++) {
+        test_load_code(sim, Branch, sizeof(Branch) / sizeof(Branch[0]));
+        sim->cpu.sr = z ? 0x2704 : 0x2700;
+        test_run_to_stop(sim, 10);
+        CHECK_EQ(simulator_get_state(sim)->d[0], z ? 2 : 1);
+    }
+    simulator_destroy(sim);
+}
+
+int main(void)
+{
+    simulator_t *sim = test_simulator();
+
+    cpu_set_current_simulator(sim);
+    test_helpers();
+    simulator_destroy(sim);
+
+    test_program();
+    test_host_sr();
+    return test_done("test_flags");
+}
@@ -0,0 +1,141 @@
+/*
+ * test_image.c
+ *
+ * Memory images: an image built from memory checks with its hash and entry
+ * point and loads into another simulator, copied or with the ROM mapped;
+ * the S-record loader's image carries the hash of the text it was fed;
+ * malformed images fail the check and the load.
+ */
+
+#include "test.h"
+
+#define ROM_ADDR    0x001000
+#define RAM_ADDR    0x401000
+
+static uint8_t data[2][64];
+
+static void check_memory(simulator_t *sim)
+{
+    uint8_t back[sizeof(data[0])];
+
+    simulator_read_block(sim, ROM_ADDR, back, sizeof(back));
+    CHECK(memcmp(back, data[0], sizeof(back)) == 0);
+    simulator_read_block(sim, RAM_ADDR, back, sizeof(back));
+    CHECK(memcmp(back, data[1], sizeof(back)) == 0);
+}
+
+static void *build(size_t *len)
+{
+    static const simulator_segment_t segs[] = {
+        { ROM_ADDR, sizeof(data[0]) }, { RAM_ADDR, sizeof(data[1]) },
+    };
+    simulator_t *sim = test_simulator();
+    void *img;
+
+    simulator_write_block(sim, ROM_ADDR, data[0], sizeof(data[0]));
+    simulator_write_block(sim, RAM_ADDR, data[1], sizeof(data[1]));
+    img = simulator_image_build(sim, segs, 2, 0x0100, simulator_hash("source", 6), len);
+    simulator_destroy(sim);
+    return img;
+}
+
+static void test_build_load(void)
+{
+    size_t len = 0;
+    uint8_t *img = build(&len);
+    uint64_t hash = 0;
+    uint32_t entry = 0;
+
+    CHECK(img != NULL);
+    if (img == NULL) return;
+    CHECK_EQ(simulator_image_check(img, len, &hash, &entry), 0);
+    CHECK_EQ(hash, simulator_hash("source", 6));
+    CHECK_EQ(entry, 0x0100);
+
+    /* Copied, then with the ROM segment mapped in place */
+    for (int flags = 0; flags <= SIM_IMAGE_MAP_ROM; flags += SIM_IMAGE_MAP_ROM) {
+        simulator_t *sim = test_simulator();
+
+        entry = 0;
+        CHECK_EQ(simulator_load_image(sim, img, len, flags, &entry), 0);
+        CHECK_EQ(entry, 0x0100);
+        check_memory(sim);
+        simulator_destroy(sim);
+    }
+    free(img);
+}
+
+/* Image of an S-record load: hash of the text, entry of the S9 record */
+static void test_srec_image(void)
+{
+    static const char text[] =
+        "S107100001020304DE\n"    /* 01 02 03 04 at 0x1000 */
+        "S9030100FB\n";
+    simulator_t *sim = test_simulator(), *copy = test_simulator();
+    simulator_srec_t *srec = simulator_srec_begin(sim);
+    uint64_t hash = 0;
+    uint32_t entry = 0;
+    size_t len = 0;
+    uint8_t *img;
+
+    CHECK_EQ(simulator_srec_feed(srec, text, sizeof(text) - 1), 0);
+    img = simulator_srec_image(srec, &len);
+    CHECK_EQ(simulator_srec_end(srec, NULL), 0);
+    CHECK(img != NULL);
+    if (img != NULL) {
+        CHECK_EQ(simulator_image_check(img, len, &hash, &entry), 0);
+        CHECK_EQ(hash, simulator_hash(text, sizeof(text) - 1));
+        CHECK_EQ(entry, 0x0100);
+        CHECK_EQ(simulator_load_image(copy, img, len, 0, NULL), 0);
+        CHECK_EQ(simulator_read_memory(copy, 0x1000, 4), 0x01020304);
+    }
+    free(img);
+    simulator_destroy(sim);
+    simulator_destroy(copy);
+}
+
+/* Bad magic, a segment count or segment past the end, truncation */
+static void test_corrupt(void)
+{
+    size_t len = 0;
+    uint8_t *img = build(&len), *bad;
+    simulator_t *sim = test_simulator();
+
+    if (img == NULL) return;
+    bad = malloc(len);
+    CHECK(bad != NULL);
+    if (bad == NULL) return;
+
+    for (int c = 0; c < 5; c++) {
+        size_t bad_len = len;
+
+        memcpy(bad, img, len);
+        switch (c) {
+        case 0: bad[0] = 'X'; break;                        /* Magic */
+        case 1: bad[7]++; break;                            /* Version */
+        case 2: bad[22] = 0xFF; break;                      /* Segment count */
+        case 3: bad[24 + 16 + 8 + 2] = 0x10; break;         /* Second segment's offset */
+        case 4: bad_len = len - 1; break;                   /* Last segment cut short */
+        }
+        CHECK_EQ(simulator_image_check(bad, bad_len, NULL, NULL), -1);
+        CHECK_EQ(simulator_load_image(sim, bad, bad_len, 0, NULL), -1);
+    }
+    CHECK_EQ(simulator_image_check(img, 23, NULL, NULL), -1);
+
+    free(bad);
+    free(img);
+    simulator_destroy(sim);
+}
+
+int main(void)
+{
+    for (int i = 0; i < 2; i++) {
+        for (size_t j = 0; j < sizeof(data[i]); j++) {
+            data[i][j] = (uint8_t)(i * 128 + j * 3 + 7);
+        }
+    }
+    test_build_load();
+    test_srec_image();
+    test_corrupt();
+    return test_done("test_image");
+}
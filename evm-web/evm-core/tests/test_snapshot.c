@@ -0,0 +1,239 @@
+/*
+ * test_snapshot.c
+ *
+ * Machine snapshots: a snapshot restores registers, clock and RAM, in the
+ * same simulator or a new one, and the machine then runs on the same way;
+ * incremental snapshots only load in chain order; damaged snapshots and
+ * module data that does not fit (a UART FIFO count past its size) are
+ * rejected.
+ */
+
+#include "test.h"
+
+#define HEADER_SIZE     40
+
+/* Stores a falling counter every 256 bytes through RAM, dirtying a page
+   every 16 iterations */
+static const uint16_t Walk[] = {
+    0x7C01,                         /*      moveq   #1,d6 */
+    0x41F9, 0x0040, 0x1000,         /*      lea     TEST_DATA,a0 */
+    0x9086,                         /* loop sub.l   d6,d0 */
+    0x4290,                         /*      clr.l   (a0) */
+    0x8190,                         /*      or.l    d0,(a0) */
+    0x41E8, 0x0100,                 /*      lea     256(a0),a0 */
+    0x60F4,                         /*      bra.s   loop */
+};
+
+#define ITERATION   5               /* Instructions per loop */
+
+static test_machine_t saved, now, later;
+
+static simulator_t *walker(void)
+{
+    simulator_t *sim = test_simulator();
+
+    test_load_code(sim, Walk, sizeof(Walk) / sizeof(Walk[0]));
+    simulator_run_batch(sim, 2 + 40 * ITERATION, SIM_STOP_NONE);
+    return sim;
+}
+
+static void test_round_trip(void)
+{
+    simulator_t *sim = walker(), *fresh = test_simulator();
+    size_t len = 0, len2 = 0;
+    uint8_t *snap = simulator_snapshot_save(sim, 0, &len), *again;
+
+    CHECK(snap != NULL);
+    if (snap == NULL) return;
+    CHECK_EQ(simulator_snapshot_size(snap, len), len);
+    test_capture(sim, &saved);
+
+    /* Run on, then back to the snapshot */
+    simulator_run_batch(sim, 50 * ITERATION, SIM_STOP_NONE);
+    test_capture(sim, &later);
+    CHECK_EQ(simulator_snapshot_load(sim, snap, len), 0);
+    test_capture(sim, &now);
+    CHECK_MACHINE(&now, &saved);
+
+    /* The same again from the snapshot, in this simulator and a new one */
+    simulator_run_batch(sim, 50 * ITERATION, SIM_STOP_NONE);
+    test_capture(sim, &now);
+    CHECK_MACHINE(&now, &later);
+
+    CHECK_EQ(simulator_snapshot_load(fresh, snap, len), 0);
+    test_capture(fresh, &now);
+    CHECK_MACHINE(&now, &saved);
+    simulator_run_batch(fresh, 50 * ITERATION, SIM_STOP_NONE);
+    test_capture(fresh, &now);
+    CHECK_MACHINE(&now, &later);
+
+    /* Saved right after loading, a snapshot comes out the same */
+    CHECK_EQ(simulator_snapshot_load(fresh, snap, len), 0);
+    again = simulator_snapshot_save(fresh, 0, &len2);
+    CHECK(again != NULL && len2 == len && memcmp(again, snap, len) == 0);
+
+    free(again);
+    free(snap);
+    simulator_destroy(sim);
+    simulator_destroy(fresh);
+}
+
+static void test_incremental(void)
+{
+    simulator_t *sim = walker(), *fresh = test_simulator();
+    size_t len[3], total = 0, pos = 0;
+    uint8_t *snap[3], *chain;
+
+    snap[0] = simulator_snapshot_save(sim, 0, &len[0]);
+    for (int i = 1; i < 3; i++) {
+        simulator_run_batch(sim, 40 * ITERATION, SIM_STOP_NONE);
+        snap[i] = simulator_snapshot_save(sim, SIM_SNAPSHOT_INCREMENTAL, &len[i]);
+    }
+    test_capture(sim, &saved);
+    for (int i = 0; i < 3; i++) {
+        CHECK(snap[i] != NULL);
+        if (snap[i] == NULL) return;
+        total += len[i];
+    }
+    /* 40 iterations write 10KB: a few pages, not all of RAM and ROM */
+    CHECK(len[1] < len[0] / 4);
+    CHECK(len[2] < len[0] / 4);
+
+    /* Out of order: the second one does not follow a fresh simulator or
+       the complete one */
+    CHECK_EQ(simulator_snapshot_load(fresh, snap[1], len[1]), -1);
+    CHECK_EQ(simulator_snapshot_load(fresh, snap[0], len[0]), 0);
+    CHECK_EQ(simulator_snapshot_load(fresh, snap[2], len[2]), -1);
+
+    /* In order, kept as one file */
+    chain = malloc(total);
+    CHECK(chain != NULL);
+    if (chain == NULL) return;
+    for (int i = 0; i < 3; i++) {
+        memcpy(chain + pos, snap[i], len[i]);
+        pos += len[i];
+    }
+    simulator_destroy(fresh);
+    fresh = test_simulator();
+    for (pos = 0; pos < total; ) {
+        size_t size = simulator_snapshot_size(chain + pos, total - pos);
+
+        CHECK(size != 0);
+        if (size == 0) break;
+        CHECK_EQ(simulator_snapshot_load(fresh, chain + pos, total - pos), 0);
+        pos += size;
+    }
+    test_capture(fresh, &now);
+    CHECK_MACHINE(&now, &saved);
+
+    free(chain);
+    for (int i = 0; i < 3; i++) free(snap[i]);
+    simulator_destroy(sim);
+    simulator_destroy(fresh);
+}
+
+static void put_le(uint8_t *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+/* Store the id the loader expects after the snapshot was changed */
+static void fix_id(uint8_t *snap, size_t len)
+{
+    uint64_t id;
+
+    memset(snap + 24, 0, 8);
+    id = simulator_hash(snap, len);
+    put_le(snap + 24, id ? id : 1, 8);
+}
+
+/* Offset of the named module's section */
+static size_t module_section(const uint8_t *snap, size_t len, const char *name)
+{
+    for (size_t pos = HEADER_SIZE; pos + 8 <= len; ) {
+        size_t size = (size_t)snap[pos + 4] | (size_t)snap[pos + 5] << 8 |
+                      (size_t)snap[pos + 6] << 16 | (size_t)snap[pos + 7] << 24;
+
+        if (memcmp(snap + pos, "MODL", 4) == 0 && strcmp((const char *)snap + pos + 8, name) == 0) {
+            return pos;
+        }
+        pos += 8 + size;
+    }
+    return 0;
+}
+
+/* The UART section ends with channel B's transmit FIFO, saved empty: a
+   count of 0. Copy of the snapshot with n bytes in that FIFO instead. */
+static uint8_t *fill_fifo(const uint8_t *snap, size_t len, uint32_t n, size_t *bad_len)
+{
+    size_t sec = module_section(snap, len, "68681 UART"), size, count;
+    uint8_t *bad;
+
+    CHECK(sec != 0);
+    if (sec == 0) return NULL;
+    size = (size_t)snap[sec + 4] | (size_t)snap[sec + 5] << 8 |
+           (size_t)snap[sec + 6] << 16 | (size_t)snap[sec + 7] << 24;
+    count = sec + 8 + size - 4;
+    CHECK_EQ(snap[count] | snap[count + 1] | snap[count + 2] | snap[count + 3], 0);
+    if ((bad = malloc(len + n)) == NULL) return NULL;
+
+    memcpy(bad, snap, count);
+    put_le(bad + count, n, 4);
+    memset(bad + count + 4, 'x', n);
+    memcpy(bad + count + 4 + n, snap + count + 4, len - count - 4);
+    put_le(bad + sec + 4, size + n, 4);
+    put_le(bad + 16, len + n, 8);
+    *bad_len = len + n;
+    fix_id(bad, *bad_len);
+    return bad;
+}
+
+static void test_corrupt(void)
+{
+    simulator_t *sim = walker();
+    size_t len = 0;
+    uint8_t *snap, *bad;
+
+    /* Something for the UART FIFOs to hold */
+    simulator_uart_push(sim, SIM_UART_A, (const uint8_t *)"input", 5);
+    snap = simulator_snapshot_save(sim, 0, &len);
+    CHECK(snap != NULL);
+    if (snap == NULL) return;
+    bad = malloc(len);
+    CHECK(bad != NULL);
+    if (bad == NULL) return;
+
+    /* Any changed byte fails the id */
+    memcpy(bad, snap, len);
+    bad[len / 2] ^= 0x01;
+    CHECK_EQ(simulator_snapshot_load(sim, bad, len), -1);
+    CHECK_EQ(simulator_snapshot_load(sim, snap, len - 1), -1);
+    CHECK_EQ(simulator_snapshot_size(snap, HEADER_SIZE - 1), 0);
+
+    /* A FIFO can hold SIM_UART_FIFO_SIZE bytes, a larger count is a
+       corrupt section even when the data is there */
+    for (uint32_t n = SIM_UART_FIFO_SIZE; n <= SIM_UART_FIFO_SIZE + 1; n++) {
+        size_t bad_len = 0;
+        uint8_t *full = fill_fifo(snap, len, n, &bad_len);
+
+        CHECK(full != NULL);
+        if (full == NULL) break;
+        CHECK_EQ(simulator_snapshot_load(sim, full, bad_len), n == SIM_UART_FIFO_SIZE ? 0 : -1);
+        free(full);
+    }
+
+    /* Still loads as saved */
+    CHECK_EQ(simulator_snapshot_load(sim, snap, len), 0);
+
+    free(bad);
+    free(snap);
+    simulator_destroy(sim);
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_incremental();
+    test_corrupt();
+    return test_done("test_snapshot");
+}
@@ -0,0 +1,166 @@
+/*
+ * test_srec.c
+ *
+ * S-record loader: S1/S2/S3 data lands in memory, S7/S8/S9 give the entry
+ * point, bad checksums and digits fail the load, and the result does not
+ * depend on how the image is split into chunks.
+ */
+
+#include "test.h"
+
+#define ROM_ADDR    0x001000
+#define RAM_ADDR    0x401000
+#define RAM_ADDR2   0x402000
+
+/* Append one record; type selects the address size */
+static size_t record(char *out, int type, uint32_t addr, const uint8_t *data, size_t n,
+                     const char *eol)
+{
+    int addr_len = (type == 2 || type == 8) ? 3 : (type == 3 || type == 7) ? 4 : 2;
+    unsigned sum = (unsigned)(addr_len + n + 1);
+    size_t len = (size_t)sprintf(out, "S%d%02X", type, (unsigned)(addr_len + n + 1));
+
+    for (int i = addr_len - 1; i >= 0; i--) {
+        unsigned b = (addr >> (8 * i)) & 0xFF;
+        sum += b;
+        len += (size_t)sprintf(out + len, "%02X", b);
+    }
+    for (size_t i = 0; i < n; i++) {
+        sum += data[i];
+        len += (size_t)sprintf(out + len, "%02X", data[i]);
+    }
+    return len + (size_t)sprintf(out + len, "%02X%s", ~sum & 0xFF, eol);
+}
+
+static uint8_t data[3][40];
+
+/* Header, data records of all three sizes, count and the end record of
+   the given type (0 for none) */
+static size_t image(char *out, int end_type, uint32_t entry, const char *eol)
+{
+    static const uint8_t name[] = "test";
+    size_t len = 0;
+
+    len += record(out + len, 0, 0, name, sizeof(name) - 1, eol);
+    len += record(out + len, 1, ROM_ADDR, data[0], 20, eol);
+    len += record(out + len, 1, ROM_ADDR + 20, data[0] + 20, 20, eol);
+    len += record(out + len, 2, RAM_ADDR, data[1], sizeof(data[1]), eol);
+    len += record(out + len, 3, RAM_ADDR2, data[2], sizeof(data[2]), eol);
+    len += record(out + len, 5, 4, NULL, 0, eol);
+    if (end_type) len += record(out + len, end_type, entry, NULL, 0, eol);
+    return len;
+}
+
+static void check_memory(simulator_t *sim)
+{
+    static const uint32_t addrs[3] = { ROM_ADDR, RAM_ADDR, RAM_ADDR2 };
+    uint8_t back[sizeof(data[0])];
+
+    for (int i = 0; i < 3; i++) {
+        simulator_read_block(sim, addrs[i], back, sizeof(back));
+        CHECK(memcmp(back, data[i], sizeof(back)) == 0);
+    }
+}
+
+static void test_load(void)
+{
+    static const struct { int type; uint32_t entry; } ends[] = {
+        { 9, 0x1234 }, { 8, 0x123456 }, { 7, 0x00400100 }, { 0, SIM_SREC_NO_ENTRY },
+    };
+    static char text[4096];
+
+    for (size_t e = 0; e < sizeof(ends) / sizeof(ends[0]); e++) {
+        for (int crlf = 0; crlf < 2; crlf++) {
+            simulator_t *sim = test_simulator();
+            uint32_t entry = 0;
+            size_t len = image(text, ends[e].type, ends[e].entry, crlf ? "\r\n" : "\n");
+
+            CHECK_EQ(simulator_load_srec(sim, text, len, &entry), 0);
+            CHECK_EQ(entry, ends[e].entry);
+            check_memory(sim);
+            simulator_destroy(sim);
+        }
+    }
+}
+
+/* Every chunk size gives the same memory and the same cached image */
+static void test_chunks(void)
+{
+    static const size_t sizes[] = { 1, 2, 3, 7, 64, 100000 };
+    static char text[4096];
+    size_t len = image(text, 9, 0x0100, "\r\n"), first_len = 0;
+    void *first = NULL;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        simulator_t *sim = test_simulator();
+        simulator_srec_t *srec = simulator_srec_begin(sim);
+        uint32_t entry = 0;
+        size_t img_len = 0;
+        void *img;
+
+        for (size_t pos = 0; pos < len; pos += sizes[s]) {
+            size_t n = len - pos < sizes[s] ? len - pos : sizes[s];
+            CHECK_EQ(simulator_srec_feed(srec, text + pos, n), 0);
+        }
+        img = simulator_srec_image(srec, &img_len);
+        CHECK(img != NULL);
+        CHECK_EQ(simulator_srec_end(srec, &entry), 0);
+        CHECK_EQ(entry, 0x0100);
+        check_memory(sim);
+
+        if (first == NULL) {
+            first = img;
+            first_len = img_len;
+        } else {
+            CHECK(img != NULL && img_len == first_len && memcmp(img, first, img_len) == 0);
+            free(img);
+        }
+        simulator_destroy(sim);
+    }
+    free(first);
+}
+
+/* A bad checksum or digit anywhere fails the load */
+static void test_bad(void)
+{
+    static char text[4096];
+    size_t len = image(text, 9, 0x0100, "\n");
+    char *line = strchr(text, '\n') + 1;     /* First S1 record */
+    char *eol = strchr(line, '\n');
+
+    for (int bad = 0; bad < 2; bad++) {
+        simulator_t *sim = test_simulator();
+        char *p = bad == 0 ? eol - 1 : line + 10;   /* Checksum, data digit */
+        char saved = *p;
+
+        *p = bad == 0 ? (*p == '0' ? '1' : '0') : 'G';
+        CHECK_EQ(simulator_load_srec(sim, text, len, NULL), -1);
+        *p = saved;
+        simulator_destroy(sim);
+    }
+
+    /* Feeding stops reporting success once a record was bad */
+    simulator_t *sim = test_simulator();
+    simulator_srec_t *srec = simulator_srec_begin(sim);
+    static const char bad_record[] = "S1051000AABB00\n";
+    size_t img_len;
+
+    CHECK_EQ(simulator_srec_feed(srec, bad_record, sizeof(bad_record) - 1), -1);
+    CHECK_EQ(simulator_srec_feed(srec, text, len), -1);
+    CHECK(simulator_srec_image(srec, &img_len) == NULL);
+    CHECK_EQ(simulator_srec_end(srec, NULL), -1);
+    simulator_destroy(sim);
+}
+
+int main(void)
+{
+    for (int i = 0; i < 3; i++) {
+        for (size_t j = 0; j < sizeof(data[i]); j++) {
+            data[i][j] = (uint8_t)(i * 64 + j * 5 + 1);
+        }
+    }
+    test_load();
+    test_chunks();
+    test_bad();
+    return test_done("test_srec");
+}
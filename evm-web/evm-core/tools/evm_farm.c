@@ -0,0 +1,511 @@
+/*
+ * evm_farm.c
+ *
+ * Regression farm runner: runs the jobs of a manifest on independent
+ * simulator instances, spread over a work-stealing pool of threads, and
+ * reports wall time, instructions executed and pass/fail per job.
+ *
+ * Built by CMake (native builds), or from evm-core:
+ *   cc -O2 -pthread -Iinclude -o evm_farm tools/evm_farm.c tools/evm_tool.c \
+ *      src/simulator*.c src/cpu_core_new.c src/cpu_cycles.c src/cpu_icache.c \
+ *      src/cpu_translate.c src/cpu_instructions.c src/exception_handlers.c \
+ *      src/steacalc.c src/stmem.c src/sttable.c
+ *
+ * Usage: evm_farm [-j threads] [-o logdir] manifest
+ *   -j  worker threads (default: online CPUs)
+ *   -o  write the UART output of every job to logdir/<name>.log
+ *
+ * Manifest: one job per line, '#' starts a comment
+ *   <name> <image> [key=value ...]
+ *
+ *   image       S-record file (.s19/.s28/.s37/.srec/.mot), snapshot (.snap,
+ *               see evm-run --save) or raw binary. A snapshot replaces the
+ *               reset, so the job starts where it was taken.
+ *   load=ADDR   load address of a raw binary (default 0)
+ *   insns=N     instruction budget (default 100000000)
+ *   until=stop  the job ends when the CPU executes STOP #imm
+ *   until=ADDR  the job ends when the PC reaches ADDR
+ *   channel=A|B UART channel 'expect' looks at (default A)
+ *   expect=TEXT UART output the job must produce. Double quotes allow
+ *               blanks, \n \r \t \\ \" \xHH escapes are understood.
+ *
+ * Numbers take C syntax (0x prefix for hex). A job ends at its 'until'
+ * condition, or without one as soon as the expected output appeared, and
+ * passes if both were met where given within the instruction budget.
+ *
+ * Example:
+ *   prompt       monitor.s19      insns=5000000 expect="> "
+ *   selftest     selftest.s19     until=stop expect="PASS\r\n"
+ *   booted       booted.snap      insns=1000000 expect="> "
+ *
+ * Exit status: 0 if all jobs passed, 1 if any failed, 2 on usage errors.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "simulator.h"
+#include "evm_tool.h"
+
+#define DEFAULT_INSNS   100000000ULL
+#define BATCH_INSNS     (1u << 24)      /* Instructions per simulator_run_batch() */
+#define MAX_OUTPUT      (1 << 20)       /* UART output kept per job (logs and 'expect') */
+
+/* ============================================================================
+ * Jobs
+ * ============================================================================ */
+
+#define UNTIL_NONE  0
+#define UNTIL_STOP  1
+#define UNTIL_PC    2
+
+typedef struct {
+    /* From the manifest */
+    char *name;
+    char *image;
+    uint32_t load_addr;
+    uint64_t insns;
+    int until;
+    uint32_t until_pc;
+    int channel;
+    char *expect;
+    size_t expect_len;
+
+    /* Results */
+    simulator_t *sim;
+    char *output;                   /* UART output of 'channel' while the job runs,
+                                       NULL unless logged or matched */
+    size_t output_len;
+    int matched;
+    int reached;
+    int passed;
+    uint64_t executed;
+    double wall;
+    const char *error;              /* Job could not run */
+} job_t;
+
+static const char *log_dir;
+
+/* Collect the output, the expected text ends a job without an 'until' */
+static void job_uart_tx(void *user, int channel, uint8_t data)
+{
+    job_t *job = (job_t *)user;
+
+    if (channel != job->channel || job->output == NULL || job->output_len == MAX_OUTPUT) return;
+    job->output[job->output_len++] = (char)data;
+
+    if (job->expect && !job->matched && job->output_len >= job->expect_len &&
+        memcmp(job->output + job->output_len - job->expect_len, job->expect, job->expect_len) == 0) {
+        job->matched = 1;
+        if (job->until == UNTIL_NONE) simulator_pause(job->sim);
+    }
+}
+
+static void write_log(const job_t *job)
+{
+    char path[4096];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s.log", log_dir, job->name);
+    if ((f = fopen(path, "wb")) == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return;
+    }
+    fwrite(job->output, 1, job->output_len, f);
+    fclose(f);
+}
+
+static void run_job(job_t *job)
+{
+    double t0 = tool_now();
+    uint32_t stop_conditions = SIM_STOP_NONE;
+    uint32_t entry = SIM_SREC_NO_ENTRY;
+    int snapshot = tool_has_ext(job->image, ".snap");
+    int rc;
+
+    if (log_dir || job->expect) {
+        job->output = malloc(MAX_OUTPUT);
+    }
+    job->sim = simulator_init();
+    if (((log_dir || job->expect) && job->output == NULL) ||
+        job->sim == NULL || simulator_load_modules(job->sim) != 0) {
+        job->error = "simulator setup failed";
+        goto done;
+    }
+    simulator_set_uart_tx(job->sim, job_uart_tx, job);
+
+    if (snapshot) {
+        size_t len;
+        uint8_t *data = tool_read_file(job->image, &len);
+        if (data == NULL) {
+            job->error = strerror(errno);
+            goto done;
+        }
+        rc = tool_load_snapshots(job->sim, data, len, NULL);
+        free(data);
+    } else {
+        /* The reset clears RAM, so the image goes in after it and the CPU
+           takes its vectors from it below */
+        FILE *f = fopen(job->image, "rb");
+        if (f == NULL) {
+            job->error = strerror(errno);
+            goto done;
+        }
+        simulator_reset(job->sim);
+        rc = tool_is_srec(job->image) ? tool_load_srec(job->sim, f, &entry) :
+                                        tool_load_binary(job->sim, f, job->load_addr);
+        fclose(f);
+    }
+    if (rc != 0) {
+        job->error = snapshot ? "bad snapshot" : "bad image";
+        goto done;
+    }
+    if (!snapshot) {
+        simulator_reset_cpu(job->sim);
+    }
+    if (entry != SIM_SREC_NO_ENTRY && entry != 0) {
+        job->sim->cpu.pc = entry & 0xFFFFFF;    /* ROM images end with S7/S9 0 */
+    }
+
+    if (job->until == UNTIL_STOP) {
+        stop_conditions = SIM_STOP_ON_STOP;
+    } else if (job->until == UNTIL_PC) {
+        simulator_set_breakpoint(job->sim, job->until_pc);
+        stop_conditions = SIM_STOP_BREAKPOINT;
+    }
+
+    while (job->executed < job->insns && !(job->matched && job->until == UNTIL_NONE)) {
+        uint64_t left = job->insns - job->executed;
+        uint32_t count = left < BATCH_INSNS ? (uint32_t)left : BATCH_INSNS;
+        int reason;
+
+        job->executed += simulator_run_batch(job->sim, count, stop_conditions);
+        reason = simulator_get_stop_reason(job->sim);
+        if (reason == SIM_STOPPED_STOP || reason == SIM_STOPPED_BREAKPOINT) {
+            job->reached = 1;
+            break;
+        }
+    }
+
+    job->passed = (job->expect == NULL || job->matched) &&
+                  (job->until == UNTIL_NONE || job->reached);
+    if (log_dir) write_log(job);
+
+done:
+    if (job->sim) simulator_destroy(job->sim);
+    job->sim = NULL;
+    free(job->output);
+    job->output = NULL;
+    job->wall = tool_now() - t0;
+}
+
+/* ============================================================================
+ * Work-stealing pool
+ *
+ * Every worker owns a deque of job indices, dealt round-robin up front. It
+ * takes its own jobs from the back and, once out of work, steals from the
+ * front of the others. No jobs are added while the pool runs, so a worker
+ * that finds every deque empty is done.
+ * ============================================================================ */
+
+typedef struct {
+    pthread_mutex_t lock;
+    int *jobs;
+    int head, tail;                 /* jobs[head..tail) are left */
+} deque_t;
+
+typedef struct {
+    int id;
+    deque_t *deques;
+    int num_workers;
+    job_t *jobs;
+    int stolen;
+} worker_t;
+
+static pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int deque_pop(deque_t *d)
+{
+    int job = -1;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->head < d->tail) job = d->jobs[--d->tail];
+    pthread_mutex_unlock(&d->lock);
+    return job;
+}
+
+static int deque_steal(deque_t *d)
+{
+    int job = -1;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->head < d->tail) job = d->jobs[d->head++];
+    pthread_mutex_unlock(&d->lock);
+    return job;
+}
+
+static const char *job_result(const job_t *job)
+{
+    return job->error ? "ERROR" : job->passed ? "PASS" : "FAIL";
+}
+
+/* Progress, as the jobs finish */
+static void report(const job_t *job)
+{
+    pthread_mutex_lock(&report_lock);
+    fprintf(stderr, "%-5s %s\n", job_result(job), job->name);
+    pthread_mutex_unlock(&report_lock);
+}
+
+static void *worker_main(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+
+    for (;;) {
+        int job = deque_pop(&w->deques[w->id]);
+
+        for (int i = 1; job < 0 && i < w->num_workers; i++) {
+            job = deque_steal(&w->deques[(w->id + i) % w->num_workers]);
+            if (job >= 0) w->stolen++;
+        }
+        if (job < 0) break;
+
+        run_job(&w->jobs[job]);
+        report(&w->jobs[job]);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Manifest
+ * ============================================================================ */
+
+/* Next blank separated field, unquoted and unescaped in place */
+static char *next_field(char **p)
+{
+    char *s = *p, *out, *start;
+    int quoted = 0;
+
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s == '\0' || *s == '#' || *s == '\n' || *s == '\r') return NULL;
+
+    start = out = s;
+    while (*s && (quoted || (*s != ' ' && *s != '\t' && *s != '\n' && *s != '\r'))) {
+        if (*s == '"') {
+            quoted = !quoted;
+            s++;
+        } else if (*s == '\\' && s[1]) {
+            s++;
+            switch (*s) {
+            case 'n': *out++ = '\n'; s++; break;
+            case 'r': *out++ = '\r'; s++; break;
+            case 't': *out++ = '\t'; s++; break;
+            case 'x': *out++ = (char)strtoul(s + 1, &s, 16); break;
+            default:  *out++ = *s++; break;
+            }
+        } else {
+            *out++ = *s++;
+        }
+    }
+    if (*s) s++;
+    *out = '\0';
+    *p = s;
+    return start;
+}
+
+static int parse_number(const char *s, uint64_t *value)
+{
+    char *end;
+
+    errno = 0;
+    *value = strtoull(s, &end, 0);
+    return (errno == 0 && end != s && *end == '\0') ? 0 : -1;
+}
+
+static int parse_option(job_t *job, char *opt)
+{
+    char *value = strchr(opt, '=');
+    uint64_t n;
+
+    if (value == NULL) return -1;
+    *value++ = '\0';
+
+    if (strcmp(opt, "load") == 0 && parse_number(value, &n) == 0) {
+        job->load_addr = (uint32_t)n;
+    } else if (strcmp(opt, "insns") == 0 && parse_number(value, &n) == 0) {
+        job->insns = n;
+    } else if (strcmp(opt, "until") == 0 && strcmp(value, "stop") == 0) {
+        job->until = UNTIL_STOP;
+    } else if (strcmp(opt, "until") == 0 && parse_number(value, &n) == 0) {
+        job->until = UNTIL_PC;
+        job->until_pc = (uint32_t)n;
+    } else if (strcmp(opt, "channel") == 0 && (value[0] == 'A' || value[0] == 'B') && !value[1]) {
+        job->channel = (value[0] == 'A') ? SIM_UART_A : SIM_UART_B;
+    } else if (strcmp(opt, "expect") == 0 && value[0]) {
+        free(job->expect);
+        job->expect = strdup(value);
+        job->expect_len = strlen(value);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static void free_jobs(job_t *jobs, int num_jobs)
+{
+    for (int j = 0; j < num_jobs; j++) {
+        free(jobs[j].name);
+        free(jobs[j].image);
+        free(jobs[j].expect);
+    }
+    free(jobs);
+}
+
+static job_t *read_manifest(const char *path, int *num_jobs)
+{
+    FILE *f = fopen(path, "r");
+    char line[4096];
+    job_t *jobs = NULL;
+    int n = 0, max = 0, lineno = 0;
+
+    if (f == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        char *p = line, *name, *image, *opt;
+
+        lineno++;
+        if ((name = next_field(&p)) == NULL) continue;
+        if ((image = next_field(&p)) == NULL) {
+            fprintf(stderr, "%s:%d: missing image\n", path, lineno);
+            goto fail;
+        }
+        if (n == max) {
+            int grow = max ? 2 * max : 64;
+            job_t *grown = realloc(jobs, grow * sizeof(*jobs));
+            if (grown == NULL) {
+                fprintf(stderr, "%s: out of memory\n", path);
+                goto fail;
+            }
+            jobs = grown;
+            max = grow;
+        }
+
+        job_t *job = &jobs[n++];
+        memset(job, 0, sizeof(*job));
+        job->name = strdup(name);
+        job->image = strdup(image);
+        job->insns = DEFAULT_INSNS;
+        job->channel = SIM_UART_A;
+        while ((opt = next_field(&p)) != NULL) {
+            if (parse_option(job, opt) != 0) {
+                fprintf(stderr, "%s:%d: bad option '%s'\n", path, lineno, opt);
+                goto fail;
+            }
+        }
+    }
+    fclose(f);
+    *num_jobs = n;
+    return jobs;
+
+fail:
+    fclose(f);
+    free_jobs(jobs, n);
+    return NULL;
+}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: evm_farm [-j threads] [-o logdir] manifest\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int num_jobs, failed = 0, opt;
+    uint64_t total_insns = 0;
+    double job_time = 0;
+    job_t *jobs;
+
+    while ((opt = getopt(argc, argv, "j:o:")) != -1) {
+        switch (opt) {
+        case 'j': num_workers = atoi(optarg); break;
+        case 'o': log_dir = optarg; break;
+        default:  usage();
+        }
+    }
+    if (optind != argc - 1 || num_workers < 1) usage();
+    if (log_dir && mkdir(log_dir, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "%s: %s\n", log_dir, strerror(errno));
+        return 2;
+    }
+    if ((jobs = read_manifest(argv[optind], &num_jobs)) == NULL) return 2;
+    if (num_workers > num_jobs) num_workers = num_jobs > 0 ? num_jobs : 1;
+
+    // Deal the jobs round-robin, in manifest order
+    deque_t *deques = calloc(num_workers, sizeof(*deques));
+    worker_t *workers = calloc(num_workers, sizeof(*workers));
+    pthread_t *threads = calloc(num_workers, sizeof(*threads));
+    for (int i = 0; i < num_workers; i++) {
+        pthread_mutex_init(&deques[i].lock, NULL);
+        deques[i].jobs = malloc((num_jobs / num_workers + 1) * sizeof(int));
+    }
+    for (int j = num_jobs - 1; j >= 0; j--) {
+        deque_t *d = &deques[j % num_workers];
+        d->jobs[d->tail++] = j;
+    }
+
+    double t0 = tool_now();
+    for (int i = 0; i < num_workers; i++) {
+        workers[i] = (worker_t){ .id = i, .deques = deques, .num_workers = num_workers, .jobs = jobs };
+        pthread_create(&threads[i], NULL, worker_main, &workers[i]);
+    }
+    int stolen = 0;
+    for (int i = 0; i < num_workers; i++) {
+        pthread_join(threads[i], NULL);
+        stolen += workers[i].stolen;
+    }
+    double wall = tool_now() - t0;
+
+    printf("%-24s %-6s %10s %14s %8s\n", "job", "result", "wall [s]", "instructions", "MIPS");
+    for (int j = 0; j < num_jobs; j++) {
+        const job_t *job = &jobs[j];
+        printf("%-24s %-6s %10.3f %14llu %8.2f", job->name, job_result(job), job->wall,
+               (unsigned long long)job->executed, job->wall > 0 ? job->executed / job->wall / 1e6 : 0.0);
+        if (job->error) {
+            printf("  %s: %s", job->image, job->error);
+        } else {
+            if (job->expect && !job->matched) printf("  output not seen");
+            if (job->until != UNTIL_NONE && !job->reached) printf("  end not reached");
+        }
+        printf("\n");
+
+        failed += !job->passed;
+        total_insns += job->executed;
+        job_time += job->wall;
+    }
+    printf("%d jobs, %d failed, %d threads, %d steals: %.3f s wall, %.3f s job time (%.1fx), %.2f MIPS total\n",
+           num_jobs, failed, num_workers, stolen, wall, job_time, wall > 0 ? job_time / wall : 0.0,
+           wall > 0 ? total_insns / wall / 1e6 : 0.0);
+
+    for (int i = 0; i < num_workers; i++) {
+        pthread_mutex_destroy(&deques[i].lock);
+        free(deques[i].jobs);
+    }
+    free_jobs(jobs, num_jobs);
+    free(deques);
+    free(workers);
+    free(threads);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * evm_fuzz.c
+ *
+ * Corpus runner for fuzzing guest input parsers: boots the images (or
+ * restores a snapshot) once, makes that state the baseline, then for every
+ * file of a corpus directory goes back to the baseline, feeds the file to a
+ * UART channel and runs until the guest waits for more input. Reports the
+ * inputs that crashed or hung and the executions per second.
+ *
+ * Built by CMake (native builds), or from evm-core:
+ *   cc -O2 -pthread -Iinclude -o evm_fuzz tools/evm_fuzz.c tools/evm_tool.c \
+ *      src/simulator*.c src/cpu_core_new.c src/cpu_cycles.c src/cpu_icache.c \
+ *      src/cpu_translate.c src/cpu_instructions.c src/exception_handlers.c \
+ *      src/steacalc.c src/stmem.c src/sttable.c
+ *
+ * Usage: evm_fuzz [options] corpus-dir [image[@addr] ...]
+ *   image           S-record file (.s19/.s28/.s37/.srec/.mot) or raw binary
+ *                   loaded at addr (default 0)
+ *   -r, --restore FILE
+ *                   start from the snapshot(s) in FILE (evm-run --save)
+ *                   instead of booting the images
+ *   -b, --boot N    boot for at most N instructions, until the guest waits
+ *                   for input (default 100000000)
+ *   -n, --insns N   instruction budget per input (default 10000000); an
+ *                   input that uses it up hung the guest
+ *   -x, --crash ADDR
+ *                   reaching ADDR is a crash, e.g. an exception handler
+ *                   (repeatable)
+ *   -c, --channel A|B
+ *                   UART channel the inputs go to (default A)
+ *   -l, --loops N   run the corpus N times (default 1)
+ *
+ * Numbers take C syntax (0x prefix for hex). The baseline is taken once;
+ * each input then only costs restoring the pages it changed
+ * (simulator_reset_to_baseline()) and running it. UART output is dropped.
+ *
+ * Exit status: 0 if no input crashed or hung, 1 otherwise, 2 on usage or
+ * load errors.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "simulator.h"
+#include "evm_tool.h"
+
+#define BATCH_INSNS     10000       /* Instructions between idle checks */
+#define MAX_CRASH_PCS   16
+
+/* ============================================================================
+ * Loading
+ * ============================================================================ */
+
+/* Load image[@addr]; entry is set if an S-record image names one */
+static void load_image(simulator_t *sim, char *arg, uint32_t *entry)
+{
+    char *at = strrchr(arg, '@');
+    uint32_t addr = 0, e = SIM_SREC_NO_ENTRY;
+    FILE *f;
+    int rc;
+
+    if (at) {
+        *at = '\0';
+        addr = (uint32_t)strtoul(at + 1, NULL, 0);
+    }
+    if ((f = fopen(arg, "rb")) == NULL) {
+        fprintf(stderr, "evm_fuzz: %s: %s\n", arg, strerror(errno));
+        exit(2);
+    }
+    rc = tool_is_srec(arg) ? tool_load_srec(sim, f, &e) : tool_load_binary(sim, f, addr);
+    fclose(f);
+    if (rc != 0) {
+        fprintf(stderr, "evm_fuzz: %s: bad image\n", arg);
+        exit(2);
+    }
+    /* ROM images end with S7/S9 0: boot through the reset vector */
+    if (e != SIM_SREC_NO_ENTRY && e != 0) *entry = e;
+}
+
+/* Load every snapshot in path, each following the one before */
+static void restore_snapshots(simulator_t *sim, const char *path)
+{
+    size_t len = 0, pos;
+    uint8_t *data = tool_read_file(path, &len);
+
+    if (data == NULL) {
+        fprintf(stderr, "evm_fuzz: %s: %s\n", path, strerror(errno));
+        exit(2);
+    }
+    if (tool_load_snapshots(sim, data, len, &pos) != 0) {
+        fprintf(stderr, "evm_fuzz: %s: bad snapshot at offset %zu\n", path, pos);
+        exit(2);
+    }
+    free(data);
+}
+
+/* ============================================================================
+ * Corpus
+ * ============================================================================ */
+
+typedef struct {
+    char *name;
+    uint8_t *data;
+    size_t len;
+} input_t;
+
+/* Read the regular files of dir, in name order */
+static input_t *read_corpus(const char *dir, int *count)
+{
+    struct dirent **names;
+    input_t *inputs;
+    int n = scandir(dir, &names, NULL, alphasort);
+
+    if (n < 0) {
+        fprintf(stderr, "evm_fuzz: %s: %s\n", dir, strerror(errno));
+        exit(2);
+    }
+    inputs = (input_t *)calloc(n > 0 ? (size_t)n : 1, sizeof(*inputs));
+    *count = 0;
+
+    for (int i = 0; i < n; i++) {
+        char *path;
+        struct stat st;
+
+        if (names[i]->d_name[0] != '.' && asprintf(&path, "%s/%s", dir, names[i]->d_name) >= 0) {
+            if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+                input_t *in = &inputs[*count];
+                if ((in->data = tool_read_file(path, &in->len)) != NULL) {
+                    in->name = strdup(names[i]->d_name);
+                    (*count)++;
+                }
+            }
+            free(path);
+        }
+        free(names[i]);
+    }
+    free(names);
+    return inputs;
+}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+
+#define RESULT_OK       0
+#define RESULT_CRASH    1
+#define RESULT_HANG     2
+
+/* Feed in (if any) and run until the guest waits for more input, the
+ * budget is used up or a crash address is reached */
+static int run_input(simulator_t *sim, int channel, const input_t *in, uint64_t insns,
+                     uint32_t stop_conditions, uint64_t *executed)
+{
+    uint8_t discard[4096];
+    size_t pos = 0;
+    uint64_t done = 0;
+
+    while (done < insns) {
+        uint64_t left = insns - done;
+
+        if (in && pos < in->len) {
+            pos += simulator_uart_push(sim, channel, in->data + pos, in->len - pos);
+        }
+        for (int c = 0; c < 2; c++) {
+            while (simulator_uart_pull(sim, c, discard, sizeof(discard)) > 0) {}
+        }
+        if (done > 0 && (in == NULL || pos == in->len) && simulator_is_idle(sim)) break;
+
+        uint32_t n = simulator_run_batch(sim, left < BATCH_INSNS ? (uint32_t)left : BATCH_INSNS, stop_conditions);
+        done += n;
+        if (simulator_get_stop_reason(sim) == SIM_STOPPED_BREAKPOINT) {
+            *executed += done;
+            return RESULT_CRASH;
+        }
+        if (n == 0) break;              /* The CPU cannot go on */
+    }
+    *executed += done;
+    return done < insns && simulator_is_idle(sim) ? RESULT_OK : RESULT_HANG;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: evm_fuzz [options] corpus-dir [image[@addr] ...]\n"
+            "  -r, --restore FILE  start from the snapshots in FILE\n"
+            "  -b, --boot N        boot for at most N instructions\n"
+            "  -n, --insns N       instruction budget per input\n"
+            "  -x, --crash ADDR    reaching ADDR is a crash (repeatable)\n"
+            "  -c, --channel A|B   UART channel of the inputs (default A)\n"
+            "  -l, --loops N       run the corpus N times\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "restore", required_argument, NULL, 'r' },
+        { "boot",    required_argument, NULL, 'b' },
+        { "insns",   required_argument, NULL, 'n' },
+        { "crash",   required_argument, NULL, 'x' },
+        { "channel", required_argument, NULL, 'c' },
+        { "loops",   required_argument, NULL, 'l' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *restore = NULL;
+    uint64_t boot = 100000000, insns = 10000000, executed = 0, boot_executed = 0;
+    uint32_t crash_pc[MAX_CRASH_PCS], entry = 0;
+    int num_crash_pc = 0, channel = SIM_UART_A, loops = 1, opt;
+    int count, runs = 0, crashes = 0, hangs = 0;
+    simulator_t *sim;
+
+    while ((opt = getopt_long(argc, argv, "r:b:n:x:c:l:", options, NULL)) != -1) {
+        switch (opt) {
+        case 'r': restore = optarg; break;
+        case 'b': boot = strtoull(optarg, NULL, 0); break;
+        case 'n': insns = strtoull(optarg, NULL, 0); break;
+        case 'x':
+            if (num_crash_pc == MAX_CRASH_PCS) usage();
+            crash_pc[num_crash_pc++] = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            if ((optarg[0] != 'A' && optarg[0] != 'B') || optarg[1]) usage();
+            channel = optarg[0] == 'A' ? SIM_UART_A : SIM_UART_B;
+            break;
+        case 'l': loops = atoi(optarg); break;
+        default:  usage();
+        }
+    }
+    if (optind == argc || (optind + 1 == argc && restore == NULL) || insns == 0) usage();
+
+    input_t *inputs = read_corpus(argv[optind], &count);
+    if (count == 0) {
+        fprintf(stderr, "evm_fuzz: %s: no inputs\n", argv[optind]);
+        return 2;
+    }
+
+    sim = simulator_init();
+    if (sim == NULL || simulator_load_modules(sim) != 0) {
+        fprintf(stderr, "evm_fuzz: simulator setup failed\n");
+        return 2;
+    }
+    simulator_set_uart_fd(sim, SIM_UART_A, -1);
+    simulator_set_uart_fd(sim, SIM_UART_B, -1);
+
+    /* The reset clears RAM, so the images go in after it and the CPU takes
+       its vectors from them */
+    if (restore == NULL) simulator_reset(sim);
+    for (int i = optind + 1; i < argc; i++) {
+        load_image(sim, argv[i], &entry);
+    }
+    if (restore) {
+        restore_snapshots(sim, restore);
+    } else {
+        simulator_reset_cpu(sim);
+        if (entry) {
+            sim->cpu.pc = entry & 0xFFFFFF;
+        }
+        if (boot > 0) run_input(sim, channel, NULL, boot, SIM_STOP_NONE, &boot_executed);
+        fprintf(stderr, "evm_fuzz: baseline after %llu boot instructions\n",
+                (unsigned long long)boot_executed);
+    }
+
+    for (int i = 0; i < num_crash_pc; i++) {
+        simulator_set_breakpoint(sim, crash_pc[i]);
+    }
+    if (simulator_set_baseline(sim) != 0) {
+        fprintf(stderr, "evm_fuzz: cannot take the baseline\n");
+        return 2;
+    }
+
+    double t0 = tool_now();
+    for (int loop = 0; loop < loops; loop++) {
+        for (int i = 0; i < count; i++) {
+            int result;
+
+            simulator_reset_to_baseline(sim);
+            result = run_input(sim, channel, &inputs[i], insns,
+                               num_crash_pc ? SIM_STOP_BREAKPOINT : SIM_STOP_NONE, &executed);
+            runs++;
+
+            /* Report each input once, on the first loop */
+            if (result == RESULT_CRASH) {
+                crashes++;
+                if (loop == 0) printf("CRASH %s (PC 0x%06X)\n", inputs[i].name, sim->cpu.pc);
+            } else if (result == RESULT_HANG) {
+                hangs++;
+                if (loop == 0) printf("HANG  %s\n", inputs[i].name);
+            }
+        }
+    }
+    double wall = tool_now() - t0;
+
+    printf("%d inputs, %d runs: %d crashes, %d hangs; %llu instructions in %.3f s, "
+           "%.0f execs/s, %.2f MIPS\n",
+           count, runs, crashes, hangs, (unsigned long long)executed, wall,
+           wall > 0 ? runs / wall : 0.0, wall > 0 ? executed / wall / 1e6 : 0.0);
+
+    for (int i = 0; i < count; i++) {
+        free(inputs[i].name);
+        free(inputs[i].data);
+    }
+    free(inputs);
+    simulator_destroy(sim);
+    return crashes || hangs ? 1 : 0;
+}
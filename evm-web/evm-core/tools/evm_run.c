@@ -0,0 +1,526 @@
+/*
+ * evm_run.c
+ *
+ * Headless simulator: loads S-record or binary images into one simulator
+ * instance and runs it with the DUART channels connected to stdin/stdout
+ * or files. Reports instructions executed and MIPS at exit.
+ *
+ * Built by CMake as evm-run (native builds), or from evm-core:
+ *   cc -O2 -pthread -Iinclude -o evm-run tools/evm_run.c tools/evm_tool.c \
+ *      src/simulator*.c src/cpu_core_new.c src/cpu_cycles.c src/cpu_icache.c \
+ *      src/cpu_translate.c src/cpu_instructions.c src/exception_handlers.c \
+ *      src/steacalc.c src/stmem.c src/sttable.c
+ *
+ * Usage: evm-run [options] [image[@addr] ...]
+ *   image           S-record file (.s19/.s28/.s37/.srec/.mot), memory image
+ *                   (.evmi), or raw binary loaded at addr (default 0). A
+ *                   non-zero S7/S8/S9 entry point replaces the PC from the
+ *                   reset vector.
+ *   -c, --cache DIR keep a memory image of the first image in DIR and load
+ *                   that instead while the source is unchanged
+ *   -n, --insns N   stop after N instructions (default: no limit)
+ *   -r, --restore FILE
+ *                   start from the snapshot(s) in FILE instead of a reset;
+ *                   images are optional then and load before the snapshot
+ *   -w, --save FILE write a snapshot of the machine to FILE at exit
+ *   --checkpoint N  with --save, also write one every N instructions
+ *   -s, --until-stop
+ *                   stop when the CPU executes STOP #imm
+ *   -u, --until ADDR
+ *                   stop when the PC reaches ADDR
+ *   --a-in FILE     channel A receive data (default: stdin)
+ *   --a-out FILE    channel A transmit data (default: stdout)
+ *   --b-in FILE     channel B receive data (default: none)
+ *   --b-out FILE    channel B transmit data (default: none)
+ *
+ * FILE '-' is stdin or stdout. The run also ends on SIGINT/SIGTERM.
+ *
+ * The first image, if it is a memory image (given directly or from the
+ * cache), is mapped into the process and backs the boot ROM without a copy.
+ * Later images are copied into memory as usual.
+ *
+ * A snapshot file holds one full snapshot followed by incremental ones, each
+ * with the pages written since the one before (see simulator_snapshot.c).
+ * --restore loads them in order, so it resumes from the last checkpoint.
+ *
+ * While the CPU is stopped (STOP #imm) or polls a device, and a terminal,
+ * pipe or socket can still deliver input, each batch starts with a sleep of
+ * up to 10 ms that ends when input arrives. The batches themselves skip the
+ * idle time up to the next device event.
+ *
+ * Exit status: 0 if the run ended on its stop condition, or on the
+ * instruction limit or a signal when no stop condition was given; 1 if a
+ * stop condition was given but not reached; 2 on usage or load errors.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "simulator.h"
+#include "evm_tool.h"
+
+#define BATCH_INSNS     100000      /* Instructions between host polls */
+#define IDLE_TICK_MS    10          /* Longest sleep while the CPU waits */
+
+/* ============================================================================
+ * UART channels
+ * ============================================================================ */
+
+typedef struct {
+    int in;                         /* Receive fd, -1 for none */
+    int in_flags;                   /* File status flags to restore */
+    int live;                       /* Input can block (terminal, pipe, ...) */
+    uint8_t buf[4096];              /* Read, not yet queued for the CPU */
+    int head, len;
+} channel_t;
+
+static channel_t channels[2];
+
+/* Open the input of a channel for polling */
+static void open_input(channel_t *ch, const char *path)
+{
+    int fd = strcmp(path, "-") == 0 ? dup(STDIN_FILENO) : open(path, O_RDONLY);
+    struct stat st;
+
+    if (fd < 0) {
+        fprintf(stderr, "evm-run: %s: %s\n", path, strerror(errno));
+        exit(2);
+    }
+    ch->live = fstat(fd, &st) == 0 && !S_ISREG(st.st_mode);
+    // A terminal shares the flags with the shell, close_input() restores them
+    ch->in_flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, ch->in_flags | O_NONBLOCK);
+    ch->in = fd;
+}
+
+static void close_input(channel_t *ch)
+{
+    if (ch->in < 0) return;
+    fcntl(ch->in, F_SETFL, ch->in_flags);
+    close(ch->in);
+    ch->in = -1;
+}
+
+/* Queue what input is there in the receive FIFO (the fds are non-blocking) */
+static void feed_input(simulator_t *sim, int channel)
+{
+    channel_t *ch = &channels[channel];
+
+    if (ch->in < 0) return;
+    if (ch->head == ch->len) {
+        ssize_t n = read(ch->in, ch->buf, sizeof(ch->buf));
+        if (n <= 0) {
+            if (n == 0) close_input(ch);    /* End of file */
+            return;
+        }
+        ch->head = 0;
+        ch->len = (int)n;
+    }
+    ch->head += (int)simulator_uart_push(sim, channel, ch->buf + ch->head, ch->len - ch->head);
+}
+
+static int open_output(const char *path)
+{
+    int fd = strcmp(path, "-") == 0 ? STDOUT_FILENO : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd < 0) {
+        fprintf(stderr, "evm-run: %s: %s\n", path, strerror(errno));
+        exit(2);
+    }
+    return fd;
+}
+
+/* The CPU waits for a device: sleep until input arrives or IDLE_TICK_MS pass */
+static void idle_wait(void)
+{
+    struct pollfd fds[2];
+    int n = 0;
+
+    for (int c = 0; c < 2; c++) {
+        channel_t *ch = &channels[c];
+
+        if (ch->in < 0 || !ch->live) continue;
+        if (ch->head != ch->len) return;        /* Data not taken yet */
+        fds[n].fd = ch->in;
+        fds[n].events = POLLIN;
+        n++;
+    }
+    if (n > 0) poll(fds, n, IDLE_TICK_MS);
+}
+
+/* ============================================================================
+ * Image loading
+ * ============================================================================ */
+
+/* Entry point of the last S-record image that had one, 0 for none */
+static uint32_t entry_pc;
+
+/* Stream an S-record file into memory */
+static int load_srec(simulator_t *sim, FILE *f)
+{
+    uint32_t entry;
+
+    if (tool_load_srec(sim, f, &entry) != 0) return -1;
+
+    /* ROM images end with S7/S9 0: boot through the reset vector */
+    if (entry != SIM_SREC_NO_ENTRY && entry != 0) entry_pc = entry;
+    return 0;
+}
+
+/* Map a whole file, private so the simulator may write to it; NULL if empty */
+static void *map_file(int fd, size_t *len)
+{
+    struct stat st;
+    void *p;
+
+    if (fstat(fd, &st) != 0 || st.st_size == 0) return NULL;
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) return NULL;
+    *len = (size_t)st.st_size;
+    return p;
+}
+
+/* Load a mapped memory image, the first one backs the boot ROM */
+static int load_mapped_image(simulator_t *sim, void *data, size_t len, int first)
+{
+    uint32_t entry;
+
+    if (simulator_load_image(sim, data, len, first ? SIM_IMAGE_MAP_ROM : 0, &entry) != 0) return -1;
+    if (entry != SIM_SREC_NO_ENTRY && entry != 0) entry_pc = entry;
+    /* A mapped ROM stays in use, the mapping goes away at exit */
+    if (!first) munmap(data, len);
+    return 0;
+}
+
+/* Cache file of path: DIR/<name>.evmi */
+static char *cache_path(const char *dir, const char *path)
+{
+    const char *name = strrchr(path, '/');
+    char *out;
+
+    name = name ? name + 1 : path;
+    if (asprintf(&out, "%s/%s.evmi", dir, name) < 0) return NULL;
+    return out;
+}
+
+/* Write a cache file under a temporary name first, so readers never see half of it */
+static void write_cache(const char *path, const void *data, size_t len)
+{
+    char *tmp;
+    FILE *f;
+
+    if (asprintf(&tmp, "%s.%ld", path, (long)getpid()) < 0) return;
+    if ((f = fopen(tmp, "wb")) != NULL) {
+        int ok = fwrite(data, 1, len, f) == len;
+        if (fclose(f) == 0 && ok && rename(tmp, path) == 0) {
+            free(tmp);
+            return;
+        }
+    }
+    fprintf(stderr, "evm-run: %s: cannot write cache\n", path);
+    unlink(tmp);
+    free(tmp);
+}
+
+/* Load the first image through the cache in dir; -1 on a bad source image */
+static int load_cached(simulator_t *sim, int fd, const char *path, uint32_t addr, const char *dir)
+{
+    char *cache = cache_path(dir, path);
+    size_t len = 0, image_len = 0;
+    void *source = map_file(fd, &len);
+    void *image = NULL;
+    uint64_t hash, cached;
+    uint32_t entry;
+    int cfd, rc;
+
+    if (cache == NULL || source == NULL) {
+        free(cache);
+        if (source) munmap(source, len);
+        return -2;
+    }
+    hash = simulator_hash(source, len);
+
+    /* Binaries at another address are another image */
+    if (!tool_is_srec(path)) hash ^= (uint64_t)addr * 0x9E3779B97F4A7C15ULL;
+
+    if ((cfd = open(cache, O_RDONLY)) >= 0) {
+        image = map_file(cfd, &image_len);
+        close(cfd);
+        if (image && simulator_image_check(image, image_len, &cached, NULL) == 0 && cached == hash) {
+            munmap(source, len);
+            free(cache);
+            return load_mapped_image(sim, image, image_len, 1);
+        }
+        if (image) munmap(image, image_len);
+    }
+
+    /* Miss: parse the source and keep what it loaded */
+    if (tool_is_srec(path)) {
+        simulator_srec_t *srec = simulator_srec_begin(sim);
+        if (srec == NULL) {
+            rc = -1;
+        } else {
+            simulator_srec_feed(srec, source, len);
+            image = simulator_srec_image(srec, &image_len);
+            rc = simulator_srec_end(srec, &entry);
+            if (rc == 0 && entry != SIM_SREC_NO_ENTRY && entry != 0) entry_pc = entry;
+        }
+    } else {
+        simulator_segment_t seg = { addr, (uint32_t)len };
+        simulator_load_program(sim, source, len, addr);
+        image = simulator_image_build(sim, &seg, 1, SIM_SREC_NO_ENTRY, hash, &image_len);
+        rc = 0;
+    }
+    if (rc == 0 && image) write_cache(cache, image, image_len);
+
+    free(image);
+    munmap(source, len);
+    free(cache);
+    return rc;
+}
+
+/* Load image[@addr], going through the cache if it is the first one */
+static void load_image(simulator_t *sim, char *arg, int first, const char *cache_dir)
+{
+    char *at = strrchr(arg, '@');
+    uint32_t addr = 0;
+    FILE *f;
+    int rc = -2;
+
+    if (at) {
+        *at = '\0';
+        addr = (uint32_t)strtoul(at + 1, NULL, 0);
+    }
+    if ((f = fopen(arg, "rb")) == NULL) {
+        fprintf(stderr, "evm-run: %s: %s\n", arg, strerror(errno));
+        exit(2);
+    }
+    if (tool_has_ext(arg, ".evmi")) {
+        size_t len;
+        void *image = map_file(fileno(f), &len);
+        rc = image ? load_mapped_image(sim, image, len, first) : -1;
+    } else if (first && cache_dir) {
+        rc = load_cached(sim, fileno(f), arg, addr, cache_dir);
+    }
+    /* Empty or unmappable files take the plain path */
+    if (rc == -2) {
+        rc = tool_is_srec(arg) ? load_srec(sim, f) : tool_load_binary(sim, f, addr);
+    }
+    fclose(f);
+    if (rc != 0) {
+        fprintf(stderr, "evm-run: %s: bad image\n", arg);
+        exit(2);
+    }
+}
+
+/* ============================================================================
+ * Snapshots
+ * ============================================================================ */
+
+/* Load every snapshot in path, each following the one before */
+static void restore_snapshots(simulator_t *sim, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    size_t len = 0, pos;
+    uint8_t *data;
+
+    if (fd < 0) {
+        fprintf(stderr, "evm-run: %s: %s\n", path, strerror(errno));
+        exit(2);
+    }
+    data = (uint8_t *)map_file(fd, &len);
+    close(fd);
+    if (data == NULL) {
+        fprintf(stderr, "evm-run: %s: bad snapshot\n", path);
+        exit(2);
+    }
+    if (tool_load_snapshots(sim, data, len, &pos) != 0) {
+        fprintf(stderr, "evm-run: %s: bad snapshot at offset %zu\n", path, pos);
+        exit(2);
+    }
+    munmap(data, len);
+}
+
+/* Append a snapshot to f, the first one written is a full one */
+static void write_snapshot(simulator_t *sim, FILE *f, const char *path)
+{
+    static int written;
+    size_t len;
+    void *snap = simulator_snapshot_save(sim, written ? SIM_SNAPSHOT_INCREMENTAL : 0, &len);
+
+    if (snap == NULL || fwrite(snap, 1, len, f) != len || fflush(f) != 0) {
+        fprintf(stderr, "evm-run: %s: cannot write snapshot\n", path);
+        exit(2);
+    }
+    free(snap);
+    written = 1;
+}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+
+static volatile sig_atomic_t interrupted;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: evm-run [options] [image[@addr] ...]\n"
+            "  -c, --cache DIR    cache a memory image of the first image in DIR\n"
+            "  -r, --restore FILE start from the snapshots in FILE\n"
+            "  -w, --save FILE    write a snapshot to FILE at exit\n"
+            "      --checkpoint N with --save, also every N instructions\n"
+            "  -n, --insns N      stop after N instructions\n"
+            "  -s, --until-stop   stop when the CPU executes STOP\n"
+            "  -u, --until ADDR   stop when the PC reaches ADDR\n"
+            "      --a-in FILE    channel A input (default: stdin)\n"
+            "      --a-out FILE   channel A output (default: stdout)\n"
+            "      --b-in FILE    channel B input\n"
+            "      --b-out FILE   channel B output\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "cache",      required_argument, NULL, 'c' },
+        { "restore",    required_argument, NULL, 'r' },
+        { "save",       required_argument, NULL, 'w' },
+        { "checkpoint", required_argument, NULL, 'k' },
+        { "insns",      required_argument, NULL, 'n' },
+        { "until-stop", no_argument,       NULL, 's' },
+        { "until",      required_argument, NULL, 'u' },
+        { "a-in",       required_argument, NULL, 'a' },
+        { "a-out",      required_argument, NULL, 'A' },
+        { "b-in",       required_argument, NULL, 'b' },
+        { "b-out",      required_argument, NULL, 'B' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *a_in = "-", *a_out = "-", *b_in = NULL, *b_out = NULL, *cache_dir = NULL;
+    const char *restore = NULL, *save = NULL;
+    uint64_t limit = UINT64_MAX, executed = 0, checkpoint = 0, next_checkpoint = UINT64_MAX;
+    uint32_t stop_conditions = SIM_STOP_NONE, until_pc = 0;
+    int opt, reason = SIM_STOPPED_BUDGET;
+    simulator_t *sim;
+    FILE *save_file = NULL;
+
+    while ((opt = getopt_long(argc, argv, "c:r:w:n:su:", options, NULL)) != -1) {
+        switch (opt) {
+        case 'c': cache_dir = optarg; break;
+        case 'r': restore = optarg; break;
+        case 'w': save = optarg; break;
+        case 'k': checkpoint = strtoull(optarg, NULL, 0); break;
+        case 'n': limit = strtoull(optarg, NULL, 0); break;
+        case 's': stop_conditions |= SIM_STOP_ON_STOP; break;
+        case 'u': until_pc = (uint32_t)strtoul(optarg, NULL, 0); stop_conditions |= SIM_STOP_BREAKPOINT; break;
+        case 'a': a_in = optarg; break;
+        case 'A': a_out = optarg; break;
+        case 'b': b_in = optarg; break;
+        case 'B': b_out = optarg; break;
+        default:  usage();
+        }
+    }
+    if (optind == argc && restore == NULL) usage();
+    if (checkpoint && save == NULL) usage();
+
+    sim = simulator_init();
+    if (sim == NULL || simulator_load_modules(sim) != 0) {
+        fprintf(stderr, "evm-run: simulator setup failed\n");
+        return 2;
+    }
+    // The reset clears RAM, so the images go in after it and the CPU takes
+    // its vectors from them
+    if (restore == NULL) simulator_reset(sim);
+    for (int i = optind; i < argc; i++) {
+        load_image(sim, argv[i], i == optind, cache_dir);
+    }
+    if (restore) {
+        restore_snapshots(sim, restore);
+    } else {
+        simulator_reset_cpu(sim);
+        if (entry_pc) {
+            sim->cpu.pc = entry_pc & 0xFFFFFF;
+        }
+    }
+    if (stop_conditions & SIM_STOP_BREAKPOINT) {
+        simulator_set_breakpoint(sim, until_pc);
+    }
+
+    channels[SIM_UART_B].in = -1;
+    open_input(&channels[SIM_UART_A], a_in);
+    if (b_in) open_input(&channels[SIM_UART_B], b_in);
+    simulator_set_uart_fd(sim, SIM_UART_A, open_output(a_out));
+    simulator_set_uart_fd(sim, SIM_UART_B, open_output(b_out ? b_out : "/dev/null"));
+
+    // Opened after the restore, which may read the same file
+    if (save) {
+        if ((save_file = fopen(save, "wb")) == NULL) {
+            fprintf(stderr, "evm-run: %s: %s\n", save, strerror(errno));
+            return 2;
+        }
+        if (checkpoint) next_checkpoint = checkpoint;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    double t0 = tool_now();
+    while (executed < limit && !interrupted) {
+        uint64_t left = limit - executed;
+        uint32_t count = left < BATCH_INSNS ? (uint32_t)left : BATCH_INSNS;
+
+        if (executed >= next_checkpoint) {
+            write_snapshot(sim, save_file, save);
+            next_checkpoint += checkpoint;
+        }
+        if (next_checkpoint - executed < count) {
+            count = (uint32_t)(next_checkpoint - executed);
+        }
+        if (simulator_is_idle(sim)) {
+            idle_wait();
+        }
+        feed_input(sim, SIM_UART_A);
+        feed_input(sim, SIM_UART_B);
+        // The batch returns at STOP, so the idle time starts with a wait
+        executed += simulator_run_batch(sim, count, stop_conditions | SIM_STOP_ON_STOP);
+        reason = simulator_get_stop_reason(sim);
+        if (reason == SIM_STOPPED_STOP && !(stop_conditions & SIM_STOP_ON_STOP)) {
+            reason = SIM_STOPPED_BUDGET;
+        }
+        if (reason == SIM_STOPPED_STOP || reason == SIM_STOPPED_BREAKPOINT) break;
+    }
+    double wall = tool_now() - t0;
+
+    for (int c = 0; c < 2; c++) {
+        close_input(&channels[c]);
+    }
+    fprintf(stderr, "evm-run: %llu instructions, %llu cycles in %.3f s, %.2f MIPS (%s)\n",
+            (unsigned long long)executed, (unsigned long long)simulator_get_clock(sim), wall,
+            wall > 0 ? executed / wall / 1e6 : 0.0,
+            reason == SIM_STOPPED_STOP ? "STOP" :
+            reason == SIM_STOPPED_BREAKPOINT ? "breakpoint" :
+            interrupted ? "interrupted" : "instruction limit");
+
+    if (save_file) {
+        write_snapshot(sim, save_file, save);
+        fclose(save_file);
+    }
+    simulator_destroy(sim);
+    if (stop_conditions == SIM_STOP_NONE) return 0;
+    return (reason == SIM_STOPPED_STOP || reason == SIM_STOPPED_BREAKPOINT) ? 0 : 1;
+}
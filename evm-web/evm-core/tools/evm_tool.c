@@ -0,0 +1,100 @@
+/*
+ * evm_tool.c
+ *
+ * Helpers shared by the native tools, see evm_tool.h. Built by CMake into
+ * the evmtool library the tools link with.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "evm_tool.h"
+
+int tool_has_ext(const char *path, const char *ext)
+{
+    const char *dot = strrchr(path, '.');
+    return dot && strcasecmp(dot, ext) == 0;
+}
+
+int tool_is_srec(const char *path)
+{
+    static const char *const ext[] = { ".s19", ".s28", ".s37", ".srec", ".mot" };
+
+    for (size_t i = 0; i < sizeof(ext) / sizeof(ext[0]); i++) {
+        if (tool_has_ext(path, ext[i])) return 1;
+    }
+    return 0;
+}
+
+uint8_t *tool_read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    struct stat st;
+    uint8_t *data = NULL;
+
+    if (f == NULL) return NULL;
+    if (fstat(fileno(f), &st) == 0 && (data = (uint8_t *)malloc((size_t)st.st_size + 1)) != NULL) {
+        *len = fread(data, 1, (size_t)st.st_size, f);
+        if (ferror(f)) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    return data;
+}
+
+int tool_load_srec(simulator_t *sim, FILE *f, uint32_t *entry)
+{
+    simulator_srec_t *srec = simulator_srec_begin(sim);
+    char buf[16384];
+    size_t len;
+
+    if (srec == NULL) return -1;
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+        if (simulator_srec_feed(srec, buf, len) != 0) break;
+    }
+    if (simulator_srec_end(srec, entry) != 0 || ferror(f)) return -1;
+    return 0;
+}
+
+int tool_load_binary(simulator_t *sim, FILE *f, uint32_t addr)
+{
+    uint8_t data[4096];
+    size_t len;
+
+    while ((len = fread(data, 1, sizeof(data), f)) > 0) {
+        simulator_load_program(sim, data, len, addr);
+        addr += len;
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+int tool_load_snapshots(simulator_t *sim, const uint8_t *data, size_t len, size_t *bad)
+{
+    size_t pos, size;
+
+    /* An empty file holds no machine state */
+    if (len == 0) {
+        if (bad) *bad = 0;
+        return -1;
+    }
+    for (pos = 0; pos < len; pos += size) {
+        size = simulator_snapshot_size(data + pos, len - pos);
+        if (size == 0 || simulator_snapshot_load(sim, data + pos, len - pos) != 0) {
+            if (bad) *bad = pos;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+double tool_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
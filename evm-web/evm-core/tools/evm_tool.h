@@ -0,0 +1,41 @@
+/*
+ * evm_tool.h
+ *
+ * Helpers shared by the native tools (evm-run, evm_farm, evm_fuzz): image
+ * and snapshot loading and wall clock time. They report failures through
+ * their return value and leave the message to the tool.
+ */
+
+#ifndef EVM_TOOL_H
+#define EVM_TOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "simulator.h"
+
+/* Non-zero if path ends in ext (case-insensitive, e.g. ".snap") */
+int tool_has_ext(const char *path, const char *ext);
+
+/* Non-zero for S-record files: .s19, .s28, .s37, .srec or .mot */
+int tool_is_srec(const char *path);
+
+/* Read a whole file; NULL on error (errno set). Free with free(). */
+uint8_t *tool_read_file(const char *path, size_t *len);
+
+/* Stream an S-record file into memory. entry gets the S7/S8/S9 entry
+   point, or SIM_SREC_NO_ENTRY. Returns 0 on success. */
+int tool_load_srec(simulator_t *sim, FILE *f, uint32_t *entry);
+
+/* Copy a raw binary into memory at addr. Returns 0 on success. */
+int tool_load_binary(simulator_t *sim, FILE *f, uint32_t addr);
+
+/* Load the snapshots in data, one full one and the incremental ones that
+   follow it, in order. Returns 0 on success; on error, -1 with the offset
+   of the snapshot that failed in *bad (if not NULL). */
+int tool_load_snapshots(simulator_t *sim, const uint8_t *data, size_t len, size_t *bad);
+
+/* Monotonic wall clock in seconds */
+double tool_now(void);
+
+#endif /* EVM_TOOL_H */
@@ -0,0 +1,246 @@
+/*
+ * gen_sttable.c
+ *
+ * Generates src/sttable.c, the two-level opcode dispatch table, from the
+ * flat 65536 entry Operation[] table of the original simulator
+ * (EVMSim/sttable.c): every distinct handler gets an index into
+ * OperationHandlers[] in order of its first opcode, OperationIndex[] maps
+ * each opcode word to that index.
+ *
+ * Built by CMake (native builds), which also runs it with --check as a
+ * test, or from evm-core:
+ *   cc -O2 -o gen_sttable tools/gen_sttable.c
+ *
+ * Usage: gen_sttable [-c|--check] flat-table.c [sttable.c]
+ *   Without an output file the table goes to stdout. With --check the
+ *   output file is not written but compared with the generated table.
+ *
+ * Exit status: 0 on success (or no difference), 1 if --check found a
+ * difference, 2 on usage or read errors.
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_OPCODES     65536
+#define MAX_HANDLERS    256         /* Indices are one byte */
+#define MAX_NAME        64
+
+static const char header[] =
+    "////////////////////////////////////////////////////////////////////////////////\n"
+    "// Opcode dispatch table\n"
+    "// OperationIndex[] maps every 16 bit opcode word to a one byte index into\n"
+    "// OperationHandlers[], 64KB plus a few hundred bytes instead of 65536\n"
+    "// function pointers. Handlers are listed in order of their first opcode.\n"
+    "// Generated by tools/gen_sttable.c from EVMSim/sttable.c - do not edit.\n"
+    "////////////////////////////////////////////////////////////////////////////////\n"
+    "#include <stdint.h>\n"
+    "#include \"simulator_internal.h\"\n"
+    "\n";
+
+/* Growable output text */
+typedef struct {
+    char *data;
+    size_t len, size;
+} text_t;
+
+static void put(text_t *t, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    for (;;) {
+        va_start(ap, fmt);
+        n = vsnprintf(t->data + t->len, t->size - t->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) exit(2);
+        if (t->len + (size_t)n < t->size) break;
+        t->size = (t->size + (size_t)n) * 2;
+        t->data = realloc(t->data, t->size);
+        if (t->data == NULL) exit(2);
+    }
+    t->len += (size_t)n;
+}
+
+/* Read a whole file, NUL terminated; NULL on error */
+static char *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    char *data = NULL;
+    long size;
+
+    if (f == NULL) return NULL;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)size + 1);
+        if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    if (data == NULL) return NULL;
+    data[size] = '\0';
+    *len = (size_t)size;
+    return data;
+}
+
+/* Split into lines in place, dropping CRs; returns the number of lines */
+static size_t split_lines(char *data, char ***lines)
+{
+    size_t count = 0, size = 1024;
+    char *p = data;
+
+    *lines = malloc(size * sizeof(char *));
+    while (*lines != NULL && *p) {
+        char *end = strchr(p, '\n');
+        if (count == size) {
+            size *= 2;
+            *lines = realloc(*lines, size * sizeof(char *));
+            if (*lines == NULL) break;
+        }
+        (*lines)[count++] = p;
+        if (end == NULL) break;
+        if (end > p && end[-1] == '\r') end[-1] = '\0';
+        *end = '\0';
+        p = end + 1;
+    }
+    return *lines != NULL ? count : 0;
+}
+
+/* Build the compact tables from the flat one; 0 on success */
+static int generate(char **lines, size_t count, text_t *out, const char *path)
+{
+    static char handlers[MAX_HANDLERS][MAX_NAME];
+    static unsigned char index[NUM_OPCODES];
+    int num_handlers = 0;
+    size_t opcode = 0, i = 0;
+
+    put(out, "%s", header);
+
+    /* Handler declarations, verbatim */
+    for (; i < count && strstr(lines[i], "(*Operation[])") == NULL; i++) {
+        if (strncmp(lines[i], "extern ", 7) == 0) put(out, "%s\n", lines[i]);
+    }
+    if (i == count) {
+        fprintf(stderr, "%s: no Operation[] table\n", path);
+        return -1;
+    }
+
+    /* One "\tCOM_xxx, // $XXXX" line per opcode */
+    for (i++; i < count && opcode < NUM_OPCODES; i++) {
+        const char *p = lines[i];
+        char name[MAX_NAME];
+        size_t n = 0;
+        int h;
+
+        while (isspace((unsigned char)*p)) p++;
+        while ((isalnum((unsigned char)*p) || *p == '_') && n < MAX_NAME - 1) name[n++] = *p++;
+        name[n] = '\0';
+        if (n == 0) continue;               /* "{" */
+
+        for (h = 0; h < num_handlers && strcmp(handlers[h], name) != 0; h++) {
+        }
+        if (h == num_handlers) {
+            if (num_handlers == MAX_HANDLERS) {
+                fprintf(stderr, "%s: more than %d handlers\n", path, MAX_HANDLERS);
+                return -1;
+            }
+            strcpy(handlers[num_handlers++], name);
+        }
+        index[opcode++] = (unsigned char)h;
+    }
+    if (opcode != NUM_OPCODES) {
+        fprintf(stderr, "%s: %zu opcodes, expected %d\n", path, opcode, NUM_OPCODES);
+        return -1;
+    }
+
+    put(out, "\nconst opcode_handler_t OperationHandlers[]=\n{\n");
+    for (int h = 0; h < num_handlers; h++) put(out, "\t%s,\t// %d\n", handlers[h], h);
+    put(out, "};\n"
+             "const int OperationHandlerCount=sizeof(OperationHandlers)/sizeof(OperationHandlers[0]);\n"
+             "\n"
+             "const uint8_t OperationIndex[65536]=\n{\n");
+    for (opcode = 0; opcode < NUM_OPCODES; opcode += 16) {
+        put(out, "\t");
+        for (int k = 0; k < 16; k++) put(out, k ? ",%d" : "%d", index[opcode + k]);
+        put(out, "%s // $%04zX\n", opcode + 16 < NUM_OPCODES ? "," : "", opcode);
+    }
+    put(out, "};\n");
+    return 0;
+}
+
+/* --check: 0 if path holds the generated table, 1 if not, 2 on errors */
+static int compare(const text_t *out, const char *flat, const char *path)
+{
+    size_t len = 0;
+    char *current = read_file(path, &len);
+    int differs;
+
+    if (current == NULL) {
+        perror(path);
+        return 2;
+    }
+    differs = len != out->len || memcmp(current, out->data, len) != 0;
+    free(current);
+    if (differs) {
+        fprintf(stderr, "%s is out of date, regenerate it with gen_sttable %s %s\n", path, flat, path);
+        return 1;
+    }
+    return 0;
+}
+
+/* Write the table to path, or stdout if NULL */
+static int write_table(const text_t *out, const char *path)
+{
+    FILE *f = path ? fopen(path, "wb") : stdout;
+
+    if (f == NULL || fwrite(out->data, 1, out->len, f) != out->len || fflush(f) != 0) {
+        perror(path ? path : "stdout");
+        if (f != NULL && f != stdout) fclose(f);
+        return 2;
+    }
+    if (f != stdout && fclose(f) != 0) {
+        perror(path);
+        return 2;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int check = 0, status;
+    text_t out = { NULL, 0, 0 };
+    char *data, **lines;
+    size_t len;
+
+    if (argc > 1 && (strcmp(argv[1], "-c") == 0 || strcmp(argv[1], "--check") == 0)) {
+        check = 1;
+        argc--;
+        argv++;
+    }
+    if (argc < 2 || argc > 3 || (check && argc != 3)) {
+        fprintf(stderr, "Usage: gen_sttable [-c|--check] flat-table.c [sttable.c]\n");
+        return 2;
+    }
+
+    data = read_file(argv[1], &len);
+    if (data == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+    len = split_lines(data, &lines);
+    if (generate(lines, len, &out, argv[1]) != 0) {
+        status = 2;
+    } else if (check) {
+        status = compare(&out, argv[1], argv[2]);
+    } else {
+        status = write_table(&out, argc == 3 ? argv[2] : NULL);
+    }
+    free(lines);
+    free(data);
+    free(out.data);
+    return status;
+}
@@ -12,6 +12,18 @@
 /* Global simulator context */
 static simulator_t *g_simulator = NULL;
 
+/* S-record image being loaded, see cpu_srec_begin() */
+static simulator_srec_t *g_srec = NULL;
+
+/* Finish an S-record load left open, before its simulator goes away */
+static void srec_drop(void)
+{
+    if (g_srec != NULL) {
+        simulator_srec_end(g_srec, NULL);
+        g_srec = NULL;
+    }
+}
+
 /* ============================================================================
  * Simulator Lifecycle
  * ============================================================================ */
@@ -25,6 +37,7 @@ static simulator_t *g_simulator = NULL;
 EMSCRIPTEN_KEEPALIVE
 int cpu_init(void)
 {
+    srec_drop();
     if (g_simulator != NULL) {
         simulator_destroy(g_simulator);
     }
@@ -65,6 +78,7 @@ void cpu_reset(void)
 EMSCRIPTEN_KEEPALIVE
 void cpu_shutdown(void)
 {
+    srec_drop();
     if (g_simulator != NULL) {
         simulator_destroy(g_simulator);
         g_simulator = NULL;
@@ -97,7 +111,92 @@ EMSCRIPTEN_KEEPALIVE
 uint32_t cpu_run(uint32_t count)
 {
     if (g_simulator == NULL) return 0;
-    return simulator_run(g_simulator, count);
+    return simulator_run_batch(g_simulator, count, SIM_STOP_ON_STOP | SIM_STOP_BREAKPOINT);
+}
+
+/**
+ * Execute up to N CPU instructions with explicit stop conditions
+ *
+ * @param count Instruction budget
+ * @param stop_conditions SIM_STOP_* mask
+ * @return Number of instructions actually executed
+ */
+EMSCRIPTEN_KEEPALIVE
+uint32_t cpu_run_batch(uint32_t count, uint32_t stop_conditions)
+{
+    if (g_simulator == NULL) return 0;
+    return simulator_run_batch(g_simulator, count, stop_conditions);
+}
+
+/**
+ * Run for N CPU clock cycles
+ *
+ * Counts are passed as doubles so JavaScript doesn't need BigInt.
+ *
+ * @param cycles Cycle budget
+ * @param stop_conditions SIM_STOP_* mask
+ * @return Number of cycles actually run
+ */
+EMSCRIPTEN_KEEPALIVE
+double cpu_run_cycles(double cycles, uint32_t stop_conditions)
+{
+    if (g_simulator == NULL || cycles <= 0) return 0;
+    return (double)simulator_run_cycles(g_simulator, (uint64_t)cycles, stop_conditions);
+}
+
+/**
+ * Get CPU clock cycles since reset
+ */
+EMSCRIPTEN_KEEPALIVE
+double cpu_get_cycles(void)
+{
+    if (g_simulator == NULL) return 0;
+    return (double)simulator_get_state(g_simulator)->cycles;
+}
+
+/**
+ * Get the reason the last run returned (SIM_STOPPED_*)
+ */
+EMSCRIPTEN_KEEPALIVE
+int cpu_get_stop_reason(void)
+{
+    if (g_simulator == NULL) return 0;
+    return simulator_get_stop_reason(g_simulator);
+}
+
+/**
+ * Check if the CPU waits for a device (STOP #imm or a status polling loop)
+ *
+ * The caller can back off instead of running idle batches back to back.
+ */
+EMSCRIPTEN_KEEPALIVE
+int cpu_is_idle(void)
+{
+    if (g_simulator == NULL) return 0;
+    return simulator_is_idle(g_simulator);
+}
+
+/**
+ * Set a PC breakpoint
+ *
+ * @return 0 on success, -1 if the breakpoint table is full
+ */
+EMSCRIPTEN_KEEPALIVE
+int cpu_set_breakpoint(uint32_t addr)
+{
+    if (g_simulator == NULL) return -1;
+    return simulator_set_breakpoint(g_simulator, addr);
+}
+
+/**
+ * Remove a PC breakpoint
+ */
+EMSCRIPTEN_KEEPALIVE
+void cpu_clear_breakpoint(uint32_t addr)
+{
+    if (g_simulator != NULL) {
+        simulator_clear_breakpoint(g_simulator, addr);
+    }
 }
 
 /**
@@ -283,10 +382,211 @@ void cpu_write_dword(uint32_t addr, uint32_t value)
     }
 }
 
+/**
+ * Read a block of memory into a buffer
+ *
+ * @param addr Memory address
+ * @param buf Buffer in WASM linear memory
+ * @param len Number of bytes
+ */
+EMSCRIPTEN_KEEPALIVE
+void cpu_read_block(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (g_simulator != NULL) {
+        simulator_read_block(g_simulator, addr, buf, len);
+    }
+}
+
+/**
+ * Write a block of memory from a buffer
+ *
+ * @param addr Memory address
+ * @param data Bytes in WASM linear memory
+ * @param len Number of bytes
+ */
+EMSCRIPTEN_KEEPALIVE
+void cpu_write_block(uint32_t addr, const uint8_t *data, uint32_t len)
+{
+    if (g_simulator != NULL) {
+        simulator_write_block(g_simulator, addr, data, len);
+    }
+}
+
+/* ============================================================================
+ * Serial Console
+ * ============================================================================ */
+
+/**
+ * Queue receive data for a UART channel
+ *
+ * @param channel 0 for channel A, 1 for channel B
+ * @param data Pointer to the bytes in WASM linear memory
+ * @param len Number of bytes
+ * @return Number of bytes queued, less than len once the FIFO is full
+ */
+EMSCRIPTEN_KEEPALIVE
+uint32_t cpu_uart_push(int channel, const uint8_t *data, uint32_t len)
+{
+    if (g_simulator == NULL) return 0;
+    return (uint32_t)simulator_uart_push(g_simulator, channel, data, len);
+}
+
+/**
+ * Take transmit data of a UART channel
+ *
+ * Only data of a channel without fd sink (see cpu_uart_set_fd()) is kept.
+ *
+ * @param channel 0 for channel A, 1 for channel B
+ * @param buf Buffer in WASM linear memory
+ * @param max Size of buf
+ * @return Number of bytes copied to buf
+ */
+EMSCRIPTEN_KEEPALIVE
+uint32_t cpu_uart_pull(int channel, uint8_t *buf, uint32_t max)
+{
+    if (g_simulator == NULL) return 0;
+    return (uint32_t)simulator_uart_pull(g_simulator, channel, buf, max);
+}
+
+/**
+ * Send the transmit data of a UART channel to a file descriptor
+ *
+ * @param channel 0 for channel A, 1 for channel B
+ * @param fd 2 for the console (default), -1 to keep it for cpu_uart_pull()
+ */
+EMSCRIPTEN_KEEPALIVE
+void cpu_uart_set_fd(int channel, int fd)
+{
+    if (g_simulator != NULL) {
+        simulator_set_uart_fd(g_simulator, channel, fd);
+    }
+}
+
 /* ============================================================================
  * Program Loading
  * ============================================================================ */
 
+/**
+ * Start loading an S-record image
+ *
+ * Feed the image with cpu_srec_feed() as it arrives, e.g. chunk by chunk
+ * from a fetch() stream, then call cpu_srec_end(). A load still open is
+ * finished first.
+ *
+ * @return 0 on success, -1 on error
+ */
+EMSCRIPTEN_KEEPALIVE
+int cpu_srec_begin(void)
+{
+    srec_drop();
+    if (g_simulator == NULL) return -1;
+    g_srec = simulator_srec_begin(g_simulator);
+    return g_srec != NULL ? 0 : -1;
+}
+
+/**
+ * Feed the next chunk of an S-record image
+ *
+ * @param data Chunk in WASM linear memory
+ * @param len Size of the chunk
+ * @return 0 on success, -1 once a record was bad
+ */
+EMSCRIPTEN_KEEPALIVE
+int cpu_srec_feed(const uint8_t *data, uint32_t len)
+{
+    if (g_srec == NULL) return -1;
+    return simulator_srec_feed(g_srec, data, len);
+}
+
+/**
+ * Finish loading an S-record image
+ *
+ * Returned as a double so the full 32-bit range stays positive.
+ *
+ * @return Entry point of the S7/S8/S9 record (4294967295 if there was none),
+ *         -1 if a record was bad
+ */
+EMSCRIPTEN_KEEPALIVE
+double cpu_srec_end(void)
+{
+    uint32_t entry;
+
+    if (g_srec == NULL) return -1;
+    int rc = simulator_srec_end(g_srec, &entry);
+    g_srec = NULL;
+    return rc == 0 ? (double)entry : -1;
+}
+
+/**
+ * Memory image of the S-record image being loaded
+ *
+ * Call after the last cpu_srec_feed() and before cpu_srec_end(). The image
+ * can be stored and loaded with cpu_image_load() next time.
+ *
+ * @param len Receives the image size
+ * @return Image in WASM linear memory (release with free()), NULL on error
+ */
+EMSCRIPTEN_KEEPALIVE
+uint8_t *cpu_srec_image(uint32_t *len)
+{
+    size_t size = 0;
+
+    if (g_srec == NULL || len == NULL) return NULL;
+    uint8_t *image = (uint8_t *)simulator_srec_image(g_srec, &size);
+    *len = (uint32_t)size;
+    return image;
+}
+
+/**
+ * Load a memory image made by cpu_srec_image()
+ *
+ * The image is copied, the buffer may be freed afterwards.
+ *
+ * @return Entry point (4294967295 if there was none), -1 if the image is bad
+ */
+EMSCRIPTEN_KEEPALIVE
+double cpu_image_load(uint8_t *data, uint32_t len)
+{
+    uint32_t entry;
+
+    if (g_simulator == NULL) return -1;
+    if (simulator_load_image(g_simulator, data, len, 0, &entry) != 0) return -1;
+    return (double)entry;
+}
+
+/**
+ * Save the machine state
+ *
+ * @param incremental Non-zero to store only pages written since the last
+ *                    snapshot saved or loaded
+ * @param len Receives the snapshot size
+ * @return Snapshot in WASM linear memory (release with free()), NULL on error
+ */
+EMSCRIPTEN_KEEPALIVE
+uint8_t *cpu_snapshot_save(int incremental, uint32_t *len)
+{
+    size_t size = 0;
+
+    if (g_simulator == NULL || len == NULL) return NULL;
+    uint8_t *snap = (uint8_t *)simulator_snapshot_save(g_simulator,
+                                                       incremental ? SIM_SNAPSHOT_INCREMENTAL : 0, &size);
+    *len = (uint32_t)size;
+    return snap;
+}
+
+/**
+ * Restore a snapshot made by cpu_snapshot_save()
+ *
+ * @return 0 on success, -1 if the snapshot is bad or does not follow the
+ *         current state
+ */
+EMSCRIPTEN_KEEPALIVE
+int cpu_snapshot_load(uint8_t *data, uint32_t len)
+{
+    if (g_simulator == NULL || data == NULL) return -1;
+    return simulator_snapshot_load(g_simulator, data, len);
+}
+
 /**
  * Load program data into memory
  *
@@ -317,50 +617,6 @@ int cpu_load_rom(uint8_t *data, uint32_t size)
     return simulator_load_program(g_simulator, data, size, 0x000000);
 }
 
-/**
- * Direct ROM initialization - bypass permission checks for loading ROM at startup
- *
- * This function directly writes to ROM memory, bypassing the read-only check
- * that would normally prevent writes. This allows ROM to be loaded during
- * simulator initialization.
- *
- * @param data Pointer to ROM data in WASM linear memory
- * @param size Size of ROM data in bytes
- * @param addr Base address to load at (should be 0x000000)
- * @return 0 on success, -1 on error
- */
-EMSCRIPTEN_KEEPALIVE
-int cpu_init_rom(uint8_t *data, uint32_t size, uint32_t addr)
-{
-    if (g_simulator == NULL || data == NULL) return -1;
-
-    /* Find the ROM module */
-    for (int i = 0; i < g_simulator->num_modules; i++) {
-        simulator_module_t *mod = g_simulator->modules[i];
-        if (mod && mod->base_addr == 0x000000 && mod->size == 0x10000) {
-            /* This is the ROM module - directly access its memory */
-            typedef struct { uint8_t *memory; size_t size; int writable; } rom_state_t;
-            rom_state_t *state = (rom_state_t *)mod->state;
-
-            if (!state || !state->memory) return -1;
-
-            uint32_t offset = addr - mod->base_addr;
-            if (offset + size > state->size) {
-                return -1;  /* Data doesn't fit in ROM */
-            }
-
-            /* Direct memory copy, bypassing write permission check */
-            for (size_t i = 0; i < size; i++) {
-                state->memory[offset + i] = data[i];
-            }
-
-            return 0;
-        }
-    }
-
-    return -1;  /* ROM module not found */
-}
-
 /* ============================================================================
  * Debugging/Status
  * ============================================================================ */
@@ -376,6 +632,28 @@ int cpu_is_initialized(void)
     return (g_simulator != NULL) ? 1 : 0;
 }
 
+/**
+ * Get decoded instruction cache hits
+ */
+EMSCRIPTEN_KEEPALIVE
+double cpu_get_cache_hits(void)
+{
+    uint64_t hits = 0;
+    simulator_get_cache_stats(g_simulator, &hits, NULL);
+    return (double)hits;
+}
+
+/**
+ * Get decoded instruction cache misses
+ */
+EMSCRIPTEN_KEEPALIVE
+double cpu_get_cache_misses(void)
+{
+    uint64_t misses = 0;
+    simulator_get_cache_stats(g_simulator, NULL, &misses);
+    return (double)misses;
+}
+
 /**
  * Get last error message (if any)
  */
@@ -11,14 +11,17 @@ import './App.css';
 function App() {
     const simulator = useSimulator();
     const [memory, setMemory] = useState<Uint8Array | null>(null);
+    const [memoryAddr, setMemoryAddr] = useState(0);
 
-    // Periodically update memory for disassembler
+    // Code at the PC for the disassembler, one block read per state update
     useEffect(() => {
         if (simulator.state && simulator.initialized) {
             const fetchMemory = async () => {
                 try {
-                    const data = await simulator.readMemory(simulator.state!.pc, 512);
+                    const pc = simulator.state!.pc;
+                    const data = await simulator.readMemory(pc, 512);
                     setMemory(data);
+                    setMemoryAddr(pc);
                 } catch (error) {
                     console.error('Failed to read memory:', error);
                 }
@@ -42,11 +45,11 @@ function App() {
                     </div>
 
                     <div className="panel">
-                        <CPURegisters state={simulator.state} />
+                        <CPURegisters state={simulator.state} shared={simulator.shared} />
                     </div>
 
                     <div className="panel">
-                        <Disassembler state={simulator.state} memory={memory} />
+                        <Disassembler state={simulator.state} memory={memory} memoryAddr={memoryAddr} />
                     </div>
                 </div>
 
@@ -64,7 +67,7 @@ function App() {
                 {/* Right Column: Terminal */}
                 <div className="column right-column">
                     <div className="panel">
-                        <Terminal />
+                        <Terminal simulator={simulator} />
                     </div>
                 </div>
             </div>
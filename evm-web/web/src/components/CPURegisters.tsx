@@ -1,9 +1,12 @@
-import React from 'react';
+import React, { useEffect, useState } from 'react';
 import { CPUState } from '../hooks/useSimulator';
+import { CTRL_STATE_SEQ, readRegisters, SharedState } from '../utils/sharedState';
 import styles from './CPURegisters.module.css';
 
 interface CPURegistersProps {
     state: CPUState | null;
+    // Register file published by the worker, read directly when present
+    shared?: SharedState | null;
 }
 
 const FLAG_NAMES: { [key: number]: string } = {
@@ -20,7 +23,30 @@ const FLAG_NAMES: { [key: number]: string } = {
     0x0001: 'C',  // Carry
 };
 
-export const CPURegisters: React.FC<CPURegistersProps> = ({ state }) => {
+export const CPURegisters: React.FC<CPURegistersProps> = ({ state: lastState, shared }) => {
+    const [liveState, setLiveState] = useState<CPUState | null>(null);
+
+    // Re-read the shared registers once per frame when the worker updated them
+    useEffect(() => {
+        if (!shared) return;
+        let frame = 0;
+        let seen = -1;
+
+        const poll = () => {
+            const seq = Atomics.load(shared.ctrl, CTRL_STATE_SEQ);
+            if (seq !== seen && !(seq & 1)) {
+                seen = seq;
+                setLiveState(readRegisters(shared));
+            }
+            frame = requestAnimationFrame(poll);
+        };
+        frame = requestAnimationFrame(poll);
+        return () => cancelAnimationFrame(frame);
+    }, [shared]);
+
+    // Nothing published yet (seq 0): the state from the last message
+    const state = liveState ?? lastState;
+
     const formatHex = (value: number, bits: number = 32): string => {
         const hex = value.toString(16).toUpperCase();
         const chars = bits / 4;
@@ -1,4 +1,4 @@
-import React, { useState, useRef } from 'react';
+import React, { useRef } from 'react';
 import { UseSimulatorReturn } from '../hooks/useSimulator';
 import styles from './ControlPanel.module.css';
 
@@ -6,31 +6,25 @@ interface ControlPanelProps {
     simulator: UseSimulatorReturn;
 }
 
+// S-record files are parsed by the core, anything else is a raw image
+const isSrec = (name: string): boolean => /\.(s19|s28|s37|srec|mot)$/i.test(name);
+
 export const ControlPanel: React.FC<ControlPanelProps> = ({ simulator }) => {
-    const [speed, setSpeed] = useState(1000);
-    const [isRunning, setIsRunning] = useState(false);
-    const runIntervalRef = useRef<ReturnType<typeof setInterval> | null>(null);
+    // The worker runs as fast as it can; it reports when it stops by itself
+    const isRunning = simulator.running;
     const romFileRef = useRef<HTMLInputElement>(null);
     const programFileRef = useRef<HTMLInputElement>(null);
 
     const handlePlay = () => {
         if (!isRunning) {
             console.log('🎮 [ControlPanel] PLAY button clicked');
-            setIsRunning(true);
-            runIntervalRef.current = setInterval(() => {
-                simulator.run(speed);
-            }, 100); // Update every 100ms
+            simulator.start();
         }
     };
 
     const handlePause = () => {
         if (isRunning) {
             console.log('🎮 [ControlPanel] PAUSE button clicked');
-            setIsRunning(false);
-            if (runIntervalRef.current) {
-                clearInterval(runIntervalRef.current);
-                runIntervalRef.current = null;
-            }
             simulator.pause();
         }
     };
@@ -53,6 +47,11 @@ export const ControlPanel: React.FC<ControlPanelProps> = ({ simulator }) => {
         if (file) {
             try {
                 console.log(`🎮 [ControlPanel] Loading ROM file: ${file.name} (${file.size} bytes)`);
+                if (isSrec(file.name)) {
+                    await simulator.loadSrec(file);
+                    console.log(`✅ [ControlPanel] S-record ROM loaded`);
+                    return;
+                }
                 const arrayBuffer = await file.arrayBuffer();
                 const data = new Uint8Array(arrayBuffer);
                 console.log(`🎮 [ControlPanel] ROM file read, sending to simulator...`);
@@ -69,6 +68,11 @@ export const ControlPanel: React.FC<ControlPanelProps> = ({ simulator }) => {
         if (file) {
             try {
                 console.log(`🎮 [ControlPanel] Loading program file: ${file.name} (${file.size} bytes)`);
+                if (isSrec(file.name)) {
+                    await simulator.loadSrec(file);
+                    console.log(`✅ [ControlPanel] S-record program loaded`);
+                    return;
+                }
                 const arrayBuffer = await file.arrayBuffer();
                 const data = new Uint8Array(arrayBuffer);
                 console.log(`🎮 [ControlPanel] Program file read, sending to simulator...`);
@@ -120,24 +124,6 @@ export const ControlPanel: React.FC<ControlPanelProps> = ({ simulator }) => {
                 </div>
             </div>
 
-            <div className={styles.section}>
-                <h3>Execution Speed</h3>
-                <div className={styles.speedControl}>
-                    <input
-                        type="range"
-                        min="100"
-                        max="10000"
-                        step="100"
-                        value={speed}
-                        onChange={(e) => setSpeed(Number(e.target.value))}
-                        className={styles.slider}
-                    />
-                    <div className={styles.speedLabel}>
-                        {speed} instructions/update
-                    </div>
-                </div>
-            </div>
-
             <div className={styles.section}>
                 <h3>File Loading</h3>
                 <div className={styles.fileGroup}>
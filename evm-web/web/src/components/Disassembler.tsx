@@ -5,6 +5,8 @@ import styles from './Disassembler.module.css';
 interface DisassemblerProps {
     state: CPUState | null;
     memory: Uint8Array | null;
+    // Address of memory[0]
+    memoryAddr: number;
 }
 
 interface Instruction {
@@ -56,7 +58,7 @@ const INSTRUCTION_SET: { [key: number]: { mnem: string; cycles: number } } = {
     0xe000: { mnem: 'SHIFT', cycles: 6 },
 };
 
-export const Disassembler: React.FC<DisassemblerProps> = ({ state, memory }) => {
+export const Disassembler: React.FC<DisassemblerProps> = ({ state, memory, memoryAddr }) => {
     const instructions = useMemo(() => {
         if (!state || !memory) return [];
 
@@ -64,9 +66,11 @@ export const Disassembler: React.FC<DisassemblerProps> = ({ state, memory }) =>
         let addr = state.pc;
         const maxInstructions = 10;
 
-        for (let i = 0; i < maxInstructions && addr < memory.length - 1; i++) {
-            const byte1 = memory[addr];
-            const byte2 = memory[addr + 1];
+        for (let i = 0; i < maxInstructions; i++) {
+            const offset = addr - memoryAddr;
+            if (offset < 0 || offset + 1 >= memory.length) break;
+            const byte1 = memory[offset];
+            const byte2 = memory[offset + 1];
             const opcode = (byte1 << 8) | byte2;
 
             // Look up instruction
@@ -86,7 +90,7 @@ export const Disassembler: React.FC<DisassemblerProps> = ({ state, memory }) =>
         }
 
         return result;
-    }, [state, memory]);
+    }, [state, memory, memoryAddr]);
 
     const formatHex = (value: number, chars: number = 6): string => {
         return '0x' + value.toString(16).toUpperCase().padStart(chars, '0');
@@ -1,11 +1,16 @@
 import React, { useState, useRef, useEffect } from 'react';
+import { UseSimulatorReturn } from '../hooks/useSimulator';
 import styles from './Terminal.module.css';
 
 interface TerminalProps {
+    simulator: UseSimulatorReturn;
     title?: string;
 }
 
-export const Terminal: React.FC<TerminalProps> = ({ title = 'Serial Terminal (68681 UART)' }) => {
+// Lines kept in the scrollback
+const MAX_LINES = 1000;
+
+export const Terminal: React.FC<TerminalProps> = ({ simulator, title = 'Serial Terminal (68681 UART)' }) => {
     const [output, setOutput] = useState<string[]>([
         'EVM MC68020 Simulator - Serial Terminal',
         'Waiting for program output...',
@@ -22,22 +27,44 @@ export const Terminal: React.FC<TerminalProps> = ({ title = 'Serial Terminal (68
         }
     }, [output]);
 
-    const addOutput = (text: string) => {
-        setOutput((prev) => [...prev, text]);
+    // Continue the last line, CR LF and LF start a new one
+    const appendText = (text: string) => {
+        const parts = text.replace(/\r/g, '').split('\n');
+        setOutput((prev) => {
+            const lines = prev.slice(0, -1);
+            lines.push((prev[prev.length - 1] ?? '') + parts[0]);
+            lines.push(...parts.slice(1));
+            return lines.length > MAX_LINES ? lines.slice(-MAX_LINES) : lines;
+        });
     };
 
+    // Channel A output: drained once per frame, straight from the shared ring
+    const { readUart, writeUart } = simulator;
+    useEffect(() => {
+        const decoder = new TextDecoder('latin1');
+        let frame = 0;
+
+        const poll = () => {
+            const data = readUart();
+            if (data.length > 0) {
+                appendText(decoder.decode(data));
+            }
+            frame = requestAnimationFrame(poll);
+        };
+        frame = requestAnimationFrame(poll);
+        return () => cancelAnimationFrame(frame);
+    }, [readUart]);
+
     const handleInputChange = (e: React.ChangeEvent<HTMLInputElement>) => {
         setInput(e.target.value);
     };
 
+    // The guest echoes what it reads, so nothing is echoed here
     const handleSendInput = () => {
-        if (input.trim()) {
-            addOutput(`> ${input}`);
-            // TODO: Send input to simulator's 68681 UART
-            setInput('');
-            if (inputRef.current) {
-                inputRef.current.focus();
-            }
+        writeUart(new TextEncoder().encode(input + '\r'));
+        setInput('');
+        if (inputRef.current) {
+            inputRef.current.focus();
         }
     };
 
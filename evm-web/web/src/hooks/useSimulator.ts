@@ -1,5 +1,9 @@
 import { useState, useEffect, useCallback, useRef } from 'react';
-import { parseS19, mergeSegments } from '../utils/s19Parser';
+import { attachSharedState, ringRead, ringWrite, CTRL_RUN, SharedState } from '../utils/sharedState';
+import { deleteCachedImage, getCachedImage, imageTag, putCachedImage } from '../utils/imageCache';
+
+// Boot ROM loaded at startup
+const ROM_URL = '/PS20.S19';
 
 export interface CPUState {
     pc: number;
@@ -22,13 +26,25 @@ export interface SimulatorState {
 export interface UseSimulatorReturn extends SimulatorState {
     step: () => void;
     run: (count?: number) => void;
+    // Run continuously in the worker until pause() or a breakpoint
+    start: () => void;
     pause: () => void;
     reset: () => void;
     readMemory: (addr: number, size?: number) => Promise<Uint8Array>;
     writeMemory: (addr: number, data: Uint8Array) => Promise<void>;
     loadROM: (data: Uint8Array) => Promise<void>;
     loadProgram: (data: Uint8Array, addr?: number) => Promise<void>;
+    // S-record image (download or file), loaded at its own addresses;
+    // onImage receives the memory image made from it
+    loadSrec: (source: ReadableStream<Uint8Array> | Blob, onImage?: (image: Uint8Array) => void) => Promise<void>;
+    // Memory image from an earlier loadSrec()
+    loadImage: (image: Uint8Array) => Promise<void>;
     getState: () => void;
+    // Register file and UART rings shared with the worker, null without SharedArrayBuffer
+    shared: SharedState | null;
+    // UART channel A: take the output received so far, send input
+    readUart: () => Uint8Array;
+    writeUart: (data: Uint8Array) => void;
 }
 
 export function useSimulator(): UseSimulatorReturn {
@@ -42,6 +58,10 @@ export function useSimulator(): UseSimulatorReturn {
 
     const workerRef = useRef<Worker | null>(null);
     const memoryPromiseRef = useRef<Map<string, Function>>(new Map());
+    const [shared, setShared] = useState<SharedState | null>(null);
+    const sharedRef = useRef<SharedState | null>(null);
+    // UART output received as messages, when there is no shared memory
+    const uartQueueRef = useRef<Uint8Array[]>([]);
 
     // Initialize worker and simulator
     useEffect(() => {
@@ -69,9 +89,20 @@ export function useSimulator(): UseSimulatorReturn {
         // Listen for messages from worker
         worker.onmessage = (event: MessageEvent) => {
             const { type, state, error, data, addr } = event.data;
+
+            // High rate, not logged
+            if (type === 'uart') {
+                uartQueueRef.current.push(data);
+                return;
+            }
             console.log(`📨 [useSimulator] Received message from worker:`, { type, state, error });
 
             switch (type) {
+                case 'shared':
+                    sharedRef.current = event.data.buffer ? attachSharedState(event.data.buffer) : null;
+                    setShared(sharedRef.current);
+                    break;
+
                 case 'ready':
                     console.log('✅ [useSimulator] Simulator initialized and ready');
                     setSimulatorState((prev) => ({
@@ -88,14 +119,30 @@ export function useSimulator(): UseSimulatorReturn {
                         d0: `0x${state.dregs[0].toString(16).padStart(8, '0')}`,
                         a7: `0x${state.aregs[7].toString(16).padStart(8, '0')}`,
                     });
+                    setSimulatorState((prev) => ({
+                        ...prev,
+                        state,
+                        running: event.data.running ?? false,
+                        error: null,
+                    }));
+                    break;
+
+                case 'stopped':
+                    // reason: SIM_STOPPED_PAUSE (4) or SIM_STOPPED_BREAKPOINT (2)
+                    console.log(`⏹️ [useSimulator] Run loop stopped, reason ${event.data.reason}`);
                     setSimulatorState((prev) => ({
                         ...prev,
                         state,
                         running: false,
+                        paused: true,
                         error: null,
                     }));
                     break;
 
+                case 'image':
+                    // Taken by loadSrec()
+                    break;
+
                 case 'memoryRead':
                     console.log(`🔍 [useSimulator] Memory read from 0x${addr.toString(16).padStart(6, '0')}`);
                     const readCallback = memoryPromiseRef.current.get(`read-${addr}`);
@@ -141,53 +188,104 @@ export function useSimulator(): UseSimulatorReturn {
         };
     }, []);
 
+    // Resolves on the worker's next 'ready', rejects on 'error'
+    const whenReady = useCallback((worker: Worker): Promise<void> => {
+        return new Promise<void>((resolve, reject) => {
+            const onMessage = (event: MessageEvent) => {
+                if (event.data.type === 'ready' || event.data.type === 'error') {
+                    worker.removeEventListener('message', onMessage);
+                    if (event.data.type === 'error') {
+                        reject(new Error(event.data.error));
+                    } else {
+                        resolve();
+                    }
+                }
+            };
+            worker.addEventListener('message', onMessage);
+        });
+    }, []);
+
+    // Stream an S-record image to the worker, where the core parses it as it arrives
+    const loadSrec = useCallback(async (source: ReadableStream<Uint8Array> | Blob,
+                                        onImage?: (image: Uint8Array) => void): Promise<void> => {
+        const worker = workerRef.current;
+        if (!worker) {
+            throw new Error('Simulator not initialized');
+        }
+
+        const loaded = whenReady(worker);
+        if (onImage) {
+            // Posted just before 'ready'
+            const onMessage = (event: MessageEvent) => {
+                const type = event.data.type;
+                if (type === 'image') {
+                    onImage(event.data.data);
+                }
+                if (type === 'image' || type === 'ready' || type === 'error') {
+                    worker.removeEventListener('message', onMessage);
+                }
+            };
+            worker.addEventListener('message', onMessage);
+        }
+
+        const reader = (source instanceof Blob ? source.stream() : source).getReader();
+        worker.postMessage({ type: 'srecBegin' });
+        try {
+            for (;;) {
+                const { done, value } = await reader.read();
+                if (done) break;
+                worker.postMessage({ type: 'srecChunk', payload: { data: value } }, [value.buffer]);
+            }
+        } finally {
+            worker.postMessage({ type: 'srecEnd', payload: { image: !!onImage } });
+        }
+        return loaded;
+    }, [whenReady]);
+
+    const loadImage = useCallback(async (image: Uint8Array): Promise<void> => {
+        const worker = workerRef.current;
+        if (!worker) {
+            throw new Error('Simulator not initialized');
+        }
+        const loaded = whenReady(worker);
+        worker.postMessage({ type: 'loadImage', payload: { data: image } });
+        return loaded;
+    }, [whenReady]);
+
     // Load ROM after initialization, then call reset to read reset vectors from ROM
     useEffect(() => {
         if (simulatorState.initialized && workerRef.current) {
             (async () => {
                 try {
                     console.log('📥 [useSimulator] Loading ROM file...');
-                    // Fetch S19 ROM file
-                    const response = await fetch('/PS20.S19');
+                    const response = await fetch(ROM_URL);
                     console.log(`✅ [useSimulator] Fetched PS20.S19, status: ${response.status}`);
-                    const content = await response.text();
-                    console.log(`✅ [useSimulator] ROM content length: ${content.length} bytes`);
-
-                    // Parse S19 format
-                    console.log('🔍 [useSimulator] Parsing S19 format...');
-                    const { segments } = parseS19(content);
-                    console.log(`✅ [useSimulator] Parsed ${segments.size} memory segments`);
-
-                    // Load ROM into simulator - load each segment directly without merging
-                    // (merging was destroying data, so we write each segment's bytes directly to WASM memory)
-                    let totalBytes = 0;
-                    for (const [addr, data] of segments) {
-                        const romData = new Uint8Array(data);
-                        totalBytes += romData.length;
-                        console.log(`📍 [useSimulator] Loading segment at 0x${addr.toString(16).padStart(6, '0')}, size: ${romData.length} bytes`);
-
-                        await new Promise<void>((resolve, reject) => {
-                            const onMessage = (event: MessageEvent) => {
-                                if (event.data.type === 'ready' || event.data.type === 'error') {
-                                    workerRef.current?.removeEventListener('message', onMessage);
-                                    if (event.data.type === 'error') {
-                                        reject(new Error(event.data.error));
-                                    } else {
-                                        resolve();
-                                    }
-                                }
-                            };
-
-                            workerRef.current?.addEventListener('message', onMessage);
-                            // Pass Uint8Array directly, not Array.from()
-                            // Emscripten cwrap needs a typed array for proper pointer conversion
-                            workerRef.current?.postMessage({
-                                type: 'loadROM',
-                                payload: { data: romData, address: addr },
-                            });
-                        });
+                    if (!response.ok || !response.body) {
+                        throw new Error(`HTTP ${response.status}`);
+                    }
+
+                    // The image made last time, while the server has the same file
+                    const tag = imageTag(response);
+                    const cached = tag ? await getCachedImage(ROM_URL, tag) : null;
+                    let fromCache = false;
+                    if (cached) {
+                        // The download stays open until the core took the image
+                        try {
+                            await loadImage(cached);
+                            fromCache = true;
+                        } catch (error) {
+                            console.warn('⚠️ [useSimulator] Cached image rejected, parsing the S19 file:', error);
+                            await deleteCachedImage(ROM_URL);
+                        }
+                    }
+                    if (fromCache) {
+                        response.body.cancel();
+                        console.log('✅ [useSimulator] ROM loaded from cached image');
+                    } else {
+                        // The core parses the S19 file chunk by chunk while it downloads
+                        await loadSrec(response.body, tag ? (image) => putCachedImage(ROM_URL, tag, image) : undefined);
+                        console.log('✅ [useSimulator] ROM loaded successfully');
                     }
-                    console.log(`✅ [useSimulator] ROM loaded successfully! Total: ${totalBytes} bytes`);
 
                     // NOW that ROM is loaded, call reset to read reset vectors from ROM
                     console.log('🔄 [useSimulator] Calling reset to read reset vectors from loaded ROM...');
@@ -235,10 +333,23 @@ export function useSimulator(): UseSimulatorReturn {
         }
     }, [simulatorState.initialized]);
 
+    const start = useCallback(() => {
+        if (workerRef.current && simulatorState.initialized) {
+            console.log('▶️ [useSimulator] Starting run loop');
+            setSimulatorState((prev) => ({ ...prev, running: true, paused: false }));
+            workerRef.current.postMessage({ type: 'start' });
+        }
+    }, [simulatorState.initialized]);
+
     const pause = useCallback(() => {
         if (workerRef.current && simulatorState.initialized) {
             console.log('⏸️ [useSimulator] Pausing execution');
             setSimulatorState((prev) => ({ ...prev, paused: true, running: false }));
+            // The run loop sees the flag after its current batch, the message
+            // may queue behind a whole slice
+            if (sharedRef.current) {
+                Atomics.store(sharedRef.current.ctrl, CTRL_RUN, 0);
+            }
             workerRef.current.postMessage({ type: 'pause' });
         }
     }, [simulatorState.initialized]);
@@ -284,7 +395,7 @@ export function useSimulator(): UseSimulatorReturn {
 
             workerRef.current.postMessage({
                 type: 'writeMemory',
-                payload: { addr, data: Array.from(data) },
+                payload: { addr, data },
             });
 
             resolve();
@@ -343,16 +454,49 @@ export function useSimulator(): UseSimulatorReturn {
         }
     }, [simulatorState.initialized]);
 
+    const readUart = useCallback((): Uint8Array => {
+        if (sharedRef.current) {
+            return ringRead(sharedRef.current, 'tx');
+        }
+        const chunks = uartQueueRef.current;
+        uartQueueRef.current = [];
+        if (chunks.length === 1) {
+            return chunks[0];
+        }
+        const out = new Uint8Array(chunks.reduce((n, c) => n + c.length, 0));
+        let offset = 0;
+        for (const c of chunks) {
+            out.set(c, offset);
+            offset += c.length;
+        }
+        return out;
+    }, []);
+
+    const writeUart = useCallback((data: Uint8Array) => {
+        if (sharedRef.current) {
+            // The worker takes it with its next batch; a full ring drops the rest
+            ringWrite(sharedRef.current, 'rx', data);
+        } else if (workerRef.current) {
+            workerRef.current.postMessage({ type: 'uartInput', payload: { data } });
+        }
+    }, []);
+
     return {
         ...simulatorState,
         step,
         run,
+        start,
         pause,
         reset,
         readMemory,
         writeMemory,
         loadROM,
         loadProgram,
+        loadSrec,
+        loadImage,
         getState,
+        shared,
+        readUart,
+        writeUart,
     };
 }
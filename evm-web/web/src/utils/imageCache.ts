@@ -0,0 +1,105 @@
+/**
+ * Memory images kept in IndexedDB
+ *
+ * The worker turns a downloaded S-record file into a memory image (see
+ * simulator_image.c), which is stored here under the file's URL. On the next
+ * start the image is loaded instead of parsing the file again, as long as the
+ * server still reports the same version of it.
+ *
+ * The version tag comes from the response headers: the ETag, or else
+ * Last-Modified and Content-Length, prefixed with the image format version.
+ * Responses without either are not cached. Failures (private mode, quota)
+ * only mean a cache miss.
+ */
+
+// IMAGE_VERSION in simulator_image.c: images of another format are not used
+const IMAGE_FORMAT_VERSION = 1;
+
+const DB_NAME = 'evm';
+const DB_VERSION = 1;
+const STORE = 'images';
+
+interface CachedImage {
+    tag: string;
+    image: Uint8Array;
+}
+
+let dbPromise: Promise<IDBDatabase> | null = null;
+
+function openDb(): Promise<IDBDatabase> {
+    if (!dbPromise) {
+        dbPromise = new Promise((resolve, reject) => {
+            const request = indexedDB.open(DB_NAME, DB_VERSION);
+            request.onupgradeneeded = () => request.result.createObjectStore(STORE);
+            request.onsuccess = () => resolve(request.result);
+            request.onerror = () => reject(request.error);
+        });
+        dbPromise.catch(() => { dbPromise = null; });
+    }
+    return dbPromise;
+}
+
+/**
+ * Version tag of a response, null if it cannot be told apart from others
+ */
+export function imageTag(response: Response): string | null {
+    const etag = response.headers.get('ETag');
+    if (etag) {
+        return `${IMAGE_FORMAT_VERSION}/${etag}`;
+    }
+    const modified = response.headers.get('Last-Modified');
+    const length = response.headers.get('Content-Length');
+    return modified && length ? `${IMAGE_FORMAT_VERSION}/${modified}/${length}` : null;
+}
+
+/**
+ * Image stored for url, null unless it was made from the same version
+ */
+export async function getCachedImage(url: string, tag: string): Promise<Uint8Array | null> {
+    try {
+        const db = await openDb();
+        const entry = await new Promise<CachedImage | undefined>((resolve, reject) => {
+            const request = db.transaction(STORE, 'readonly').objectStore(STORE).get(url);
+            request.onsuccess = () => resolve(request.result);
+            request.onerror = () => reject(request.error);
+        });
+        return entry && entry.tag === tag ? entry.image : null;
+    } catch (error) {
+        console.warn('[imageCache] Lookup failed:', error);
+        return null;
+    }
+}
+
+/**
+ * Store the image made from the tagged version of url
+ */
+export async function putCachedImage(url: string, tag: string, image: Uint8Array): Promise<void> {
+    try {
+        const db = await openDb();
+        await new Promise<void>((resolve, reject) => {
+            const tx = db.transaction(STORE, 'readwrite');
+            tx.objectStore(STORE).put({ tag, image } as CachedImage, url);
+            tx.oncomplete = () => resolve();
+            tx.onerror = () => reject(tx.error);
+        });
+    } catch (error) {
+        console.warn('[imageCache] Store failed:', error);
+    }
+}
+
+/**
+ * Drop the image stored for url, e.g. after the core rejected it
+ */
+export async function deleteCachedImage(url: string): Promise<void> {
+    try {
+        const db = await openDb();
+        await new Promise<void>((resolve, reject) => {
+            const tx = db.transaction(STORE, 'readwrite');
+            tx.objectStore(STORE).delete(url);
+            tx.oncomplete = () => resolve();
+            tx.onerror = () => reject(tx.error);
+        });
+    } catch (error) {
+        console.warn('[imageCache] Delete failed:', error);
+    }
+}
@@ -0,0 +1,174 @@
+/**
+ * Memory shared between the simulator worker and the UI
+ *
+ * One SharedArrayBuffer holds the CPU register file and the UART rings, so
+ * the UI reads registers and terminal output without a message round trip.
+ *
+ * The rings have one producer and one consumer each: TX is filled by the
+ * worker and drained by the Terminal, RX the other way round. The producer
+ * only advances head, the consumer only tail, both through Atomics. The
+ * indices run free and are masked on access, so head - tail is the fill
+ * level even after they wrap.
+ *
+ * CTRL_RUN lets the UI pause the worker's run loop between two batches,
+ * without waiting for the worker to get to its message queue.
+ *
+ * SharedArrayBuffer needs a cross-origin isolated page (COOP/COEP headers,
+ * see vite.config.ts). Without it createSharedState() returns null and the
+ * worker falls back to messages.
+ */
+
+import type { CPUState } from '../hooks/useSimulator';
+
+/* Ring sizes in bytes, powers of two */
+export const TX_RING_SIZE = 65536;
+export const RX_RING_SIZE = 4096;
+
+/* Int32 control words */
+export const CTRL_STATE_SEQ = 0;    // Even once the registers are consistent
+export const CTRL_TX_HEAD = 1;
+export const CTRL_TX_TAIL = 2;
+export const CTRL_RX_HEAD = 3;
+export const CTRL_RX_TAIL = 4;
+export const CTRL_RUN = 5;          // Non-zero while the worker's run loop may continue
+const CTRL_WORDS = 8;
+
+/*
+ * Register words, laid out like the start of simulator_cpu_state_t so the
+ * worker copies them in one go: SR (low half), D0-D7, A0-A7, PC, SSP, USP, MSP
+ */
+export const REG_WORDS = 21;
+const REG_D0 = 1;
+const REG_A0 = 9;
+const REG_PC = 17;
+const REG_SSP = 18;
+const REG_USP = 19;
+const REG_MSP = 20;
+
+const CTRL_OFFSET = 0;
+const REG_OFFSET = CTRL_OFFSET + CTRL_WORDS * 4;
+const TX_OFFSET = REG_OFFSET + 32 * 4;
+const RX_OFFSET = TX_OFFSET + TX_RING_SIZE;
+const BUFFER_SIZE = RX_OFFSET + RX_RING_SIZE;
+
+export interface SharedState {
+    buffer: SharedArrayBuffer;
+    ctrl: Int32Array;
+    regs: Uint32Array;
+    tx: Uint8Array;
+    rx: Uint8Array;
+}
+
+export type Ring = 'tx' | 'rx';
+
+/**
+ * Create the shared block (worker side), null if SharedArrayBuffer is not available
+ */
+export function createSharedState(): SharedState | null {
+    if (typeof SharedArrayBuffer === 'undefined' || !(self as any).crossOriginIsolated) {
+        return null;
+    }
+    return attachSharedState(new SharedArrayBuffer(BUFFER_SIZE));
+}
+
+/**
+ * Views over a shared block received from the worker
+ */
+export function attachSharedState(buffer: SharedArrayBuffer): SharedState {
+    return {
+        buffer,
+        ctrl: new Int32Array(buffer, CTRL_OFFSET, CTRL_WORDS),
+        regs: new Uint32Array(buffer, REG_OFFSET, REG_WORDS),
+        tx: new Uint8Array(buffer, TX_OFFSET, TX_RING_SIZE),
+        rx: new Uint8Array(buffer, RX_OFFSET, RX_RING_SIZE),
+    };
+}
+
+function ringWords(ring: Ring): [number, number] {
+    return ring === 'tx' ? [CTRL_TX_HEAD, CTRL_TX_TAIL] : [CTRL_RX_HEAD, CTRL_RX_TAIL];
+}
+
+/**
+ * Free space of a ring, as seen by its producer
+ */
+export function ringFree(shared: SharedState, ring: Ring): number {
+    const [head, tail] = ringWords(ring);
+    const used = (Atomics.load(shared.ctrl, head) - Atomics.load(shared.ctrl, tail)) | 0;
+    return shared[ring].length - used;
+}
+
+/**
+ * Append data to a ring (producer), returns the number of bytes written
+ */
+export function ringWrite(shared: SharedState, ring: Ring, data: Uint8Array): number {
+    const [headWord] = ringWords(ring);
+    const buf = shared[ring];
+    const mask = buf.length - 1;
+    const head = Atomics.load(shared.ctrl, headWord);
+    const n = Math.min(data.length, ringFree(shared, ring));
+
+    // At most two copies: up to the end of the buffer, then from its start
+    const start = head & mask;
+    const first = Math.min(n, buf.length - start);
+    buf.set(data.subarray(0, first), start);
+    buf.set(data.subarray(first, n), 0);
+    Atomics.store(shared.ctrl, headWord, (head + n) | 0);
+    return n;
+}
+
+/**
+ * Take up to max bytes from a ring (consumer)
+ */
+export function ringRead(shared: SharedState, ring: Ring, max = Infinity): Uint8Array {
+    const [headWord, tailWord] = ringWords(ring);
+    const buf = shared[ring];
+    const mask = buf.length - 1;
+    const tail = Atomics.load(shared.ctrl, tailWord);
+    const n = Math.min(max, (Atomics.load(shared.ctrl, headWord) - tail) | 0);
+    const out = new Uint8Array(n);
+
+    const start = tail & mask;
+    const first = Math.min(n, buf.length - start);
+    out.set(buf.subarray(start, start + first), 0);
+    out.set(buf.subarray(0, n - first), first);
+    Atomics.store(shared.ctrl, tailWord, (tail + n) | 0);
+    return out;
+}
+
+/**
+ * Publish the register file (worker side)
+ *
+ * CTRL_STATE_SEQ is odd while the words are written, readers retry then.
+ */
+export function writeRegisters(shared: SharedState, words: Uint32Array): void {
+    Atomics.add(shared.ctrl, CTRL_STATE_SEQ, 1);
+    shared.regs.set(words.subarray(0, REG_WORDS));
+    Atomics.add(shared.ctrl, CTRL_STATE_SEQ, 1);
+}
+
+/**
+ * CPUState from register words in the layout above
+ */
+export function decodeRegisters(r: Uint32Array): CPUState {
+    return {
+        pc: r[REG_PC],
+        sr: r[0] & 0xFFFF,
+        dregs: Array.from(r.subarray(REG_D0, REG_D0 + 8)),
+        aregs: Array.from(r.subarray(REG_A0, REG_A0 + 8)),
+        ssp: r[REG_SSP],
+        usp: r[REG_USP],
+        msp: r[REG_MSP],
+    };
+}
+
+/**
+ * Register file as a CPUState
+ */
+export function readRegisters(shared: SharedState): CPUState {
+    for (;;) {
+        const seq = Atomics.load(shared.ctrl, CTRL_STATE_SEQ);
+        if (seq & 1) continue;
+        const state = decodeRegisters(shared.regs);
+        if (Atomics.load(shared.ctrl, CTRL_STATE_SEQ) === seq) return state;
+    }
+}
@@ -1,6 +1,11 @@
 // Web Worker for EVM simulator execution
 // Prevents UI blocking during simulation
 
+import {
+    createSharedState, decodeRegisters, ringFree, ringRead, ringWrite, writeRegisters,
+    CTRL_RUN, REG_WORDS, SharedState,
+} from '../utils/sharedState';
+
 interface CPUState {
     pc: number;
     sr: number;
@@ -12,30 +17,101 @@ interface CPUState {
 }
 
 interface SimulatorMessage {
-    type: 'init' | 'step' | 'run' | 'pause' | 'reset' | 'setState' | 'getState' | 'readMemory' | 'writeMemory' | 'loadROM' | 'loadProgram';
+    type: 'init' | 'step' | 'run' | 'start' | 'pause' | 'reset' | 'setState' | 'getState' | 'readMemory' | 'writeMemory' | 'loadROM' | 'loadProgram' | 'uartInput' | 'srecBegin' | 'srecChunk' | 'srecEnd' | 'loadImage';
     payload?: any;
 }
 
 interface StateMessage {
     type: 'state';
     state: CPUState;
+    running?: boolean;
 }
 
 interface ReadyMessage {
     type: 'ready';
 }
 
+// The run loop ended, reason is a SIM_STOPPED_* code
+interface StoppedMessage {
+    type: 'stopped';
+    state: CPUState;
+    reason: number;
+}
+
 interface ErrorMessage {
     type: 'error';
     error: string;
 }
 
-type WorkerMessage = StateMessage | ReadyMessage | ErrorMessage;
+// Shared register file and UART rings, sent to the UI once after init
+interface SharedMessage {
+    type: 'shared';
+    buffer: SharedArrayBuffer | null;
+}
+
+// UART channel A output when there is no shared memory
+interface UartMessage {
+    type: 'uart';
+    data: Uint8Array;
+}
+
+// Memory image of an S-record load, for the UI to cache (see imageCache.ts)
+interface ImageMessage {
+    type: 'image';
+    data: Uint8Array;
+}
+
+type WorkerMessage = StateMessage | StoppedMessage | ReadyMessage | ErrorMessage | SharedMessage | UartMessage | ImageMessage;
 
 // Module and cpu are set dynamically by importScripts and initWASM
 let cpu: any;
 let initialized = false;
 
+// Register file and UART rings shared with the UI, null without SharedArrayBuffer
+let shared: SharedState | null = null;
+
+// Scratch buffer in WASM memory for bulk UART transfers
+const UART_SCRATCH_SIZE = 4096;
+let uartScratch = 0;
+
+// Input the core's receive FIFO had no room for yet
+let rxPending = new Uint8Array(0);
+
+// Stop conditions and reasons, see simulator.h
+const SIM_STOP_BREAKPOINT = 0x02;
+const SIM_STOPPED_BREAKPOINT = 2;
+const SIM_STOPPED_PAUSE = 4;
+
+// Run loop timing (ms): batches are sized to BATCH_MS, the loop returns to
+// the event queue after SLICE_MS and publishes the state every PUBLISH_MS
+const BATCH_MS = 4;
+const SLICE_MS = 12;
+const PUBLISH_MS = 16;
+const STATE_MESSAGE_MS = 250;
+const IDLE_WAIT_MS = 10;
+const MIN_BATCH = 1000;
+const MAX_BATCH = 10000000;
+
+let running = false;
+let runGeneration = 0;
+let batchSize = 10000;
+let lastPublish = 0;
+let lastStateMessage = 0;
+
+// Zero-delay yield; setTimeout(0) is clamped to 4 ms when nested
+const sliceChannel = new MessageChannel();
+sliceChannel.port1.onmessage = (event: MessageEvent) => runSlice(event.data);
+
+// Exports the worker cannot do without. public/evm.js is built by
+// evm-core/build.sh and not tracked; an older build lacks some of these.
+const REQUIRED_EXPORTS = [
+    'cpu_init', 'cpu_reset', 'cpu_step', 'cpu_get_state', 'cpu_load_rom', 'cpu_load_program',
+    'cpu_write_byte', 'cpu_srec_begin', 'cpu_srec_feed', 'cpu_srec_end', 'cpu_srec_image',
+    'cpu_image_load', 'cpu_set_pc', 'cpu_read_block', 'cpu_write_block',
+    // Run loop
+    'cpu_run', 'cpu_pause', 'cpu_run_batch', 'cpu_get_stop_reason', 'cpu_is_idle',
+];
+
 // Get reference to Module that was loaded by importScripts
 // This avoids declaring it twice
 function getModule(): any {
@@ -123,8 +199,12 @@ async function initWASM(): Promise<void> {
             if (Module.runtimeInitialized) {
                 console.log('[Worker] WASM already initialized, calling setupCPU now');
                 clearTimeout(timeout);
-                setupCPU();
-                resolve();
+                try {
+                    setupCPU();
+                    resolve();
+                } catch (e) {
+                    reject(e);
+                }
                 return;
             }
 
@@ -142,8 +222,12 @@ async function initWASM(): Promise<void> {
                     }
                 }
 
-                setupCPU();
-                resolve();
+                try {
+                    setupCPU();
+                    resolve();
+                } catch (e) {
+                    reject(e);
+                }
             };
         });
     } catch (error) {
@@ -162,6 +246,13 @@ function setupCPU(): void {
         }
         console.log('[Worker] setupCPU: Module exists, cwrap available?', !!Module.cwrap);
 
+        // cwrap does not check that an export exists, a missing one would
+        // only fail when it is first called
+        const missing = REQUIRED_EXPORTS.filter((name) => typeof Module['_' + name] !== 'function');
+        if (missing.length > 0) {
+            throw new Error(`evm.js lacks ${missing.join(', ')}: rebuild it with evm-core/build.sh`);
+        }
+
         // Wrap each function with individual error handling
         const init = Module.cwrap('cpu_init', 'number', []);
         console.log('[Worker] ✓ cpu_init wrapped');
@@ -178,6 +269,11 @@ function setupCPU(): void {
         const pause = Module.cwrap('cpu_pause', null, []);
         console.log('[Worker] ✓ cpu_pause wrapped');
 
+        const runBatch = Module.cwrap('cpu_run_batch', 'number', ['number', 'number']);
+        const getStopReason = Module.cwrap('cpu_get_stop_reason', 'number', []);
+        const isIdle = Module.cwrap('cpu_is_idle', 'number', []);
+        console.log('[Worker] ✓ cpu_run_batch, cpu_get_stop_reason, cpu_is_idle wrapped');
+
         const getState = Module.cwrap('cpu_get_state', 'number', []);
         console.log('[Worker] ✓ cpu_get_state wrapped');
 
@@ -190,18 +286,36 @@ function setupCPU(): void {
         const writeByte = Module.cwrap('cpu_write_byte', null, ['number', 'number']);
         console.log('[Worker] ✓ cpu_write_byte wrapped');
 
-        // Direct ROM initialization function (bypasses read-only check)
-        // This is available in the rebuilt WASM
-        let initRom = null;
+        const srecBegin = Module.cwrap('cpu_srec_begin', 'number', []);
+        const srecFeed = Module.cwrap('cpu_srec_feed', 'number', ['number', 'number']);
+        const srecEnd = Module.cwrap('cpu_srec_end', 'number', []);
+        const srecImage = Module.cwrap('cpu_srec_image', 'number', ['number']);
+        const imageLoad = Module.cwrap('cpu_image_load', 'number', ['number', 'number']);
+        const setPC = Module.cwrap('cpu_set_pc', null, ['number']);
+        console.log('[Worker] ✓ cpu_srec_*, cpu_image_load, cpu_set_pc wrapped');
+
+        const readBlock = Module.cwrap('cpu_read_block', null, ['number', 'number', 'number']);
+        const writeBlock = Module.cwrap('cpu_write_block', null, ['number', 'number', 'number']);
+        console.log('[Worker] ✓ cpu_read_block, cpu_write_block wrapped');
+
+        // Bulk UART transfers, missing in older evm.js builds
+        let uartPush = null;
+        let uartPull = null;
+        let uartSetFd = null;
         try {
-            initRom = Module.cwrap('cpu_init_rom', 'number', ['array', 'number', 'number']);
-            console.log('[Worker] ✓ cpu_init_rom wrapped (direct ROM initialization available)');
+            uartPush = Module.cwrap('cpu_uart_push', 'number', ['number', 'number', 'number']);
+            uartPull = Module.cwrap('cpu_uart_pull', 'number', ['number', 'number', 'number']);
+            uartSetFd = Module.cwrap('cpu_uart_set_fd', null, ['number', 'number']);
+            console.log('[Worker] ✓ cpu_uart_* wrapped');
         } catch (e) {
-            console.log('[Worker] ℹ cpu_init_rom not available: ' + e);
+            console.log('[Worker] ℹ cpu_uart_* not available: ' + e);
         }
 
         // Now assign all at once
-        cpu = { init, reset, step, run, pause, getState, loadROM, loadProgram, writeByte, initRom };
+        cpu = { init, reset, step, run, pause, runBatch, getStopReason, isIdle,
+                getState, loadROM, loadProgram, writeByte, readBlock, writeBlock,
+                srecBegin, srecFeed, srecEnd, srecImage, imageLoad, setPC,
+                uartPush, uartPull, uartSetFd };
 
         console.log('[Worker] All CPU functions assigned to cpu object');
         console.log('[Worker] cpu.init typeof:', typeof cpu.init);
@@ -217,6 +331,9 @@ function setupCPU(): void {
 
 /**
  * Extract CPU state from WASM memory
+ *
+ * The register file is read as one block of words (see utils/sharedState.ts
+ * for the layout) and published to the shared memory on the way.
  */
 function getCPUState(): CPUState {
     if (!initialized || !cpu) {
@@ -224,8 +341,8 @@ function getCPUState(): CPUState {
     }
 
     const Module = getModule();
-    if (!Module) {
-        throw new Error('WASM Module is not available');
+    if (!Module || !Module.HEAPU8) {
+        throw new Error('WASM memory is not available');
     }
 
     const statePtr = cpu.getState();
@@ -233,48 +350,268 @@ function getCPUState(): CPUState {
         throw new Error('cpu_get_state returned null/undefined pointer - simulator may be uninitialized');
     }
 
-    // Use Emscripten's getValue to read from WASM memory
-    // The CPU state structure layout:
-    // uint16_t sr (2 bytes at offset 0)
-    // uint32_t d[8] (32 bytes at offset 4)
-    // uint32_t a[8] (32 bytes at offset 36)
-    // uint32_t pc (4 bytes at offset 68)
-    // uint32_t ssp, usp, msp (12 bytes at offset 72)
+    // Fresh view: the heap buffer is replaced when memory grows
+    const words = new Uint32Array(Module.HEAPU8.buffer, statePtr, REG_WORDS);
+    if (shared) {
+        writeRegisters(shared, words);
+    }
+    return decodeRegisters(words);
+}
+
+/**
+ * Take UART channel A over from the console: its output stays in the core's
+ * transmit FIFO until pumpUART() moves it to the UI. Channel B keeps the
+ * console.
+ */
+function setupUART(): void {
+    shared = createSharedState();
+    console.log(`[Worker] UART: ${shared ? 'shared memory rings' : 'messages (no SharedArrayBuffer)'}`);
+    if (!cpu.uartPull) {
+        return;
+    }
+    uartScratch = getModule()._malloc(UART_SCRATCH_SIZE);
+    cpu.uartSetFd(0, -1);
+}
+
+/**
+ * Move UART data between the core and the UI
+ *
+ * Input goes into the core's receive FIFO as far as it has room. Output is
+ * only taken as far as the UI's ring has room, the rest waits in the core
+ * (the guest sees TXRDY drop once that fills up too).
+ */
+function pumpUART(): void {
+    if (!uartScratch) {
+        return;
+    }
+    const Module = getModule();
+
+    if (shared) {
+        const more = ringRead(shared, 'rx', UART_SCRATCH_SIZE - rxPending.length);
+        if (more.length > 0) {
+            const joined = new Uint8Array(rxPending.length + more.length);
+            joined.set(rxPending);
+            joined.set(more, rxPending.length);
+            rxPending = joined;
+        }
+    }
+    if (rxPending.length > 0) {
+        const chunk = rxPending.subarray(0, UART_SCRATCH_SIZE);
+        Module.HEAPU8.set(chunk, uartScratch);
+        rxPending = rxPending.slice(cpu.uartPush(0, uartScratch, chunk.length));
+    }
+
+    for (;;) {
+        const room = shared ? Math.min(ringFree(shared, 'tx'), UART_SCRATCH_SIZE) : UART_SCRATCH_SIZE;
+        if (room === 0) {
+            break;
+        }
+        const n = cpu.uartPull(0, uartScratch, room);
+        if (n === 0) {
+            break;
+        }
+        const data = Module.HEAPU8.subarray(uartScratch, uartScratch + n);
+        if (shared) {
+            ringWrite(shared, 'tx', data);
+        } else {
+            (self as any).postMessage({ type: 'uart', data: data.slice() } as UartMessage);
+        }
+    }
+}
+
+/**
+ * Copy a block of simulated memory out of / into WASM memory
+ *
+ * The bytes pass through one malloc'ed buffer, one call each way.
+ */
+function readBlock(addr: number, size: number): Uint8Array {
+    const Module = getModule();
+    const buf = Module._malloc(size);
+    try {
+        cpu.readBlock(addr, buf, size);
+        return Module.HEAPU8.slice(buf, buf + size);
+    } finally {
+        Module._free(buf);
+    }
+}
 
-    if (!Module.getValue) {
-        throw new Error('Module.getValue not available - cannot read WASM memory');
+function writeBlock(addr: number, data: Uint8Array): void {
+    const Module = getModule();
+    const buf = Module._malloc(data.length);
+    try {
+        Module.HEAPU8.set(data, buf);
+        cpu.writeBlock(addr, buf, data.length);
+    } finally {
+        Module._free(buf);
     }
+}
 
+// S-record chunk buffer in WASM memory, grown as needed
+let srecBuffer = 0;
+let srecBufferSize = 0;
+
+/**
+ * Pass one chunk of an S-record image to the core's loader
+ */
+function srecFeed(data: Uint8Array): number {
+    const Module = getModule();
+    if (data.length > srecBufferSize) {
+        if (srecBuffer) {
+            Module._free(srecBuffer);
+        }
+        srecBufferSize = Math.max(data.length, 65536);
+        srecBuffer = Module._malloc(srecBufferSize);
+    }
+    Module.HEAPU8.set(data, srecBuffer);
+    return cpu.srecFeed(srecBuffer, data.length);
+}
+
+/**
+ * Memory image of the S-record load in progress, null if there is none
+ */
+function srecImage(): Uint8Array | null {
+    const Module = getModule();
+    const lenPtr = Module._malloc(4);
     try {
-        return {
-            pc: Module.getValue(statePtr + 68, 'i32'),
-            sr: Module.getValue(statePtr, 'i16'),
-            dregs: [
-                Module.getValue(statePtr + 4, 'i32'),
-                Module.getValue(statePtr + 8, 'i32'),
-                Module.getValue(statePtr + 12, 'i32'),
-                Module.getValue(statePtr + 16, 'i32'),
-                Module.getValue(statePtr + 20, 'i32'),
-                Module.getValue(statePtr + 24, 'i32'),
-                Module.getValue(statePtr + 28, 'i32'),
-                Module.getValue(statePtr + 32, 'i32'),
-            ],
-            aregs: [
-                Module.getValue(statePtr + 36, 'i32'),
-                Module.getValue(statePtr + 40, 'i32'),
-                Module.getValue(statePtr + 44, 'i32'),
-                Module.getValue(statePtr + 48, 'i32'),
-                Module.getValue(statePtr + 52, 'i32'),
-                Module.getValue(statePtr + 56, 'i32'),
-                Module.getValue(statePtr + 60, 'i32'),
-                Module.getValue(statePtr + 64, 'i32'),
-            ],
-            ssp: Module.getValue(statePtr + 72, 'i32'),
-            usp: Module.getValue(statePtr + 76, 'i32'),
-            msp: Module.getValue(statePtr + 80, 'i32'),
-        };
-    } catch (e) {
-        throw new Error(`Failed to read CPU state from WASM memory: ${e}`);
+        const image = cpu.srecImage(lenPtr);
+        if (!image) {
+            return null;
+        }
+        const len = Module.getValue(lenPtr, 'i32') >>> 0;
+        const data = Module.HEAPU8.slice(image, image + len);
+        Module._free(image);
+        return data;
+    } finally {
+        Module._free(lenPtr);
+    }
+}
+
+/**
+ * Load a memory image, returns its entry point or -1 if it is bad
+ */
+function imageLoad(data: Uint8Array): number {
+    const Module = getModule();
+    const buf = Module._malloc(data.length);
+    try {
+        Module.HEAPU8.set(data, buf);
+        return cpu.imageLoad(buf, data.length);
+    } finally {
+        Module._free(buf);
+    }
+}
+
+/**
+ * Start at an image's entry point; ROM images end with S7/S9 0, the reset
+ * vector decides then
+ */
+function setEntry(entry: number): void {
+    if (entry !== 0 && entry !== 0xFFFFFFFF) {
+        cpu.setPC(entry);
+        console.log(`[Worker] Entry point 0x${entry.toString(16).padStart(6, '0')}`);
+    }
+}
+
+/**
+ * Check whether the run loop may continue
+ *
+ * The UI clears CTRL_RUN to pause between two batches; the 'pause' message
+ * clears both.
+ */
+function runRequested(): boolean {
+    return running && (!shared || Atomics.load(shared.ctrl, CTRL_RUN) !== 0);
+}
+
+/**
+ * Start the run loop, which continues in slices until paused or a breakpoint
+ */
+function startRun(): void {
+    if (running) {
+        return;
+    }
+    running = true;
+    if (shared) {
+        Atomics.store(shared.ctrl, CTRL_RUN, 1);
+    }
+    lastPublish = lastStateMessage = 0;
+    sliceChannel.port2.postMessage(++runGeneration);
+}
+
+/**
+ * End the run loop and report why
+ */
+function stopRun(reason: number): void {
+    running = false;
+    runGeneration++;
+    if (shared) {
+        Atomics.store(shared.ctrl, CTRL_RUN, 0);
+    }
+    pumpUART();
+    (self as any).postMessage({ type: 'stopped', state: getCPUState(), reason } as StoppedMessage);
+}
+
+/**
+ * Publish the state at display rate
+ *
+ * The shared register file is updated every frame. State messages, which
+ * re-render the whole UI, go out less often unless they are the only way.
+ */
+function publishState(now: number): void {
+    if (now - lastPublish < PUBLISH_MS) {
+        return;
+    }
+    lastPublish = now;
+    const state = getCPUState();
+    if (!shared || now - lastStateMessage >= STATE_MESSAGE_MS) {
+        lastStateMessage = now;
+        (self as any).postMessage({ type: 'state', state, running: true } as StateMessage);
+    }
+}
+
+/**
+ * One time slice of the run loop
+ *
+ * Runs batches until SLICE_MS is used up, then yields so messages get
+ * handled. The batch size follows the measured speed, so that one batch
+ * takes about BATCH_MS. While the CPU waits for a device the loop backs
+ * off instead of fast-forwarding the clock back to back.
+ */
+function runSlice(generation: number): void {
+    if (generation !== runGeneration) {
+        return;
+    }
+    const sliceEnd = performance.now() + SLICE_MS;
+    let idle = false;
+
+    pumpUART();
+    do {
+        if (!runRequested()) {
+            stopRun(SIM_STOPPED_PAUSE);
+            return;
+        }
+
+        const start = performance.now();
+        const done = cpu.runBatch(batchSize, SIM_STOP_BREAKPOINT);
+        const elapsed = performance.now() - start;
+
+        if (cpu.getStopReason() === SIM_STOPPED_BREAKPOINT) {
+            stopRun(SIM_STOPPED_BREAKPOINT);
+            return;
+        }
+        idle = cpu.isIdle() !== 0;
+
+        // Idle batches skip most of their work and say nothing about the speed
+        if (!idle && done === batchSize) {
+            const scale = Math.min(2, Math.max(0.5, BATCH_MS / Math.max(elapsed, 0.1)));
+            batchSize = Math.min(MAX_BATCH, Math.max(MIN_BATCH, Math.round(batchSize * scale)));
+        }
+    } while (!idle && performance.now() < sliceEnd);
+    pumpUART();
+    publishState(performance.now());
+
+    if (idle) {
+        setTimeout(() => runSlice(generation), IDLE_WAIT_MS);
+    } else {
+        sliceChannel.port2.postMessage(generation);
     }
 }
 
@@ -297,6 +634,11 @@ async function handleMessage(event: MessageEvent<SimulatorMessage>): Promise<voi
                     console.log('[Worker] INIT: Calling cpu.init()...');
                     cpu.init();
                     console.log('[Worker] INIT: CPU initialized');
+                    setupUART();
+                    (self as any).postMessage({
+                        type: 'shared',
+                        buffer: shared ? shared.buffer : null,
+                    } as SharedMessage);
                 }
                 console.log('[Worker] INIT: Sending ready message');
                 (self as any).postMessage({ type: 'ready' } as ReadyMessage);
@@ -305,7 +647,9 @@ async function handleMessage(event: MessageEvent<SimulatorMessage>): Promise<voi
             case 'step':
                 console.log('[Worker] STEP: Executing one instruction');
                 try {
+                    pumpUART();
                     const stepResult = cpu.step();
+                    pumpUART();
                     console.log('[Worker] STEP: cpu.step() returned:', stepResult);
                     const state = getCPUState();
                     console.log('[Worker] STEP: Done, PC=0x' + state.pc.toString(16).padStart(6, '0'));
@@ -319,15 +663,26 @@ async function handleMessage(event: MessageEvent<SimulatorMessage>): Promise<voi
             case 'run':
                 const count = payload?.count || 1000;
                 console.log(`[Worker] RUN: Executing ${count} instructions`);
+                pumpUART();
                 cpu.run(count);
+                pumpUART();
                 const runState = getCPUState();
                 console.log('[Worker] RUN: Done, PC=0x' + runState.pc.toString(16).padStart(6, '0'));
                 (self as any).postMessage({ type: 'state', state: runState } as StateMessage);
                 break;
 
+            case 'start':
+                console.log('[Worker] START: Entering run loop');
+                startRun();
+                break;
+
             case 'pause':
+                // Nothing runs while a message is handled, so only the loop
+                // needs stopping
                 console.log('[Worker] PAUSE: Pausing CPU');
-                cpu.pause();
+                if (running) {
+                    stopRun(SIM_STOPPED_PAUSE);
+                }
                 break;
 
             case 'reset':
@@ -338,10 +693,22 @@ async function handleMessage(event: MessageEvent<SimulatorMessage>): Promise<voi
                 (self as any).postMessage({ type: 'state', state: resetState } as StateMessage);
                 break;
 
+            case 'uartInput':
+                // Terminal input when there is no shared RX ring
+                const input = payload?.data as Uint8Array;
+                if (input && input.length > 0) {
+                    const joined = new Uint8Array(rxPending.length + input.length);
+                    joined.set(rxPending);
+                    joined.set(input, rxPending.length);
+                    rxPending = joined;
+                    pumpUART();
+                }
+                break;
+
             case 'getState':
                 console.log('[Worker] GETSTATE: Reading current CPU state');
                 const currentState = getCPUState();
-                (self as any).postMessage({ type: 'state', state: currentState } as StateMessage);
+                (self as any).postMessage({ type: 'state', state: currentState, running } as StateMessage);
                 break;
 
             case 'loadROM':
@@ -364,48 +731,8 @@ async function handleMessage(event: MessageEvent<SimulatorMessage>): Promise<voi
                 }
                 console.log(`[Worker] LOADROM: Loading ${romData.length} bytes at 0x${romAddr.toString(16).padStart(6, '0')}`);
 
-                let romResult = -1;
-
-                // Use direct ROM initialization if available (bypasses read-only check)
-                if (cpu.initRom && romAddr === 0x000000) {
-                    console.log(`[Worker] LOADROM: Using direct ROM initialization (cpu_init_rom)`);
-                    try {
-                        romResult = cpu.initRom(romData, romData.length, romAddr);
-                        console.log(`[Worker] LOADROM: cpu_init_rom returned ${romResult}`);
-                    } catch (e) {
-                        console.warn(`[Worker] LOADROM: Direct init failed: ${e}`);
-                        romResult = -1;
-                    }
-                }
-
-                // If direct init not available or failed, try standard load
-                if (romResult !== 0) {
-                    console.log(`[Worker] LOADROM: Attempting standard load path (cpu_load_program)`);
-                    try {
-                        romResult = cpu.loadProgram(romData, romData.length, romAddr);
-                        console.log(`[Worker] LOADROM: cpu_load_program returned ${romResult}`);
-                    } catch (e) {
-                        console.warn(`[Worker] LOADROM: Standard load failed: ${e}`);
-                        romResult = -1;
-                    }
-                }
-
-                // For ROM at 0x000000, provide helpful error message if load failed
-                if (romResult !== 0 && romAddr === 0x000000) {
-                    console.warn(`[Worker] LOADROM: ⚠️  Failed to load ROM at 0x000000`);
-                    console.warn(`[Worker] LOADROM: The WASM binary has read-only ROM protection`);
-                    console.warn(`[Worker] LOADROM: To fix this, rebuild WASM with Emscripten:`);
-                    console.warn(`[Worker] LOADROM:   1. Install Emscripten: https://emscripten.org/docs/getting_started/downloads.html`);
-                    console.warn(`[Worker] LOADROM:   2. Rebuild: cd evm-web/evm-core && ./build.sh`);
-                    console.log(`[Worker] LOADROM: Continuing without ROM (simulator is ready)`);
-                    (self as any).postMessage({ type: 'ready' } as ReadyMessage);
-                    break;
-                }
-
-                // For non-ROM data, throw error if load failed
-                if (romResult !== 0) {
-                    throw new Error(`Failed to load program at 0x${romAddr.toString(16).padStart(6, '0')}`);
-                }
+                // Block write: ROM pages are written too, cached code is dropped
+                writeBlock(romAddr, romData);
 
                 console.log('[Worker] LOADROM: Success');
                 (self as any).postMessage({ type: 'ready' } as ReadyMessage);
@@ -426,17 +753,63 @@ async function handleMessage(event: MessageEvent<SimulatorMessage>): Promise<voi
                 (self as any).postMessage({ type: 'ready' } as ReadyMessage);
                 break;
 
+            // S-record image in chunks, parsed by the core as they arrive
+            case 'srecBegin':
+                if (cpu.srecBegin() !== 0) {
+                    throw new Error('Cannot start S-record load');
+                }
+                break;
+
+            case 'srecChunk':
+                // A bad record is reported once, by srecEnd
+                srecFeed(payload.data as Uint8Array);
+                break;
+
+            case 'srecEnd':
+                // The image has to be taken before the loader is finished
+                const image = payload?.image ? srecImage() : null;
+                const entry = cpu.srecEnd();
+                if (entry < 0) {
+                    throw new Error('Bad S-record image (see console)');
+                }
+                setEntry(entry);
+                if (image) {
+                    (self as any).postMessage({ type: 'image', data: image } as ImageMessage, [image.buffer]);
+                }
+                (self as any).postMessage({ type: 'ready' } as ReadyMessage);
+                break;
+
+            // Memory image from an earlier srecEnd, instead of the S-records
+            case 'loadImage':
+                const imageEntry = imageLoad(payload.data as Uint8Array);
+                if (imageEntry < 0) {
+                    throw new Error('Bad memory image');
+                }
+                setEntry(imageEntry);
+                (self as any).postMessage({ type: 'ready' } as ReadyMessage);
+                break;
+
+            case 'readMemory':
+                const readAddr = payload?.addr as number;
+                const readSize = payload?.size || 256;
+                if (readAddr === undefined) {
+                    throw new Error('No addr provided for memory read');
+                }
+                const readData = readBlock(readAddr, readSize);
+                (self as any).postMessage({ type: 'memoryRead', addr: readAddr, data: readData },
+                                          [readData.buffer]);
+                break;
+
             case 'writeMemory':
                 const writeAddr = payload?.addr as number;
-                const writeData = payload?.data as number[];
+                const writeData = payload?.data as Uint8Array | number[];
                 if (writeAddr === undefined || !writeData) {
                     throw new Error('No addr or data provided for memory write');
                 }
                 console.log(`[Worker] WRITEMEM: Writing ${writeData.length} bytes at 0x${writeAddr.toString(16).padStart(6, '0')}`);
 
-                // Write each byte
-                for (let i = 0; i < writeData.length; i++) {
-                    cpu.writeByte(writeAddr + i, writeData[i]);
+                if (writeData.length > 0) {
+                    writeBlock(writeAddr, writeData instanceof Uint8Array ? writeData : new Uint8Array(writeData));
                 }
 
                 console.log('[Worker] WRITEMEM: Success');
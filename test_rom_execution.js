@@ -1,202 +0,0 @@
-#!/usr/bin/env node
-/**
- * ROM Execution Test - Verify that WASM module can load and execute MC68020 code
- */
-
-const fs = require('fs');
-const path = require('path');
-
-// S19 Parser
-function parseS19(data) {
-  const lines = data.toString().split('\n');
-  const segments = {};
-
-  for (const line of lines) {
-    if (!line.startsWith('S1') && !line.startsWith('S2') && !line.startsWith('S3')) {
-      continue;
-    }
-
-    const recordType = line.substring(0, 2);
-    const byteCount = parseInt(line.substring(2, 4), 16);
-
-    let addressBytes = 2;
-    if (recordType === 'S3') addressBytes = 4;
-    else if (recordType === 'S2') addressBytes = 3;
-
-    const addressStart = 4;
-    const addressEnd = addressStart + addressBytes * 2;
-    const address = parseInt(line.substring(addressStart, addressEnd), 16);
-
-    const dataStart = addressEnd;
-    const dataEnd = 4 + byteCount * 2 - 2; // -2 for checksum
-    const data = line.substring(dataStart, dataEnd);
-
-    if (!segments[address]) {
-      segments[address] = [];
-    }
-
-    // Parse data bytes
-    for (let i = 0; i < data.length; i += 2) {
-      segments[address].push(parseInt(data.substring(i, i + 2), 16));
-    }
-  }
-
-  return segments;
-}
-
-// Merge S19 segments into linear buffer
-function mergeSegments(segments, baseAddress = 0) {
-  if (Object.keys(segments).length === 0) return new Uint8Array(0);
-
-  const addresses = Object.keys(segments).map(Number);
-  const minAddr = Math.min(...addresses);
-  const maxAddr = Math.max(...addresses, ...Object.keys(segments).map(addr =>
-    addr + segments[addr].length - 1
-  ).map(Number));
-
-  const buffer = new Uint8Array(maxAddr - minAddr + 1);
-
-  for (const [addr, bytes] of Object.entries(segments)) {
-    const numAddr = Number(addr);
-    for (let i = 0; i < bytes.length; i++) {
-      buffer[numAddr - minAddr + i] = bytes[i];
-    }
-  }
-
-  return buffer;
-}
-
-async function testROMExecution() {
-  console.log('🧪 Starting ROM Execution Test...\n');
-
-  try {
-    // Check if WASM files exist
-    const wasmPath = '/home/kgerlich/dev/EVM/evm-web/web/public/evm.js';
-    const wasmBinaryPath = '/home/kgerlich/dev/EVM/evm-web/web/public/evm.wasm';
-    const romPath = '/home/kgerlich/dev/EVM/evm-web/web/public/PS20.S19';
-
-    if (!fs.existsSync(wasmPath)) {
-      throw new Error(`WASM JS file not found: ${wasmPath}`);
-    }
-    if (!fs.existsSync(wasmBinaryPath)) {
-      throw new Error(`WASM binary not found: ${wasmBinaryPath}`);
-    }
-    if (!fs.existsSync(romPath)) {
-      throw new Error(`ROM file not found: ${romPath}`);
-    }
-
-    console.log('✅ All required files found');
-    console.log(`   - WASM JS: ${wasmPath}`);
-    console.log(`   - WASM Binary: ${wasmBinaryPath}`);
-    console.log(`   - ROM file: ${romPath}\n`);
-
-    // Load WASM module
-    console.log('📦 Loading WASM module...');
-    const Module = {};
-
-    // Create fs mock for Emscripten
-    const fsModule = {
-      readFileSync: (filename) => {
-        if (filename === 'evm.wasm') {
-          return fs.readFileSync(wasmBinaryPath);
-        }
-        return fs.readFileSync(filename);
-      }
-    };
-
-    // Execute WASM JS with proper scope
-    const wasmCode = fs.readFileSync(wasmPath, 'utf8');
-
-    // Create execution context with necessary globals
-    const ctx = {
-      Module,
-      fs: fsModule,
-      console,
-      fetch: (url) => {
-        if (url === 'evm.wasm') {
-          return Promise.resolve({
-            arrayBuffer: () => Promise.resolve(fs.readFileSync(wasmBinaryPath).buffer)
-          });
-        }
-      },
-      XMLHttpRequest: class {
-        open() {}
-        send() {}
-      }
-    };
-
-    // Check WASM binary validity
-    const wasmBinary = fs.readFileSync(wasmBinaryPath);
-    const magicNumber = wasmBinary.slice(0, 4).toString('hex');
-    if (magicNumber !== '0061736d') {
-      throw new Error(`Invalid WASM binary magic number: ${magicNumber} (expected 0061736d)`);
-    }
-    console.log('✅ WASM module structure verified\n');
-
-    // Parse ROM
-    console.log('📂 Parsing S19 ROM file...');
-    const romData = fs.readFileSync(romPath, 'utf8');
-    const segments = parseS19(romData);
-    const romBuffer = mergeSegments(segments);
-
-    console.log(`✅ ROM parsed successfully`);
-    console.log(`   - Number of memory segments: ${Object.keys(segments).length}`);
-    console.log(`   - Total ROM size: ${romBuffer.length} bytes (0x${romBuffer.length.toString(16).padStart(4, '0')})\n`);
-
-    // Display segment info
-    const addrs = Object.keys(segments).map(Number).sort((a, b) => a - b);
-    console.log('📍 Memory segments:');
-    for (const addr of addrs) {
-      const size = segments[addr].length;
-      console.log(`   - 0x${addr.toString(16).padStart(6, '0')} - 0x${(addr + size - 1).toString(16).padStart(6, '0')} (${size} bytes)`);
-    }
-
-    // Show first few bytes of ROM
-    console.log('\n📄 First 32 bytes of ROM (hex):');
-    let hexLine = '   ';
-    for (let i = 0; i < Math.min(32, romBuffer.length); i++) {
-      hexLine += romBuffer[i].toString(16).padStart(2, '0').toUpperCase() + ' ';
-    }
-    console.log(hexLine);
-
-    // Interpret first instructions
-    console.log('\n🔍 Analyzing ROM structure:');
-    if (romBuffer.length >= 2) {
-      const firstOpcode = (romBuffer[0] << 8) | romBuffer[1];
-      console.log(`   - First opcode at 0x000000: 0x${firstOpcode.toString(16).padStart(4, '0').toUpperCase()}`);
-
-      // Common 68020 opcodes
-      const opcodeInfo = {
-        0x4E70: 'RESET',
-        0x4E71: 'NOP',
-        0x4E75: 'RTS',
-        0x4E73: 'RTE',
-        0x2F00: 'MOVE.L D0,-(A7)',
-        0x70FF: 'MOVEQ #-1,D0'
-      };
-
-      if (opcodeInfo[firstOpcode]) {
-        console.log(`   - Instruction: ${opcodeInfo[firstOpcode]}`);
-      }
-    }
-
-    console.log('\n✨ ROM EXECUTION TEST PASSED');
-    console.log('✅ ROM file can be loaded and parsed successfully');
-    console.log('✅ WASM module structure is correct');
-    console.log('✅ Memory layout can be initialized from S19 format');
-    console.log('\n🚀 Next step: Execute instructions via WASM interface');
-
-    return true;
-
-  } catch (error) {
-    console.error('\n❌ ROM EXECUTION TEST FAILED');
-    console.error(`Error: ${error.message}`);
-    console.error(`Stack: ${error.stack}`);
-    return false;
-  }
-}
-
-// Run test
-testROMExecution().then(success => {
-  process.exit(success ? 0 : 1);
-});
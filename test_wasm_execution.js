@@ -1,203 +0,0 @@
-#!/usr/bin/env node
-/**
- * Full WASM Execution Test - Load WASM module and execute ROM code
- */
-
-const fs = require('fs');
-const path = require('path');
-
-// S19 Parser
-function parseS19(data) {
-  const lines = data.toString().split('\n');
-  const segments = {};
-
-  for (const line of lines) {
-    if (!line.startsWith('S1') && !line.startsWith('S2') && !line.startsWith('S3')) {
-      continue;
-    }
-
-    const recordType = line.substring(0, 2);
-    const byteCount = parseInt(line.substring(2, 4), 16);
-
-    let addressBytes = 2;
-    if (recordType === 'S3') addressBytes = 4;
-    else if (recordType === 'S2') addressBytes = 3;
-
-    const addressStart = 4;
-    const addressEnd = addressStart + addressBytes * 2;
-    const address = parseInt(line.substring(addressStart, addressEnd), 16);
-
-    const dataStart = addressEnd;
-    const dataEnd = 4 + byteCount * 2 - 2; // -2 for checksum
-    const data = line.substring(dataStart, dataEnd);
-
-    if (!segments[address]) {
-      segments[address] = [];
-    }
-
-    // Parse data bytes
-    for (let i = 0; i < data.length; i += 2) {
-      segments[address].push(parseInt(data.substring(i, i + 2), 16));
-    }
-  }
-
-  return segments;
-}
-
-// Merge S19 segments into buffer at specific address
-function buildMemoryImage(segments) {
-  if (Object.keys(segments).length === 0) return new Map();
-
-  const memoryMap = new Map();
-  for (const [addr, bytes] of Object.entries(segments)) {
-    const numAddr = Number(addr);
-    memoryMap.set(numAddr, Buffer.from(bytes));
-  }
-  return memoryMap;
-}
-
-// Format bytes as hex
-function hexDump(buffer, address = 0, length = 32) {
-  let hex = '';
-  for (let i = 0; i < Math.min(length, buffer.length); i++) {
-    hex += buffer[i].toString(16).padStart(2, '0').toUpperCase() + ' ';
-  }
-  return hex;
-}
-
-async function testWASMExecution() {
-  console.log('🧪 Starting WASM Execution Test...\n');
-
-  try {
-    const wasmPath = '/home/kgerlich/dev/EVM/evm-web/web/public/evm.wasm';
-    const romPath = '/home/kgerlich/dev/EVM/evm-web/web/public/PS20.S19';
-
-    if (!fs.existsSync(wasmPath)) {
-      throw new Error(`WASM binary not found: ${wasmPath}`);
-    }
-    if (!fs.existsSync(romPath)) {
-      throw new Error(`ROM file not found: ${romPath}`);
-    }
-
-    console.log('✅ Files found');
-
-    // Load WASM binary
-    console.log('\n📦 Loading WASM module...');
-    const wasmBuffer = fs.readFileSync(wasmPath);
-    let wasmModule = null;
-
-    try {
-      // Try to instantiate WASM
-      const wasmMemory = new WebAssembly.Memory({ initial: 256, maximum: 512 });
-      const importObject = {
-        env: {
-          memory: wasmMemory
-        },
-        js: {
-          mem: wasmMemory
-        }
-      };
-
-      // This will fail in Node.js because WebAssembly is not fully available without special setup
-      // But let's check if the module is valid
-      console.log('✅ WASM binary is valid format (magic number OK)');
-    } catch (e) {
-      console.log('⚠️  Cannot instantiate WASM in Node.js directly');
-      console.log('   This is expected - WASM requires browser or special Node.js setup');
-    }
-
-    // Parse ROM
-    console.log('\n📂 Parsing S19 ROM file...');
-    const romData = fs.readFileSync(romPath, 'utf8');
-    const segments = parseS19(romData);
-    const memoryImage = buildMemoryImage(segments);
-
-    console.log(`✅ ROM parsed successfully`);
-    console.log(`   - Memory segments: ${memoryImage.size}`);
-
-    // Calculate total ROM size
-    let totalSize = 0;
-    let minAddr = Infinity;
-    let maxAddr = 0;
-    for (const [addr, buffer] of memoryImage) {
-      totalSize += buffer.length;
-      minAddr = Math.min(minAddr, addr);
-      maxAddr = Math.max(maxAddr, addr + buffer.length - 1);
-    }
-    console.log(`   - Total ROM size: ${totalSize} bytes`);
-    console.log(`   - Address range: 0x${minAddr.toString(16).padStart(6, '0')} - 0x${maxAddr.toString(16).padStart(6, '0')}`);
-
-    // Show first actual code segment
-    const firstSegmentAddr = Array.from(memoryImage.keys()).sort((a, b) => a - b)[0];
-    const firstSegment = memoryImage.get(firstSegmentAddr);
-
-    console.log(`\n📄 First memory segment at 0x${firstSegmentAddr.toString(16).padStart(6, '0')}:`);
-    console.log(`   ${hexDump(firstSegment, firstSegmentAddr, 16)}`);
-
-    // Decode first opcode
-    if (firstSegment.length >= 2) {
-      const firstOpcode = (firstSegment[0] << 8) | firstSegment[1];
-      console.log(`\n🔍 First instruction: 0x${firstOpcode.toString(16).padStart(4, '0').toUpperCase()}`);
-
-      // MC68020 opcode decoding hints
-      const opcodeBits = firstOpcode.toString(2).padStart(16, '0');
-      console.log(`   - Binary: ${opcodeBits}`);
-
-      // Basic 68020 opcode patterns
-      const top4bits = (firstOpcode >> 12) & 0xF;
-      const top6bits = (firstOpcode >> 10) & 0x3F;
-
-      const opcodePatterns = {
-        0x4: 'Miscellaneous (CLR, NEG, NBCD, PEA, MOVE to SR, etc.)',
-        0x2: 'MOVE instruction family',
-        0x3: 'MOVE instruction family',
-        0x5: 'ADDQ/SUBQ/Scc/DBcc',
-        0x6: 'Branch instructions (BRA, BSR, Bcc)',
-        0x7: 'MOVEQ',
-        0x8: 'OR/Divu/Divs',
-        0x9: 'SUB/SUBX',
-        0xB: 'CMP/CMPM',
-        0xC: 'AND/Mulu/Muls',
-        0xD: 'ADD/ADDX',
-        0xE: 'Shift/Rotate',
-        0xF: 'Line F Coprocessor'
-      };
-
-      if (opcodePatterns[top4bits]) {
-        console.log(`   - Instruction family: ${opcodePatterns[top4bits]}`);
-      }
-    }
-
-    // Summary
-    console.log('\n' + '='.repeat(50));
-    console.log('✨ WASM & ROM STRUCTURE VERIFICATION COMPLETE');
-    console.log('='.repeat(50));
-    console.log('\n✅ WASM binary is valid');
-    console.log('✅ ROM can be parsed and loaded into memory');
-    console.log('✅ First opcode decoded successfully');
-    console.log('\n📊 ROM Configuration:');
-    console.log(`   - Format: Motorola S-record (S19)`);
-    console.log(`   - Segments: ${memoryImage.size}`);
-    console.log(`   - Total size: ${totalSize} bytes`);
-    console.log(`   - Address space: ${(maxAddr - minAddr + 1) / 1024} KB`);
-
-    console.log('\n🚀 Runtime Execution:');
-    console.log('   Status: Ready for execution in browser');
-    console.log('   Method: WASM module loads ROM, executes instructions');
-    console.log('   CPU state: Tracked via simulator.worker.ts');
-    console.log('   Interface: useSimulator.ts React hook');
-
-    return true;
-
-  } catch (error) {
-    console.error('\n❌ TEST FAILED');
-    console.error(`Error: ${error.message}`);
-    console.error(`Stack: ${error.stack}`);
-    return false;
-  }
-}
-
-// Run test
-testWASMExecution().then(success => {
-  process.exit(success ? 0 : 1);
-});